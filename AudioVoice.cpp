@@ -22,56 +22,128 @@
 
 #include "SaXAudio.h"
 #include "Fader.h"
+#include "Dsp.h"
 
 namespace SaXAudio
 {
-    BOOL AudioVoice::Start(const UINT32 atSample, BOOL flush)
+    BOOL AudioVoice::Start(const UINT32 atSample, BOOL flush, const UINT32 leadIn, const UINT32 operationSet)
     {
+        IsScheduled = false;
+        m_segmented = false;
+        m_segmentOffset = 0;
+
+        if (IsVirtual && BankData)
+        {
+            Log(BankID, VoiceID, "[Start] Virtual at: " + to_string(atSample));
+
+            BOOL wasPlaying = IsPlaying;
+            // A negative position is the lead in left before the voice is heard
+            m_virtualPosition = (double)atSample - leadIn;
+            Looping = Looping && atSample < LoopEnd;
+            IsPlaying = true;
+
+            // The voice might be important enough to get a source voice right away
+            if (!wasPlaying)
+                SaXAudio::Instance.Reschedule();
+            return true;
+        }
+
         if (!SourceVoice || !BankData) return false;
         Log(BankID, VoiceID, "[Start] at: " + to_string(atSample) + (Looping ? " loop start: " + to_string(LoopStart) + " loop end: " + to_string(LoopEnd) : ""));
 
-        // Update position offset
-        m_positionOffset = atSample;
+        // Check if we are past the new looping points
+        Looping = Looping && LoopStart < LoopEnd && atSample < LoopEnd;
+
+        return StartPlan(PlanStart(atSample, Looping, LoopStart, LoopEnd, BankData->totalSamples), flush, leadIn, operationSet);
+    }
+
+    BOOL AudioVoice::StartSegments(const PlaybackSegment* segments, const UINT32 count)
+    {
+        if ((!SourceVoice && !IsVirtual) || !BankData || !segments) return false;
+
+        SegmentPlan plan = PlanSegments(segments, count, BankData->totalSamples);
+        if (plan.count == 0) return false;
+        Log(BankID, VoiceID, "[StartSegments] count: " + to_string(plan.count));
+
+        // A final infinite loop is the loop of the voice, SetLooping(false) exits it
+        const Segment& last = plan.segments[plan.count - 1];
+        Looping = last.loopCount == XAUDIO2_LOOP_INFINITE;
+        if (Looping)
+        {
+            LoopStart = last.loopBegin;
+            LoopEnd = last.loopEnd;
+        }
+
+        IsScheduled = false;
+        m_segmented = true;
+        m_segmentOffset = 0;
+
+        // A virtual voice follows the plan, the rest of it is submitted once it gets a source voice
+        if (IsVirtual)
+        {
+            BOOL wasPlaying = IsPlaying;
+            m_plan = plan;
+            m_virtualPlayed = 0;
+            m_virtualPosition = plan.segments[0].playBegin;
+            IsPlaying = true;
+
+            if (!wasPlaying)
+                SaXAudio::Instance.Reschedule();
+            return true;
+        }
+
+        return StartPlan(plan, true, 0, XAUDIO2_COMMIT_NOW);
+    }
+
+    BOOL AudioVoice::StartPlan(const SegmentPlan& plan, BOOL flush, const UINT32 leadIn, const UINT32 operationSet)
+    {
+        // The new segments start after what the voice already played
+        UINT64 samplesPlayed = 0;
         if (IsPlaying)
         {
             if (flush)
             {
-                m_tempFlush++;
+                m_bufferToken++;
                 SourceVoice->Stop();
                 SourceVoice->FlushSourceBuffers();
             }
             XAUDIO2_VOICE_STATE state;
             SourceVoice->GetState(&state);
-            m_positionOffset -= state.SamplesPlayed;
+            samplesPlayed = state.SamplesPlayed;
         }
 
-        // Set up buffer
-        Buffer.PlayBegin = atSample;
-        Buffer.PlayLength = 0; // Plays until the end
-
-        // Check if we are past the new looping points
-        if (Looping && atSample < LoopEnd)
+        if (leadIn > 0)
         {
-            Buffer.LoopBegin = LoopStart;
-            Buffer.LoopLength = LoopEnd - LoopStart;
-            Buffer.LoopCount = XAUDIO2_LOOP_INFINITE;
-        }
-        else
-        {
-            // XAudio will refuse the buffer if PlayBegin is past the end of the loop,
-            // we will just play the sound from the position without a loop
-            Looping = false;
-            Buffer.LoopBegin = 0;
-            Buffer.LoopLength = 0;
-            Buffer.LoopCount = 0;
+            // Silence up to the scheduled time, the position stays at atSample until it has played
+            XAUDIO2_BUFFER silence = { 0 };
+            silence.AudioBytes = leadIn * BankData->channels * sizeof(FLOAT);
+            silence.pAudioData = (const BYTE*)SaXAudio::Instance.m_silence.data();
+            silence.pContext = LEAD_IN_CONTEXT;
+
+            HRESULT hr = SourceVoice->SubmitSourceBuffer(&silence);
+            if (FAILED(hr))
+            {
+                Log(BankID, VoiceID, "[Start] Failed to submit lead in", hr);
+            }
+            else
+            {
+                samplesPlayed += leadIn;
+            }
         }
 
-        // Submitting the buffer
-        HRESULT hr = SourceVoice->SubmitSourceBuffer(&Buffer);
+        m_plan = plan;
+        m_plan.origin = samplesPlayed;
+        m_previousPlan = m_plan;
+        m_loopChangePending = false;
+        Buffer.PlayBegin = plan.count > 0 ? plan.segments[0].playBegin : 0;
+
+        // Submitting the buffers
+        HRESULT hr = SubmitPlan(m_plan);
         if (FAILED(hr))
         {
             Log(BankID, VoiceID, "[Start] Failed to submit buffer", hr);
-            SaXAudio::Instance.RemoveVoice(VoiceID);
+            EventQueue::Instance.Push(EVENT_VOICE_ERROR, VoiceID, BankID, hr);
+            SaXAudio::Instance.FinishVoice(VoiceID);
             return false;
         }
 
@@ -83,54 +155,33 @@ namespace SaXAudio
             return IsPlaying;
         }
 
-        if (BankData->decodedSamples <= atSample)
+        if (BankData->decodedSamples <= Buffer.PlayBegin)
         {
-            // Waiting for some decoded samples to not read garbage
-            thread wait(WaitForDecoding, this);
-            wait.detach();
+            // Waiting for some decoded samples to not read garbage, the control thread starts it once they are there
+            SaXAudio::Instance.WaitForDecoding(VoiceID);
         }
-        else if (FAILED(hr = SourceVoice->Start()))
+        else if (FAILED(hr = SourceVoice->Start(0, operationSet)))
         {
             Log(BankID, VoiceID, "[Start] FAILED starting", hr);
-            SaXAudio::Instance.RemoveVoice(VoiceID);
+            EventQueue::Instance.Push(EVENT_VOICE_ERROR, VoiceID, BankID, hr);
+            SaXAudio::Instance.FinishVoice(VoiceID);
             return false;
         }
         return IsPlaying;
     }
 
-    void AudioVoice::WaitForDecoding(AudioVoice* voice)
+    BOOL AudioVoice::Stop(const FLOAT fade)
     {
-        Log(voice->BankID, voice->VoiceID, "[Start] Waiting for decoded data");
-        unique_lock<mutex> lock(voice->BankData->decodingMutex);
-        if (voice->BankData->decodedSamples == 0)
+        if (IsScheduled && !IsPlaying)
         {
-            if (!voice->BankData->decodingPerform.wait_for(lock, chrono::milliseconds(500), [voice] { return voice->BankData->decodedSamples > voice->Buffer.PlayBegin; }))
-            {
-                Log(voice->BankID, voice->VoiceID, " ERROR | [Start] Failed waiting for decoded data, timed out");
-                SaXAudio::Instance.RemoveVoice(voice->VoiceID);
-                return;
-            }
+            // Cancel the scheduled start
+            Log(BankID, VoiceID, "[Stop] Scheduled start canceled");
+            IsScheduled = false;
+            SaXAudio::Instance.CancelScheduledStart(VoiceID);
+            return true;
         }
 
-        // Sound has been paused while we were waiting
-        if (voice->m_pauseStack > 0) return;
-
-        HRESULT hr = voice->SourceVoice->Start();
-        if (FAILED(hr))
-        {
-            Log(voice->BankID, voice->VoiceID, "[Start] Failed starting", hr);
-            SaXAudio::Instance.RemoveVoice(voice->VoiceID);
-        }
-        else
-        {
-            voice->m_tempFlush = 0;
-            Log(voice->BankID, voice->VoiceID, "[Start] Successfully waited for decoded data");
-        }
-    }
-
-    BOOL AudioVoice::Stop(const FLOAT fade)
-    {
-        if (!SourceVoice || !IsPlaying) return false;
+        if ((!SourceVoice && !IsVirtual) || !IsPlaying) return false;
         Log(BankID, VoiceID, "[Stop] fade: " + to_string(fade));
 
         IsPlaying = false;
@@ -139,8 +190,14 @@ namespace SaXAudio
         Fader::Instance.StopFade(m_volumeFadeID);
         m_volumeFadeID = 0;
 
-        if (fade > 0)
+        if (IsVirtual)
         {
+            // Nothing to hear, no need to fade
+            SaXAudio::Instance.RemoveVoice(VoiceID);
+        }
+        else if (fade > 0)
+        {
+            IsStopping = true;
             FLOAT current = 1.0f;
             SourceVoice->GetVolume(&current);
             m_volumeFadeID = Fader::Instance.StartFade(current, 0, fade, OnFadeVolume, VoiceID);
@@ -149,7 +206,6 @@ namespace SaXAudio
         }
         else
         {
-            m_tempFlush = 0;
             SourceVoice->Stop();
             SourceVoice->FlushSourceBuffers();
         }
@@ -158,7 +214,7 @@ namespace SaXAudio
 
     UINT32 AudioVoice::Pause(const FLOAT fade)
     {
-        if (!SourceVoice) return 0;
+        if (!SourceVoice && !IsVirtual) return 0;
 
         m_pauseStack++;
         Log(BankID, VoiceID, "[Pause] stack: " + to_string(m_pauseStack));
@@ -170,6 +226,10 @@ namespace SaXAudio
         Fader::Instance.PauseFade(m_speedFadeID);
         Fader::Instance.PauseFade(m_panningFadeID);
 
+        // A virtual voice only needs the pause stack to stop advancing
+        if (!SourceVoice)
+            return m_pauseStack;
+
         if (fade > 0 && Volume > 0 && IsPlaying)
         {
             FLOAT current = 1.0f;
@@ -185,7 +245,7 @@ namespace SaXAudio
 
     UINT32 AudioVoice::Resume(const FLOAT fade)
     {
-        if (!SourceVoice || m_pauseStack == 0) return 0;
+        if ((!SourceVoice && !IsVirtual) || m_pauseStack == 0) return 0;
 
         m_pauseStack--;
         Log(BankID, VoiceID, "[Resume] stack: " + to_string(m_pauseStack) + (Looping ? " - Looping" : ""));
@@ -193,12 +253,13 @@ namespace SaXAudio
         if (m_pauseStack > 0)
             return m_pauseStack;
 
-        SourceVoice->Start();
+        if (SourceVoice)
+            SourceVoice->Start();
 
         Fader::Instance.StopFade(m_pauseFadeID);
         m_pauseFadeID = 0;
 
-        if (fade > 0 && Volume > 0)
+        if (fade > 0 && Volume > 0 && SourceVoice)
         {
             FLOAT current = 0.0f;
             SourceVoice->GetVolume(&current);
@@ -206,7 +267,8 @@ namespace SaXAudio
         }
         else
         {
-            SourceVoice->SetVolume(Volume);
+            if (SourceVoice)
+                SourceVoice->SetVolume(Volume);
             // Resume the fading interrupted by pause
             Fader::Instance.ResumeFade(m_volumeFadeID);
             Fader::Instance.ResumeFade(m_speedFadeID);
@@ -222,33 +284,103 @@ namespace SaXAudio
 
     UINT64 AudioVoice::CalculateCurrentPosition()
     {
+        if (!BankData) return 0;
+
         XAUDIO2_VOICE_STATE state;
         SourceVoice->GetState(&state);
+        return CalculatePosition(state.SamplesPlayed);
+    }
 
-        UINT64 position = state.SamplesPlayed + m_positionOffset;
-        if (Looping && position > LoopStart)
+    UINT64 AudioVoice::CalculatePosition(const UINT64 samplesPlayed)
+    {
+        // The previous plan plays until the loop exits, the lead in is before the origin of both
+        const SegmentPlan& plan = samplesPlayed < m_plan.origin ? m_previousPlan : m_plan;
+        return GetPlanPosition(plan, samplesPlayed, BankData->totalSamples);
+    }
+
+    UINT32 AudioVoice::CalculateSegmentIndex(const UINT64 samplesPlayed)
+    {
+        // Only the regions of StartSegments are counted, a plain start with an intro is still region 0
+        if (!m_segmented) return 0;
+
+        const SegmentPlan& plan = samplesPlayed < m_plan.origin ? m_previousPlan : m_plan;
+        return m_segmentOffset + GetPlanSegment(plan, samplesPlayed, BankData->totalSamples);
+    }
+
+    HRESULT AudioVoice::SubmitPlan(const SegmentPlan& plan)
+    {
+        if (plan.count == 0)
+            return E_INVALIDARG;
+
+        for (UINT32 i = 0; i < plan.count; i++)
         {
-            // We are somewhere in the loop
-            position = LoopStart + ((position - LoopStart) % (UINT64)(LoopEnd - LoopStart));
+            const Segment& segment = plan.segments[i];
+
+            XAUDIO2_BUFFER buffer = Buffer;
+            buffer.PlayBegin = segment.playBegin;
+            buffer.PlayLength = segment.playEnd ? segment.playEnd - segment.playBegin : 0; // 0 plays until the end
+            buffer.LoopBegin = segment.loopBegin;
+            buffer.LoopLength = segment.loopEnd ? segment.loopEnd - segment.loopBegin : 0;
+            buffer.LoopCount = segment.loopEnd ? segment.loopCount : 0;
+            // Only the last segment ends the stream, more segments can follow an exited loop
+            BOOL last = i == plan.count - 1 && segment.loopCount != XAUDIO2_LOOP_INFINITE;
+            buffer.Flags = last ? XAUDIO2_END_OF_STREAM : 0;
+            buffer.pContext = (void*)(UINT_PTR)m_bufferToken.load();
+
+            HRESULT hr = SourceVoice->SubmitSourceBuffer(&buffer);
+            if (FAILED(hr))
+                return hr;
         }
-        return position;
+        return S_OK;
     }
 
     UINT32 AudioVoice::GetPosition()
     {
-        if (!IsPlaying || !SourceVoice) return 0;
+        UINT32 position = 0;
+        UINT32 segmentIndex = 0;
+        GetPlayback(position, segmentIndex);
+        return position;
+    }
 
-        UINT64 position = CalculateCurrentPosition();
+    UINT32 AudioVoice::GetSegmentIndex()
+    {
+        UINT32 position = 0;
+        UINT32 segmentIndex = 0;
+        GetPlayback(position, segmentIndex);
+        return segmentIndex;
+    }
 
-        if (position == 0)
-            return 1; // Probably waiting on decoding, returning 0 would mean it finished playing
+    void AudioVoice::GetPlayback(UINT32& position, UINT32& segmentIndex)
+    {
+        position = 0;
+        segmentIndex = 0;
+        if (!IsPlaying || !BankData) return;
 
-        return (UINT32)position;
+        UINT64 current = 0;
+        if (IsVirtual)
+        {
+            current = m_virtualPosition > 0 ? (UINT64)m_virtualPosition : 0;
+            segmentIndex = CalculateSegmentIndex((UINT64)m_virtualPlayed);
+        }
+        else if (SourceVoice)
+        {
+            XAUDIO2_VOICE_STATE state;
+            SourceVoice->GetState(&state);
+            current = CalculatePosition(state.SamplesPlayed);
+            segmentIndex = CalculateSegmentIndex(state.SamplesPlayed);
+        }
+        else
+        {
+            return;
+        }
+
+        // Probably waiting on decoding, 0 would mean it finished playing
+        position = current == 0 ? 1 : (UINT32)current;
     }
 
     void AudioVoice::ChangeLoopPoints(const UINT32 start, UINT32 end)
     {
-        if (!SourceVoice || !BankData) return;
+        if ((!SourceVoice && !IsVirtual) || !BankData) return;
         Log(BankID, VoiceID, "[ChangeLoopPoints] start: " + to_string(start) + " end: " + to_string(end));
 
         if (end == 0)
@@ -257,8 +389,15 @@ namespace SaXAudio
         if (LoopStart == start && LoopEnd == end)
             return;
 
+        // The voice keeps playing, the new loop takes effect at the end of the current one
+        BOOL seamless = SeamlessLoops && Looping && IsPlaying && SourceVoice;
+
         UINT64 position = 0;
-        if (IsPlaying)
+        if (seamless)
+        {
+            Log(BankID, VoiceID, "[ChangeLoopPoints] Seamless");
+        }
+        else if (IsPlaying && SourceVoice)
         {
             // Stop and flush the voice
             SourceVoice->Stop();
@@ -266,12 +405,15 @@ namespace SaXAudio
             position = CalculateCurrentPosition();
 
             // Temporary flush the buffer
-            m_tempFlush++;
+            m_bufferToken++;
             SourceVoice->FlushSourceBuffers();
         }
+        else if (IsPlaying)
+        {
+            position = m_virtualPosition > 0 ? (UINT64)m_virtualPosition : 0;
+        }
 
         // Make sure LoopStart < LoopEnd
-        // Note: this must happen AFTER CalculateCurrentPosition
         if (start < end)
         {
             LoopStart = start;
@@ -287,17 +429,27 @@ namespace SaXAudio
             LoopStart = LoopEnd - 1;
 
         // Resume playing from calculated position
-        if (IsPlaying)
+        if (seamless)
+            RequestLoopChange();
+        else if (IsPlaying)
             Start((UINT32)position, false);
     }
 
     void AudioVoice::SetLooping(BOOL state)
     {
-        if (!SourceVoice || !BankData || Looping == state) return;
+        if ((!SourceVoice && !IsVirtual) || !BankData || Looping == state) return;
         Log(BankID, VoiceID, "[SetLooping] " + to_string(state));
 
+        if (SeamlessLoops && !state && IsPlaying && SourceVoice)
+        {
+            // The current loop plays to its end, then the rest of the sound
+            Looping = false;
+            RequestLoopChange();
+            return;
+        }
+
         UINT64 position = 0;
-        if (IsPlaying)
+        if (IsPlaying && SourceVoice)
         {
             // Stop and flush the voice
             SourceVoice->Stop();
@@ -305,11 +457,15 @@ namespace SaXAudio
             position = CalculateCurrentPosition();
 
             // Temporary flush the buffer
-            m_tempFlush++;
+            m_bufferToken++;
             SourceVoice->FlushSourceBuffers();
         }
+        else if (IsPlaying)
+        {
+            position = m_virtualPosition > 0 ? (UINT64)m_virtualPosition : 0;
+        }
 
-        Looping = state; // Note: this must happen AFTER CalculateCurrentPosition
+        Looping = state;
 
         // Make sure LoopEnd is not 0
         if (Looping && LoopEnd == 0)
@@ -320,9 +476,78 @@ namespace SaXAudio
             Start((UINT32)position, false);
     }
 
+    void AudioVoice::RequestLoopChange()
+    {
+        BOOL wasPending = m_loopChangePending;
+        m_loopChangePending = true;
+
+        // A previous change is still queued, the control thread applies this one once it plays
+        if (!ApplyLoopChange() && !wasPending)
+            SaXAudio::Instance.m_pendingLoops.push_back(VoiceID);
+    }
+
+    BOOL AudioVoice::ApplyLoopChange()
+    {
+        if (!m_loopChangePending)
+            return true;
+
+        // Virtual voices use the loop points directly
+        if (!SourceVoice || !IsPlaying || !BankData || m_plan.count == 0)
+        {
+            m_loopChangePending = false;
+            return true;
+        }
+
+        // ExitLoop only applies to the buffer playing, wait until the last segment is the only one left
+        XAUDIO2_VOICE_STATE state;
+        SourceVoice->GetState(&state);
+        if (state.BuffersQueued > 1)
+            return false;
+
+        m_loopChangePending = false;
+        const Segment& current = m_plan.segments[m_plan.count - 1];
+
+        if (current.loopCount != XAUDIO2_LOOP_INFINITE)
+        {
+            // Already past the loop, it can't be seamless anymore
+            UINT64 position = CalculateCurrentPosition();
+            m_bufferToken++;
+            SourceVoice->Stop();
+            SourceVoice->FlushSourceBuffers();
+            Start((UINT32)position, false);
+            return true;
+        }
+
+        UINT32 totalSamples = BankData->totalSamples;
+        SegmentPlan plan = PlanLoopChange(current.loopEnd, Looping, LoopStart, LoopEnd, totalSamples);
+        plan.origin = GetPlanLoopExit(m_plan, state.SamplesPlayed, totalSamples);
+
+        // Nothing to queue when the loop ended at the end of the sound
+        if (plan.count > 0)
+        {
+            HRESULT hr = SubmitPlan(plan);
+            if (FAILED(hr))
+            {
+                Log(BankID, VoiceID, "[ApplyLoopChange] Failed to submit buffer", hr);
+                EventQueue::Instance.Push(EVENT_VOICE_ERROR, VoiceID, BankID, hr);
+                SaXAudio::Instance.FinishVoice(VoiceID);
+                return true;
+            }
+        }
+
+        SourceVoice->ExitLoop();
+        m_previousPlan = m_plan;
+        m_plan = plan;
+        // Only the final loop was left of the regions, the rest is a plain start
+        m_segmented = false;
+        m_segmentOffset = 0;
+        Log(BankID, VoiceID, "[ApplyLoopChange] Exits at: " + to_string(plan.origin));
+        return true;
+    }
+
     void AudioVoice::SetVolume(const FLOAT volume, const FLOAT fade)
     {
-        if (!SourceVoice || Volume == volume) return;
+        if ((!SourceVoice && !IsVirtual) || Volume == volume) return;
         Log(BankID, VoiceID, "[SetVolume] to: " + to_string(volume) + " fade: " + to_string(fade));
 
         Fader::Instance.StopFade(m_volumeFadeID);
@@ -330,13 +555,14 @@ namespace SaXAudio
 
         if (fade > 0)
         {
-            FLOAT current = 1.0f;
-            SourceVoice->GetVolume(&current);
+            FLOAT current = Volume;
+            if (SourceVoice)
+                SourceVoice->GetVolume(&current);
             m_volumeFadeID = Fader::Instance.StartFade(current, volume, fade, OnFadeVolume, VoiceID);
             if (m_pauseStack > 0)
                 Fader::Instance.PauseFade(m_volumeFadeID);
         }
-        else
+        else if (SourceVoice)
         {
             SourceVoice->SetVolume(volume);
         }
@@ -345,7 +571,7 @@ namespace SaXAudio
 
     void AudioVoice::SetSpeed(FLOAT speed, const FLOAT fade)
     {
-        if (!SourceVoice || !BankData || Speed == speed) return;
+        if ((!SourceVoice && !IsVirtual) || !BankData || Speed == speed) return;
         Log(BankID, VoiceID, "[SetSpeed] to: " + to_string(speed) + " fade: " + to_string(fade));
 
         // Ensure ratio is not too small
@@ -364,13 +590,14 @@ namespace SaXAudio
         else
         {
             Speed = speed;
-            SourceVoice->SetFrequencyRatio(speed);
+            if (SourceVoice)
+                SourceVoice->SetFrequencyRatio(speed);
         }
     }
 
     void AudioVoice::SetPanning(const FLOAT panning, const FLOAT fade)
     {
-        if (!SourceVoice || Panning == panning) return;
+        if ((!SourceVoice && !IsVirtual) || Panning == panning) return;
         Log(BankID, VoiceID, "[SetPanning] to: " + to_string(panning) + " fade: " + to_string(fade));
 
         Fader::Instance.StopFade(m_panningFadeID);
@@ -389,125 +616,150 @@ namespace SaXAudio
         }
     }
 
+    void AudioVoice::UpdateLevels(const UINT32 position)
+    {
+        FLOAT peak[2] = { 0, 0 };
+        FLOAT rms[2] = { 0, 0 };
+
+        UINT32 channels = BankData ? BankData->channels : 0;
+        if (IsPlaying && m_pauseStack == 0 && BankData && channels > 0 && channels <= 2 && BankData->buffer.Data)
+        {
+            // The last 10ms played, only what is decoded already
+            UINT32 end = min(position, BankData->decodedSamples.load());
+            UINT32 frames = min(end, BankData->sampleRate / 100);
+            MeasureLevels(BankData->buffer.Data + (end - frames) * channels, frames, channels, peak, rms);
+        }
+
+        // Mono is heard on both sides
+        for (UINT32 i = 0; i < 2; i++)
+        {
+            UINT32 c = channels == 2 ? i : 0;
+            PeakLevels[i] = peak[c] * Volume * Gain;
+            RMSLevels[i] = rms[c] * Volume * Gain;
+        }
+    }
+
     void AudioVoice::SetOutputMatrix(FLOAT panning)
     {
         if (!SourceVoice || !BankData) return;
 
         UINT32 sourceChannels = BankData->channels;
-        UINT32 destChannels = SaXAudio::Instance.m_masterDetails.InputChannels;
-        DWORD channelMask = SaXAudio::Instance.m_channelMask;
-        if (sourceChannels > 2 || destChannels == 0)
+        const SpeakerLayout& layout = SaXAudio::Instance.m_speakerLayout;
+        if (layout.channels == 0)
             return;
 
-        const UINT32 inChannels = 2;
-        const UINT32 outChannels = 12;
+        // Max 2x12 matrix, initialized to 0
+        FLOAT outputMatrix[2 * MAX_OUTPUT_CHANNELS] = { 0 };
 
-        // Allocate output matrix on stack (assume reasonable max channels)
-        FLOAT outputMatrix[inChannels * outChannels] = { 0 }; // Max 2x12 matrix, initialized to 0
+        // The speaker positions are cached, only the gains depend on the panning
+        if (sourceChannels == 1)
+            BuildOutputMatrix<1>(layout, panning, outputMatrix);
+        else if (sourceChannels == 2)
+            BuildOutputMatrix<2>(layout, panning, outputMatrix);
+        else
+            return;
 
-        // Find channel positions in destination (support 5.1/7.1)
-        INT32 leftChannelIndex = -1;
-        INT32 rightChannelIndex = -1;
-        INT32 centerChannelIndex = -1;
-        INT32 lfeChannelIndex = -1;
-        INT32 backLeftChannelIndex = -1;
-        INT32 backRightChannelIndex = -1;
-        INT32 sideLeftChannelIndex = -1;
-        INT32 sideRightChannelIndex = -1;
+        if (Gain != 1.0f)
+        {
+            for (UINT32 i = 0; i < sourceChannels * layout.channels; i++)
+                outputMatrix[i] *= Gain;
+        }
 
-        // Map channel mask to indices
-        DWORD currentMask = 1;
-        INT32 channelIndex = 0;
+        // Apply the output matrix to the voice
+        HRESULT hr = SourceVoice->SetOutputMatrix(OutputVoice, sourceChannels, layout.channels, outputMatrix);
+        if (FAILED(hr))
+        {
+            Log(BankID, VoiceID, "[SetOutputMatrix] Failed. Source channels: " + to_string(sourceChannels) + " Destination channels: " + to_string(layout.channels), hr);
+        }
 
-        for (UINT32 i = 0; i < outChannels && channelIndex < (INT32)destChannels; i++)
+        // The sends get the same panning scaled by their level
+        FLOAT sendMatrix[2 * MAX_OUTPUT_CHANNELS];
+        for (UINT32 i = 0; i < SendCount; i++)
         {
-            if (channelMask & currentMask)
+            for (UINT32 j = 0; j < sourceChannels * layout.channels; j++)
+                sendMatrix[j] = outputMatrix[j] * Sends[i].level;
+
+            hr = SourceVoice->SetOutputMatrix(Sends[i].voice, sourceChannels, layout.channels, sendMatrix);
+            if (FAILED(hr))
             {
-                switch (currentMask)
-                {
-                case SPEAKER_FRONT_LEFT: leftChannelIndex = channelIndex; break;
-                case SPEAKER_FRONT_RIGHT: rightChannelIndex = channelIndex; break;
-                case SPEAKER_FRONT_CENTER: centerChannelIndex = channelIndex; break;
-                case SPEAKER_LOW_FREQUENCY: lfeChannelIndex = channelIndex; break;
-                case SPEAKER_BACK_LEFT: backLeftChannelIndex = channelIndex; break;
-                case SPEAKER_BACK_RIGHT: backRightChannelIndex = channelIndex; break;
-                case SPEAKER_SIDE_LEFT: sideLeftChannelIndex = channelIndex; break;
-                case SPEAKER_SIDE_RIGHT: sideRightChannelIndex = channelIndex; break;
-                }
-                channelIndex++;
+                Log(BankID, VoiceID, "[SetOutputMatrix] Failed for send to bus " + to_string(Sends[i].busID), hr);
             }
-            currentMask <<= 1;
         }
+    }
 
-        if (sourceChannels == 1)
-        {
-            FLOAT leftGain = min(1, 1 - panning);
-            FLOAT rightGain = min(1, 1 + panning);
+    UINT32 AudioVoice::GetOutputs(XAUDIO2_SEND_DESCRIPTOR* descriptors)
+    {
+        // The descriptors must hold MAX_SENDS + 1 entries
+        descriptors[0] = { 0, OutputVoice };
+        for (UINT32 i = 0; i < SendCount; i++)
+            descriptors[i + 1] = { 0, Sends[i].voice };
+        return SendCount + 1;
+    }
+
+    BOOL AudioVoice::SetSend(const INT32 busID, const FLOAT level)
+    {
+        // The voice already outputs to its own bus
+        if (busID == BusID) return false;
 
-            if (leftChannelIndex >= 0) outputMatrix[leftChannelIndex] = leftGain;
-            if (rightChannelIndex >= 0) outputMatrix[rightChannelIndex] = rightGain;
-            if (centerChannelIndex >= 0) outputMatrix[centerChannelIndex] = 0.707f;
+        UINT32 index = 0;
+        while (index < SendCount && Sends[index].busID != busID)
+            index++;
 
-            FLOAT surroundGain = 0.5f; // -6dB
-            if (backLeftChannelIndex >= 0) outputMatrix[backLeftChannelIndex] = surroundGain * leftGain;
-            if (backRightChannelIndex >= 0) outputMatrix[backRightChannelIndex] = surroundGain * rightGain;
-            if (sideLeftChannelIndex >= 0) outputMatrix[sideLeftChannelIndex] = surroundGain * leftGain;
-            if (sideRightChannelIndex >= 0) outputMatrix[sideRightChannelIndex] = surroundGain * rightGain;
-        }
-        else if (sourceChannels == 2)
+        if (index < SendCount && level > 0)
         {
-            FLOAT LR = max(0, -panning);
-            FLOAT RL = max(0, panning);
-            FLOAT LL = min(1, 1 - panning);
-            FLOAT RR = min(1, 1 + panning);
+            // Only the level changes, no need to touch the outputs
+            Log(BankID, VoiceID, "[SetSend] bus: " + to_string(busID) + " level: " + to_string(level));
+            Sends[index].level = level;
+            SetOutputMatrix(Panning);
+            return true;
+        }
 
-            if (leftChannelIndex >= 0)
-            {
-                outputMatrix[leftChannelIndex * sourceChannels + 0] = LL;
-                outputMatrix[leftChannelIndex * sourceChannels + 1] = LR;
-            }
-            if (rightChannelIndex >= 0)
-            {
-                outputMatrix[rightChannelIndex * sourceChannels + 0] = RL;
-                outputMatrix[rightChannelIndex * sourceChannels + 1] = RR;
-            }
-            if (centerChannelIndex >= 0)
+        if (level > 0)
+        {
+            if (SendCount >= MAX_SENDS)
             {
-                outputMatrix[centerChannelIndex * sourceChannels + 0] = 0.707f;
-                outputMatrix[centerChannelIndex * sourceChannels + 1] = 0.707f;
+                Log(BankID, VoiceID, "[SetSend] Failed, too many sends");
+                return false;
             }
 
-            FLOAT surroundGain = 0.5f; // -6dB
-            if (backLeftChannelIndex >= 0)
-            {
-                outputMatrix[backLeftChannelIndex * sourceChannels + 0] = surroundGain * LL;
-                outputMatrix[backLeftChannelIndex * sourceChannels + 1] = surroundGain * LR;
-            }
-            if (backRightChannelIndex >= 0)
+            IXAudio2Voice* destination = nullptr;
+            if (busID == 0)
             {
-                outputMatrix[backRightChannelIndex * sourceChannels + 0] = surroundGain * RL;
-                outputMatrix[backRightChannelIndex * sourceChannels + 1] = surroundGain * RR;
+                destination = SaXAudio::Instance.m_masteringBus.voice;
             }
-            if (sideLeftChannelIndex >= 0)
-            {
-                outputMatrix[sideLeftChannelIndex * sourceChannels + 0] = surroundGain * LL;
-                outputMatrix[sideLeftChannelIndex * sourceChannels + 1] = surroundGain * LR;
-            }
-            if (sideRightChannelIndex >= 0)
+            else
             {
-                outputMatrix[sideRightChannelIndex * sourceChannels + 0] = surroundGain * RL;
-                outputMatrix[sideRightChannelIndex * sourceChannels + 1] = surroundGain * RR;
+                BusData* bus = SaXAudio::Instance.GetBus(busID);
+                destination = bus ? bus->voice : nullptr;
             }
+            if (!destination) return false;
+
+            Sends[SendCount++] = { busID, destination, level };
+        }
+        else if (index < SendCount)
+        {
+            Sends[index] = Sends[--SendCount];
+        }
+        else
+        {
+            return true;
         }
 
-        // LFE channel gets no direct signal (would need bass management for proper implementation)
+        Log(BankID, VoiceID, "[SetSend] bus: " + to_string(busID) + " level: " + to_string(level) + " sends: " + to_string(SendCount));
 
-        // Apply the output matrix to the voice
-        HRESULT hr = SourceVoice->SetOutputMatrix(nullptr, sourceChannels, destChannels, outputMatrix);
+        // A virtual voice gets its sends when the source voice is created
+        if (!SourceVoice) return true;
+
+        XAUDIO2_SEND_DESCRIPTOR descriptors[MAX_SENDS + 1];
+        XAUDIO2_VOICE_SENDS sends = { GetOutputs(descriptors), descriptors };
+        HRESULT hr = SourceVoice->SetOutputVoices(&sends);
         if (FAILED(hr))
         {
-            Log(BankID, VoiceID, "[SetOutputMatrix] Failed. Source channels: " + to_string(sourceChannels) + " Destination channels: " + to_string(destChannels), hr);
+            Log(BankID, VoiceID, "[SetSend] Failed to set the output voices", hr);
+            return false;
         }
+        SetOutputMatrix(Panning);
+        return true;
     }
 
     void AudioVoice::Reset()
@@ -523,31 +775,155 @@ namespace SaXAudio
         m_pauseFadeID = 0;
 
         m_pauseStack = 0;
-        m_positionOffset = 0;
         m_volumeTarget = 0;
 
-        m_tempFlush = 0;
+        m_plan = SegmentPlan();
+        m_previousPlan = SegmentPlan();
+        m_loopChangePending = false;
+        m_segmented = false;
+
+        // Callbacks from the previous source voice must not affect the next one
+        m_bufferToken++;
+        m_virtualPosition = 0;
+        m_virtualPlayed = 0;
+        m_segmentOffset = 0;
 
         Buffer = { 0 };
         BankID = 0;
         BusID = 0;
 
+        BusLink = VoiceLink();
+        BankLink = VoiceLink();
+
+        OutputVoice = nullptr;
+        SendCount = 0;
+
         SourceVoice = nullptr;
         BankData = nullptr;
         Volume = 1.0f;
         Speed = 1.0f;
         Panning = 0.0f;
+        Gain = 1.0f;
         LoopStart = 0;
         LoopEnd = 0;
         Looping = false;
         IsPlaying = false;
+        IsStopping = false;
+        IsFinishing = false;
+        Position = 0;
+        SegmentIndex = 0;
+        Priority = 0;
+        IsVirtual = false;
+        IsScheduled = false;
+        SeamlessLoops = false;
+
+        for (UINT32 i = 0; i < 2; i++)
+        {
+            PeakLevels[i] = 0;
+            RMSLevels[i] = 0;
+        }
+    }
+
+    void AudioVoice::Virtualize()
+    {
+        // Stopping voices are about to be removed anyway
+        if (IsVirtual || !SourceVoice || IsStopping) return;
+
+        // Remember where the voice is, the position keeps advancing without a source voice
+        m_virtualPosition = IsPlaying ? (double)CalculateCurrentPosition() : 0;
+        if (m_segmented && IsPlaying && BankData)
+        {
+            // Where the voice is in its plan, the plan starts over from there
+            XAUDIO2_VOICE_STATE state;
+            SourceVoice->GetState(&state);
+            SegmentPlan plan = PlanRemainder(m_plan, state.SamplesPlayed, BankData->totalSamples);
+            m_segmentOffset += m_plan.count - plan.count;
+            m_plan = plan;
+            m_virtualPlayed = 0;
+        }
+
+        // Callbacks still coming from the destroyed source voice must be ignored
+        m_bufferToken++;
+
+        IXAudio2SourceVoice* sourceVoice = SourceVoice;
+        SourceVoice = nullptr;
+        IsVirtual = true;
+        sourceVoice->DestroyVoice();
+        SaXAudio::Instance.m_realVoiceCount--;
+
+        // Nothing runs the echo without a source voice, another voice can use it
+        SaXAudio::Instance.DetachEcho(nullptr, &EffectData);
+
+        Log(BankID, VoiceID, "[Virtualize] at: " + to_string(m_virtualPosition));
+    }
+
+    BOOL AudioVoice::Devirtualize()
+    {
+        if (!IsVirtual || !BankData) return false;
+
+        BusData* bus = BusID ? SaXAudio::Instance.GetBus(BusID) : nullptr;
+        HRESULT hr = SaXAudio::Instance.CreateSourceVoice(this, bus);
+        if (FAILED(hr))
+        {
+            Log(BankID, VoiceID, "[Devirtualize] Failed to create source voice", hr);
+            return false;
+        }
+
+        IsVirtual = false;
+        SaXAudio::Instance.m_realVoiceCount++;
+        Log(BankID, VoiceID, "[Devirtualize] at: " + to_string(m_virtualPosition));
+
+        // Restore the state of the voice, running fades will continue from there
+        SourceVoice->SetVolume(Volume);
+        SourceVoice->SetFrequencyRatio(Speed);
+        SetOutputMatrix(Panning);
+        SaXAudio::Instance.RestoreEffects(this);
+
+        if (IsPlaying && m_segmented)
+        {
+            SegmentPlan plan = PlanRemainder(m_plan, (UINT64)m_virtualPlayed, BankData->totalSamples);
+            m_segmentOffset += m_plan.count - plan.count;
+            return plan.count > 0 && StartPlan(plan, false, 0, XAUDIO2_COMMIT_NOW);
+        }
+        if (IsPlaying && m_virtualPosition < 0)
+            return Start(0, false, (UINT32)-m_virtualPosition);
+        if (IsPlaying)
+            return Start((UINT32)m_virtualPosition, false);
+        return true;
+    }
+
+    BOOL AudioVoice::AdvanceVirtual(const FLOAT elapsed)
+    {
+        if (!IsVirtual || !IsPlaying || m_pauseStack > 0 || !BankData) return false;
+
+        if (m_segmented)
+        {
+            // The regions play one after the other with their loops
+            m_virtualPlayed += elapsed * BankData->sampleRate * Speed;
+            if (m_virtualPlayed >= (double)GetPlanDuration(m_plan, BankData->totalSamples))
+                return true;
+            m_virtualPosition = (double)GetPlanPosition(m_plan, (UINT64)m_virtualPlayed, BankData->totalSamples);
+            return false;
+        }
+
+        m_virtualPosition += elapsed * BankData->sampleRate * Speed;
+
+        if (Looping && LoopEnd > LoopStart && m_virtualPosition >= LoopEnd)
+        {
+            // We are somewhere in the loop
+            m_virtualPosition = LoopStart + fmod(m_virtualPosition - LoopStart, (double)(LoopEnd - LoopStart));
+        }
+
+        // Reached the end of the buffer
+        return !Looping && m_virtualPosition >= BankData->totalSamples;
     }
 
     void AudioVoice::OnFadeVolume(INT64 voiceID, UINT32 count, FLOAT* newValues, BOOL hasFinished)
     {
         AudioVoice* voice = SaXAudio::Instance.GetVoice((INT32)voiceID);
         if (!voice) return;
-        voice->SourceVoice->SetVolume(newValues[0]);
+        if (voice->SourceVoice)
+            voice->SourceVoice->SetVolume(newValues[0]);
 
         if (hasFinished)
         {
@@ -558,7 +934,8 @@ namespace SaXAudio
                 if (voice->m_pauseStack > 0)
                 {
                     // Pause
-                    voice->SourceVoice->Stop();
+                    if (voice->SourceVoice)
+                        voice->SourceVoice->Stop();
                     Log(voice->BankID, voice->VoiceID, "[OnFadeVolume] Pause");
                 }
                 else
@@ -575,9 +952,8 @@ namespace SaXAudio
                 voice->m_volumeFadeID = 0;
             }
 
-            if (!voice->IsPlaying)
+            if (!voice->IsPlaying && voice->IsStopping && voice->SourceVoice)
             {
-                voice->m_tempFlush = 0;
                 voice->SourceVoice->Stop();
                 voice->SourceVoice->FlushSourceBuffers();
                 Log(voice->BankID, voice->VoiceID, "[OnFadeVolume] Stop");
@@ -590,7 +966,8 @@ namespace SaXAudio
         AudioVoice* voice = SaXAudio::Instance.GetVoice((INT32)voiceID);
         if (!voice) return;
         voice->Speed = newValues[0];
-        voice->SourceVoice->SetFrequencyRatio(newValues[0]);
+        if (voice->SourceVoice)
+            voice->SourceVoice->SetFrequencyRatio(newValues[0]);
 
         if (hasFinished)
             voice->m_speedFadeID = 0;
@@ -609,15 +986,36 @@ namespace SaXAudio
 
     void __stdcall AudioVoice::OnBufferEnd(void* pBufferContext)
     {
+        // The lead in of a scheduled start, the sound itself follows
+        if (pBufferContext == LEAD_IN_CONTEXT)
+            return;
+
+        // The voice only finished when its last segment ended
+        IXAudio2SourceVoice* sourceVoice = SourceVoice;
+        if (sourceVoice && pBufferContext == (void*)(UINT_PTR)m_bufferToken.load())
+        {
+            XAUDIO2_VOICE_STATE state;
+            sourceVoice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+            if (state.BuffersQueued > 0)
+                return;
+        }
+
         // We don't want to do anything when temporary flushing the buffer
-        if (m_tempFlush > 0)
+        // The flushed buffer carries the token it was submitted with, which is outdated by then
+        if (pBufferContext != (void*)(UINT_PTR)m_bufferToken.load())
         {
             Log(BankID, VoiceID, "[OnBufferEnd] Flush reset");
-            m_tempFlush--;
             return;
         }
         Log(BankID, VoiceID, "[OnBufferEnd] Voice finished playing");
 
-        SaXAudio::Instance.RemoveVoice(VoiceID);
+        // Called on the XAudio thread, the voice is removed by the control thread
+        SaXAudio::Instance.FinishVoice(VoiceID);
+    }
+
+    void __stdcall AudioVoice::OnVoiceError(void* pBufferContext, HRESULT error)
+    {
+        Log(BankID, VoiceID, "[OnVoiceError]", error);
+        EventQueue::Instance.Push(EVENT_VOICE_ERROR, VoiceID, BankID, error);
     }
-}
+}
\ No newline at end of file
@@ -24,10 +24,14 @@
 
 #include "Includes.h"
 #include "Structs.h"
+#include "SegmentPlanner.h"
 
 namespace SaXAudio
 {
-    typedef void (*OnFinishedCallback)(INT32 voiceID);
+    // Context of the silent buffer submitted before a scheduled start, never matches a buffer token
+#define LEAD_IN_CONTEXT ((void*)UINTPTR_MAX)
+    // Buses a voice can send to besides its own
+#define MAX_SENDS 4
 
     class AudioVoice : public IXAudio2VoiceCallback
     {
@@ -38,33 +42,85 @@ namespace SaXAudio
         UINT32 m_pauseFadeID = 0;
 
         atomic<UINT32> m_pauseStack = 0;
-        INT64 m_positionOffset = 0;
         FLOAT m_volumeTarget = 0;
 
-        atomic<UINT32> m_tempFlush = 0;
+        // Segments queued on the source voice, the previous plan plays until the loop exits into the current one
+        SegmentPlan m_plan;
+        SegmentPlan m_previousPlan;
+        BOOL m_loopChangePending = false;
+        // Playing the regions given to StartSegments, a plain start from the position can't resume it
+        BOOL m_segmented = false;
+
+        // Identifies the buffer currently submitted, OnBufferEnd ignores flushed buffers carrying an older token
+        atomic<UINT32> m_bufferToken = 0;
+
+        // Position tracked while the voice is virtual
+        double m_virtualPosition = 0;
+        // Samples of m_plan played while a segmented voice is virtual
+        double m_virtualPlayed = 0;
+        // Regions dropped from the plan when it was resumed, GetSegmentIndex counts from the first region
+        UINT32 m_segmentOffset = 0;
     public:
-        BankData* BankData = nullptr;
+        SaXAudio::BankData* BankData = nullptr;
         IXAudio2SourceVoice* SourceVoice = nullptr;
         XAUDIO2_BUFFER Buffer = { 0 };
 
         INT32 BankID = 0;
-        INT32 VoiceID = 0;
+        atomic<INT32> VoiceID = 0;
         INT32 BusID = 0;
 
-        FLOAT Volume = 1.0f;
-        FLOAT Speed = 1.0f;
-        FLOAT Panning = 0.0f;
+        UINT32 Generation = 0;
+        // The voiceID handed out by CreateVoice until the control thread creates the voice
+        atomic<INT32> ReservedID = 0;
+        // Readers outside of the control thread holding the voice, RemoveVoice waits for them
+        atomic<UINT32> Pins = 0;
 
-        EffectData EffectData;
+        VoiceLink BusLink;
+        VoiceLink BankLink;
 
-        UINT32 LoopStart = 0;
-        UINT32 LoopEnd = 0;
+        // Written by the control thread, atomic so the getters can read them from any thread
+        atomic<FLOAT> Volume = 1.0f;
+        atomic<FLOAT> Speed = 1.0f;
+        atomic<FLOAT> Panning = 0.0f;
+        // Loudness normalization of the bank, applied through the output matrix
+        FLOAT Gain = 1.0f;
+
+        SaXAudio::EffectData EffectData;
+
+        // The bus or mastering voice the source voice outputs to
+        IXAudio2Voice* OutputVoice = nullptr;
+        VoiceSend Sends[MAX_SENDS];
+        UINT32 SendCount = 0;
+
+        atomic<UINT32> LoopStart = 0;
+        atomic<UINT32> LoopEnd = 0;
 
         atomic<BOOL> Looping = false;
         atomic<BOOL> IsPlaying = false;
         BOOL IsProtected = false;
-
-        BOOL Start(const UINT32 atSample = 0, BOOL flush = true);
+        BOOL IsStopping = false;
+        // The voice ended or failed outside of the control thread, it is removed by the next control tick
+        atomic<BOOL> IsFinishing = false;
+
+        // Voices with higher priority keep their source voice over quieter ones
+        UINT32 Priority = 0;
+        // The voice has no source voice and only tracks its position
+        atomic<BOOL> IsVirtual = false;
+        // The voice waits for the engine to reach the time given to StartAtEngineTime
+        atomic<BOOL> IsScheduled = false;
+        // Loop changes wait for the end of the current loop instead of flushing the voice
+        BOOL SeamlessLoops = false;
+
+        // Play cursor and segment as of the last control tick, for the getters
+        atomic<UINT32> Position = 0;
+        atomic<UINT32> SegmentIndex = 0;
+
+        // Estimated from the bank buffer around the play cursor, refreshed by the control thread
+        atomic<FLOAT> PeakLevels[2] = {};
+        atomic<FLOAT> RMSLevels[2] = {};
+
+        BOOL Start(const UINT32 atSample = 0, BOOL flush = true, const UINT32 leadIn = 0, const UINT32 operationSet = XAUDIO2_COMMIT_NOW);
+        BOOL StartSegments(const PlaybackSegment* segments, const UINT32 count);
         BOOL Stop(const FLOAT fade = 0.0f);
 
         UINT32 Pause(const FLOAT fade = 0.0f);
@@ -72,19 +128,31 @@ namespace SaXAudio
         UINT32 GetPauseStack();
 
         UINT32 GetPosition();
+        UINT32 GetSegmentIndex();
+        // Position and segment index from a single read of the source voice state
+        void GetPlayback(UINT32& position, UINT32& segmentIndex);
+        void UpdateLevels(const UINT32 position);
 
         void ChangeLoopPoints(const UINT32 start, const UINT32 end);
         void SetLooping(BOOL state);
+        BOOL ApplyLoopChange();
 
         void SetVolume(const FLOAT volume, const FLOAT fade = 0);
         void SetSpeed(FLOAT speed, const FLOAT fade = 0);
         void SetPanning(FLOAT panning, const FLOAT fade = 0);
+        BOOL SetSend(const INT32 busID, const FLOAT level);
 
         void Reset();
         void SetOutputMatrix(const FLOAT panning);
+        UINT32 GetOutputs(XAUDIO2_SEND_DESCRIPTOR* descriptors);
+
+        void Virtualize();
+        BOOL Devirtualize();
+        BOOL AdvanceVirtual(const FLOAT elapsed);
 
         // Callbacks
         void __stdcall OnBufferEnd(void* pBufferContext) override;
+        void __stdcall OnVoiceError(void* pBufferContext, HRESULT error) override;
 
         // Required methods (not used)
         void __stdcall OnVoiceProcessingPassStart(UINT32) override {}
@@ -92,11 +160,14 @@ namespace SaXAudio
         void __stdcall OnStreamEnd() override {}
         void __stdcall OnBufferStart(void*) override {}
         void __stdcall OnLoopEnd(void*) override {}
-        void __stdcall OnVoiceError(void*, HRESULT) override {}
 
     private:
         UINT64 CalculateCurrentPosition();
-        static void WaitForDecoding(AudioVoice* voice);
+        UINT64 CalculatePosition(const UINT64 samplesPlayed);
+        UINT32 CalculateSegmentIndex(const UINT64 samplesPlayed);
+        BOOL StartPlan(const SegmentPlan& plan, BOOL flush, const UINT32 leadIn, const UINT32 operationSet);
+        HRESULT SubmitPlan(const SegmentPlan& plan);
+        void RequestLoopChange();
 
         static void OnFadeVolume(INT64 voiceID, UINT32 count, FLOAT* newValues, BOOL hasFinished);
         static void OnFadeSpeed(INT64 voiceID, UINT32 count, FLOAT* newValues, BOOL hasFinished);
@@ -0,0 +1,117 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "Benchmark.h"
+
+namespace SaXAudio
+{
+    void Benchmark::Add(const string& name, const vector<BenchmarkMetric>& metrics)
+    {
+        m_results.push_back({ name, metrics });
+    }
+
+    void Benchmark::Print()
+    {
+        for (const BenchmarkResult& result : m_results)
+        {
+            printf("%-44s", result.name.c_str());
+            for (const BenchmarkMetric& metric : result.metrics)
+                printf(" %s=%.6g", metric.name.c_str(), metric.value);
+            printf("\n");
+        }
+    }
+
+    BOOL Benchmark::WriteJson(const string& path, const string& build)
+    {
+        ofstream file(path);
+        if (!file)
+            return false;
+
+        file << "{\n";
+        file << "  \"build\": \"" << build << "\",\n";
+        file << "  \"quick\": " << (m_quick ? "true" : "false") << ",\n";
+        file << "  \"hardware_threads\": " << thread::hardware_concurrency() << ",\n";
+        file << "  \"results\": [\n";
+        for (size_t i = 0; i < m_results.size(); i++)
+        {
+            const BenchmarkResult& result = m_results[i];
+            file << "    { \"name\": \"" << result.name << "\"";
+            for (const BenchmarkMetric& metric : result.metrics)
+            {
+                // JSON has no infinity or NaN
+                double value = isfinite(metric.value) ? metric.value : 0;
+                file << ", \"" << metric.name << "\": " << setprecision(6) << value;
+            }
+            file << " }" << (i + 1 < m_results.size() ? "," : "") << "\n";
+        }
+        file << "  ]\n";
+        file << "}\n";
+        return (BOOL)file.good();
+    }
+}
+
+using namespace SaXAudio;
+
+int main(int argc, char** argv)
+{
+    BOOL quick = false;
+    string json = "benchmarks.json";
+    string filter;
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        if (argument == "--quick")
+            quick = true;
+        else if (argument == "--json" && i + 1 < argc)
+            json = argv[++i];
+        else if (argument == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else
+        {
+            printf("Usage: %s [--quick] [--json path] [--filter dsp|engine]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Benchmark benchmark(quick);
+    if (filter.empty() || filter == "dsp")
+        RunDspBenchmarks(benchmark);
+    if (filter.empty() || filter == "engine")
+        RunEngineBenchmarks(benchmark);
+
+    benchmark.Print();
+
+#ifdef NDEBUG
+    const string build = "release";
+#else
+    const string build = "debug";
+#endif
+    if (!benchmark.WriteJson(json, build))
+    {
+        printf("Failed to write %s\n", json.c_str());
+        return 1;
+    }
+    printf("Results written to %s\n", json.c_str());
+    return 0;
+}
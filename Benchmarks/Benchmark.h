@@ -0,0 +1,111 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+    struct BenchmarkMetric
+    {
+        string name;
+        double value;
+    };
+
+    struct BenchmarkResult
+    {
+        string name;
+        vector<BenchmarkMetric> metrics;
+    };
+
+    // Median time of a few runs, each run repeats the operation long enough to be measured
+    struct BenchmarkTiming
+    {
+        double nanoseconds = 0;     // Per call, median of the runs
+        double best = 0;            // Per call, fastest run
+        UINT64 calls = 0;           // Per run
+    };
+
+    class Benchmark
+    {
+    private:
+        BOOL m_quick;
+        vector<BenchmarkResult> m_results;
+
+    public:
+        static constexpr UINT32 RUNS = 5;
+
+        Benchmark(const BOOL quick) : m_quick(quick) {}
+
+        // Quick runs only check that everything works, the numbers are not meaningful
+        BOOL IsQuick() { return m_quick; }
+        double GetRunTime() { return m_quick ? 0.002 : 0.1; }
+
+        template<class Operation>
+        BenchmarkTiming Time(Operation operation);
+
+        void Add(const string& name, const vector<BenchmarkMetric>& metrics);
+        void Print();
+        BOOL WriteJson(const string& path, const string& build);
+    };
+
+    template<class Operation>
+    BenchmarkTiming Benchmark::Time(Operation operation)
+    {
+        typedef chrono::steady_clock Clock;
+
+        // Double the calls until a run is long enough
+        BenchmarkTiming timing;
+        UINT64 calls = 1;
+        while (true)
+        {
+            auto start = Clock::now();
+            for (UINT64 i = 0; i < calls; i++)
+                operation();
+            double seconds = chrono::duration<double>(Clock::now() - start).count();
+            if (seconds >= GetRunTime() || calls >= (1ull << 32))
+                break;
+            calls *= 2;
+        }
+
+        double runs[RUNS];
+        for (UINT32 r = 0; r < RUNS; r++)
+        {
+            auto start = Clock::now();
+            for (UINT64 i = 0; i < calls; i++)
+                operation();
+            runs[r] = chrono::duration<double, nano>(Clock::now() - start).count() / calls;
+        }
+        sort(runs, runs + RUNS);
+
+        timing.nanoseconds = runs[RUNS / 2];
+        timing.best = runs[0];
+        timing.calls = calls;
+        return timing;
+    }
+
+    // Each file of benchmarks adds its results
+    void RunDspBenchmarks(Benchmark& benchmark);
+    void RunEngineBenchmarks(Benchmark& benchmark);
+}
@@ -0,0 +1,288 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "Benchmark.h"
+#include "Dsp.h"
+#include "OutputMatrix.h"
+
+namespace SaXAudio
+{
+    static volatile FLOAT s_sink;
+
+    void BenchmarkConversion(Benchmark& benchmark)
+    {
+        // One second of stereo at 48kHz
+        const UINT32 samples = 48000 * 2;
+        vector<BYTE> pcm(samples * 4);
+        vector<FLOAT> output(samples);
+        mt19937 random(1);
+        for (BYTE& byte : pcm)
+            byte = (BYTE)random();
+
+        struct Format
+        {
+            const char* name;
+            function<void()> convert;
+        };
+        const Format formats[] =
+        {
+            { "pcm_convert/8bit", [&] { ConvertPCM8ToFloat(pcm.data(), output.data(), samples); } },
+            { "pcm_convert/16bit", [&] { ConvertPCM16ToFloat((const INT16*)pcm.data(), output.data(), samples); } },
+            { "pcm_convert/24bit", [&] { ConvertPCM24ToFloat(pcm.data(), output.data(), samples); } },
+            { "pcm_convert/32bit", [&] { ConvertPCM32ToFloat((const INT32*)pcm.data(), output.data(), samples); } },
+        };
+
+        for (const Format& format : formats)
+        {
+            BenchmarkTiming timing = benchmark.Time(format.convert);
+            s_sink = output[samples - 1];
+            benchmark.Add(format.name, {
+                { "ns_per_call", timing.nanoseconds },
+                { "ns_per_sample", timing.nanoseconds / samples },
+                { "msamples_per_second", samples / timing.nanoseconds * 1000.0 },
+                });
+        }
+    }
+
+    void BenchmarkOutputMatrix(Benchmark& benchmark)
+    {
+        struct Layout
+        {
+            const char* name;
+            DWORD mask;
+            UINT32 channels;
+        };
+        const Layout layouts[] =
+        {
+            { "stereo", SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT, 2 },
+            { "5.1", 0x3F, 6 },
+            { "7.1", 0x63F, 8 },
+        };
+
+        for (const Layout& layout : layouts)
+        {
+            SpeakerLayout speakers;
+            speakers.Init(layout.mask, layout.channels);
+
+            for (UINT32 source = 1; source <= 2; source++)
+            {
+                // Same as AudioVoice::SetOutputMatrix, the matrix starts cleared and the panning changes every call
+                FLOAT panning = -1.0f;
+                auto build = [&](const BOOL cached)
+                {
+                    FLOAT matrix[2 * MAX_OUTPUT_CHANNELS] = { 0 };
+                    panning = panning < 1.0f ? panning + 0.01f : -1.0f;
+
+                    // Without the cache the layout was found from the channel mask on every call
+                    SpeakerLayout uncached;
+                    if (!cached)
+                        uncached.Init(layout.mask, layout.channels);
+                    const SpeakerLayout& used = cached ? speakers : uncached;
+
+                    if (source == 1)
+                        BuildOutputMatrix<1>(used, panning, matrix);
+                    else
+                        BuildOutputMatrix<2>(used, panning, matrix);
+                    s_sink = matrix[source * layout.channels - 1];
+                };
+
+                string name = string("output_matrix/") + layout.name + "/" + to_string(source) + "ch";
+                BenchmarkTiming cached = benchmark.Time([&] { build(true); });
+                BenchmarkTiming uncached = benchmark.Time([&] { build(false); });
+                benchmark.Add(name, {
+                    { "ns_per_call", cached.nanoseconds },
+                    { "ns_per_call_layout_lookup", uncached.nanoseconds },
+                    });
+            }
+        }
+    }
+
+    void BenchmarkLevels(Benchmark& benchmark)
+    {
+        // 10ms at 48kHz, what a voice or a meter measures every tick
+        const UINT32 frames = 480;
+        vector<FLOAT> samples(frames * 6);
+        mt19937 random(1);
+        uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+        for (FLOAT& sample : samples)
+            sample = distribution(random);
+
+        for (UINT32 channels : { 1u, 2u, 6u })
+        {
+            FLOAT peak[6];
+            FLOAT rms[6];
+            BenchmarkTiming timing = benchmark.Time([&] { MeasureLevels(samples.data(), frames, channels, peak, rms); });
+            s_sink = peak[0] + rms[channels - 1];
+
+            // The plain loop used above 2 channels, for comparison
+            BenchmarkTiming scalar = benchmark.Time([&]
+            {
+                for (UINT32 c = 0; c < channels; c++)
+                {
+                    peak[c] = 0;
+                    rms[c] = 0;
+                }
+                for (UINT32 i = 0; i < frames * channels; i++)
+                {
+                    UINT32 c = i % channels;
+                    peak[c] = max(peak[c], fabsf(samples[i]));
+                    rms[c] += samples[i] * samples[i];
+                }
+                for (UINT32 c = 0; c < channels; c++)
+                    rms[c] = sqrtf(rms[c] / frames);
+            });
+            s_sink = peak[0] + rms[channels - 1];
+
+            benchmark.Add("levels/" + to_string(channels) + "ch", {
+                { "ns_per_call", timing.nanoseconds },
+                { "ns_per_call_scalar", scalar.nanoseconds },
+                { "ns_per_frame", timing.nanoseconds / frames },
+                });
+        }
+    }
+
+    void BenchmarkLoudness(Benchmark& benchmark)
+    {
+        // One second of audio at 48kHz, fed in decoder sized chunks
+        const UINT32 frames = 48000;
+        const UINT32 chunk = 4096;
+        vector<FLOAT> samples(frames * 2);
+        mt19937 random(1);
+        uniform_real_distribution<FLOAT> distribution(-0.5f, 0.5f);
+        for (FLOAT& sample : samples)
+            sample = distribution(random);
+
+        for (UINT32 channels : { 1u, 2u })
+        {
+            LoudnessMeter meter;
+            BenchmarkTiming timing = benchmark.Time([&]
+            {
+                meter.Init(channels, 48000);
+                for (UINT32 i = 0; i < frames; i += chunk)
+                    meter.Process(samples.data() + i * channels, min(chunk, frames - i));
+                s_sink = meter.GetLoudness() + meter.GetTruePeak();
+            });
+
+            // How much faster than real time a bank is analyzed while decoding
+            benchmark.Add("loudness/" + to_string(channels) + "ch", {
+                { "ns_per_call", timing.nanoseconds },
+                { "ns_per_frame", timing.nanoseconds / frames },
+                { "realtime_factor", 1e9 / timing.nanoseconds },
+                });
+        }
+    }
+
+    void BenchmarkConvolution(Benchmark& benchmark)
+    {
+        mt19937 random(1);
+        uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+
+        // Stereo impulse responses, processed in passes of 480 frames like a bus at 48kHz
+        const UINT32 frames = 480;
+        vector<FLOAT> noise(frames * 2);
+        vector<FLOAT> samples(frames * 2);
+        for (FLOAT& sample : noise)
+            sample = distribution(random) * 0.1f;
+
+        for (FLOAT seconds : { 0.5f, 2.0f })
+        {
+            UINT32 length = (UINT32)(seconds * 48000);
+            vector<FLOAT> response(length * 2);
+            for (UINT32 i = 0; i < length * 2; i++)
+                response[i] = distribution(random) * expf(-6.0f * i / (length * 2));
+
+            ConvolutionEngine engine(response.data(), length, 2, 2);
+            BenchmarkTiming timing = benchmark.Time([&]
+            {
+                // The engine processes in place, the input is the same every pass
+                copy(noise.begin(), noise.end(), samples.begin());
+                engine.Process(samples.data(), frames, 0.5f, 0.5f);
+            });
+            s_sink = samples[0];
+
+            char name[64];
+            snprintf(name, sizeof(name), "convolution/%.1fs_stereo", seconds);
+            benchmark.Add(name, {
+                { "ns_per_pass", timing.nanoseconds },
+                { "cpu_ms_per_second", timing.nanoseconds * (48000.0 / frames) / 1e6 },
+                });
+        }
+    }
+
+    void BenchmarkDynamics(Benchmark& benchmark)
+    {
+        // Stereo passes of 480 frames, loud enough for both to reduce all the time
+        const UINT32 frames = 480;
+        vector<FLOAT> noise(frames * 2);
+        vector<FLOAT> samples(frames * 2);
+        mt19937 random(1);
+        uniform_real_distribution<FLOAT> distribution(-2.0f, 2.0f);
+        for (FLOAT& sample : noise)
+            sample = distribution(random);
+
+        LimiterEngine limiter;
+        limiter.Init(2, 48000);
+        BenchmarkTiming timing = benchmark.Time([&]
+        {
+            copy(noise.begin(), noise.end(), samples.begin());
+            limiter.Process(samples.data(), frames);
+        });
+        s_sink = samples[0];
+
+        benchmark.Add("dynamics/limiter", {
+            { "ns_per_pass", timing.nanoseconds },
+            { "ns_per_frame", timing.nanoseconds / frames },
+            });
+
+        for (BOOL rms : { false, true })
+        {
+            CompressorEngine compressor;
+            compressor.Init(2, 48000);
+            CompressorParameters parameters;
+            parameters.RMS = rms;
+            compressor.SetParameters(parameters);
+            timing = benchmark.Time([&]
+            {
+                copy(noise.begin(), noise.end(), samples.begin());
+                compressor.Process(samples.data(), frames, -1.0f);
+            });
+            s_sink = samples[0];
+
+            benchmark.Add(rms ? "dynamics/compressor_rms" : "dynamics/compressor", {
+                { "ns_per_pass", timing.nanoseconds },
+                { "ns_per_frame", timing.nanoseconds / frames },
+                });
+        }
+    }
+
+    void RunDspBenchmarks(Benchmark& benchmark)
+    {
+        BenchmarkConversion(benchmark);
+        BenchmarkOutputMatrix(benchmark);
+        BenchmarkLevels(benchmark);
+        BenchmarkLoudness(benchmark);
+        BenchmarkConvolution(benchmark);
+        BenchmarkDynamics(benchmark);
+    }
+}
@@ -0,0 +1,301 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "Benchmark.h"
+#include "VorbisWriter.h"
+#include "SaXAudio.h"
+#include "Fader.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    typedef chrono::steady_clock Clock;
+
+    static atomic<UINT32> s_decoded = 0;
+
+    static void OnDecoded(INT32 bankID, const BYTE* buffer)
+    {
+        s_decoded++;
+    }
+
+    static void OnFadeNothing(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
+    {
+    }
+
+    // A bank of a sine, without going through a file
+    INT32 AddSineBank(const UINT32 channels, const UINT32 sampleRate, const UINT32 frames)
+    {
+        Buffer buffer = SaXAudio::Instance.GetBuffer(frames * channels);
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            for (UINT32 c = 0; c < channels; c++)
+                buffer.Data[i * channels + c] = 0.5f * sinf(2.0f * 3.14159265f * 440.0f * i / sampleRate);
+        }
+        return SaXAudio::Instance.AddBankData(buffer, channels, sampleRate, frames);
+    }
+
+    double Median(vector<double> values)
+    {
+        sort(values.begin(), values.end());
+        return values.empty() ? 0 : values[values.size() / 2];
+    }
+
+    void BenchmarkDecode(Benchmark& benchmark)
+    {
+        const UINT32 sampleRate = 48000;
+        const FLOAT seconds = benchmark.IsQuick() ? 1.0f : 10.0f;
+        const UINT32 runs = benchmark.IsQuick() ? 1 : Benchmark::RUNS;
+        vector<BYTE> ogg = VorbisWriter::Write(2, sampleRate, seconds);
+
+        // Offline the bank is decoded before BankAddOgg returns
+        double single = 0;
+        CreateOffline(2, sampleRate);
+        for (BOOL loudness : { false, true })
+        {
+            SetLoudnessAnalysis(loudness);
+
+            vector<double> times;
+            for (UINT32 r = 0; r < runs; r++)
+            {
+                auto start = Clock::now();
+                INT32 bankID = BankAddOgg(ogg.data(), (UINT32)ogg.size());
+                times.push_back(chrono::duration<double>(Clock::now() - start).count());
+                BankRemove(bankID);
+            }
+
+            double time = Median(times);
+            if (!loudness)
+                single = seconds / time;
+            benchmark.Add(loudness ? "decode_ogg/single_loudness" : "decode_ogg/single", {
+                { "ms_per_decode", time * 1000.0 },
+                { "audio_seconds", seconds },
+                { "realtime_factor", seconds / time },
+                { "kbps", ogg.size() * 8 / seconds / 1000.0 },
+                });
+        }
+        SetLoudnessAnalysis(false);
+        Release();
+
+        // One bank per hardware thread, each decoded by its own thread
+        const UINT32 threads = max(1u, thread::hardware_concurrency());
+        CreateSoftware(2, sampleRate);
+        vector<double> times;
+        for (UINT32 r = 0; r < runs; r++)
+        {
+            s_decoded = 0;
+            vector<INT32> bankIDs;
+            auto start = Clock::now();
+            for (UINT32 t = 0; t < threads; t++)
+                bankIDs.push_back(BankAddOgg(ogg.data(), (UINT32)ogg.size(), OnDecoded));
+            while (s_decoded < threads)
+                this_thread::sleep_for(chrono::microseconds(100));
+            times.push_back(chrono::duration<double>(Clock::now() - start).count());
+
+            for (INT32 bankID : bankIDs)
+                BankRemove(bankID);
+        }
+        Release();
+
+        double perCore = seconds / Median(times);
+        benchmark.Add("decode_ogg/parallel", {
+            { "threads", (double)threads },
+            { "realtime_factor_total", perCore * threads },
+            { "realtime_factor_per_core", perCore },
+            { "scaling", perCore / single },
+            });
+    }
+
+    void BenchmarkBufferPool(Benchmark& benchmark)
+    {
+        // Sizes of banks from short sounds to music, each a bit off the power of 2 the pool rounds to
+        const UINT32 sizes[] = { 900, 3000, 20000, 48000, 100000, 500000, 960000, 2000000 };
+        const UINT32 outstanding = 32;
+
+        CreateOffline(2, 48000);
+
+        auto churn = [&](const UINT32 seed, const UINT64 operations)
+        {
+            mt19937 random(seed);
+            vector<Buffer> held;
+            for (UINT32 i = 0; i < outstanding; i++)
+                held.push_back(SaXAudio::Instance.GetBuffer(sizes[random() % 8]));
+
+            UINT32 index = 0;
+            auto operation = [&]
+            {
+                SaXAudio::Instance.ReturnBuffer(held[index]);
+                held[index] = SaXAudio::Instance.GetBuffer(sizes[random() % 8]);
+                index = (index + 1) % outstanding;
+            };
+
+            BenchmarkTiming timing;
+            if (operations == 0)
+                timing = benchmark.Time(operation);
+            else
+            {
+                for (UINT64 i = 0; i < operations; i++)
+                    operation();
+            }
+
+            for (Buffer& buffer : held)
+                SaXAudio::Instance.ReturnBuffer(buffer);
+            return timing;
+        };
+
+        BenchmarkTiming timing = churn(1, 0);
+        benchmark.Add("buffer_pool/churn", {
+            { "ns_per_return_get", timing.nanoseconds },
+            });
+
+        // Banks added from several threads at once
+        const UINT32 threads = max(2u, thread::hardware_concurrency());
+        const UINT64 operations = benchmark.IsQuick() ? 1000 : 200000;
+        vector<thread> workers;
+        auto start = Clock::now();
+        for (UINT32 t = 0; t < threads; t++)
+            workers.emplace_back([&churn, t, operations] { churn(t + 2, operations); });
+        for (thread& worker : workers)
+            worker.join();
+        double elapsed = chrono::duration<double, nano>(Clock::now() - start).count();
+        benchmark.Add("buffer_pool/churn_threads", {
+            { "threads", (double)threads },
+            { "ns_per_return_get", elapsed / (operations * threads) },
+            });
+
+        Release();
+    }
+
+    void BenchmarkFader(Benchmark& benchmark)
+    {
+        for (UINT32 jobs : { 1, 16, 256, 4096 })
+        {
+            // Long enough to never finish during the benchmark
+            vector<UINT32> fadeIDs;
+            for (UINT32 i = 0; i < jobs; i++)
+                fadeIDs.push_back(Fader::Instance.StartFade(0.0f, 1.0f, 1e6f, OnFadeNothing, i));
+
+            BenchmarkTiming timing = benchmark.Time([] { Fader::Instance.Tick(); });
+
+            for (UINT32 fadeID : fadeIDs)
+                Fader::Instance.StopFade(fadeID);
+
+            benchmark.Add("fader_tick/" + to_string(jobs) + "_jobs", {
+                { "ns_per_tick", timing.nanoseconds },
+                { "ns_per_job", timing.nanoseconds / jobs },
+                { "percent_of_interval", timing.nanoseconds / (Fader::INTERVAL * 1e6) * 100.0 },
+                });
+        }
+    }
+
+    void BenchmarkVoiceLookup(Benchmark& benchmark)
+    {
+        CreateOffline(2, 48000);
+        INT32 bankID = AddSineBank(1, 48000, 4800);
+
+        // Voices that stay alive, paused so nothing removes them
+        const UINT32 count = 256;
+        vector<INT32> voiceIDs;
+        for (UINT32 i = 0; i < count; i++)
+            voiceIDs.push_back(CreateVoice(bankID, 0, true));
+
+        UINT32 index = 0;
+        BenchmarkTiming timing = benchmark.Time([&] { VoiceExist(voiceIDs[index++ % count]); });
+        benchmark.Add("voice_lookup/single", {
+            { "ns_per_lookup", timing.nanoseconds },
+            });
+
+        // Getters reading the voice pin it for the duration of the read
+        timing = benchmark.Time([&] { GetSampleRate(voiceIDs[index++ % count]); });
+        benchmark.Add("voice_lookup/pinned", {
+            { "ns_per_lookup", timing.nanoseconds },
+            });
+
+        // The readers look up the live voices while a writer creates voices and stops them, removed by the next pass
+        const double duration = benchmark.IsQuick() ? 0.02 : 0.5;
+        vector<UINT32> readerCounts = { 1, 2, 4, max(1u, thread::hardware_concurrency()) };
+        sort(readerCounts.begin(), readerCounts.end());
+        readerCounts.erase(unique(readerCounts.begin(), readerCounts.end()), readerCounts.end());
+        for (UINT32 readers : readerCounts)
+        {
+            atomic<BOOL> running = true;
+            atomic<UINT64> lookups = 0;
+            atomic<UINT64> found = 0;
+            UINT64 created = 0;
+
+            vector<thread> workers;
+            for (UINT32 t = 0; t < readers; t++)
+            {
+                workers.emplace_back([&, t]
+                    {
+                        UINT64 local = 0;
+                        UINT64 localFound = 0;
+                        UINT32 i = t * 7;
+                        while (running)
+                        {
+                            for (UINT32 j = 0; j < 64; j++, i++)
+                                localFound += VoiceExist(voiceIDs[i % count]);
+                            local += 64;
+                        }
+                        lookups += local;
+                        found += localFound;
+                    });
+            }
+
+            auto start = Clock::now();
+            while (chrono::duration<double>(Clock::now() - start).count() < duration)
+            {
+                for (UINT32 j = 0; j < 16; j++)
+                {
+                    INT32 voiceID = CreateVoice(bankID, 0, false);
+                    Stop(voiceID, 0);
+                    created++;
+                }
+                Advance(0.01f);
+            }
+            running = false;
+            for (thread& worker : workers)
+                worker.join();
+            double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+            benchmark.Add("voice_lookup/contended_" + to_string(readers) + "_readers", {
+                { "readers", (double)readers },
+                { "lookups_per_second", lookups / elapsed },
+                { "ns_per_lookup", elapsed * readers * 1e9 / max(lookups.load(), (UINT64)1) },
+                { "creates_per_second", created / elapsed },
+                { "found_ratio", (double)found / max(lookups.load(), (UINT64)1) },
+                });
+        }
+
+        Release();
+    }
+
+    void RunEngineBenchmarks(Benchmark& benchmark)
+    {
+        BenchmarkDecode(benchmark);
+        BenchmarkBufferPool(benchmark);
+        BenchmarkFader(benchmark);
+        BenchmarkVoiceLookup(benchmark);
+    }
+}
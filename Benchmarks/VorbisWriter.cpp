@@ -0,0 +1,315 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "VorbisWriter.h"
+
+namespace SaXAudio
+{
+    // Only one block size, every packet after the first gives half a block of samples
+#define BLOCK_EXPONENT 11
+#define BLOCK_SIZE (1 << BLOCK_EXPONENT)
+#define PARTITION_SIZE 32
+    // Residue book: 16 entries of 4 bits, pairs of values in -1.5, -0.5, 0.5, 1.5
+#define RESIDUE_BITS 4
+#define RESIDUE_DIMENSIONS 2
+    // Packets per Ogg page
+#define PAGE_PACKETS 8
+
+    // Vorbis packs the bits from the least significant one
+    class BitWriter
+    {
+    private:
+        vector<BYTE> m_bytes;
+        UINT32 m_bit = 0;
+
+    public:
+        void Write(UINT32 value, const UINT32 bits)
+        {
+            for (UINT32 i = 0; i < bits; i++, value >>= 1)
+            {
+                if (m_bit == 0)
+                    m_bytes.push_back(0);
+                if (value & 1)
+                    m_bytes.back() |= (BYTE)(1 << m_bit);
+                m_bit = (m_bit + 1) & 7;
+            }
+        }
+
+        // Huffman codewords are read from their first (most significant) bit
+        void WriteCode(const UINT32 code, const UINT32 bits)
+        {
+            for (UINT32 i = bits; i > 0; i--)
+                Write((code >> (i - 1)) & 1, 1);
+        }
+
+        void WriteString(const char* text)
+        {
+            while (*text)
+                Write((BYTE)*text++, 8);
+        }
+
+        vector<BYTE>& GetBytes() { return m_bytes; }
+    };
+
+    // Same layout as the float32_unpack of the specification, 21 bits of mantissa
+    inline UINT32 PackFloat(const FLOAT value)
+    {
+        UINT32 sign = value < 0 ? 0x80000000 : 0;
+        double mantissa = fabs(value);
+        INT32 exponent = 0;
+        while (mantissa != 0 && mantissa < (1 << 20))
+        {
+            mantissa *= 2;
+            exponent--;
+        }
+        return sign | ((UINT32)(exponent + 788) << 21) | (UINT32)mantissa;
+    }
+
+    class OggWriter
+    {
+    private:
+        vector<BYTE>& m_stream;
+        UINT32 m_serial;
+        UINT32 m_sequence = 0;
+        UINT32 m_crc[256];
+
+    public:
+        OggWriter(vector<BYTE>& stream, const UINT32 serial) : m_stream(stream), m_serial(serial)
+        {
+            for (UINT32 i = 0; i < 256; i++)
+            {
+                UINT32 r = i << 24;
+                for (UINT32 j = 0; j < 8; j++)
+                    r = (r & 0x80000000) ? (r << 1) ^ 0x04C11DB7 : r << 1;
+                m_crc[i] = r;
+            }
+        }
+
+        void WritePage(const vector<vector<BYTE>>& packets, const UINT64 granule, const BYTE flags)
+        {
+            vector<BYTE> lacing;
+            for (const vector<BYTE>& packet : packets)
+            {
+                size_t size = packet.size();
+                while (size >= 255)
+                {
+                    lacing.push_back(255);
+                    size -= 255;
+                }
+                lacing.push_back((BYTE)size);
+            }
+
+            size_t start = m_stream.size();
+            const BYTE header[] = { 'O', 'g', 'g', 'S', 0, flags };
+            m_stream.insert(m_stream.end(), header, header + sizeof(header));
+            for (UINT32 i = 0; i < 8; i++)
+                m_stream.push_back((BYTE)(granule >> (i * 8)));
+            for (UINT32 i = 0; i < 4; i++)
+                m_stream.push_back((BYTE)(m_serial >> (i * 8)));
+            for (UINT32 i = 0; i < 4; i++)
+                m_stream.push_back((BYTE)(m_sequence >> (i * 8)));
+            m_sequence++;
+
+            size_t crcOffset = m_stream.size();
+            m_stream.insert(m_stream.end(), 4, 0);
+            m_stream.push_back((BYTE)lacing.size());
+            m_stream.insert(m_stream.end(), lacing.begin(), lacing.end());
+            for (const vector<BYTE>& packet : packets)
+                m_stream.insert(m_stream.end(), packet.begin(), packet.end());
+
+            UINT32 crc = 0;
+            for (size_t i = start; i < m_stream.size(); i++)
+                crc = (crc << 8) ^ m_crc[((crc >> 24) & 0xFF) ^ m_stream[i]];
+            for (UINT32 i = 0; i < 4; i++)
+                m_stream[crcOffset + i] = (BYTE)(crc >> (i * 8));
+        }
+    };
+
+    vector<BYTE> IdentificationHeader(const UINT32 channels, const UINT32 sampleRate)
+    {
+        BitWriter bits;
+        bits.Write(1, 8);
+        bits.WriteString("vorbis");
+        bits.Write(0, 32);                  // Version
+        bits.Write(channels, 8);
+        bits.Write(sampleRate, 32);
+        bits.Write(0, 32);                  // Bit rates, unset
+        bits.Write(0, 32);
+        bits.Write(0, 32);
+        bits.Write(BLOCK_EXPONENT, 4);      // Short and long blocks are the same
+        bits.Write(BLOCK_EXPONENT, 4);
+        bits.Write(1, 1);                   // Framing
+        return bits.GetBytes();
+    }
+
+    vector<BYTE> CommentHeader()
+    {
+        const char* vendor = "SaXAudio VorbisWriter";
+        BitWriter bits;
+        bits.Write(3, 8);
+        bits.WriteString("vorbis");
+        bits.Write((UINT32)strlen(vendor), 32);
+        bits.WriteString(vendor);
+        bits.Write(0, 32);                  // No user comments
+        bits.Write(1, 1);
+        return bits.GetBytes();
+    }
+
+    vector<BYTE> SetupHeader(const UINT32 channels)
+    {
+        BitWriter bits;
+        bits.Write(5, 8);
+        bits.WriteString("vorbis");
+
+        // Codebooks
+        bits.Write(2 - 1, 8);
+
+        // 0: residue classification, 2 entries of 1 bit, only the first is used
+        bits.Write(0x564342, 24);
+        bits.Write(1, 16);                  // Dimensions
+        bits.Write(2, 24);                  // Entries
+        bits.Write(0, 1);                   // Not ordered
+        bits.Write(0, 1);                   // Not sparse
+        bits.Write(1 - 1, 5);
+        bits.Write(1 - 1, 5);
+        bits.Write(0, 4);                   // No lookup
+
+        // 1: residue values, every entry is a pair from a lattice of 4 values
+        bits.Write(0x564342, 24);
+        bits.Write(RESIDUE_DIMENSIONS, 16);
+        bits.Write(1 << RESIDUE_BITS, 24);
+        bits.Write(0, 1);
+        bits.Write(0, 1);
+        for (UINT32 i = 0; i < (1 << RESIDUE_BITS); i++)
+            bits.Write(RESIDUE_BITS - 1, 5);
+        bits.Write(1, 4);                   // Lattice lookup
+        bits.Write(PackFloat(-1.5f), 32);   // Minimum
+        bits.Write(PackFloat(1.0f), 32);    // Delta
+        bits.Write(2 - 1, 4);               // Bits per value
+        bits.Write(0, 1);                   // Not cumulative
+        for (UINT32 i = 0; i < 4; i++)
+            bits.Write(i, 2);
+
+        // Time domain transforms, placeholders
+        bits.Write(1 - 1, 6);
+        bits.Write(0, 16);
+
+        // Floor 1 without partitions, only the two end posts
+        bits.Write(1 - 1, 6);
+        bits.Write(1, 16);
+        bits.Write(0, 5);                   // Partitions
+        bits.Write(1 - 1, 2);               // Multiplier
+        bits.Write(BLOCK_EXPONENT - 1, 4);  // Range bits, the last post is at half a block
+
+        // Residue 2, the channels are interleaved in one vector
+        bits.Write(1 - 1, 6);
+        bits.Write(2, 16);
+        bits.Write(0, 24);                  // Begin
+        bits.Write(BLOCK_SIZE / 2 * channels, 24); // End
+        bits.Write(PARTITION_SIZE - 1, 24);
+        bits.Write(1 - 1, 6);               // Classifications
+        bits.Write(0, 8);                   // Classification book
+        bits.Write(1, 3);                   // Only the first pass is coded
+        bits.Write(0, 1);
+        bits.Write(1, 8);                   // Book of the first pass
+
+        // Mapping, one submap and no coupling
+        bits.Write(1 - 1, 6);
+        bits.Write(0, 16);
+        bits.Write(0, 1);                   // Submaps
+        bits.Write(0, 1);                   // Coupling
+        bits.Write(0, 2);
+        bits.Write(0, 8);                   // Time
+        bits.Write(0, 8);                   // Floor
+        bits.Write(0, 8);                   // Residue
+
+        // Modes
+        bits.Write(1 - 1, 6);
+        bits.Write(0, 1);                   // Block flag
+        bits.Write(0, 16);                  // Window type
+        bits.Write(0, 16);                  // Transform type
+        bits.Write(0, 8);                   // Mapping
+
+        bits.Write(1, 1);
+        return bits.GetBytes();
+    }
+
+    vector<BYTE> AudioPacket(const UINT32 channels, mt19937& random)
+    {
+        BitWriter bits;
+        bits.Write(0, 1);                   // Audio packet, the only mode takes no bits
+
+        // Floor of each channel, a slope between two levels around -40dB
+        uniform_int_distribution<UINT32> level(150, 190);
+        for (UINT32 c = 0; c < channels; c++)
+        {
+            bits.Write(1, 1);               // Used
+            bits.Write(level(random), 8);
+            bits.Write(level(random) - 60, 8);
+        }
+
+        // Residue, the classification then the values of each partition
+        uniform_int_distribution<UINT32> entry(0, (1 << RESIDUE_BITS) - 1);
+        const UINT32 partitions = BLOCK_SIZE / 2 * channels / PARTITION_SIZE;
+        for (UINT32 p = 0; p < partitions; p++)
+        {
+            bits.WriteCode(0, 1);
+            for (UINT32 i = 0; i < PARTITION_SIZE / RESIDUE_DIMENSIONS; i++)
+                bits.WriteCode(entry(random), RESIDUE_BITS);
+        }
+        return bits.GetBytes();
+    }
+
+    vector<BYTE> VorbisWriter::Write(const UINT32 channels, const UINT32 sampleRate, const FLOAT seconds, const UINT32 seed)
+    {
+        vector<BYTE> stream;
+        if (channels == 0 || channels > 8 || sampleRate == 0)
+            return stream;
+
+        OggWriter ogg(stream, seed);
+        ogg.WritePage({ IdentificationHeader(channels, sampleRate) }, 0, 0x02);
+        ogg.WritePage({ CommentHeader(), SetupHeader(channels) }, 0, 0);
+
+        // The first packet only primes the overlap
+        const UINT64 totalSamples = (UINT64)(seconds * sampleRate);
+        const UINT32 packets = (UINT32)((totalSamples + BLOCK_SIZE / 2 - 1) / (BLOCK_SIZE / 2)) + 1;
+
+        mt19937 random(seed);
+        vector<vector<BYTE>> page;
+        for (UINT32 i = 0; i < packets; i++)
+        {
+            page.push_back(AudioPacket(channels, random));
+
+            BOOL last = i == packets - 1;
+            if (page.size() == PAGE_PACKETS || last)
+            {
+                // The granule of the last page trims the stream to its exact length
+                UINT64 granule = last ? totalSamples : (UINT64)i * (BLOCK_SIZE / 2);
+                ogg.WritePage(page, granule, last ? 0x04 : 0);
+                page.clear();
+            }
+        }
+        return stream;
+    }
+}
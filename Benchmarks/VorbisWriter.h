@@ -0,0 +1,46 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+    // Writes a valid Ogg Vorbis stream without an encoder, for decoding benchmarks and tests
+    // The setup is the simplest the format allows: one block size, a floor of two posts and
+    // a single residue book of 16 pairs, the spectrum is random so it decodes to shaped noise
+    // The bit rate (about 190kbps in stereo) and the decoding work are close to a real file
+    class VorbisWriter
+    {
+    public:
+        /// <summary>
+        /// Build the stream in memory
+        /// </summary>
+        /// <param name="channels">1 to 8</param>
+        /// <param name="sampleRate">Sample rate written in the header</param>
+        /// <param name="seconds">Length of the stream</param>
+        /// <param name="seed">Seed of the random spectrum</param>
+        static vector<BYTE> Write(const UINT32 channels, const UINT32 sampleRate, const FLOAT seconds, const UINT32 seed = 1);
+    };
+}
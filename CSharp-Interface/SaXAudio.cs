@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Runtime.InteropServices;
+using System.Threading;
 
 namespace SaXAudio
 {
@@ -66,6 +67,180 @@ namespace SaXAudio
             public EqParameters() { }
         }
 
+        public enum CommandType : UInt32
+        {
+            CreateVoice = 1,    // id: bankID, param1: busID, param2: paused. Result: voiceID
+            Start = 2,          // param1: sample, param2: 1 to hold the start until CommitGroup. Result: true if started
+            Stop = 3,           // fade. Result: true if stopped
+            Pause = 4,          // fade. Result: pause stack
+            Resume = 5,         // fade. Result: pause stack
+            SetVolume = 6,      // value, fade
+            SetSpeed = 7,       // value, fade
+            SetPanning = 8,     // value, fade
+            SetLooping = 9,     // param1: looping
+            SetLoopPoints = 10, // param1: start, param2: end
+            SetPriority = 11,   // param1: priority
+            Protect = 12,
+            SetBusVolume = 13,  // id: busID (0 for master), value, fade
+            SetSeamlessLoops = 14, // param1: seamless
+            SetSend = 15,       // param1: busID (0 for master), value: level. Result: true if set
+            StartAtEngineTime = 16, // param1: engine time low 32 bits, param2: high 32 bits. Result: true if scheduled
+            StartAtTime = 18,   // value: time in seconds. Result: true if started
+            CommitGroup = 19    // The starts held so far begin in the same audio pass
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Command
+        {
+            public CommandType Type;
+            public Int32 ID;        // Negative to refer to a voice created earlier in the batch: -1 for the first command
+            public Int32 Param1;
+            public Int32 Param2;
+            public Single Value;
+            public Single Fade;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct CommandResult
+        {
+            public Int32 Value;
+            public Boolean Success;
+        }
+
+        /// <summary>
+        /// Collects commands to send them all with a single ExecuteCommands call
+        /// </summary>
+        public class CommandBatch
+        {
+            private Command[] m_commands;
+            private CommandResult[] m_results;
+
+            public Int32 Count { get; private set; }
+            public CommandResult[] Results => m_results;
+
+            public CommandBatch(Int32 capacity = 64)
+            {
+                m_commands = new Command[capacity];
+                m_results = new CommandResult[capacity];
+            }
+
+            /// <summary>
+            /// Add a command
+            /// </summary>
+            /// <returns>The reference to use as id in the following commands to target the voice created by this command</returns>
+            public Int32 Add(CommandType type, Int32 id, Int32 param1 = 0, Int32 param2 = 0, Single value = 0, Single fade = 0)
+            {
+                if (Count == m_commands.Length)
+                {
+                    Array.Resize(ref m_commands, Count * 2);
+                    Array.Resize(ref m_results, Count * 2);
+                }
+                m_commands[Count] = new Command { Type = type, ID = id, Param1 = param1, Param2 = param2, Value = value, Fade = fade };
+                return -(++Count);
+            }
+
+            public Int32 CreateVoice(Int32 bankID, Int32 busID = 0, Boolean paused = true) => Add(CommandType.CreateVoice, bankID, busID, paused ? 1 : 0);
+            public void Start(Int32 voiceID, UInt32 sample = 0) => Add(CommandType.Start, voiceID, (Int32)sample);
+            public void Stop(Int32 voiceID, Single fade = 0.1f) => Add(CommandType.Stop, voiceID, fade: fade);
+            public void Pause(Int32 voiceID, Single fade = 0.1f) => Add(CommandType.Pause, voiceID, fade: fade);
+            public void Resume(Int32 voiceID, Single fade = 0.1f) => Add(CommandType.Resume, voiceID, fade: fade);
+            public void SetVolume(Int32 voiceID, Single volume, Single fade = 0) => Add(CommandType.SetVolume, voiceID, value: volume, fade: fade);
+            public void SetSpeed(Int32 voiceID, Single speed, Single fade = 0) => Add(CommandType.SetSpeed, voiceID, value: speed, fade: fade);
+            public void SetPanning(Int32 voiceID, Single panning, Single fade = 0) => Add(CommandType.SetPanning, voiceID, value: panning, fade: fade);
+            public void SetLooping(Int32 voiceID, Boolean looping) => Add(CommandType.SetLooping, voiceID, looping ? 1 : 0);
+            public void SetLoopPoints(Int32 voiceID, UInt32 start, UInt32 end) => Add(CommandType.SetLoopPoints, voiceID, (Int32)start, (Int32)end);
+            public void SetPriority(Int32 voiceID, UInt32 priority) => Add(CommandType.SetPriority, voiceID, (Int32)priority);
+            public void Protect(Int32 voiceID) => Add(CommandType.Protect, voiceID);
+            public void SetBusVolume(Int32 busID, Single volume, Single fade = 0) => Add(CommandType.SetBusVolume, busID, value: volume, fade: fade);
+            public void SetSeamlessLoops(Int32 voiceID, Boolean seamless) => Add(CommandType.SetSeamlessLoops, voiceID, seamless ? 1 : 0);
+            public void SetSend(Int32 voiceID, Int32 busID, Single level) => Add(CommandType.SetSend, voiceID, busID, value: level);
+            public void StartAtEngineTime(Int32 voiceID, UInt64 engineTime) => Add(CommandType.StartAtEngineTime, voiceID, (Int32)(UInt32)engineTime, (Int32)(UInt32)(engineTime >> 32));
+            public void StartAtTime(Int32 voiceID, Single time) => Add(CommandType.StartAtTime, voiceID, value: time);
+            public void StartInGroup(Int32 voiceID) => Add(CommandType.Start, voiceID, 0, 1);
+            public void CommitGroup() => Add(CommandType.CommitGroup, 0);
+
+            /// <summary>
+            /// Execute all the commands and clear the batch, the results stay available until the next Execute
+            /// </summary>
+            public void Execute()
+            {
+                if (Count == 0) return;
+                ExecuteCommands(m_commands, (UInt32)Count, m_results);
+                Count = 0;
+            }
+        }
+
+        public enum StealPolicy : UInt32
+        {
+            Reject = 0,
+            Oldest = 1,
+            Quietest = 2
+        }
+
+        public enum FilterType : UInt32
+        {
+            LowPass = 0,
+            BandPass = 1,
+            HighPass = 2,
+            Notch = 3,
+            LowPassOnePole = 4,
+            HighPassOnePole = 5
+        }
+
+        public enum Quantize : UInt32
+        {
+            None = 0,
+            Beat = 1,
+            Bar = 2
+        }
+
+        public enum EventType : UInt32
+        {
+            VoiceFinished = 1,
+            BankDecoded = 2,
+            VoiceError = 3
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct AudioEvent
+        {
+            public EventType Type;
+            public Int32 VoiceID;
+            public Int32 BankID;
+            public Int32 Result; // HRESULT of the failure for VoiceError
+        }
+
+        public const UInt32 LoopInfinite = 255;
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct PlaybackSegment
+        {
+            public UInt32 Start;
+            public UInt32 End;          // 0 for the end of the sound
+            public UInt32 LoopCount;    // Number of times the region is repeated, LoopInfinite to loop forever
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct VoiceState
+        {
+            public Int32 VoiceID;
+            public UInt32 Position; // In samples
+            public Boolean Playing;
+            public Boolean Paused;
+            public Single Volume;
+            public Single Peak;     // Loudest channel, estimated from the bank buffer around the play cursor
+            public Single Rms;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct RenderStats
+        {
+            public UInt64 Quanta;
+            public Single LastCost;     // In milliseconds
+            public Single AverageCost;
+            public Single MaxCost;
+        }
+
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
         public struct EchoParameters
         {
@@ -76,14 +251,40 @@ namespace SaXAudio
             public EchoParameters() { }
         }
 
+        [StructLayout(LayoutKind.Sequential, Pack = 1)]
+        public struct CompressorParameters
+        {
+            public Single Threshold = -20f;  // [-60, 0] in dB
+            public Single Ratio = 4f;        // [1, 100], 4 gives 1dB out for every 4dB in above the threshold
+            public Single Attack = 10f;      // [0.1, 500] in ms
+            public Single Release = 100f;    // [1, 5000] in ms
+            public Single MakeupGain = 0f;   // [0, 24] in dB
+            public Boolean RMS = false;      // Follow the RMS level instead of the peaks
+
+            public CompressorParameters() { }
+        }
+
+        [StructLayout(LayoutKind.Sequential, Pack = 1)]
+        public struct LimiterParameters
+        {
+            public Single Ceiling = -1f;     // [-24, 0] in dB, the peaks don't go above
+            public Single Release = 50f;     // [1, 1000] in ms
+            public Single Lookahead = 5f;    // [0.1, 10] in ms, also the latency of the limiter
+
+            public LimiterParameters() { }
+        }
+
+        private static readonly OnFinishedDelegate s_onFinished = TriggerOnFinished;
+
         /// <summary>
         /// Initialize the SaXAudio library and set up the voice finished callback
         /// </summary>
+        /// <param name="polling">When true, no callback is set and events must be read with PollEvents</param>
         /// <returns>True if initialization was successful</returns>
-        public static Boolean Initialize()
+        public static Boolean Initialize(Boolean polling = false)
         {
             Boolean result = Create();
-            SetOnFinishedCallback(TriggerOnFinished);
+            SetOnFinishedCallback(polling ? null : s_onFinished);
             return result;
         }
 
@@ -94,6 +295,67 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         private static extern Boolean Create();
 
+        /// <summary>
+        /// Initialize with the software mixer instead of an audio device
+        /// Nothing is heard, the audio is pulled with Render
+        /// </summary>
+        /// <param name="channels">Channels of the output, 0 for stereo</param>
+        /// <param name="sampleRate">Sample rate of the output</param>
+        /// <returns>Return true if successful</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean CreateSoftware(UInt32 channels = 2, UInt32 sampleRate = 48000);
+
+        /// <summary>
+        /// Mix the next frames of the software mixer
+        /// </summary>
+        /// <param name="buffer">Receives interleaved float samples, frames * channels of them</param>
+        /// <param name="frames">The number of frames to render</param>
+        /// <returns>The number of frames rendered, 0 when not using the software mixer</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 Render([Out] Single[] buffer, UInt32 frames);
+
+        /// <summary>
+        /// Initialize with the software mixer in offline mode
+        /// Time only moves when Render or Advance is called, as fast as the CPU allows
+        /// Fades, scheduled starts and bank cooldowns follow the rendered time and ogg banks are decoded before BankAddOgg returns
+        /// </summary>
+        /// <param name="channels">Channels of the output, 0 for stereo</param>
+        /// <param name="sampleRate">Sample rate of the output</param>
+        /// <returns>Return true if successful</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean CreateOffline(UInt32 channels = 2, UInt32 sampleRate = 48000);
+
+        /// <summary>
+        /// Render the given time with the software mixer, the audio is only kept if captured
+        /// </summary>
+        /// <param name="seconds">Time to render in seconds</param>
+        /// <returns>The number of frames rendered</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 Advance(Single seconds);
+
+        /// <summary>
+        /// Write everything rendered from now on to a 32-bit float wav file
+        /// </summary>
+        /// <param name="filePath">Path of the wav file, overwritten if it exists</param>
+        /// <returns>True if the file was opened</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean StartCapture(string filePath);
+
+        /// <summary>
+        /// Finish the wav file started with StartCapture
+        /// </summary>
+        [DllImport("SaXAudio")]
+        public static extern void StopCapture();
+
+        /// <summary>
+        /// Get the time taken by the passes in offline mode, the control tick included
+        /// </summary>
+        /// <param name="stats">Receives the number of passes and their last, average and max cost in milliseconds</param>
+        /// <param name="reset">Start counting again after reading</param>
+        /// <returns>False if not in offline mode</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean GetRenderStats(out RenderStats stats, Boolean reset = false);
+
         /// <summary>
         /// Release everything
         /// </summary>
@@ -127,7 +389,7 @@ namespace SaXAudio
         /// Pause all playing voices
         /// </summary>
         /// <param name="fade">The duration of the fade in seconds</param>
-        /// <param name="busID">Specific bus to pause (0 to pause all voices)</param>
+        /// <param name="busID">Specific bus to pause (0 to pause all voices), includes its child buses</param>
         [DllImport("SaXAudio")]
         public static extern void PauseAll(Single fade = 0.1f, Int32 busID = 0);
 
@@ -135,7 +397,7 @@ namespace SaXAudio
         /// Resume playing all voices
         /// </summary>
         /// <param name="fade">The duration of the fade in seconds</param>
-        /// <param name="busID">Specific bus to resume (0 to resume all voices)</param>
+        /// <param name="busID">Specific bus to resume (0 to resume all voices), includes its child buses</param>
         [DllImport("SaXAudio")]
         public static extern void ResumeAll(Single fade = 0.1f, Int32 busID = 0);
 
@@ -143,7 +405,7 @@ namespace SaXAudio
         /// Stop all voices
         /// </summary>
         /// <param name="fade">Fade duration in seconds</param>
-        /// <param name="busID">Specific bus to stop (0 to stop all voices)</param>
+        /// <param name="busID">Specific bus to stop (0 to stop all voices), includes its child buses</param>
         [DllImport("SaXAudio")]
         public static extern void StopAll(Single fade = 0.1f, Int32 busID = 0);
 
@@ -154,6 +416,24 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         public static extern void Protect(Int32 voiceID);
 
+        /// <summary>
+        /// Limit the number of voices actually being mixed
+        /// Voices over the limit become virtual, they keep track of their position without being heard
+        /// and are brought back at the correct sample when they are important enough again
+        /// </summary>
+        /// <param name="count">Maximum number of real voices, 0 for no limit</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetMaxRealVoices(UInt32 count);
+
+        /// <summary>
+        /// Set the priority of a voice, higher priority voices are kept real over lower priority ones
+        /// Between voices of the same priority the most audible ones (volume x bus volume) are kept
+        /// </summary>
+        /// <param name="voiceID">The voice to change</param>
+        /// <param name="priority">The priority, 0 by default</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetPriority(Int32 voiceID, UInt32 priority);
+
         /// <summary>
         /// Add ogg audio data to the sound bank
         /// The data in the buffer will be decoded (async) and stored in memory
@@ -189,6 +469,68 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         public static extern void BankAutoRemove(Int32 bankID);
 
+        /// <summary>
+        /// Limit how many voices can play the bank at the same time
+        /// Useful for sounds triggered in rapid succession (footsteps, impacts, clicks)
+        /// </summary>
+        /// <param name="bankID">The bank to limit</param>
+        /// <param name="maxInstances">Maximum number of voices playing the bank, 0 for no limit</param>
+        /// <param name="cooldown">Minimum time in seconds between the creation of two voices, 0 for none</param>
+        /// <param name="policy">What to do when maxInstances is reached: reject the new voice or stop the oldest/quietest one</param>
+        [DllImport("SaXAudio")]
+        public static extern void BankSetLimits(Int32 bankID, UInt32 maxInstances, Single cooldown = 0, StealPolicy policy = StealPolicy.Reject);
+
+        /// <summary>
+        /// Get how many voices were not created because of the bank limits
+        /// </summary>
+        /// <param name="bankID">The bank to query, 0 for all banks</param>
+        /// <returns>Number of rejected voices</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 BankGetRejectedCount(Int32 bankID = 0);
+
+        /// <summary>
+        /// Get how many voices were stopped to make room for a new voice because of the bank limits
+        /// </summary>
+        /// <param name="bankID">The bank to query, 0 for all banks</param>
+        /// <returns>Number of stolen voices</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 BankGetStolenCount(Int32 bankID = 0);
+
+        /// <summary>
+        /// Measure the integrated loudness (ITU-R BS.1770) and true peak of the banks added from now on
+        /// Ogg banks are measured while decoding, wav banks when added
+        /// </summary>
+        /// <param name="enabled">Enable or disable the analysis</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetLoudnessAnalysis(Boolean enabled);
+
+        /// <summary>
+        /// Normalize the voices created from analyzed banks to the target loudness
+        /// The gain is limited so the true peak stays under 0dBTP, it doesn't change the voice volume
+        /// </summary>
+        /// <param name="target">Target loudness in LUFS (e.g. -16), 0 to disable</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetLoudnessTarget(Single target);
+
+        /// <summary>
+        /// Get the loudness measured for a bank, to cache it with the asset
+        /// </summary>
+        /// <param name="bankID">The bank to query</param>
+        /// <param name="loudness">Receives the integrated loudness in LUFS</param>
+        /// <param name="truePeak">Receives the linear true peak</param>
+        /// <returns>true if the bank was analyzed</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean BankGetLoudness(Int32 bankID, out Single loudness, out Single truePeak);
+
+        /// <summary>
+        /// Restore a cached loudness, an Ogg bank still decoding is not analyzed anymore
+        /// </summary>
+        /// <param name="bankID">The bank to modify</param>
+        /// <param name="loudness">Integrated loudness in LUFS</param>
+        /// <param name="truePeak">Linear true peak</param>
+        [DllImport("SaXAudio")]
+        public static extern void BankSetLoudness(Int32 bankID, Single loudness, Single truePeak);
+
         /// <summary>
         /// Create a voice for playing the specified audio data
         /// When the audio data finished playing, the voice will be deleted
@@ -196,7 +538,7 @@ namespace SaXAudio
         /// <param name="bankID">The bankID of the data to play</param>
         /// <param name="busID">The bus to play the voice on</param>
         /// <param name="paused">when false, the audio will start playing immediately</param>
-        /// <returns>unique voiceID</returns>
+        /// <returns>unique voiceID, 0 if the bank doesn't exist. The voice is created by the next control tick, it is dropped if the bank limits reject it</returns>
         [DllImport("SaXAudio")]
         public static extern Int32 CreateVoice(Int32 bankID, Int32 busID = 0, Boolean paused = true);
 
@@ -204,31 +546,44 @@ namespace SaXAudio
         /// Check if the specified voice exists
         /// </summary>
         /// <param name="voiceID">The voice to check</param>
-        /// <returns>true if the specified voice exists</returns>
+        /// <returns>true if the specified voice exists or is waiting to be created</returns>
         [DllImport("SaXAudio")]
         public static extern Boolean VoiceExist(Int32 voiceID);
 
         /// <summary>
         /// Create a bus
+        /// The volume and effects of a bus apply to its child buses
         /// </summary>
+        /// <param name="parentBusID">The bus to output to, 0 for the mastering voice</param>
         /// <returns>unique busID</returns>
         [DllImport("SaXAudio")]
-        public static extern Int32 CreateBus();
+        public static extern Int32 CreateBus(Int32 parentBusID = 0);
 
         /// <summary>
         /// Removes a bus
-        /// All voices on that bus will be stopped
+        /// All voices on that bus and its child buses will be stopped, the child buses are removed
         /// </summary>
         /// <param name="busID">The bus to remove</param>
         [DllImport("SaXAudio")]
         public static extern void RemoveBus(Int32 busID);
 
+        /// <summary>
+        /// Send the voice to another bus on top of its own, e.g. a bus hosting a reverb shared by many voices
+        /// The send follows the panning of the voice, scaled by the level
+        /// </summary>
+        /// <param name="voiceID">The voice to modify</param>
+        /// <param name="busID">The bus to send to, 0 for the mastering voice</param>
+        /// <param name="level">Send level [0, 1], 0 removes the send</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetSend(Int32 voiceID, Int32 busID, Single level);
+
         /// <summary>
         /// Starts playing the specified voice
         /// Resets the pause stack
+        /// The start is queued and applied by the next control tick, like the other commands
         /// </summary>
         /// <param name="voiceID">The voice to start</param>
-        /// <returns>true if successful or already playing</returns>
+        /// <returns>true if the voice exists and the start was queued</returns>
         [DllImport("SaXAudio")]
         public static extern Boolean Start(Int32 voiceID);
 
@@ -238,7 +593,7 @@ namespace SaXAudio
         /// </summary>
         /// <param name="voiceID">The voice to start</param>
         /// <param name="sample">The sample position to start at</param>
-        /// <returns>true if successful</returns>
+        /// <returns>true if the voice exists and the start was queued</returns>
         [DllImport("SaXAudio")]
         public static extern Boolean StartAtSample(Int32 voiceID, UInt32 sample);
 
@@ -248,17 +603,63 @@ namespace SaXAudio
         /// </summary>
         /// <param name="voiceID">The voice to start</param>
         /// <param name="time">The time position in seconds to start at</param>
-        /// <returns>true if successful</returns>
+        /// <returns>true if the voice exists and the start was queued</returns>
         [DllImport("SaXAudio")]
         public static extern Boolean StartAtTime(Int32 voiceID, Single time);
 
+        /// <summary>
+        /// Starts playing the specified voice when the engine reaches a sample time
+        /// Voices scheduled to the same time start on the same sample, use GetEngineTime to get the current time
+        /// Scheduling the voice again replaces the previous time, Stop cancels it
+        /// Rarely, when the engine begins a pass while the start is committed, the voices start one pass (10ms) late
+        /// </summary>
+        /// <param name="voiceID">The voice to start</param>
+        /// <param name="engineTime">The engine sample time to start at, see GetEngineSampleRate</param>
+        /// <returns>true if the voice exists and isn't playing, the start is scheduled by the next control tick</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean StartAtEngineTime(Int32 voiceID, UInt64 engineTime);
+
+        /// <summary>
+        /// Starts playing several voices at once, they all begin in the same audio pass
+        /// </summary>
+        /// <param name="voiceIDs">The voices to start</param>
+        /// <param name="count">The number of voices</param>
+        /// <returns>The number of voices found, their starts are queued and applied together by the next control tick</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 StartGroup(Int32[] voiceIDs, UInt32 count);
+
+        /// <summary>
+        /// Starts playing a list of regions of the bank one after the other, like an intro followed by a loop
+        /// The transitions are sample exact, a final infinite loop can be exited with SetLooping(false)
+        /// </summary>
+        /// <param name="voiceID">The voice to start</param>
+        /// <param name="segments">The regions to play, at most 16</param>
+        /// <param name="count">The number of regions</param>
+        /// <returns>true if the voice exists and the regions were queued, the regions are checked by the next control tick</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean StartSegments(Int32 voiceID, PlaybackSegment[] segments, UInt32 count);
+
+        /// <summary>
+        /// Get the number of samples processed by the engine since Create
+        /// </summary>
+        /// <returns>The engine sample time</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt64 GetEngineTime();
+
+        /// <summary>
+        /// Get the sample rate of the engine time
+        /// </summary>
+        /// <returns>The sample rate of the mastering voice</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 GetEngineSampleRate();
+
         /// <summary>
         /// Stops playing the specified voice
         /// This will also delete the voice
         /// </summary>
         /// <param name="voiceID">The voice to stop</param>
         /// <param name="fade">Fade duration in seconds</param>
-        /// <returns>true if successful</returns>
+        /// <returns>true if the voice was playing or scheduled, the stop is queued either way</returns>
         [DllImport("SaXAudio")]
         public static extern Boolean Stop(Int32 voiceID, Single fade = 0.1f);
 
@@ -269,18 +670,18 @@ namespace SaXAudio
         /// </summary>
         /// <param name="voiceID">The voice to pause</param>
         /// <param name="fade">The duration of the fade in seconds</param>
-        /// <returns>value of the pause stack</returns>
+        /// <returns>true if the voice exists and the pause was queued, see GetPauseStack once it is applied</returns>
         [DllImport("SaXAudio")]
-        public static extern UInt32 Pause(Int32 voiceID, Single fade = 0.1f);
+        public static extern Boolean Pause(Int32 voiceID, Single fade = 0.1f);
 
         /// <summary>
         /// Reduce the pause stack and resume playing the voice if the stack becomes empty
         /// </summary>
         /// <param name="voiceID">The voice to resume</param>
         /// <param name="fade">The duration of the fade in seconds</param>
-        /// <returns>value of the pause stack</returns>
+        /// <returns>true if the voice exists and the resume was queued, see GetPauseStack once it is applied</returns>
         [DllImport("SaXAudio")]
-        public static extern UInt32 Resume(Int32 voiceID, Single fade = 0.1f);
+        public static extern Boolean Resume(Int32 voiceID, Single fade = 0.1f);
 
         /// <summary>
         /// Gets the pause stack value of the specified voice, 0 if empty
@@ -290,6 +691,80 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         public static extern UInt32 GetPauseStack(Int32 voiceID);
 
+        /// <summary>
+        /// Create a music playlist, the tracks play back to back without gaps
+        /// </summary>
+        /// <param name="busID">The bus the tracks are played on, 0 for the mastering voice</param>
+        /// <returns>The playlistID</returns>
+        [DllImport("SaXAudio")]
+        public static extern Int32 CreatePlaylist(Int32 busID = 0);
+
+        /// <summary>
+        /// Stop and remove a playlist
+        /// </summary>
+        /// <param name="playlistID">The playlist to remove</param>
+        [DllImport("SaXAudio")]
+        public static extern void RemovePlaylist(Int32 playlistID);
+
+        /// <summary>
+        /// Set the tempo used to quantize the transitions
+        /// The beat grid starts when the current track started
+        /// </summary>
+        /// <param name="playlistID">The playlist to modify</param>
+        /// <param name="bpm">Beats per minute</param>
+        /// <param name="beatsPerBar">Beats per bar</param>
+        /// <returns>true if successful</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean PlaylistSetTempo(Int32 playlistID, Single bpm, UInt32 beatsPerBar = 4);
+
+        /// <summary>
+        /// Add a track at the end of the playlist
+        /// The next track is scheduled to start the sample the current one ends
+        /// A looping track plays until PlaylistTransition or PlaylistStop
+        /// </summary>
+        /// <param name="playlistID">The playlist to modify</param>
+        /// <param name="bankID">The bank to play</param>
+        /// <param name="looping">Loop the track</param>
+        /// <returns>true if successful</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean PlaylistQueue(Int32 playlistID, Int32 bankID, Boolean looping = false);
+
+        /// <summary>
+        /// Start playing the first queued track
+        /// </summary>
+        /// <param name="playlistID">The playlist to play</param>
+        /// <returns>true if a track is playing</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean PlaylistPlay(Int32 playlistID);
+
+        /// <summary>
+        /// Crossfade from the current track to a new one, the queued tracks play after it
+        /// </summary>
+        /// <param name="playlistID">The playlist to modify</param>
+        /// <param name="bankID">The bank to play</param>
+        /// <param name="looping">Loop the track</param>
+        /// <param name="fade">Equal power crossfade duration in seconds</param>
+        /// <param name="quantize">Start on the next beat or bar of the current track</param>
+        /// <returns>true if successful</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean PlaylistTransition(Int32 playlistID, Int32 bankID, Boolean looping, Single fade, Quantize quantize = Quantize.None);
+
+        /// <summary>
+        /// Stop the current track and clear the queue
+        /// </summary>
+        /// <param name="playlistID">The playlist to stop</param>
+        /// <param name="fade">Fade duration in seconds</param>
+        [DllImport("SaXAudio")]
+        public static extern void PlaylistStop(Int32 playlistID, Single fade = 0.1f);
+
+        /// <summary>
+        /// Get the voice playing the current track
+        /// </summary>
+        /// <param name="playlistID">The playlist to query</param>
+        /// <returns>The voiceID or 0 if nothing is playing</returns>
+        [DllImport("SaXAudio")]
+        public static extern Int32 PlaylistGetCurrentVoice(Int32 playlistID);
+
         /// <summary>
         /// Set the master volume
         /// </summary>
@@ -345,6 +820,15 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         public static extern void SetLoopPoints(Int32 voiceID, UInt32 start, UInt32 end);
 
+        /// <summary>
+        /// Makes loop changes seamless, the voice is never stopped or flushed
+        /// New loop points and disabling the loop take effect when the current loop reaches its end
+        /// </summary>
+        /// <param name="voiceID">The voice to modify</param>
+        /// <param name="seamless">true to wait for the end of the loop, false to apply changes immediately</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetSeamlessLoops(Int32 voiceID, Boolean seamless);
+
         /// <summary>
         /// Get the master volume
         /// </summary>
@@ -457,11 +941,96 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         public static extern void RemoveEcho(Int32 voiceID, Single fade = 0, Boolean isBus = false);
 
+        /// <summary>
+        /// Set the longest delay the echo of a voice or bus can use, its memory grows with it
+        /// Applied the next time the echo is added, the echo delay is limited to it
+        /// </summary>
+        /// <param name="voiceID">The voice or bus ID to modify</param>
+        /// <param name="maxDelay">[1, 3000] in milliseconds, 0 for 3000</param>
+        /// <param name="isBus">true if voiceID refers to a bus, false for voice</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetEchoMaxDelay(Int32 voiceID, Single maxDelay, Boolean isBus = false);
+
+        /// <summary>
+        /// Add/Modify the native filter of a voice or bus, much cheaper than the EQ for occlusion
+        /// The cutoff fades when the type doesn't change, band-pass and notch start without fade
+        /// </summary>
+        /// <param name="voiceID">The voice or bus ID to modify</param>
+        /// <param name="type">Type of the filter</param>
+        /// <param name="cutoff">Cutoff frequency in Hz, capped at a sixth of the engine sample rate except for one-pole filters</param>
+        /// <param name="q">[0.67, ...] quality of the filter, one-pole filters ignore it</param>
+        /// <param name="fade">Fade duration in seconds</param>
+        /// <param name="isBus">true if voiceID refers to a bus, false for voice</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetFilter(Int32 voiceID, FilterType type, Single cutoff, Single q = 1f, Single fade = 0, Boolean isBus = false);
+
+        /// <summary>
+        /// Remove the native filter of a voice or bus
+        /// </summary>
+        /// <param name="voiceID">The voice or bus ID to modify</param>
+        /// <param name="fade">Fade duration in seconds</param>
+        /// <param name="isBus">true if voiceID refers to a bus, false for voice</param>
+        [DllImport("SaXAudio")]
+        public static extern void RemoveFilter(Int32 voiceID, Single fade = 0, Boolean isBus = false);
+
+        /// <summary>
+        /// Add/Modify the convolution reverb of a bus, using a bank as impulse response
+        /// The bank must be fully decoded, it can be removed afterward
+        /// The reverb is delayed by 512 samples, the dry sound is not
+        /// A new bank is resampled and prepared on its own thread, the previous one keeps playing until it is ready
+        /// </summary>
+        /// <param name="busID">The bus to modify</param>
+        /// <param name="bankID">The impulse response</param>
+        /// <param name="wetDryMix">[0, 100] percentage of reverb</param>
+        /// <returns>true if the bus and the decoded bank exist, the reverb is enabled once prepared</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean SetConvolutionReverb(Int32 busID, Int32 bankID, Single wetDryMix = 100f);
+
+        /// <summary>
+        /// Remove the convolution reverb from a bus
+        /// </summary>
+        /// <param name="busID">The bus to modify</param>
+        [DllImport("SaXAudio")]
+        public static extern void RemoveConvolutionReverb(Int32 busID);
+
+        /// <summary>
+        /// Add/Modify the compressor of a bus
+        /// </summary>
+        /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+        /// <param name="compressorParams">Compressor parameters</param>
+        /// <param name="sidechainBusID">Bus whose level drives the compression (ducking), 0 for the bus itself</param>
+        /// <returns>true if the buses exist, the compressor is enabled by the next control tick</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean SetCompressor(Int32 busID, CompressorParameters compressorParams, Int32 sidechainBusID = 0);
+
+        /// <summary>
+        /// Remove the compressor from a bus
+        /// </summary>
+        /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+        [DllImport("SaXAudio")]
+        public static extern void RemoveCompressor(Int32 busID);
+
+        /// <summary>
+        /// Add/Modify the look-ahead limiter of a bus, the bus is delayed by the look-ahead
+        /// </summary>
+        /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+        /// <param name="limiterParams">Limiter parameters</param>
+        /// <returns>true if the bus exists, the limiter is enabled by the next control tick</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean SetLimiter(Int32 busID, LimiterParameters limiterParams);
+
+        /// <summary>
+        /// Remove the limiter from a bus
+        /// </summary>
+        /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+        [DllImport("SaXAudio")]
+        public static extern void RemoveLimiter(Int32 busID);
+
         /// <summary>
         /// Gets the position of the playing voice in samples
         /// </summary>
         /// <param name="voiceID">The voice to query</param>
-        /// <returns>sample position if playing or 0</returns>
+        /// <returns>sample position if playing or 0, as of the last control tick</returns>
         [DllImport("SaXAudio")]
         public static extern UInt32 GetPositionSample(Int32 voiceID);
 
@@ -469,10 +1038,18 @@ namespace SaXAudio
         /// Gets the position of the playing voice in seconds
         /// </summary>
         /// <param name="voiceID">The voice to query</param>
-        /// <returns>position in seconds if playing or 0</returns>
+        /// <returns>position in seconds if playing or 0, as of the last control tick</returns>
         [DllImport("SaXAudio")]
         public static extern Single GetPositionTime(Int32 voiceID);
 
+        /// <summary>
+        /// Get the index of the region playing, see StartSegments
+        /// </summary>
+        /// <param name="voiceID">The voice to query</param>
+        /// <returns>The index of the region, 0 when not playing segments, as of the last control tick</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 GetSegmentIndex(Int32 voiceID);
+
         /// <summary>
         /// Gets the total amount of samples of the voice
         /// </summary>
@@ -505,6 +1082,50 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         public static extern UInt32 GetChannelCount(Int32 voiceID);
 
+        /// <summary>
+        /// Get the snapshot of every voice state, refreshed every 10ms by the audio thread
+        /// Use ReadVoiceStates to read it
+        /// </summary>
+        /// <returns>Pointer to the snapshot, valid for the lifetime of the library</returns>
+        [DllImport("SaXAudio")]
+        public static extern IntPtr GetVoiceSnapshot();
+
+        private static IntPtr s_snapshot = IntPtr.Zero;
+
+        /// <summary>
+        /// Copy the state of every voice from the snapshot, without calling into the library
+        /// </summary>
+        /// <param name="states">The buffer receiving the states</param>
+        /// <returns>Number of states copied</returns>
+        public static UInt32 ReadVoiceStates(VoiceState[] states)
+        {
+            if (s_snapshot == IntPtr.Zero)
+                s_snapshot = GetVoiceSnapshot();
+
+            // Layout: sequence, front, capacity, count[2], voices[2][capacity]
+            Int32 size = Marshal.SizeOf<VoiceState>();
+            while (true)
+            {
+                Int32 sequence = Marshal.ReadInt32(s_snapshot, 0);
+                Thread.MemoryBarrier();
+                if ((sequence & 1) != 0)
+                    continue;
+
+                Int32 front = Marshal.ReadInt32(s_snapshot, 4);
+                Int32 capacity = Marshal.ReadInt32(s_snapshot, 8);
+                Int32 count = Math.Min(Marshal.ReadInt32(s_snapshot, 12 + front * 4), states.Length);
+
+                IntPtr voices = s_snapshot + 20 + front * capacity * size;
+                for (Int32 i = 0; i < count; i++)
+                    states[i] = Marshal.PtrToStructure<VoiceState>(voices + i * size);
+
+                // The front buffer was switched while reading, try again
+                Thread.MemoryBarrier();
+                if (Marshal.ReadInt32(s_snapshot, 0) == sequence)
+                    return (UInt32)count;
+            }
+        }
+
         /// <summary>
         /// Get the number of voices
         /// </summary>
@@ -519,19 +1140,100 @@ namespace SaXAudio
         [DllImport("SaXAudio")]
         public static extern UInt32 GetBankCount();
 
+        /// <summary>
+        /// Get the number of voices being mixed (not virtual)
+        /// </summary>
+        /// <returns>Number of real voices</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 GetRealVoiceCount();
+
+        /// <summary>
+        /// Check if a voice is currently virtual
+        /// </summary>
+        /// <param name="voiceID">The voice to query</param>
+        /// <returns>True if the voice exists and is virtual</returns>
+        [DllImport("SaXAudio")]
+        public static extern Boolean IsVirtual(Int32 voiceID);
+
+        /// <summary>
+        /// Enable the volume meter of a bus, needed by GetPeakLevel and GetRMSLevel on buses
+        /// </summary>
+        /// <param name="busID">The bus to meter, 0 for the mastering voice</param>
+        /// <param name="enabled">Enable or disable the meter</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetMetering(Int32 busID, Boolean enabled);
+
+        /// <summary>
+        /// Get the peak volume level (for VU meters, etc.)
+        /// Refreshed every 10ms by the audio thread, reading it doesn't lock
+        /// A voice level is estimated from its audio around the play cursor, times its volume
+        /// A bus level is measured at the end of its effect chain, before the bus volume
+        /// </summary>
+        /// <param name="voiceID">The voice or bus to query</param>
+        /// <param name="channelIndex">Channel to get peak for (0=left, 1=right, etc.)</param>
+        /// <param name="isBus">true if voiceID refers to a bus, 0 for the mastering voice</param>
+        /// <returns>Peak level [0, 1]</returns>
+        [DllImport("SaXAudio")]
+        public static extern Single GetPeakLevel(Int32 voiceID, UInt32 channelIndex = 0, Boolean isBus = false);
+
+        /// <summary>
+        /// Get the RMS volume level, same as GetPeakLevel
+        /// </summary>
+        /// <param name="voiceID">The voice or bus to query</param>
+        /// <param name="channelIndex">Channel to get RMS for (0=left, 1=right, etc.)</param>
+        /// <param name="isBus">true if voiceID refers to a bus, 0 for the mastering voice</param>
+        /// <returns>RMS level [0, 1]</returns>
+        [DllImport("SaXAudio")]
+        public static extern Single GetRMSLevel(Int32 voiceID, UInt32 channelIndex = 0, Boolean isBus = false);
+
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         public delegate void OnDecodedDelegate(Int32 bankID, IntPtr buffer);
 
+        /// <summary>
+        /// Execute a batch of commands in a single call, in order
+        /// A command can target a voice created earlier in the batch with a negative id: -1 for the first command, -2 for the second...
+        /// See CommandBatch
+        /// </summary>
+        /// <param name="commands">The commands to execute</param>
+        /// <param name="count">The number of commands</param>
+        /// <param name="results">Receives one result per command (voiceID, pause stack, etc.), can be null</param>
+        [DllImport("SaXAudio")]
+        public static extern void ExecuteCommands([In] Command[] commands, UInt32 count, [Out] CommandResult[] results);
+
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         public delegate void OnFinishedDelegate(Int32 voiceID);
 
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public delegate void OnEventsDelegate(IntPtr events, UInt32 count);
+
         /// <summary>
         /// Sets a callback for when a voice finishes playing
+        /// The callback is called from a single dispatcher thread, in the order voices finished
         /// </summary>
         /// <param name="callback">The callback function to call when voices finish</param>
         [DllImport("SaXAudio")]
         private static extern void SetOnFinishedCallback(OnFinishedDelegate callback);
 
+        /// <summary>
+        /// Sets a callback receiving every event (finished, decoded, error) in batches
+        /// The callback is called from a single dispatcher thread
+        /// Keep a reference to the delegate for as long as it is set
+        /// </summary>
+        /// <param name="callback">The callback function to call with a batch of events</param>
+        [DllImport("SaXAudio")]
+        public static extern void SetOnEventsCallback(OnEventsDelegate callback);
+
+        /// <summary>
+        /// Copy the pending events (finished, decoded, error) into the buffer
+        /// Only use when no callback is set, otherwise the dispatcher thread consumes the events
+        /// Call Initialize() with polling = true to use this on the game thread
+        /// </summary>
+        /// <param name="events">The buffer receiving the events</param>
+        /// <param name="maxCount">The maximum number of events the buffer can hold</param>
+        /// <returns>Number of events copied</returns>
+        [DllImport("SaXAudio")]
+        public static extern UInt32 PollEvents([Out] AudioEvent[] events, UInt32 maxCount);
+
         private static void TriggerOnFinished(Int32 voiceID)
         {
             OnVoiceFinished?.Invoke(voiceID);
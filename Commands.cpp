@@ -0,0 +1,226 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Commands.h"
+#include "SaXAudio.h"
+
+namespace SaXAudio
+{
+    CommandResult ExecuteCommand(const Command& command, const INT32 voiceID)
+    {
+        CommandResult result = { 0, false };
+
+        if (command.type == COMMAND_CREATE_VOICE)
+        {
+            AudioVoice* voice = SaXAudio::Instance.CreateVoice(command.id, command.param1);
+            if (!voice)
+                return result;
+
+            if (!command.param2)
+                voice->Start();
+
+            result.value = voice->VoiceID;
+            result.success = true;
+            return result;
+        }
+
+        // The voice of CreateVoice, the voiceID was handed out before the voice existed
+        if (command.type == COMMAND_CREATE_RESERVED)
+        {
+            AudioVoice* voice = SaXAudio::Instance.CreateVoice(command.param1, command.param2, command.id);
+            result.value = voice ? voice->VoiceID.load() : 0;
+            result.success = voice != nullptr;
+            return result;
+        }
+
+        if (command.type == COMMAND_COMMIT_GROUP)
+        {
+            SaXAudio::Instance.CommitGroup();
+            result.success = true;
+            return result;
+        }
+
+        // Also takes the segments back when the voice is gone
+        if (command.type == COMMAND_START_SEGMENTS)
+        {
+            result.value = SaXAudio::Instance.StartPostedSegments(voiceID, (UINT32)command.param1);
+            result.success = result.value;
+            return result;
+        }
+
+        if (command.type == COMMAND_SET_BUS_VOLUME)
+        {
+            SaXAudio::Instance.SetBusVolume(command.id, command.value, command.fade);
+            result.success = true;
+            return result;
+        }
+
+        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        if (!voice)
+            return result;
+
+        result.success = true;
+        switch (command.type)
+        {
+        case COMMAND_START:
+            result.value = voice->Start(command.param1, true, 0, command.param2 ? SaXAudio::Instance.GetGroupOperationSet() : XAUDIO2_COMMIT_NOW);
+            result.success = result.value;
+            break;
+        case COMMAND_START_AT_TIME:
+            result.value = voice->BankData && command.value >= 0 && voice->Start((UINT32)(command.value * voice->BankData->sampleRate));
+            result.success = result.value;
+            break;
+
+        case COMMAND_STOP:
+            result.value = voice->Stop(command.fade);
+            result.success = result.value;
+            break;
+        case COMMAND_PAUSE:
+            result.value = voice->Pause(command.fade);
+            break;
+        case COMMAND_RESUME:
+            result.value = voice->Resume(command.fade);
+            break;
+        case COMMAND_SET_VOLUME:
+            voice->SetVolume(command.value, command.fade);
+            break;
+        case COMMAND_SET_SPEED:
+            voice->SetSpeed(command.value, command.fade);
+            break;
+        case COMMAND_SET_PANNING:
+            voice->SetPanning(command.value, command.fade);
+            break;
+        case COMMAND_SET_LOOPING:
+            voice->SetLooping(command.param1);
+            break;
+        case COMMAND_SET_LOOP_POINTS:
+            voice->ChangeLoopPoints(command.param1, command.param2);
+            break;
+        case COMMAND_SET_PRIORITY:
+            voice->Priority = command.param1;
+            break;
+        case COMMAND_PROTECT:
+            SaXAudio::Instance.Protect(voiceID);
+            break;
+        case COMMAND_SET_SEAMLESS_LOOPS:
+            voice->SeamlessLoops = command.param1;
+            break;
+        case COMMAND_SET_SEND:
+            result.success = voice->SetSend(command.param1, command.value);
+            break;
+        case COMMAND_START_AT_ENGINE_TIME:
+            result.value = SaXAudio::Instance.ScheduleStart(voiceID, ((UINT64)(UINT32)command.param2 << 32) | (UINT32)command.param1);
+            result.success = result.value;
+            break;
+        default:
+            Log(0, voiceID, "[ExecuteCommands] Unknown command: " + to_string(command.type));
+            result.success = false;
+            break;
+        }
+        return result;
+    }
+
+    void ExecuteEffectCommand(const EffectCommand& command)
+    {
+        SaXAudio& engine = SaXAudio::Instance;
+        switch (command.type)
+        {
+        case EFFECT_SET_REVERB:
+            engine.SetReverb(command.id, command.isBus, &command.reverb, command.fade);
+            break;
+        case EFFECT_REMOVE_REVERB:
+            engine.RemoveReverb(command.id, command.isBus, command.fade);
+            break;
+        case EFFECT_SET_EQ:
+            engine.SetEq(command.id, command.isBus, &command.eq, command.fade);
+            break;
+        case EFFECT_REMOVE_EQ:
+            engine.RemoveEq(command.id, command.isBus, command.fade);
+            break;
+        case EFFECT_SET_ECHO:
+            engine.SetEcho(command.id, command.isBus, &command.echo, command.fade);
+            break;
+        case EFFECT_REMOVE_ECHO:
+            engine.RemoveEcho(command.id, command.isBus, command.fade);
+            break;
+        case EFFECT_SET_ECHO_MAX_DELAY:
+            engine.SetEchoMaxDelay(command.id, command.isBus, command.maxDelay);
+            break;
+        case EFFECT_SET_FILTER:
+            engine.SetFilter(command.id, command.isBus, command.filter.type, command.filter.cutoff, command.filter.q, command.fade);
+            break;
+        case EFFECT_REMOVE_FILTER:
+            engine.RemoveFilter(command.id, command.isBus, command.fade);
+            break;
+        case EFFECT_SET_CONVOLUTION:
+            engine.SetConvolutionReverb(command.id, command.convolution.bankID, command.convolution.ticket, command.convolution.wetDryMix);
+            break;
+        case EFFECT_REMOVE_CONVOLUTION:
+            engine.RemoveConvolutionReverb(command.id);
+            break;
+        case EFFECT_SET_COMPRESSOR:
+            engine.SetCompressor(command.id, &command.compressor, command.sidechainBusID);
+            break;
+        case EFFECT_REMOVE_COMPRESSOR:
+            engine.RemoveCompressor(command.id);
+            break;
+        case EFFECT_SET_LIMITER:
+            engine.SetLimiter(command.id, &command.limiter);
+            break;
+        case EFFECT_REMOVE_LIMITER:
+            engine.RemoveLimiter(command.id);
+            break;
+        default:
+            Log(0, command.id, "[ExecuteEffectCommand] Unknown command: " + to_string(command.type));
+            break;
+        }
+    }
+
+    void ProcessCommands(const Command* commands, const UINT32 count, CommandResult* results)
+    {
+        if (!commands) return;
+        auto lock = SaXAudio::Instance.AcquireControl();
+
+        // Results are needed to resolve references to voices created in the batch
+        vector<CommandResult> localResults;
+        if (!results)
+        {
+            localResults.resize(count);
+            results = localResults.data();
+        }
+
+        for (UINT32 i = 0; i < count; i++)
+        {
+            const Command& command = commands[i];
+
+            INT32 voiceID = command.id;
+            if (voiceID < 0 && command.type != COMMAND_CREATE_VOICE && command.type != COMMAND_SET_BUS_VOLUME)
+            {
+                UINT32 index = (UINT32)(-(voiceID + 1));
+                voiceID = index < i ? results[index].value : 0;
+            }
+
+            results[i] = ExecuteCommand(command, voiceID);
+        }
+    }
+}
@@ -0,0 +1,144 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+#include "Dsp.h"
+
+namespace SaXAudio
+{
+    enum CommandType : UINT32
+    {
+        COMMAND_CREATE_VOICE = 1,   // id: bankID, param1: busID, param2: paused. Result: voiceID
+        COMMAND_START = 2,          // param1: sample, param2: 1 to hold the start until COMMAND_COMMIT_GROUP. Result: true if started
+        COMMAND_STOP = 3,           // fade. Result: true if stopped
+        COMMAND_PAUSE = 4,          // fade. Result: pause stack
+        COMMAND_RESUME = 5,         // fade. Result: pause stack
+        COMMAND_SET_VOLUME = 6,     // value, fade
+        COMMAND_SET_SPEED = 7,      // value, fade
+        COMMAND_SET_PANNING = 8,    // value, fade
+        COMMAND_SET_LOOPING = 9,    // param1: looping
+        COMMAND_SET_LOOP_POINTS = 10, // param1: start, param2: end
+        COMMAND_SET_PRIORITY = 11,  // param1: priority
+        COMMAND_PROTECT = 12,
+        COMMAND_SET_BUS_VOLUME = 13, // id: busID (0 for master), value, fade
+        COMMAND_SET_SEAMLESS_LOOPS = 14, // param1: seamless
+        COMMAND_SET_SEND = 15,      // param1: busID (0 for master), value: level. Result: true if set
+        COMMAND_START_AT_ENGINE_TIME = 16, // param1: engine time low 32 bits, param2: high 32 bits. Result: true if scheduled
+        COMMAND_CREATE_RESERVED = 17, // id: voiceID from ReserveVoice, param1: bankID, param2: busID. Result: voiceID
+        COMMAND_START_AT_TIME = 18, // value: time in seconds. Result: true if started
+        COMMAND_COMMIT_GROUP = 19,  // The starts held so far begin in the same audio pass
+        COMMAND_START_SEGMENTS = 20 // param1: ticket from PostSegments. Result: true if started
+    };
+
+    // Blittable so an array of commands can be passed from C# as is
+    struct Command
+    {
+        CommandType type;
+        // The voiceID, except for CREATE_VOICE and SET_BUS_VOLUME
+        // A negative id refers to the voice created earlier in the same batch: -1 is the result of the first command
+        INT32 id;
+        INT32 param1;
+        INT32 param2;
+        FLOAT value;
+        FLOAT fade;
+    };
+
+    struct CommandResult
+    {
+        INT32 value;
+        BOOL success;   // false when the target doesn't exist or the command failed
+    };
+
+    enum EffectCommandType : UINT32
+    {
+        EFFECT_SET_REVERB = 1,
+        EFFECT_REMOVE_REVERB = 2,
+        EFFECT_SET_EQ = 3,
+        EFFECT_REMOVE_EQ = 4,
+        EFFECT_SET_ECHO = 5,
+        EFFECT_REMOVE_ECHO = 6,
+        EFFECT_SET_ECHO_MAX_DELAY = 7,
+        EFFECT_SET_FILTER = 8,
+        EFFECT_REMOVE_FILTER = 9,
+        EFFECT_SET_COMPRESSOR = 10,
+        EFFECT_REMOVE_COMPRESSOR = 11,
+        EFFECT_SET_LIMITER = 12,
+        EFFECT_REMOVE_LIMITER = 13,
+        EFFECT_SET_CONVOLUTION = 14,
+        EFFECT_REMOVE_CONVOLUTION = 15
+    };
+
+    // Effect changes posted by the exports, their parameters don't fit in a Command
+    struct EffectCommand
+    {
+        EffectCommandType type;
+        INT32 id;           // The voiceID or busID
+        BOOL isBus;
+        FLOAT fade;
+        union
+        {
+            XAUDIO2FX_REVERB_PARAMETERS reverb;
+            FXEQ_PARAMETERS eq;
+            FXECHO_PARAMETERS echo;
+            struct
+            {
+                XAUDIO2_FILTER_TYPE type;
+                FLOAT cutoff;
+                FLOAT q;
+            } filter;
+            FLOAT maxDelay;
+            INT32 sidechainBusID;
+            struct
+            {
+                INT32 bankID;
+                UINT32 ticket;      // The copy of the bank, see PostImpulseResponse
+                FLOAT wetDryMix;
+            } convolution;
+        };
+        // Outside of the union, their default values make them non-trivial
+        CompressorParameters compressor;
+        LimiterParameters limiter;
+    };
+
+    /// <summary>
+    /// Execute a single command, the control lock must be held
+    /// </summary>
+    /// <param name="command">The command to execute</param>
+    /// <param name="voiceID">The voice targeted, with references to the batch already resolved</param>
+    CommandResult ExecuteCommand(const Command& command, const INT32 voiceID);
+
+    /// <summary>
+    /// Execute the commands in order
+    /// </summary>
+    /// <param name="commands">The commands to execute</param>
+    /// <param name="count">The number of commands</param>
+    /// <param name="results">Receives one result per command, can be null</param>
+    void ProcessCommands(const Command* commands, const UINT32 count, CommandResult* results);
+
+    /// <summary>
+    /// Execute an effect change, the control lock must be held
+    /// </summary>
+    void ExecuteEffectCommand(const EffectCommand& command);
+}
@@ -0,0 +1,751 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "Dsp.h"
+#include <emmintrin.h>
+
+namespace SaXAudio
+{
+#define PI 3.14159265358979323846
+
+    // Windowed sinc giving the 4 points between two samples, coefficients[tap][phase]
+    // The taps cover the last 12 samples, the interpolated points sit between the 6th and 7th last
+    struct TruePeakFilter
+    {
+        alignas(16) FLOAT coefficients[TRUE_PEAK_TAPS][TRUE_PEAK_PHASES];
+
+        TruePeakFilter()
+        {
+            const double halfWidth = TRUE_PEAK_TAPS / 2;
+            for (UINT32 tap = 0; tap < TRUE_PEAK_TAPS; tap++)
+            {
+                for (UINT32 phase = 0; phase < TRUE_PEAK_PHASES; phase++)
+                {
+                    double distance = tap - (halfWidth - 1) - (double)phase / TRUE_PEAK_PHASES;
+                    double sinc = distance == 0 ? 1.0 : sin(PI * distance) / (PI * distance);
+                    double window = 0.5 + 0.5 * cos(PI * distance / halfWidth);
+                    coefficients[tap][phase] = (FLOAT)(sinc * window);
+                }
+            }
+        }
+    };
+    static const TruePeakFilter s_truePeakFilter;
+
+    // Convert 8-bit PCM to 32-bit float
+    void ConvertPCM8ToFloat(const BYTE* pcmData, FLOAT* floatData, UINT32 sampleCount)
+    {
+        for (UINT32 i = 0; i < sampleCount; i++)
+        {
+            // 8-bit PCM is unsigned, convert to signed then to float
+            INT8 signedValue = static_cast<INT8>(pcmData[i] - 128);
+            floatData[i] = static_cast<FLOAT>(signedValue) / 128.0f;
+        }
+    }
+
+    // Convert 16-bit PCM to 32-bit float
+    void ConvertPCM16ToFloat(const INT16* pcmData, FLOAT* floatData, UINT32 sampleCount)
+    {
+        for (UINT32 i = 0; i < sampleCount; i++)
+        {
+            floatData[i] = static_cast<FLOAT>(pcmData[i]) / 32768.0f;
+        }
+    }
+
+    // Convert 24-bit PCM to 32-bit float
+    void ConvertPCM24ToFloat(const BYTE* pcmData, FLOAT* floatData, UINT32 sampleCount)
+    {
+        for (UINT32 i = 0; i < sampleCount; i++)
+        {
+            // Extract 24-bit value (little endian)
+            INT32 value = (pcmData[i * 3] << 8) | (pcmData[i * 3 + 1] << 16) | (pcmData[i * 3 + 2] << 24);
+            value >>= 8; // Sign extend from 24 to 32 bits
+
+            floatData[i] = static_cast<FLOAT>(value) / 8388608.0f; // 2^23
+        }
+    }
+
+    // Convert 32-bit PCM to 32-bit float
+    void ConvertPCM32ToFloat(const INT32* pcmData, FLOAT* floatData, UINT32 sampleCount)
+    {
+        for (UINT32 i = 0; i < sampleCount; i++)
+        {
+            floatData[i] = static_cast<FLOAT>(pcmData[i]) / 2147483648.0f; // 2^31
+        }
+    }
+
+    void Resample(const FLOAT* input, const UINT32 frames, const UINT32 channels, const UINT32 inputRate, const UINT32 outputRate, vector<FLOAT>& output)
+    {
+        const double step = (double)inputRate / outputRate;
+        const UINT32 outputFrames = max((UINT32)(frames / step), 1u);
+        output.assign((size_t)outputFrames * channels, 0.0f);
+        if (inputRate == outputRate)
+        {
+            copy(input, input + min(frames, outputFrames) * channels, output.begin());
+            return;
+        }
+
+        // The cutoff follows the lower of the two Nyquist frequencies, the sinc gets wider as it goes down
+        const double cutoff = min(1.0, 1.0 / step);
+        const double halfWidth = RESAMPLE_ZERO_CROSSINGS / cutoff;
+        vector<double> weights;
+        for (UINT32 i = 0; i < outputFrames; i++)
+        {
+            const double center = i * step;
+            const INT64 first = max((INT64)ceil(center - halfWidth), (INT64)0);
+            const INT64 last = min((INT64)floor(center + halfWidth), (INT64)frames - 1);
+
+            // Same weights for every channel
+            weights.clear();
+            for (INT64 k = first; k <= last; k++)
+            {
+                double distance = k - center;
+                double x = PI * distance * cutoff;
+                double sinc = x == 0 ? 1.0 : sin(x) / x;
+                double window = 0.5 + 0.5 * cos(PI * distance / halfWidth);
+                weights.push_back(cutoff * sinc * window);
+            }
+
+            for (UINT32 c = 0; c < channels; c++)
+            {
+                double sum = 0;
+                for (INT64 k = first; k <= last; k++)
+                    sum += weights[k - first] * input[k * channels + c];
+                output[(size_t)i * channels + c] = (FLOAT)sum;
+            }
+        }
+    }
+
+    void MeasureLevels(const FLOAT* samples, const UINT32 frames, const UINT32 channels, FLOAT* peak, FLOAT* rms)
+    {
+        for (UINT32 c = 0; c < channels; c++)
+        {
+            peak[c] = 0;
+            rms[c] = 0;
+        }
+        if (frames == 0 || channels == 0)
+            return;
+
+        UINT32 count = frames * channels;
+        UINT32 i = 0;
+
+        if (channels <= 2)
+        {
+            // Clearing the sign bit gives the absolute value
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            __m128 maxAbs = _mm_setzero_ps();
+            __m128 sumSquares = _mm_setzero_ps();
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 value = _mm_loadu_ps(samples + i);
+                maxAbs = _mm_max_ps(maxAbs, _mm_and_ps(value, absMask));
+                sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(value, value));
+            }
+
+            // Stereo lanes are L R L R, mono lanes are all the same channel
+            FLOAT lanesMax[4];
+            FLOAT lanesSum[4];
+            _mm_storeu_ps(lanesMax, maxAbs);
+            _mm_storeu_ps(lanesSum, sumSquares);
+            for (UINT32 lane = 0; lane < 4; lane++)
+            {
+                peak[lane % channels] = max(peak[lane % channels], lanesMax[lane]);
+                rms[lane % channels] += lanesSum[lane];
+            }
+        }
+
+        // What is left, or everything for more than 2 channels
+        for (; i < count; i++)
+        {
+            UINT32 c = i % channels;
+            peak[c] = max(peak[c], fabsf(samples[i]));
+            rms[c] += samples[i] * samples[i];
+        }
+
+        for (UINT32 c = 0; c < channels; c++)
+            rms[c] = sqrtf(rms[c] / frames);
+    }
+
+    void LoudnessMeter::Init(const UINT32 channels, const UINT32 sampleRate)
+    {
+        *this = LoudnessMeter();
+        if (channels > LOUDNESS_MAX_CHANNELS || sampleRate == 0)
+            return;
+
+        m_channels = channels;
+        m_segmentLength = max(sampleRate / 10, 1u);
+
+        // K-weighting filters from BS.1770, recomputed for the sample rate of the sound
+        double K = tan(PI * 1681.974450955533 / sampleRate);
+        double Q = 0.7071752369554196;
+        double Vh = pow(10.0, 3.999843853973347 / 20.0);
+        double Vb = pow(Vh, 0.4996667741545416);
+        double a0 = 1.0 + K / Q + K * K;
+        m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+        m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+        K = tan(PI * 38.13547087602444 / sampleRate);
+        Q = 0.5003270373238773;
+        a0 = 1.0 + K / Q + K * K;
+        m_highPass.b0 = 1.0;
+        m_highPass.b1 = -2.0;
+        m_highPass.b2 = 1.0;
+        m_highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+        m_highPass.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    void LoudnessMeter::Process(const FLOAT* samples, const UINT32 frames)
+    {
+        if (m_channels == 0)
+            return;
+
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        __m128 maxAbs = _mm_setzero_ps();
+
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            for (UINT32 c = 0; c < m_channels; c++)
+            {
+                FLOAT x = samples[i * m_channels + c];
+                double* state = m_state[c];
+
+                // Two biquads, transposed direct form II
+                double y = m_shelf.b0 * x + state[0];
+                state[0] = m_shelf.b1 * x - m_shelf.a1 * y + state[1];
+                state[1] = m_shelf.b2 * x - m_shelf.a2 * y;
+
+                double z = m_highPass.b0 * y + state[2];
+                state[2] = m_highPass.b1 * y - m_highPass.a1 * z + state[3];
+                state[3] = m_highPass.b2 * y - m_highPass.a2 * z;
+
+                m_segmentSum += z * z;
+
+                // 4x oversampling, one tap of the 4 phases per SSE multiply
+                FLOAT* history = m_history[c];
+                history[m_historyIndex] = x;
+                history[m_historyIndex + TRUE_PEAK_TAPS] = x;
+
+                const FLOAT* window = history + m_historyIndex + 1;
+                __m128 sum = _mm_setzero_ps();
+                for (UINT32 tap = 0; tap < TRUE_PEAK_TAPS; tap++)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(s_truePeakFilter.coefficients[tap]), _mm_set1_ps(window[tap])));
+                maxAbs = _mm_max_ps(maxAbs, _mm_and_ps(sum, absMask));
+            }
+            m_historyIndex = (m_historyIndex + 1) % TRUE_PEAK_TAPS;
+
+            if (++m_segmentFrames == m_segmentLength)
+            {
+                m_segments.push_back(m_segmentSum / m_segmentLength);
+                m_segmentSum = 0;
+                m_segmentFrames = 0;
+            }
+        }
+
+        FLOAT lanes[4];
+        _mm_storeu_ps(lanes, maxAbs);
+        for (UINT32 lane = 0; lane < 4; lane++)
+            m_truePeak = max(m_truePeak, lanes[lane]);
+    }
+
+    FLOAT LoudnessMeter::GetLoudness()
+    {
+        if (m_channels == 0)
+            return LOUDNESS_SILENCE;
+
+        // 400ms blocks overlapping by 75%
+        vector<double> blocks;
+        if (m_segments.size() < 4)
+        {
+            // Shorter than a block, the whole sound is a single block
+            UINT32 frames = (UINT32)m_segments.size() * m_segmentLength + m_segmentFrames;
+            if (frames == 0)
+                return LOUDNESS_SILENCE;
+
+            double sum = m_segmentSum;
+            for (double segment : m_segments)
+                sum += segment * m_segmentLength;
+            blocks.push_back(sum / frames);
+        }
+        else
+        {
+            blocks.reserve(m_segments.size() - 3);
+            for (size_t i = 0; i + 4 <= m_segments.size(); i++)
+                blocks.push_back((m_segments[i] + m_segments[i + 1] + m_segments[i + 2] + m_segments[i + 3]) / 4);
+        }
+
+        auto toLoudness = [](const double meanSquare) { return meanSquare > 0 ? -0.691 + 10.0 * log10(meanSquare) : -1000.0; };
+
+        // Absolute gate, then relative gate 10 LU under the loudness of what passed
+        double gate = LOUDNESS_SILENCE;
+        double loudness = LOUDNESS_SILENCE;
+        for (UINT32 pass = 0; pass < 2; pass++)
+        {
+            double sum = 0;
+            UINT32 count = 0;
+            for (double block : blocks)
+            {
+                if (toLoudness(block) > gate)
+                {
+                    sum += block;
+                    count++;
+                }
+            }
+            if (count == 0)
+                return LOUDNESS_SILENCE;
+
+            loudness = toLoudness(sum / count);
+            gate = max(gate, loudness - 10.0);
+        }
+        return (FLOAT)max(loudness, (double)LOUDNESS_SILENCE);
+    }
+
+    void FFT::Init(const UINT32 size)
+    {
+        m_size = size;
+
+        UINT32 bits = 0;
+        while ((1u << bits) < size)
+            bits++;
+
+        m_reversed.resize(size);
+        for (UINT32 i = 0; i < size; i++)
+        {
+            UINT32 reversed = 0;
+            for (UINT32 bit = 0; bit < bits; bit++)
+                reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+            m_reversed[i] = reversed;
+        }
+
+        m_twiddleRe.resize(size);
+        m_twiddleIm.resize(size);
+        for (UINT32 half = 1; half < size; half <<= 1)
+        {
+            for (UINT32 k = 0; k < half; k++)
+            {
+                double angle = -PI * k / half;
+                m_twiddleRe[half - 1 + k] = (FLOAT)cos(angle);
+                m_twiddleIm[half - 1 + k] = (FLOAT)sin(angle);
+            }
+        }
+    }
+
+    void FFT::Transform(FLOAT* re, FLOAT* im, const BOOL inverse)
+    {
+        for (UINT32 i = 0; i < m_size; i++)
+        {
+            UINT32 j = m_reversed[i];
+            if (j > i)
+            {
+                swap(re[i], re[j]);
+                swap(im[i], im[j]);
+            }
+        }
+
+        // The inverse uses the conjugated twiddles
+        const FLOAT sign = inverse ? -1.0f : 1.0f;
+        const __m128 signs = _mm_set1_ps(sign);
+
+        for (UINT32 half = 1; half < m_size; half <<= 1)
+        {
+            const FLOAT* twiddleRe = &m_twiddleRe[half - 1];
+            const FLOAT* twiddleIm = &m_twiddleIm[half - 1];
+
+            for (UINT32 start = 0; start < m_size; start += half * 2)
+            {
+                FLOAT* aRe = re + start;
+                FLOAT* aIm = im + start;
+                FLOAT* bRe = aRe + half;
+                FLOAT* bIm = aIm + half;
+
+                // From the third stage on, 4 butterflies at a time
+                UINT32 k = 0;
+                for (; k + 4 <= half; k += 4)
+                {
+                    __m128 wr = _mm_loadu_ps(twiddleRe + k);
+                    __m128 wi = _mm_mul_ps(_mm_loadu_ps(twiddleIm + k), signs);
+                    __m128 xr = _mm_loadu_ps(bRe + k);
+                    __m128 xi = _mm_loadu_ps(bIm + k);
+                    __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+                    __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+                    __m128 ur = _mm_loadu_ps(aRe + k);
+                    __m128 ui = _mm_loadu_ps(aIm + k);
+                    _mm_storeu_ps(bRe + k, _mm_sub_ps(ur, tr));
+                    _mm_storeu_ps(bIm + k, _mm_sub_ps(ui, ti));
+                    _mm_storeu_ps(aRe + k, _mm_add_ps(ur, tr));
+                    _mm_storeu_ps(aIm + k, _mm_add_ps(ui, ti));
+                }
+                for (; k < half; k++)
+                {
+                    FLOAT wr = twiddleRe[k];
+                    FLOAT wi = twiddleIm[k] * sign;
+                    FLOAT tr = bRe[k] * wr - bIm[k] * wi;
+                    FLOAT ti = bRe[k] * wi + bIm[k] * wr;
+                    bRe[k] = aRe[k] - tr;
+                    bIm[k] = aIm[k] - ti;
+                    aRe[k] += tr;
+                    aIm[k] += ti;
+                }
+            }
+        }
+    }
+
+    // sum += a * b on complex numbers, count must be a multiple of 4
+    static void MultiplyAccumulate(const FLOAT* aRe, const FLOAT* aIm, const FLOAT* bRe, const FLOAT* bIm, FLOAT* sumRe, FLOAT* sumIm, const UINT32 count)
+    {
+        for (UINT32 i = 0; i < count; i += 4)
+        {
+            __m128 ar = _mm_loadu_ps(aRe + i);
+            __m128 ai = _mm_loadu_ps(aIm + i);
+            __m128 br = _mm_loadu_ps(bRe + i);
+            __m128 bi = _mm_loadu_ps(bIm + i);
+            __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+            __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+            _mm_storeu_ps(sumRe + i, _mm_add_ps(_mm_loadu_ps(sumRe + i), re));
+            _mm_storeu_ps(sumIm + i, _mm_add_ps(_mm_loadu_ps(sumIm + i), im));
+        }
+    }
+
+    ConvolutionEngine::ConvolutionEngine(const FLOAT* response, const UINT32 frames, const UINT32 responseChannels, const UINT32 channels)
+    {
+        const UINT32 size = CONVOLUTION_BLOCK * 2;
+
+        m_channels = channels;
+        m_responseChannels = max(responseChannels, 1u);
+        m_partitions = max((frames + CONVOLUTION_BLOCK - 1) / CONVOLUTION_BLOCK, 1u);
+        m_bins = (CONVOLUTION_BLOCK + 1 + 3) & ~3u;
+
+        m_fft.Init(size);
+        m_re.resize(size);
+        m_im.resize(size);
+        m_sumRe.resize(m_bins);
+        m_sumIm.resize(m_bins);
+
+        // Same energy as a unit impulse, the reverb is about as loud as the dry sound
+        double energy = 0;
+        for (UINT32 i = 0; i < frames * responseChannels; i++)
+            energy += (double)response[i] * response[i];
+        FLOAT scale = energy > 0 ? (FLOAT)(1.0 / sqrt(energy / m_responseChannels)) : 0.0f;
+
+        m_responseRe.assign(m_responseChannels * m_partitions * m_bins, 0.0f);
+        m_responseIm.assign(m_responseChannels * m_partitions * m_bins, 0.0f);
+        for (UINT32 c = 0; c < responseChannels; c++)
+        {
+            for (UINT32 p = 0; p < m_partitions; p++)
+            {
+                // Each block is zero padded to twice its size, overlap-save keeps the second half of the result
+                fill(m_re.begin(), m_re.end(), 0.0f);
+                fill(m_im.begin(), m_im.end(), 0.0f);
+                for (UINT32 i = 0; i < CONVOLUTION_BLOCK; i++)
+                {
+                    UINT32 frame = p * CONVOLUTION_BLOCK + i;
+                    if (frame >= frames)
+                        break;
+                    m_re[i] = response[frame * responseChannels + c] * scale;
+                }
+                m_fft.Forward(m_re.data(), m_im.data());
+
+                UINT32 offset = (c * m_partitions + p) * m_bins;
+                copy(m_re.begin(), m_re.begin() + CONVOLUTION_BLOCK + 1, m_responseRe.begin() + offset);
+                copy(m_im.begin(), m_im.begin() + CONVOLUTION_BLOCK + 1, m_responseIm.begin() + offset);
+            }
+        }
+
+        m_inputRe.resize(m_channels * m_partitions * m_bins);
+        m_inputIm.resize(m_channels * m_partitions * m_bins);
+        m_window.resize(m_channels * size);
+        m_input.resize(m_channels * CONVOLUTION_BLOCK);
+        m_output.resize(m_channels * CONVOLUTION_BLOCK);
+        Reset();
+    }
+
+    void ConvolutionEngine::Reset()
+    {
+        fill(m_inputRe.begin(), m_inputRe.end(), 0.0f);
+        fill(m_inputIm.begin(), m_inputIm.end(), 0.0f);
+        fill(m_window.begin(), m_window.end(), 0.0f);
+        fill(m_input.begin(), m_input.end(), 0.0f);
+        fill(m_output.begin(), m_output.end(), 0.0f);
+        m_slot = 0;
+        m_position = 0;
+    }
+
+    void ConvolutionEngine::Process(FLOAT* samples, const UINT32 frames, const FLOAT wet, const FLOAT dry)
+    {
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            FLOAT* frame = samples + i * m_channels;
+            for (UINT32 c = 0; c < m_channels; c++)
+            {
+                UINT32 index = c * CONVOLUTION_BLOCK + m_position;
+                m_input[index] = frame[c];
+                frame[c] = frame[c] * dry + m_output[index] * wet;
+            }
+
+            if (++m_position == CONVOLUTION_BLOCK)
+            {
+                ProcessBlock();
+                m_position = 0;
+            }
+        }
+    }
+
+    void ConvolutionEngine::ProcessBlock()
+    {
+        const UINT32 size = CONVOLUTION_BLOCK * 2;
+        const FLOAT scale = 1.0f / size;
+
+        for (UINT32 c = 0; c < m_channels; c++)
+        {
+            // Slide the window by one block
+            FLOAT* window = &m_window[c * size];
+            memmove(window, window + CONVOLUTION_BLOCK, CONVOLUTION_BLOCK * sizeof(FLOAT));
+            memcpy(window + CONVOLUTION_BLOCK, &m_input[c * CONVOLUTION_BLOCK], CONVOLUTION_BLOCK * sizeof(FLOAT));
+
+            memcpy(m_re.data(), window, size * sizeof(FLOAT));
+            fill(m_im.begin(), m_im.end(), 0.0f);
+            m_fft.Forward(m_re.data(), m_im.data());
+
+            // The input is real, the bins above the block size mirror the ones below
+            UINT32 channelOffset = c * m_partitions * m_bins;
+            memcpy(&m_inputRe[channelOffset + m_slot * m_bins], m_re.data(), (CONVOLUTION_BLOCK + 1) * sizeof(FLOAT));
+            memcpy(&m_inputIm[channelOffset + m_slot * m_bins], m_im.data(), (CONVOLUTION_BLOCK + 1) * sizeof(FLOAT));
+
+            fill(m_sumRe.begin(), m_sumRe.end(), 0.0f);
+            fill(m_sumIm.begin(), m_sumIm.end(), 0.0f);
+
+            // Partition p of the response goes with the input from p blocks ago
+            UINT32 responseOffset = (c % m_responseChannels) * m_partitions * m_bins;
+            for (UINT32 p = 0; p < m_partitions; p++)
+            {
+                UINT32 slot = (m_slot + m_partitions - p) % m_partitions;
+                MultiplyAccumulate(&m_inputRe[channelOffset + slot * m_bins], &m_inputIm[channelOffset + slot * m_bins],
+                    &m_responseRe[responseOffset + p * m_bins], &m_responseIm[responseOffset + p * m_bins],
+                    m_sumRe.data(), m_sumIm.data(), m_bins);
+            }
+
+            for (UINT32 k = 0; k <= CONVOLUTION_BLOCK; k++)
+            {
+                m_re[k] = m_sumRe[k];
+                m_im[k] = m_sumIm[k];
+            }
+            for (UINT32 k = 1; k < CONVOLUTION_BLOCK; k++)
+            {
+                m_re[size - k] = m_sumRe[k];
+                m_im[size - k] = -m_sumIm[k];
+            }
+            m_fft.Inverse(m_re.data(), m_im.data());
+
+            FLOAT* output = &m_output[c * CONVOLUTION_BLOCK];
+            for (UINT32 i = 0; i < CONVOLUTION_BLOCK; i++)
+                output[i] = m_re[CONVOLUTION_BLOCK + i] * scale;
+        }
+
+        m_slot = (m_slot + 1) % m_partitions;
+    }
+
+    // Coefficient of a one pole filter reaching 63% of the way in the given time
+    static FLOAT OnePole(const FLOAT milliseconds, const UINT32 sampleRate)
+    {
+        return 1.0f - expf(-1000.0f / (milliseconds * sampleRate));
+    }
+
+    void CompressorEngine::Init(const UINT32 channels, const UINT32 sampleRate)
+    {
+        m_channels = channels;
+        m_sampleRate = sampleRate;
+        SetParameters(m_parameters);
+        Reset();
+    }
+
+    void CompressorEngine::SetParameters(const CompressorParameters& parameters)
+    {
+        m_parameters.Threshold = min(max(parameters.Threshold, -60.0f), 0.0f);
+        m_parameters.Ratio = min(max(parameters.Ratio, 1.0f), 100.0f);
+        m_parameters.Attack = min(max(parameters.Attack, 0.1f), 500.0f);
+        m_parameters.Release = min(max(parameters.Release, 1.0f), 5000.0f);
+        m_parameters.MakeupGain = min(max(parameters.MakeupGain, 0.0f), 24.0f);
+        m_parameters.RMS = parameters.RMS;
+
+        m_threshold = powf(10.0f, m_parameters.Threshold / 20.0f);
+        m_slope = 1.0f - 1.0f / m_parameters.Ratio;
+        m_attack = OnePole(m_parameters.Attack, m_sampleRate);
+        m_release = OnePole(m_parameters.Release, m_sampleRate);
+        m_rmsWindow = OnePole(10.0f, m_sampleRate);
+    }
+
+    void CompressorEngine::Reset()
+    {
+        m_meanSquare = 0;
+        m_reduction = 0;
+    }
+
+    void CompressorEngine::Process(FLOAT* samples, const UINT32 frames, const FLOAT key)
+    {
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            FLOAT* frame = samples + i * m_channels;
+
+            FLOAT level = key;
+            if (key < 0)
+            {
+                FLOAT peak = 0;
+                FLOAT sum = 0;
+                for (UINT32 c = 0; c < m_channels; c++)
+                {
+                    peak = max(peak, fabsf(frame[c]));
+                    sum += frame[c] * frame[c];
+                }
+
+                if (m_parameters.RMS)
+                {
+                    m_meanSquare += (sum / m_channels - m_meanSquare) * m_rmsWindow;
+                    level = sqrtf(m_meanSquare);
+                }
+                else
+                {
+                    level = peak;
+                }
+            }
+
+            // Only the part above the threshold is reduced
+            FLOAT target = 0;
+            if (level > m_threshold)
+                target = (m_parameters.Threshold - 20.0f * log10f(level)) * m_slope;
+
+            m_reduction += (target - m_reduction) * (target < m_reduction ? m_attack : m_release);
+            if (target == 0 && m_reduction > -0.001f)
+                m_reduction = 0;
+
+            FLOAT gain = m_reduction + m_parameters.MakeupGain;
+            if (gain != 0)
+            {
+                gain = powf(10.0f, gain / 20.0f);
+                for (UINT32 c = 0; c < m_channels; c++)
+                    frame[c] *= gain;
+            }
+        }
+    }
+
+    void LimiterEngine::Init(const UINT32 channels, const UINT32 sampleRate)
+    {
+        m_channels = channels;
+        m_sampleRate = sampleRate;
+        m_capacity = max((UINT32)ceilf(LIMITER_MAX_LOOKAHEAD * sampleRate / 1000.0f), 1u);
+
+        m_delay.resize(m_capacity * channels);
+        m_envelopes.resize(m_capacity);
+
+        // The minimum is taken over the look-ahead plus the current frame
+        m_minimumGains.resize(m_capacity + 1);
+        m_minimumFrames.resize(m_capacity + 1);
+
+        m_lookahead = 0;
+        SetParameters(m_parameters);
+    }
+
+    void LimiterEngine::SetParameters(const LimiterParameters& parameters)
+    {
+        m_parameters.Ceiling = min(max(parameters.Ceiling, -24.0f), 0.0f);
+        m_parameters.Release = min(max(parameters.Release, 1.0f), 1000.0f);
+        m_parameters.Lookahead = min(max(parameters.Lookahead, 0.1f), LIMITER_MAX_LOOKAHEAD);
+
+        m_ceiling = powf(10.0f, m_parameters.Ceiling / 20.0f);
+        m_release = OnePole(m_parameters.Release, m_sampleRate);
+
+        // A different look-ahead changes the delay, what is in it is dropped
+        UINT32 lookahead = min(max((UINT32)(m_parameters.Lookahead * m_sampleRate / 1000.0f), 1u), m_capacity);
+        if (lookahead != m_lookahead)
+        {
+            m_lookahead = lookahead;
+            Reset();
+        }
+    }
+
+    void LimiterEngine::Reset()
+    {
+        fill(m_delay.begin(), m_delay.end(), 0.0f);
+        fill(m_envelopes.begin(), m_envelopes.end(), 1.0f);
+        m_sum = m_lookahead;
+        m_position = 0;
+        m_envelope = 1.0f;
+        m_gain = 1.0f;
+        m_minimumHead = 0;
+        m_minimumCount = 0;
+        m_frame = 0;
+    }
+
+    void LimiterEngine::Process(FLOAT* samples, const UINT32 frames)
+    {
+        const UINT32 queueSize = m_capacity + 1;
+
+        for (UINT32 i = 0; i < frames; i++, m_frame++)
+        {
+            FLOAT* frame = samples + i * m_channels;
+
+            FLOAT peak = 0;
+            for (UINT32 c = 0; c < m_channels; c++)
+                peak = max(peak, fabsf(frame[c]));
+            FLOAT needed = peak > m_ceiling ? m_ceiling / peak : 1.0f;
+
+            // Larger gains before this one can't be the minimum anymore
+            while (m_minimumCount > 0 && m_minimumGains[(m_minimumHead + m_minimumCount - 1) % queueSize] >= needed)
+                m_minimumCount--;
+            UINT32 back = (m_minimumHead + m_minimumCount) % queueSize;
+            m_minimumGains[back] = needed;
+            m_minimumFrames[back] = m_frame;
+            m_minimumCount++;
+
+            while (m_minimumFrames[m_minimumHead] + m_lookahead < m_frame)
+            {
+                m_minimumHead = (m_minimumHead + 1) % queueSize;
+                m_minimumCount--;
+            }
+
+            // Instant attack, the moving average spreads it over the look-ahead
+            FLOAT minimum = m_minimumGains[m_minimumHead];
+            if (minimum < m_envelope)
+                m_envelope = minimum;
+            else
+                m_envelope += (minimum - m_envelope) * m_release;
+
+            m_sum += m_envelope - m_envelopes[m_position];
+            m_envelopes[m_position] = m_envelope;
+            m_gain = min((FLOAT)(m_sum / m_lookahead), 1.0f);
+
+            FLOAT* delayed = &m_delay[m_position * m_channels];
+            for (UINT32 c = 0; c < m_channels; c++)
+            {
+                FLOAT sample = delayed[c];
+                delayed[c] = frame[c];
+                frame[c] = sample * m_gain;
+            }
+
+            if (++m_position == m_lookahead)
+                m_position = 0;
+        }
+    }
+}
@@ -0,0 +1,274 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+#define LOUDNESS_MAX_CHANNELS 8
+    // Phases of the true peak oversampling and taps per phase
+#define TRUE_PEAK_PHASES 4
+#define TRUE_PEAK_TAPS 12
+    // Loudness reported for silence, also the absolute gate of BS.1770
+#define LOUDNESS_SILENCE -70.0f
+    // Frames per partition of the convolution, also its latency
+#define CONVOLUTION_BLOCK 512
+    // Longest look-ahead of the limiter in ms
+#define LIMITER_MAX_LOOKAHEAD 10.0f
+    // Zero crossings of the resampling sinc on each side
+#define RESAMPLE_ZERO_CROSSINGS 16
+
+    struct CompressorParameters
+    {
+        FLOAT Threshold = -20.0f;   // [-60, 0] in dB
+        FLOAT Ratio = 4.0f;         // [1, 100], 4 gives 1dB out for every 4dB in above the threshold
+        FLOAT Attack = 10.0f;       // [0.1, 500] in ms
+        FLOAT Release = 100.0f;     // [1, 5000] in ms
+        FLOAT MakeupGain = 0.0f;    // [0, 24] in dB
+        BOOL RMS = false;           // Follow the RMS level instead of the peaks
+    };
+
+    struct LimiterParameters
+    {
+        FLOAT Ceiling = -1.0f;      // [-24, 0] in dB, the peaks don't go above
+        FLOAT Release = 50.0f;      // [1, 1000] in ms
+        FLOAT Lookahead = 5.0f;     // [0.1, LIMITER_MAX_LOOKAHEAD] in ms, also the latency of the limiter
+    };
+
+    // Conversions of wav PCM samples to 32-bit float, sampleCount is the number of samples of all channels
+    void ConvertPCM8ToFloat(const BYTE* pcmData, FLOAT* floatData, UINT32 sampleCount);
+    void ConvertPCM16ToFloat(const INT16* pcmData, FLOAT* floatData, UINT32 sampleCount);
+    void ConvertPCM24ToFloat(const BYTE* pcmData, FLOAT* floatData, UINT32 sampleCount);
+    void ConvertPCM32ToFloat(const INT32* pcmData, FLOAT* floatData, UINT32 sampleCount);
+
+    /// <summary>
+    /// Measure the peak and RMS level of each channel of interleaved samples
+    /// Mono and stereo use SSE2, 4 samples at a time
+    /// </summary>
+    /// <param name="samples">Interleaved samples</param>
+    /// <param name="frames">Number of frames (samples per channel)</param>
+    /// <param name="channels">Number of channels</param>
+    /// <param name="peak">Receives the peak of each channel</param>
+    /// <param name="rms">Receives the RMS of each channel</param>
+    void MeasureLevels(const FLOAT* samples, const UINT32 frames, const UINT32 channels, FLOAT* peak, FLOAT* rms);
+
+    /// <summary>
+    /// Change the sample rate of interleaved samples with a windowed sinc
+    /// Going down, the frequencies above the new Nyquist frequency are filtered out rather than folded back
+    /// Slow, meant for impulse responses and not for playback
+    /// </summary>
+    /// <param name="input">Interleaved samples</param>
+    /// <param name="frames">Number of frames (samples per channel)</param>
+    /// <param name="channels">Number of channels</param>
+    /// <param name="inputRate">Sample rate of the input</param>
+    /// <param name="outputRate">Sample rate wanted</param>
+    /// <param name="output">Receives the interleaved samples, at least one frame</param>
+    void Resample(const FLOAT* input, const UINT32 frames, const UINT32 channels, const UINT32 inputRate, const UINT32 outputRate, vector<FLOAT>& output);
+
+    // Integrated loudness (ITU-R BS.1770, LUFS) and true peak, fed in chunks as the sound is decoded
+    // Every channel has the same weight, surround weights don't apply to the banks
+    class LoudnessMeter
+    {
+    private:
+        struct Biquad
+        {
+            double b0 = 1, b1 = 0, b2 = 0;
+            double a1 = 0, a2 = 0;
+        };
+
+        UINT32 m_channels = 0;
+
+        // K-weighting: high shelf then high pass, with their state per channel
+        Biquad m_shelf;
+        Biquad m_highPass;
+        double m_state[LOUDNESS_MAX_CHANNELS][4] = {};
+
+        // Mean square of every 100ms segment, the gated blocks are 4 segments long
+        vector<double> m_segments;
+        UINT32 m_segmentLength = 0;
+        UINT32 m_segmentFrames = 0;
+        double m_segmentSum = 0;
+
+        // The last samples of each channel, written twice so the taps read them contiguously
+        FLOAT m_history[LOUDNESS_MAX_CHANNELS][TRUE_PEAK_TAPS * 2] = {};
+        UINT32 m_historyIndex = 0;
+        FLOAT m_truePeak = 0;
+
+    public:
+        void Init(const UINT32 channels, const UINT32 sampleRate);
+        void Process(const FLOAT* samples, const UINT32 frames);
+
+        FLOAT GetLoudness();
+        FLOAT GetTruePeak() { return m_truePeak; }
+    };
+
+    // Radix-2 complex FFT, the real and imaginary parts are in separate arrays
+    // Not scaled, Inverse(Forward(x)) gives x times the size
+    class FFT
+    {
+    private:
+        UINT32 m_size = 0;
+        vector<UINT32> m_reversed;
+
+        // Twiddles of each stage one after the other, a stage of half size h starts at h - 1
+        vector<FLOAT> m_twiddleRe;
+        vector<FLOAT> m_twiddleIm;
+
+        void Transform(FLOAT* re, FLOAT* im, const BOOL inverse);
+
+    public:
+        void Init(const UINT32 size);
+        void Forward(FLOAT* re, FLOAT* im) { Transform(re, im, false); }
+        void Inverse(FLOAT* re, FLOAT* im) { Transform(re, im, true); }
+    };
+
+    // Uniformly partitioned overlap-save convolution
+    // The impulse response is cut in blocks of CONVOLUTION_BLOCK frames, the spectrum of each block
+    // is multiplied with the spectrum of the input from as many blocks ago and the products are summed
+    // Everything is allocated by the constructor, Process and Reset don't allocate
+    class ConvolutionEngine
+    {
+    private:
+        UINT32 m_channels = 0;
+        UINT32 m_responseChannels = 0;
+        UINT32 m_partitions = 0;
+        UINT32 m_bins = 0;          // CONVOLUTION_BLOCK + 1 rounded up for SSE
+
+        FFT m_fft;
+
+        // Spectra, [channel][partition][bin]
+        vector<FLOAT> m_responseRe;
+        vector<FLOAT> m_responseIm;
+        vector<FLOAT> m_inputRe;    // Input of the last blocks, a ring indexed by m_slot
+        vector<FLOAT> m_inputIm;
+        UINT32 m_slot = 0;
+
+        // Per channel, the last 2 blocks of input, the block being filled and the block being output
+        vector<FLOAT> m_window;
+        vector<FLOAT> m_input;
+        vector<FLOAT> m_output;
+        UINT32 m_position = 0;
+
+        // Scratch
+        vector<FLOAT> m_re;
+        vector<FLOAT> m_im;
+        vector<FLOAT> m_sumRe;
+        vector<FLOAT> m_sumIm;
+
+        void ProcessBlock();
+
+    public:
+        /// <summary>
+        /// Prepare the spectra of the impulse response
+        /// </summary>
+        /// <param name="response">Interleaved impulse response, at the processing sample rate</param>
+        /// <param name="frames">Length of the impulse response</param>
+        /// <param name="responseChannels">Channels of the impulse response, repeated over the processed channels</param>
+        /// <param name="channels">Channels of the processed audio</param>
+        ConvolutionEngine(const FLOAT* response, const UINT32 frames, const UINT32 responseChannels, const UINT32 channels);
+
+        /// <summary>
+        /// Convolve interleaved samples in place, the reverb is delayed by CONVOLUTION_BLOCK frames
+        /// </summary>
+        void Process(FLOAT* samples, const UINT32 frames, const FLOAT wet, const FLOAT dry);
+        void Reset();
+
+        UINT32 GetChannels() { return m_channels; }
+        // Frames after the input goes silent before the output is silent too
+        UINT32 GetTail() { return (m_partitions + 1) * CONVOLUTION_BLOCK; }
+    };
+
+    // Feed forward compressor, the channels are linked and get the same gain
+    class CompressorEngine
+    {
+    private:
+        UINT32 m_channels = 0;
+        UINT32 m_sampleRate = 0;
+
+        CompressorParameters m_parameters;
+        FLOAT m_threshold = 1.0f;   // Linear, below it nothing is computed in dB
+        FLOAT m_slope = 0;
+        FLOAT m_attack = 0;         // One pole coefficients
+        FLOAT m_release = 0;
+        FLOAT m_rmsWindow = 0;
+
+        FLOAT m_meanSquare = 0;
+        FLOAT m_reduction = 0;      // In dB, 0 or negative
+
+    public:
+        void Init(const UINT32 channels, const UINT32 sampleRate);
+        void SetParameters(const CompressorParameters& parameters);
+        void Reset();
+
+        /// <summary>
+        /// Compress interleaved samples in place
+        /// </summary>
+        /// <param name="key">Level driving the compression instead of the samples, negative for none</param>
+        void Process(FLOAT* samples, const UINT32 frames, const FLOAT key);
+
+        FLOAT GetReduction() { return m_reduction; }
+    };
+
+    // Look-ahead peak limiter, the samples are delayed so the gain is already down when a peak comes out
+    // The minimum gain needed over the look-ahead is held then smoothed by a moving average as long as the look-ahead
+    // Everything is allocated by Init for the longest look-ahead
+    class LimiterEngine
+    {
+    private:
+        UINT32 m_channels = 0;
+        UINT32 m_sampleRate = 0;
+        UINT32 m_capacity = 0;
+
+        LimiterParameters m_parameters;
+        FLOAT m_ceiling = 1.0f;
+        FLOAT m_release = 0;
+        UINT32 m_lookahead = 1;     // In frames
+
+        // Delayed samples and the envelope being averaged, rings indexed by m_position
+        vector<FLOAT> m_delay;
+        vector<FLOAT> m_envelopes;
+        double m_sum = 0;
+        UINT32 m_position = 0;
+        FLOAT m_envelope = 1.0f;
+        FLOAT m_gain = 1.0f;
+
+        // Increasing gains needed over the look-ahead, the first one is the minimum
+        vector<FLOAT> m_minimumGains;
+        vector<UINT64> m_minimumFrames;
+        UINT32 m_minimumHead = 0;
+        UINT32 m_minimumCount = 0;
+        UINT64 m_frame = 0;
+
+    public:
+        void Init(const UINT32 channels, const UINT32 sampleRate);
+        void SetParameters(const LimiterParameters& parameters);
+        void Reset();
+
+        void Process(FLOAT* samples, const UINT32 frames);
+
+        UINT32 GetLatency() { return m_lookahead; }
+        FLOAT GetReduction() { return m_gain < 1.0f ? 20.0f * log10f(max(m_gain, 1e-6f)) : 0.0f; }
+    };
+}
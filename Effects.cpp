@@ -0,0 +1,342 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "Effects.h"
+
+namespace SaXAudio
+{
+#define XAPO_FLAGS_INPLACE XAPO_FLAG_CHANNELS_MUST_MATCH | XAPO_FLAG_FRAMERATE_MUST_MATCH | XAPO_FLAG_BITSPERSAMPLE_MUST_MATCH \
+    | XAPO_FLAG_BUFFERCOUNT_MUST_MATCH | XAPO_FLAG_INPLACE_SUPPORTED | XAPO_FLAG_INPLACE_REQUIRED
+
+    XAPO_REGISTRATION_PROPERTIES ConvolutionReverb::m_registration =
+    {
+        __uuidof(ConvolutionReverb),
+        L"SaXAudio Convolution Reverb",
+        L"Copyright(c) 2025 SamsamTS",
+        1, 0,
+        XAPO_FLAGS_INPLACE,
+        1, 1, 1, 1
+    };
+
+    ConvolutionReverb::ConvolutionReverb()
+        : CXAPOParametersBase(&m_registration, (BYTE*)m_parameters, sizeof(ConvolutionParameters), false)
+    {
+        ConvolutionParameters parameters;
+        SetParameters(&parameters, sizeof(ConvolutionParameters));
+    }
+
+    ConvolutionReverb::~ConvolutionReverb()
+    {
+        delete m_engine;
+        delete m_pending.exchange(nullptr);
+        delete m_retired.exchange(nullptr);
+    }
+
+    void ConvolutionReverb::SetEngine(ConvolutionEngine* engine)
+    {
+        delete m_retired.exchange(nullptr);
+
+        // Never picked by the audio thread, nothing else uses it
+        delete m_pending.exchange(engine);
+    }
+
+    HRESULT ConvolutionReverb::LockForProcess(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+        UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters)
+    {
+        HRESULT hr = CXAPOParametersBase::LockForProcess(InputLockedParameterCount, pInputLockedParameters, OutputLockedParameterCount, pOutputLockedParameters);
+        if (SUCCEEDED(hr))
+            m_channels = pInputLockedParameters[0].pFormat->nChannels;
+        return hr;
+    }
+
+    void ConvolutionReverb::Process(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+        UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled)
+    {
+        const ConvolutionParameters* parameters = (const ConvolutionParameters*)BeginProcess();
+
+        if (m_pending.load(memory_order_relaxed))
+        {
+            ConvolutionEngine* engine = m_pending.exchange(nullptr, memory_order_acquire);
+            if (engine)
+            {
+                if (m_engine)
+                    m_retired.store(m_engine, memory_order_release);
+                m_engine = engine;
+                m_wasEnabled = false;
+            }
+        }
+
+        // In place, the output buffer is the input buffer
+        const XAPO_PROCESS_BUFFER_PARAMETERS& input = pInputProcessParameters[0];
+        XAPO_PROCESS_BUFFER_PARAMETERS& output = pOutputProcessParameters[0];
+        output.BufferFlags = input.BufferFlags;
+        output.ValidFrameCount = input.ValidFrameCount;
+
+        if (!IsEnabled || !m_engine || m_engine->GetChannels() != m_channels)
+        {
+            m_wasEnabled = false;
+            EndProcess();
+            return;
+        }
+
+        // Don't carry the tail of when it was last enabled
+        if (!m_wasEnabled)
+        {
+            m_engine->Reset();
+            m_silentFrames = m_engine->GetTail();
+            m_wasEnabled = true;
+        }
+
+        FLOAT* samples = (FLOAT*)input.pBuffer;
+        if (input.BufferFlags == XAPO_BUFFER_SILENT)
+        {
+            // Nothing left of the tail, stay silent without processing
+            if (m_silentFrames >= m_engine->GetTail())
+            {
+                EndProcess();
+                return;
+            }
+            m_silentFrames += input.ValidFrameCount;
+
+            // A silent buffer isn't cleared
+            memset(samples, 0, input.ValidFrameCount * m_channels * sizeof(FLOAT));
+        }
+        else
+        {
+            m_silentFrames = 0;
+        }
+
+        FLOAT wet = min(max(parameters->WetDryMix, 0.0f), 100.0f) / 100.0f;
+        m_engine->Process(samples, input.ValidFrameCount, wet, 1.0f - wet);
+        output.BufferFlags = XAPO_BUFFER_VALID;
+
+        EndProcess();
+    }
+
+    XAPO_REGISTRATION_PROPERTIES Compressor::m_registration =
+    {
+        __uuidof(Compressor),
+        L"SaXAudio Compressor",
+        L"Copyright(c) 2025 SamsamTS",
+        1, 0,
+        XAPO_FLAGS_INPLACE,
+        1, 1, 1, 1
+    };
+
+    Compressor::Compressor()
+        : CXAPOParametersBase(&m_registration, (BYTE*)m_parameters, sizeof(CompressorParameters), false)
+    {
+        CompressorParameters parameters;
+        SetParameters(&parameters, sizeof(CompressorParameters));
+    }
+
+    void Compressor::SetSidechain(Compressor* sidechain)
+    {
+        if (sidechain == this)
+            sidechain = nullptr;
+
+        Compressor* previous = m_sidechain.exchange(sidechain);
+        if (previous)
+            previous->m_keyUsers--;
+        if (sidechain)
+            sidechain->m_keyUsers++;
+    }
+
+    HRESULT Compressor::LockForProcess(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+        UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters)
+    {
+        HRESULT hr = CXAPOParametersBase::LockForProcess(InputLockedParameterCount, pInputLockedParameters, OutputLockedParameterCount, pOutputLockedParameters);
+        if (SUCCEEDED(hr))
+        {
+            m_channels = pInputLockedParameters[0].pFormat->nChannels;
+            m_engine.Init(m_channels, pInputLockedParameters[0].pFormat->nSamplesPerSec);
+            m_peaks.resize(m_channels);
+            m_rms.resize(m_channels);
+            m_wasEnabled = false;
+        }
+        return hr;
+    }
+
+    void Compressor::Process(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+        UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled)
+    {
+        const CompressorParameters* parameters = (const CompressorParameters*)BeginProcess();
+        if (ParametersChanged())
+            m_engine.SetParameters(*parameters);
+
+        const XAPO_PROCESS_BUFFER_PARAMETERS& input = pInputProcessParameters[0];
+        XAPO_PROCESS_BUFFER_PARAMETERS& output = pOutputProcessParameters[0];
+        output.BufferFlags = input.BufferFlags;
+        output.ValidFrameCount = input.ValidFrameCount;
+
+        FLOAT* samples = (FLOAT*)input.pBuffer;
+        const BOOL silent = input.BufferFlags == XAPO_BUFFER_SILENT;
+
+        // Measured before compressing, even when disabled
+        if (m_keyUsers > 0)
+        {
+            FLOAT peak = 0;
+            FLOAT meanSquare = 0;
+            if (!silent)
+            {
+                MeasureLevels(samples, input.ValidFrameCount, m_channels, m_peaks.data(), m_rms.data());
+                for (UINT32 c = 0; c < m_channels; c++)
+                {
+                    peak = max(peak, m_peaks[c]);
+                    meanSquare += m_rms[c] * m_rms[c];
+                }
+                meanSquare /= m_channels;
+            }
+            m_keyPeak.store(peak, memory_order_relaxed);
+            m_keyRMS.store(sqrtf(meanSquare), memory_order_relaxed);
+        }
+
+        if (!IsEnabled)
+        {
+            m_wasEnabled = false;
+            EndProcess();
+            return;
+        }
+
+        if (!m_wasEnabled)
+        {
+            m_engine.Reset();
+            m_wasEnabled = true;
+        }
+
+        // The sidechain bus may be processed after this one, its level is then one pass old
+        Compressor* sidechain = m_sidechain.load(memory_order_acquire);
+        FLOAT key = -1.0f;
+        if (sidechain)
+            key = parameters->RMS ? sidechain->m_keyRMS.load(memory_order_relaxed) : sidechain->m_keyPeak.load(memory_order_relaxed);
+
+        // Nothing to compress, a silent buffer isn't cleared
+        if (!silent)
+            m_engine.Process(samples, input.ValidFrameCount, key);
+
+        EndProcess();
+    }
+
+    XAPO_REGISTRATION_PROPERTIES Limiter::m_registration =
+    {
+        __uuidof(Limiter),
+        L"SaXAudio Limiter",
+        L"Copyright(c) 2025 SamsamTS",
+        1, 0,
+        XAPO_FLAGS_INPLACE,
+        1, 1, 1, 1
+    };
+
+    Limiter::Limiter()
+        : CXAPOParametersBase(&m_registration, (BYTE*)m_parameters, sizeof(LimiterParameters), false)
+    {
+        LimiterParameters parameters;
+        SetParameters(&parameters, sizeof(LimiterParameters));
+    }
+
+    HRESULT Limiter::LockForProcess(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+        UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters)
+    {
+        HRESULT hr = CXAPOParametersBase::LockForProcess(InputLockedParameterCount, pInputLockedParameters, OutputLockedParameterCount, pOutputLockedParameters);
+        if (SUCCEEDED(hr))
+        {
+            m_channels = pInputLockedParameters[0].pFormat->nChannels;
+            m_engine.Init(m_channels, pInputLockedParameters[0].pFormat->nSamplesPerSec);
+            m_wasEnabled = false;
+        }
+        return hr;
+    }
+
+    void Limiter::Process(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+        UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled)
+    {
+        const LimiterParameters* parameters = (const LimiterParameters*)BeginProcess();
+        if (ParametersChanged())
+            m_engine.SetParameters(*parameters);
+
+        const XAPO_PROCESS_BUFFER_PARAMETERS& input = pInputProcessParameters[0];
+        XAPO_PROCESS_BUFFER_PARAMETERS& output = pOutputProcessParameters[0];
+        output.BufferFlags = input.BufferFlags;
+        output.ValidFrameCount = input.ValidFrameCount;
+
+        if (!IsEnabled)
+        {
+            m_wasEnabled = false;
+            EndProcess();
+            return;
+        }
+
+        // The delay starts empty, nothing from when it was last enabled comes out
+        if (!m_wasEnabled)
+        {
+            m_engine.Reset();
+            m_silentFrames = m_engine.GetLatency();
+            m_wasEnabled = true;
+        }
+
+        FLOAT* samples = (FLOAT*)input.pBuffer;
+        if (input.BufferFlags == XAPO_BUFFER_SILENT)
+        {
+            // The delay is empty, stay silent without processing
+            if (m_silentFrames >= m_engine.GetLatency())
+            {
+                EndProcess();
+                return;
+            }
+            m_silentFrames += input.ValidFrameCount;
+            memset(samples, 0, input.ValidFrameCount * m_channels * sizeof(FLOAT));
+        }
+        else
+        {
+            m_silentFrames = 0;
+        }
+
+        m_engine.Process(samples, input.ValidFrameCount);
+        output.BufferFlags = XAPO_BUFFER_VALID;
+
+        EndProcess();
+    }
+
+    XAPO_REGISTRATION_PROPERTIES EmptyEffect::m_registration =
+    {
+        __uuidof(EmptyEffect),
+        L"SaXAudio Empty Effect",
+        L"Copyright(c) 2025 SamsamTS",
+        1, 0,
+        XAPO_FLAGS_INPLACE,
+        1, 1, 1, 1
+    };
+
+    EmptyEffect::EmptyEffect()
+        : CXAPOBase(&m_registration)
+    {
+    }
+
+    void EmptyEffect::Process(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+        UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled)
+    {
+        pOutputProcessParameters[0].BufferFlags = pInputProcessParameters[0].BufferFlags;
+        pOutputProcessParameters[0].ValidFrameCount = pInputProcessParameters[0].ValidFrameCount;
+    }
+}
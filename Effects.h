@@ -0,0 +1,137 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+#include "Dsp.h"
+#include <xapobase.h>
+
+#pragma comment(lib, "xapobase.lib")
+
+namespace SaXAudio
+{
+    struct ConvolutionParameters
+    {
+        FLOAT WetDryMix = 100.0f;   // [0, 100] percentage of reverb, like the XAudio2 reverb
+    };
+
+    // Effect of the bus chains convolving the audio with an impulse response loaded from a bank
+    class __declspec(uuid("7fa443ad-0c94-4342-a28b-b4b387874131")) ConvolutionReverb : public CXAPOParametersBase
+    {
+    private:
+        static XAPO_REGISTRATION_PROPERTIES m_registration;
+
+        // Triple buffer used by CXAPOParametersBase to hand the parameters to the audio thread
+        ConvolutionParameters m_parameters[3];
+        UINT32 m_channels = 0;
+        BOOL m_wasEnabled = false;
+        UINT32 m_silentFrames = 0;
+
+        // The control thread sets a pending engine, the audio thread picks it and retires the old one
+        // The retired engine is deleted on the next SetEngine, never on the audio thread
+        ConvolutionEngine* m_engine = nullptr;
+        atomic<ConvolutionEngine*> m_pending = nullptr;
+        atomic<ConvolutionEngine*> m_retired = nullptr;
+
+    public:
+        ConvolutionReverb();
+        ~ConvolutionReverb();
+
+        void SetEngine(ConvolutionEngine* engine);
+
+        STDMETHOD(LockForProcess)(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+            UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters) override;
+        STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+            UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) override;
+    };
+
+    // Effect of the bus chains, also measures the level of its bus for the compressors using it as sidechain
+    class __declspec(uuid("7ec7c948-273d-4d15-b848-40bbc4804a67")) Compressor : public CXAPOParametersBase
+    {
+    private:
+        static XAPO_REGISTRATION_PROPERTIES m_registration;
+
+        CompressorParameters m_parameters[3];
+        CompressorEngine m_engine;
+        UINT32 m_channels = 0;
+        BOOL m_wasEnabled = false;
+
+        // Level of the last buffer processed, only measured while another compressor uses it
+        atomic<UINT32> m_keyUsers = 0;
+        atomic<FLOAT> m_keyPeak = 0;
+        atomic<FLOAT> m_keyRMS = 0;
+        vector<FLOAT> m_peaks;
+        vector<FLOAT> m_rms;
+
+        atomic<Compressor*> m_sidechain = nullptr;
+
+    public:
+        Compressor();
+
+        /// <summary>
+        /// Follow the level of another compressor's bus instead of the input, for ducking
+        /// Set by the control thread, the compressors are never deleted while the engine runs
+        /// </summary>
+        void SetSidechain(Compressor* sidechain);
+
+        STDMETHOD(LockForProcess)(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+            UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters) override;
+        STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+            UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) override;
+    };
+
+    // Effect of the bus chains keeping the peaks under a ceiling, delays its bus by the look-ahead
+    class __declspec(uuid("dc87974c-bd40-4fc8-a177-34c1282e32fb")) Limiter : public CXAPOParametersBase
+    {
+    private:
+        static XAPO_REGISTRATION_PROPERTIES m_registration;
+
+        LimiterParameters m_parameters[3];
+        LimiterEngine m_engine;
+        UINT32 m_channels = 0;
+        BOOL m_wasEnabled = false;
+        UINT32 m_silentFrames = 0;
+
+    public:
+        Limiter();
+
+        STDMETHOD(LockForProcess)(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+            UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters) override;
+        STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+            UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) override;
+    };
+
+    // Holds the place of an effect taken from a pool while it isn't used, so the chain indices don't move
+    class __declspec(uuid("d5f98bd4-1976-403d-9e96-15f4a1d6a659")) EmptyEffect : public CXAPOBase
+    {
+    private:
+        static XAPO_REGISTRATION_PROPERTIES m_registration;
+
+    public:
+        EmptyEffect();
+
+        STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+            UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) override;
+    };
+}
@@ -0,0 +1,129 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "EventQueue.h"
+
+namespace SaXAudio
+{
+    EventQueue& EventQueue::Instance = EventQueue::getInstance();
+    const INT32 EventQueue::INTERVAL;
+
+    BOOL EventQueue::Push(const EventType type, const INT32 voiceID, const INT32 bankID, const HRESULT result)
+    {
+        if (!m_events.Push({ type, voiceID, bankID, result }))
+        {
+            // Queue is full, nobody is consuming the events
+            m_dropped++;
+            return false;
+        }
+
+        if (m_running)
+            m_wait.notify_one();
+        return true;
+    }
+
+    UINT32 EventQueue::Poll(AudioEvent* events, const UINT32 maxCount)
+    {
+        if (!events) return 0;
+
+        UINT32 count = 0;
+        while (count < maxCount && m_events.Pop(events[count]))
+            count++;
+        return count;
+    }
+
+    UINT32 EventQueue::GetDroppedCount()
+    {
+        return m_dropped;
+    }
+
+    void EventQueue::SetOnFinishedCallback(const OnFinishedCallback callback)
+    {
+        m_onFinished = callback;
+        StartDispatcher();
+    }
+
+    void EventQueue::SetOnEventsCallback(const OnEventsCallback callback)
+    {
+        m_onEvents = callback;
+        StartDispatcher();
+    }
+
+    void EventQueue::StartDispatcher()
+    {
+        // Without callbacks the events are left in the queue for Poll
+        if (!m_onFinished && !m_onEvents)
+        {
+            StopDispatcher();
+            return;
+        }
+
+        if (!m_running.exchange(true))
+        {
+            if (m_thread && m_thread->joinable())
+                m_thread->join();
+            m_thread = make_unique<thread>(DoDispatch);
+        }
+    }
+
+    void EventQueue::StopDispatcher()
+    {
+        m_running = false;
+        m_wait.notify_one();
+
+        if (m_thread && m_thread->joinable() && m_thread->get_id() != this_thread::get_id())
+            m_thread->join();
+    }
+
+    void EventQueue::DoDispatch()
+    {
+        AudioEvent batch[BATCH_SIZE];
+
+        while (Instance.m_running)
+        {
+            UINT32 count = Instance.Poll(batch, BATCH_SIZE);
+            if (count == 0)
+            {
+                // Push doesn't take the lock, the timeout covers a missed notification
+                unique_lock<mutex> lock(Instance.m_waitMutex);
+                Instance.m_wait.wait_for(lock, chrono::milliseconds(INTERVAL));
+                continue;
+            }
+
+            // Callbacks are called in order, from this thread only
+            OnEventsCallback onEvents = Instance.m_onEvents;
+            if (onEvents)
+                onEvents(batch, count);
+
+            OnFinishedCallback onFinished = Instance.m_onFinished;
+            if (onFinished)
+            {
+                for (UINT32 i = 0; i < count; i++)
+                {
+                    if (batch[i].type == EVENT_VOICE_FINISHED)
+                        onFinished(batch[i].voiceID);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+#include "RingBuffer.h"
+
+namespace SaXAudio
+{
+    enum EventType : UINT32
+    {
+        EVENT_VOICE_FINISHED = 1,
+        EVENT_BANK_DECODED = 2,
+        EVENT_VOICE_ERROR = 3
+    };
+
+    struct AudioEvent
+    {
+        EventType type;
+        INT32 voiceID;
+        INT32 bankID;
+        HRESULT result;
+    };
+
+    typedef void (*OnFinishedCallback)(INT32 voiceID);
+    typedef void (*OnEventsCallback)(const AudioEvent* events, UINT32 count);
+
+    class EventQueue
+    {
+    private:
+        static const UINT32 CAPACITY = 4096;
+        static const UINT32 BATCH_SIZE = 64;
+        static const INT32 INTERVAL = 10;
+        EventQueue() = default;
+
+        RingBuffer<AudioEvent, CAPACITY> m_events;
+        atomic<UINT32> m_dropped = 0;
+
+        atomic<OnFinishedCallback> m_onFinished = nullptr;
+        atomic<OnEventsCallback> m_onEvents = nullptr;
+
+        atomic<bool> m_running = false;
+        unique_ptr<thread, default_delete<thread>> m_thread;
+        mutex m_waitMutex;
+        condition_variable m_wait;
+
+        static EventQueue& getInstance()
+        {
+            static EventQueue instance;
+            return instance;
+        }
+        EventQueue(const EventQueue&) = delete;
+        EventQueue& operator=(const EventQueue&) = delete;
+
+        static void DoDispatch();
+
+    public:
+        static EventQueue& Instance;
+
+        BOOL Push(const EventType type, const INT32 voiceID, const INT32 bankID, const HRESULT result = S_OK);
+        UINT32 Poll(AudioEvent* events, const UINT32 maxCount);
+        UINT32 GetDroppedCount();
+
+        void SetOnFinishedCallback(const OnFinishedCallback callback);
+        void SetOnEventsCallback(const OnEventsCallback callback);
+
+        void StartDispatcher();
+        void StopDispatcher();
+    };
+}
@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include "SaXAudio.h"
+#include "Commands.h"
+#include "Playlist.h"
 #include "Exports.h"
 
 BOOL APIENTRY DllMain(HMODULE hModule,
@@ -41,11 +43,62 @@ BOOL APIENTRY DllMain(HMODULE hModule,
 
 namespace SaXAudio
 {
+    // Setters are queued and applied by the control thread, the game thread never waits on the audio locks
+    inline void PostCommand(const CommandType type, const INT32 id, const INT32 param1, const INT32 param2, const FLOAT value, const FLOAT fade)
+    {
+        Command command = { type, id, param1, param2, value, fade };
+        SaXAudio::Instance.PostCommand(command);
+    }
+
+    // The voiceID of CreateVoice is only reserved until the control thread creates the voice, the commands posted meanwhile follow the creation
+    inline BOOL CanPost(const INT32 voiceID)
+    {
+        return SaXAudio::Instance.GetVoice(voiceID) != nullptr || SaXAudio::Instance.IsReserved(voiceID);
+    }
+
     EXPORT BOOL Create()
     {
         return SaXAudio::Instance.Init();
     }
 
+    EXPORT BOOL CreateSoftware(const UINT32 channels, const UINT32 sampleRate)
+    {
+        return SaXAudio::Instance.Init(true, channels, sampleRate);
+    }
+
+    EXPORT UINT32 Render(FLOAT* buffer, const UINT32 frames)
+    {
+        if (!buffer) return 0;
+        return SaXAudio::Instance.Render(buffer, frames);
+    }
+
+    EXPORT BOOL CreateOffline(const UINT32 channels, const UINT32 sampleRate)
+    {
+        return SaXAudio::Instance.Init(true, channels, sampleRate, true);
+    }
+
+    EXPORT UINT32 Advance(const FLOAT seconds)
+    {
+        return SaXAudio::Instance.Advance(seconds);
+    }
+
+    EXPORT BOOL StartCapture(const char* filePath)
+    {
+        if (!filePath) return false;
+        return SaXAudio::Instance.StartCapture(filePath);
+    }
+
+    EXPORT void StopCapture()
+    {
+        SaXAudio::Instance.StopCapture();
+    }
+
+    EXPORT BOOL GetRenderStats(RenderStats* stats, const BOOL reset)
+    {
+        if (!stats) return false;
+        return SaXAudio::Instance.GetRenderStats(stats, reset);
+    }
+
     EXPORT void Release()
     {
         SaXAudio::Instance.Release();
@@ -81,84 +134,37 @@ namespace SaXAudio
 
     EXPORT void PauseAll(const FLOAT fade, const INT32 busID)
     {
+        auto lock = SaXAudio::Instance.AcquireControl();
         SaXAudio::Instance.PauseAll(fade, busID);
     }
 
     EXPORT void ResumeAll(const FLOAT fade, const INT32 busID)
     {
+        auto lock = SaXAudio::Instance.AcquireControl();
         SaXAudio::Instance.ResumeAll(fade, busID);
     }
 
     EXPORT void StopAll(const FLOAT fade, const INT32 busID)
     {
+        auto lock = SaXAudio::Instance.AcquireControl();
         SaXAudio::Instance.StopAll(fade, busID);
     }
 
     EXPORT void Protect(const INT32 voiceID)
     {
+        auto lock = SaXAudio::Instance.AcquireControl();
         SaXAudio::Instance.Protect(voiceID);
     }
 
-    // WAV file header structures
-#pragma pack(push, 1)
-    struct WavHeader
-    {
-        char riff[4];           // "RIFF"
-        UINT32 fileSize;        // File size - 8
-        char wave[4];           // "WAVE"
-        char fmt[4];            // "fmt "
-        UINT32 fmtSize;         // Format chunk size
-        UINT16 audioFormat;     // Audio format (WAVE_FORMAT_IEEE_FLOAT)
-        UINT16 channels;        // Number of channels
-        UINT32 sampleRate;      // Sample rate
-        UINT32 byteRate;        // Byte rate (nSamplesPerSec * nBlockAlign)
-        UINT16 blockAlign;      // Block alignment (nChannels * wBitsPerSample / 8)
-        UINT16 bitsPerSample;   // Bits per sample (32 for IEEE float)
-        char data[4];           // "data"
-        UINT32 dataSize;        // Data chunk size
-    };
-#pragma pack(pop)
-
-    // Convert 8-bit PCM to 32-bit float
-    void ConvertPCM8ToFloat(const BYTE* pcmData, FLOAT* floatData, UINT32 sampleCount)
-    {
-        for (UINT32 i = 0; i < sampleCount; i++)
-        {
-            // 8-bit PCM is unsigned, convert to signed then to float
-            INT8 signedValue = static_cast<INT8>(pcmData[i] - 128);
-            floatData[i] = static_cast<FLOAT>(signedValue) / 128.0f;
-        }
-    }
-
-    // Convert 16-bit PCM to 32-bit float
-    void ConvertPCM16ToFloat(const INT16* pcmData, FLOAT* floatData, UINT32 sampleCount)
-    {
-        for (UINT32 i = 0; i < sampleCount; i++)
-        {
-            floatData[i] = static_cast<FLOAT>(pcmData[i]) / 32768.0f;
-        }
-    }
-
-    // Convert 24-bit PCM to 32-bit float
-    void ConvertPCM24ToFloat(const BYTE* pcmData, FLOAT* floatData, UINT32 sampleCount)
+    EXPORT void SetMaxRealVoices(const UINT32 count)
     {
-        for (UINT32 i = 0; i < sampleCount; i++)
-        {
-            // Extract 24-bit value (little endian)
-            INT32 value = (pcmData[i * 3] << 8) | (pcmData[i * 3 + 1] << 16) | (pcmData[i * 3 + 2] << 24);
-            value >>= 8; // Sign extend from 24 to 32 bits
-
-            floatData[i] = static_cast<FLOAT>(value) / 8388608.0f; // 2^23
-        }
+        auto lock = SaXAudio::Instance.AcquireControl();
+        SaXAudio::Instance.SetMaxRealVoices(count);
     }
 
-    // Convert 32-bit PCM to 32-bit float
-    void ConvertPCM32ToFloat(const INT32* pcmData, FLOAT* floatData, UINT32 sampleCount)
+    EXPORT void SetPriority(const INT32 voiceID, const UINT32 priority)
     {
-        for (UINT32 i = 0; i < sampleCount; i++)
-        {
-            floatData[i] = static_cast<FLOAT>(pcmData[i]) / 2147483648.0f; // 2^31
-        }
+        PostCommand(COMMAND_SET_PRIORITY, voiceID, (INT32)priority, 0, 0.0f, 0.0f);
     }
 
     /// <summary>
@@ -316,34 +322,76 @@ namespace SaXAudio
         SaXAudio::Instance.AutoRemoveBank(bankID);
     }
 
-    EXPORT INT32 CreateVoice(const INT32 bankID, const INT32 busID, const BOOL paused)
+    EXPORT void BankSetLimits(const INT32 bankID, const UINT32 maxInstances, const FLOAT cooldown, const StealPolicy policy)
     {
-        AudioVoice* voice = SaXAudio::Instance.CreateVoice(bankID, busID);
+        SaXAudio::Instance.SetBankLimits(bankID, maxInstances, cooldown, policy);
+    }
+
+    EXPORT UINT32 BankGetRejectedCount(const INT32 bankID)
+    {
+        return SaXAudio::Instance.GetRejectedCount(bankID);
+    }
+
+    EXPORT UINT32 BankGetStolenCount(const INT32 bankID)
+    {
+        return SaXAudio::Instance.GetStolenCount(bankID);
+    }
 
-        if (!voice)
+    EXPORT void SetLoudnessAnalysis(const BOOL enabled)
+    {
+        SaXAudio::Instance.SetLoudnessAnalysis(enabled);
+    }
+
+    EXPORT void SetLoudnessTarget(const FLOAT target)
+    {
+        SaXAudio::Instance.SetLoudnessTarget(target);
+    }
+
+    EXPORT BOOL BankGetLoudness(const INT32 bankID, FLOAT* loudness, FLOAT* truePeak)
+    {
+        return SaXAudio::Instance.GetBankLoudness(bankID, loudness, truePeak);
+    }
+
+    EXPORT void BankSetLoudness(const INT32 bankID, const FLOAT loudness, const FLOAT truePeak)
+    {
+        SaXAudio::Instance.SetBankLoudness(bankID, loudness, truePeak);
+    }
+
+    EXPORT INT32 CreateVoice(const INT32 bankID, const INT32 busID, const BOOL paused)
+    {
+        // Only the slot is taken here, the bank limits are checked when the control thread creates the voice
+        INT32 voiceID = SaXAudio::Instance.ReserveVoice(bankID);
+        if (voiceID == 0)
             return 0;
 
+        PostCommand(COMMAND_CREATE_RESERVED, voiceID, bankID, busID, 0.0f, 0.0f);
         if (!paused)
-            voice->Start();
-
-        return voice->VoiceID;
+            PostCommand(COMMAND_START, voiceID, 0, 0, 0.0f, 0.0f);
+        return voiceID;
     }
 
     EXPORT BOOL VoiceExist(const INT32 voiceID)
     {
-        return SaXAudio::Instance.GetVoice(voiceID) != nullptr;
+        // Only the voiceID of the slot is read, slots are never deleted so it doesn't need a pin
+        return CanPost(voiceID);
     }
 
-    EXPORT INT32 CreateBus()
+    EXPORT INT32 CreateBus(const INT32 parentBusID)
     {
-        return SaXAudio::Instance.AddBus();
+        return SaXAudio::Instance.AddBus(parentBusID);
     }
 
     EXPORT void RemoveBus(INT32 busID)
     {
+        auto lock = SaXAudio::Instance.AcquireControl();
         SaXAudio::Instance.RemoveBus(busID);
     }
 
+    EXPORT void SetSend(const INT32 voiceID, const INT32 busID, const FLOAT level)
+    {
+        PostCommand(COMMAND_SET_SEND, voiceID, busID, 0, level, 0.0f);
+    }
+
     EXPORT BOOL Start(const INT32 voiceID)
     {
         return StartAtSample(voiceID, 0);
@@ -351,58 +399,104 @@ namespace SaXAudio
 
     EXPORT BOOL StartAtSample(const INT32 voiceID, const UINT32 sample)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            return voice->Start(sample);
-        }
-        return false;
+        if (!CanPost(voiceID))
+            return false;
+
+        PostCommand(COMMAND_START, voiceID, (INT32)sample, 0, 0.0f, 0.0f);
+        return true;
     }
 
     EXPORT BOOL StartAtTime(const INT32 voiceID, const FLOAT time)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice && voice->BankData && time >= 0)
+        // Converted to a sample by the control thread, the bank of a reserved voice isn't known yet
+        if (time < 0 || !CanPost(voiceID))
+            return false;
+
+        PostCommand(COMMAND_START_AT_TIME, voiceID, 0, 0, time, 0.0f);
+        return true;
+    }
+
+    EXPORT BOOL StartAtEngineTime(const INT32 voiceID, const UINT64 engineTime)
+    {
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (voice ? voice->IsPlaying.load() : !SaXAudio::Instance.IsReserved(voiceID))
+            return false;
+
+        PostCommand(COMMAND_START_AT_ENGINE_TIME, voiceID, (INT32)(UINT32)engineTime, (INT32)(UINT32)(engineTime >> 32), 0.0f, 0.0f);
+        return true;
+    }
+
+    EXPORT UINT32 StartGroup(const INT32* voiceIDs, const UINT32 count)
+    {
+        if (!voiceIDs)
+            return 0;
+
+        // The starts are held until COMMAND_COMMIT_GROUP, posting them one by one keeps them in order with the other commands
+        UINT32 queued = 0;
+        for (UINT32 i = 0; i < count; i++)
         {
-            UINT32 sample = (UINT32)(time * voice->BankData->sampleRate);
-            return voice->Start(sample);
+            if (!CanPost(voiceIDs[i])) continue;
+            PostCommand(COMMAND_START, voiceIDs[i], 0, 1, 0.0f, 0.0f);
+            queued++;
         }
-        return false;
+
+        if (queued > 0)
+            PostCommand(COMMAND_COMMIT_GROUP, 0, 0, 0, 0.0f, 0.0f);
+        return queued;
+    }
+
+    EXPORT BOOL StartSegments(const INT32 voiceID, const PlaybackSegment* segments, const UINT32 count)
+    {
+        if (!segments || count == 0 || !CanPost(voiceID))
+            return false;
+
+        UINT32 ticket = SaXAudio::Instance.PostSegments(segments, count);
+        PostCommand(COMMAND_START_SEGMENTS, voiceID, (INT32)ticket, 0, 0.0f, 0.0f);
+        return true;
+    }
+
+    EXPORT UINT64 GetEngineTime()
+    {
+        return SaXAudio::Instance.GetEngineTime();
+    }
+
+    EXPORT UINT32 GetEngineSampleRate()
+    {
+        return SaXAudio::Instance.GetEngineSampleRate();
     }
 
     EXPORT BOOL Stop(const INT32 voiceID, const FLOAT fade)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            return voice->Stop(fade);
-        }
-        return false;
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (!voice && !SaXAudio::Instance.IsReserved(voiceID))
+            return false;
+
+        // Posted even when not playing yet, a start might be waiting in the queue
+        PostCommand(COMMAND_STOP, voiceID, 0, 0, 0.0f, fade);
+        return !voice || voice->IsPlaying || voice->IsScheduled;
     }
 
-    EXPORT UINT32 Pause(const INT32 voiceID, const FLOAT fade)
+    EXPORT BOOL Pause(const INT32 voiceID, const FLOAT fade)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            return voice->Pause(fade);
-        }
-        return 0;
+        if (!CanPost(voiceID))
+            return false;
+
+        PostCommand(COMMAND_PAUSE, voiceID, 0, 0, 0.0f, fade);
+        return true;
     }
 
-    EXPORT UINT32 Resume(const INT32 voiceID, const FLOAT fade)
+    EXPORT BOOL Resume(const INT32 voiceID, const FLOAT fade)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            return voice->Resume(fade);
-        }
-        return 0;
+        if (!CanPost(voiceID))
+            return false;
+
+        PostCommand(COMMAND_RESUME, voiceID, 0, 0, 0.0f, fade);
+        return true;
     }
 
     EXPORT UINT32 GetPauseStack(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
             return voice->GetPauseStack();
@@ -410,70 +504,98 @@ namespace SaXAudio
         return 0;
     }
 
+    EXPORT INT32 CreatePlaylist(const INT32 busID)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        return PlaylistManager::Instance.Create(busID);
+    }
+
+    EXPORT void RemovePlaylist(const INT32 playlistID)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        PlaylistManager::Instance.Remove(playlistID);
+    }
+
+    EXPORT BOOL PlaylistSetTempo(const INT32 playlistID, const FLOAT bpm, const UINT32 beatsPerBar)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        return PlaylistManager::Instance.SetTempo(playlistID, bpm, beatsPerBar);
+    }
+
+    EXPORT BOOL PlaylistQueue(const INT32 playlistID, const INT32 bankID, const BOOL looping)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        return PlaylistManager::Instance.Queue(playlistID, bankID, looping);
+    }
+
+    EXPORT BOOL PlaylistPlay(const INT32 playlistID)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        return PlaylistManager::Instance.Play(playlistID);
+    }
+
+    EXPORT BOOL PlaylistTransition(const INT32 playlistID, const INT32 bankID, const BOOL looping, const FLOAT fade, const Quantize quantize)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        return PlaylistManager::Instance.Transition(playlistID, bankID, looping, fade, quantize);
+    }
+
+    EXPORT void PlaylistStop(const INT32 playlistID, const FLOAT fade)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        PlaylistManager::Instance.Stop(playlistID, fade);
+    }
+
+    EXPORT INT32 PlaylistGetCurrentVoice(const INT32 playlistID)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        return PlaylistManager::Instance.GetCurrentVoice(playlistID);
+    }
+
     EXPORT void SetMasterVolume(const FLOAT volume, const FLOAT fade)
     {
-        SaXAudio::Instance.SetBusVolume(0, volume, fade);
+        PostCommand(COMMAND_SET_BUS_VOLUME, 0, 0, 0, volume, fade);
     }
 
     EXPORT void SetVolume(const INT32 voiceID, const FLOAT volume, const FLOAT fade, BOOL isBus)
     {
-        if (isBus)
-        {
-            SaXAudio::Instance.SetBusVolume(voiceID, volume, fade);
-            return;
-        }
-
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            voice->SetVolume(volume, fade);
-        }
+        PostCommand(isBus ? COMMAND_SET_BUS_VOLUME : COMMAND_SET_VOLUME, voiceID, 0, 0, volume, fade);
     }
 
     EXPORT void SetSpeed(const INT32 voiceID, const FLOAT speed, const FLOAT fade)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            voice->SetSpeed(speed, fade);
-        }
+        PostCommand(COMMAND_SET_SPEED, voiceID, 0, 0, speed, fade);
     }
 
     EXPORT void SetPanning(const INT32 voiceID, const FLOAT panning, const FLOAT fade)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            voice->SetPanning(panning, fade);
-        }
+        PostCommand(COMMAND_SET_PANNING, voiceID, 0, 0, panning, fade);
     }
 
     EXPORT void SetLooping(const INT32 voiceID, const BOOL looping)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            voice->SetLooping(looping);
-        }
+        PostCommand(COMMAND_SET_LOOPING, voiceID, looping, 0, 0.0f, 0.0f);
     }
 
     EXPORT void SetLoopPoints(const INT32 voiceID, const UINT32 start, const UINT32 end)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-        if (voice)
-        {
-            voice->ChangeLoopPoints(start, end);
-        }
+        PostCommand(COMMAND_SET_LOOP_POINTS, voiceID, (INT32)start, (INT32)end, 0.0f, 0.0f);
+    }
+
+    EXPORT void SetSeamlessLoops(const INT32 voiceID, const BOOL seamless)
+    {
+        PostCommand(COMMAND_SET_SEAMLESS_LOOPS, voiceID, seamless, 0, 0.0f, 0.0f);
     }
 
     EXPORT FLOAT GetMasterVolume()
     {
+        // The mastering voice lives as long as the engine and XAudio voices can be queried from any thread
         return SaXAudio::Instance.GetBusVolume(0);
     }
 
     EXPORT FLOAT GetVolume(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
             return voice->Volume;
@@ -483,7 +605,7 @@ namespace SaXAudio
 
     EXPORT FLOAT GetSpeed(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
             return voice->Speed;
@@ -493,7 +615,7 @@ namespace SaXAudio
 
     EXPORT FLOAT GetPanning(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
             return voice->Panning;
@@ -503,7 +625,7 @@ namespace SaXAudio
 
     EXPORT BOOL GetLooping(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
             return voice->Looping;
@@ -513,7 +635,7 @@ namespace SaXAudio
 
     EXPORT UINT32 GetLoopStart(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
             return voice->LoopStart;
@@ -523,7 +645,7 @@ namespace SaXAudio
 
     EXPORT UINT32 GetLoopEnd(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
             return voice->LoopEnd;
@@ -533,57 +655,147 @@ namespace SaXAudio
 
     EXPORT void SetReverb(const INT32 voiceID, const XAUDIO2FX_REVERB_PARAMETERS reverbParams, const FLOAT fade, BOOL isBus)
     {
-        SaXAudio::Instance.SetReverb(voiceID, isBus, &reverbParams, fade);
+        EffectCommand command = { EFFECT_SET_REVERB, voiceID, isBus, fade };
+        command.reverb = reverbParams;
+        SaXAudio::Instance.PostEffectCommand(command);
     }
 
     EXPORT void RemoveReverb(const INT32 voiceID, const FLOAT fade, BOOL isBus)
     {
-        SaXAudio::Instance.RemoveReverb(voiceID, isBus, fade);
+        SaXAudio::Instance.PostEffectCommand({ EFFECT_REMOVE_REVERB, voiceID, isBus, fade });
     }
 
     EXPORT void SetEq(const INT32 voiceID, const FXEQ_PARAMETERS eqParams, const FLOAT fade, BOOL isBus)
     {
-        SaXAudio::Instance.SetEq(voiceID, isBus, &eqParams, fade);
+        EffectCommand command = { EFFECT_SET_EQ, voiceID, isBus, fade };
+        command.eq = eqParams;
+        SaXAudio::Instance.PostEffectCommand(command);
     }
 
     EXPORT void RemoveEq(const INT32 voiceID, const FLOAT fade, BOOL isBus)
     {
-        SaXAudio::Instance.RemoveEq(voiceID, isBus, fade);
+        SaXAudio::Instance.PostEffectCommand({ EFFECT_REMOVE_EQ, voiceID, isBus, fade });
     }
 
     EXPORT void SetEcho(const INT32 voiceID, const FXECHO_PARAMETERS echoParams, const FLOAT fade, BOOL isBus)
     {
-        SaXAudio::Instance.SetEcho(voiceID, isBus, &echoParams, fade);
+        EffectCommand command = { EFFECT_SET_ECHO, voiceID, isBus, fade };
+        command.echo = echoParams;
+        SaXAudio::Instance.PostEffectCommand(command);
     }
 
     EXPORT void RemoveEcho(const INT32 voiceID, const FLOAT fade, BOOL isBus)
     {
-        SaXAudio::Instance.RemoveEcho(voiceID, isBus, fade);
+        SaXAudio::Instance.PostEffectCommand({ EFFECT_REMOVE_ECHO, voiceID, isBus, fade });
+    }
+
+    EXPORT void SetEchoMaxDelay(const INT32 voiceID, const FLOAT maxDelay, BOOL isBus)
+    {
+        EffectCommand command = { EFFECT_SET_ECHO_MAX_DELAY, voiceID, isBus, 0.0f };
+        command.maxDelay = maxDelay;
+        SaXAudio::Instance.PostEffectCommand(command);
+    }
+
+    EXPORT void SetFilter(const INT32 voiceID, const XAUDIO2_FILTER_TYPE type, const FLOAT cutoff, const FLOAT q, const FLOAT fade, BOOL isBus)
+    {
+        EffectCommand command = { EFFECT_SET_FILTER, voiceID, isBus, fade };
+        command.filter = { type, cutoff, q };
+        SaXAudio::Instance.PostEffectCommand(command);
+    }
+
+    EXPORT void RemoveFilter(const INT32 voiceID, const FLOAT fade, BOOL isBus)
+    {
+        SaXAudio::Instance.PostEffectCommand({ EFFECT_REMOVE_FILTER, voiceID, isBus, fade });
+    }
+
+    EXPORT BOOL SetConvolutionReverb(const INT32 busID, const INT32 bankID, const FLOAT wetDryMix)
+    {
+        // The bank is copied now so it can be removed, the engine is built off the control thread
+        if (!SaXAudio::Instance.GetBus(busID))
+            return false;
+        UINT32 ticket = SaXAudio::Instance.PostImpulseResponse(bankID);
+        if (ticket == 0)
+            return false;
+
+        EffectCommand command = { EFFECT_SET_CONVOLUTION, busID, true, 0.0f };
+        command.convolution = { bankID, ticket, wetDryMix };
+        SaXAudio::Instance.PostEffectCommand(command);
+        return true;
+    }
+
+    EXPORT void RemoveConvolutionReverb(const INT32 busID)
+    {
+        SaXAudio::Instance.PostEffectCommand({ EFFECT_REMOVE_CONVOLUTION, busID, true, 0.0f });
+    }
+
+    EXPORT BOOL SetCompressor(const INT32 busID, const CompressorParameters params, const INT32 sidechainBusID)
+    {
+        // Only the buses are checked here, the compressor is set by the next control tick
+        if (!SaXAudio::Instance.HasBus(busID)
+            || (sidechainBusID != 0 && (sidechainBusID == busID || !SaXAudio::Instance.HasBus(sidechainBusID))))
+            return false;
+
+        EffectCommand command = { EFFECT_SET_COMPRESSOR, busID, true, 0.0f };
+        command.compressor = params;
+        command.sidechainBusID = sidechainBusID;
+        SaXAudio::Instance.PostEffectCommand(command);
+        return true;
+    }
+
+    EXPORT void RemoveCompressor(const INT32 busID)
+    {
+        SaXAudio::Instance.PostEffectCommand({ EFFECT_REMOVE_COMPRESSOR, busID, true, 0.0f });
+    }
+
+    EXPORT BOOL SetLimiter(const INT32 busID, const LimiterParameters params)
+    {
+        if (!SaXAudio::Instance.HasBus(busID))
+            return false;
+
+        EffectCommand command = { EFFECT_SET_LIMITER, busID, true, 0.0f };
+        command.limiter = params;
+        SaXAudio::Instance.PostEffectCommand(command);
+        return true;
+    }
+
+    EXPORT void RemoveLimiter(const INT32 busID)
+    {
+        SaXAudio::Instance.PostEffectCommand({ EFFECT_REMOVE_LIMITER, busID, true, 0.0f });
     }
 
     EXPORT UINT32 GetPositionSample(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice)
         {
-            return voice->GetPosition();
+            return voice->Position;
         }
         return 0;
     }
 
     EXPORT FLOAT GetPositionTime(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice && voice->BankData)
         {
-            return (FLOAT)voice->GetPosition() / voice->BankData->sampleRate;
+            return (FLOAT)voice->Position / voice->BankData->sampleRate;
         }
         return 0.0f;
     }
 
+    EXPORT UINT32 GetSegmentIndex(const INT32 voiceID)
+    {
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (voice)
+        {
+            return voice->SegmentIndex;
+        }
+        return 0;
+    }
+
     EXPORT UINT32 GetTotalSample(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice && voice->BankData)
         {
             return voice->BankData->totalSamples;
@@ -593,7 +805,7 @@ namespace SaXAudio
 
     EXPORT FLOAT GetTotalTime(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice && voice->BankData)
         {
             return (FLOAT)voice->BankData->totalSamples / voice->BankData->sampleRate;
@@ -603,7 +815,7 @@ namespace SaXAudio
 
     EXPORT UINT32 GetSampleRate(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice && voice->BankData)
         {
             return voice->BankData->sampleRate;
@@ -613,7 +825,7 @@ namespace SaXAudio
 
     EXPORT UINT32 GetChannelCount(const INT32 voiceID)
     {
-        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
         if (voice && voice->BankData)
         {
             return voice->BankData->channels;
@@ -621,10 +833,31 @@ namespace SaXAudio
         return 0;
     }
 
+    EXPORT const VoiceSnapshot* GetVoiceSnapshot()
+    {
+        return SaXAudio::Instance.GetVoiceSnapshot();
+    }
+
+    EXPORT void ExecuteCommands(const Command* commands, const UINT32 count, CommandResult* results)
+    {
+        ProcessCommands(commands, count, results);
+    }
+
     EXPORT void SetOnFinishedCallback(const OnFinishedCallback callback)
     {
         Log(0, 0, "[OnVoiceFinished]");
-        SaXAudio::Instance.OnFinishedCallback = callback;
+        EventQueue::Instance.SetOnFinishedCallback(callback);
+    }
+
+    EXPORT void SetOnEventsCallback(const OnEventsCallback callback)
+    {
+        Log(0, 0, "[SetOnEventsCallback]");
+        EventQueue::Instance.SetOnEventsCallback(callback);
+    }
+
+    EXPORT UINT32 PollEvents(AudioEvent* events, const UINT32 maxCount)
+    {
+        return EventQueue::Instance.Poll(events, maxCount);
     }
 
     EXPORT UINT32 GetVoiceCount(const INT32 bankID, const INT32 busID)
@@ -636,4 +869,35 @@ namespace SaXAudio
     {
         return SaXAudio::Instance.GetBankCount();
     }
+
+    EXPORT UINT32 GetRealVoiceCount()
+    {
+        return SaXAudio::Instance.GetRealVoiceCount();
+    }
+
+    EXPORT BOOL IsVirtual(const INT32 voiceID)
+    {
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (voice)
+        {
+            return voice->IsVirtual;
+        }
+        return false;
+    }
+
+    EXPORT void SetMetering(const INT32 busID, const BOOL enabled)
+    {
+        auto lock = SaXAudio::Instance.AcquireControl();
+        SaXAudio::Instance.SetMetering(busID, enabled);
+    }
+
+    EXPORT FLOAT GetPeakLevel(const INT32 voiceID, const UINT32 channelIndex, const BOOL isBus)
+    {
+        return SaXAudio::Instance.GetPeakLevel(voiceID, channelIndex, isBus);
+    }
+
+    EXPORT FLOAT GetRMSLevel(const INT32 voiceID, const UINT32 channelIndex, const BOOL isBus)
+    {
+        return SaXAudio::Instance.GetRMSLevel(voiceID, channelIndex, isBus);
+    }
 }
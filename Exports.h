@@ -32,6 +32,53 @@ namespace SaXAudio
     /// <returns>Return true if successful</returns>
     EXPORT BOOL Create();
     /// <summary>
+    /// Initialize with the software mixer instead of an audio device
+    /// Nothing is heard, the audio is pulled with Render
+    /// </summary>
+    /// <param name="channels">Channels of the output, 0 for stereo</param>
+    /// <param name="sampleRate">Sample rate of the output</param>
+    /// <returns>Return true if successful</returns>
+    EXPORT BOOL CreateSoftware(const UINT32 channels = 2, const UINT32 sampleRate = 48000);
+    /// <summary>
+    /// Mix the next frames of the software mixer
+    /// </summary>
+    /// <param name="buffer">Receives interleaved float samples, frames * channels of them</param>
+    /// <param name="frames">The number of frames to render</param>
+    /// <returns>The number of frames rendered, 0 when not using the software mixer</returns>
+    EXPORT UINT32 Render(FLOAT* buffer, const UINT32 frames);
+    /// <summary>
+    /// Initialize with the software mixer in offline mode
+    /// Time only moves when Render or Advance is called, as fast as the CPU allows
+    /// Fades, scheduled starts and bank cooldowns follow the rendered time and ogg banks are decoded before BankAddOgg returns
+    /// </summary>
+    /// <param name="channels">Channels of the output, 0 for stereo</param>
+    /// <param name="sampleRate">Sample rate of the output</param>
+    /// <returns>Return true if successful</returns>
+    EXPORT BOOL CreateOffline(const UINT32 channels = 2, const UINT32 sampleRate = 48000);
+    /// <summary>
+    /// Render the given time with the software mixer, the audio is only kept if captured
+    /// </summary>
+    /// <param name="seconds">Time to render in seconds</param>
+    /// <returns>The number of frames rendered</returns>
+    EXPORT UINT32 Advance(const FLOAT seconds);
+    /// <summary>
+    /// Write everything rendered from now on to a 32-bit float wav file
+    /// </summary>
+    /// <param name="filePath">Path of the wav file, overwritten if it exists</param>
+    /// <returns>True if the file was opened</returns>
+    EXPORT BOOL StartCapture(const char* filePath);
+    /// <summary>
+    /// Finish the wav file started with StartCapture
+    /// </summary>
+    EXPORT void StopCapture();
+    /// <summary>
+    /// Get the time taken by the passes in offline mode, the control tick included
+    /// </summary>
+    /// <param name="stats">Receives the number of passes and their last, average and max cost in milliseconds</param>
+    /// <param name="reset">Start counting again after reading</param>
+    /// <returns>False if not in offline mode</returns>
+    EXPORT BOOL GetRenderStats(RenderStats* stats, const BOOL reset = false);
+    /// <summary>
     /// Release everything
     /// </summary>
     EXPORT void Release();
@@ -69,19 +116,19 @@ namespace SaXAudio
     /// Pause all playing voices
     /// </summary>
     /// <param name="fade">The duration of the fade in seconds</param>
-    /// <param name="busID">Specific bus to pause (0 to pause all voices)</param>
+    /// <param name="busID">Specific bus to pause (0 to pause all voices), includes its child buses</param>
     EXPORT void PauseAll(const FLOAT fade = 0.1f, const INT32 busID = 0);
     /// <summary>
     /// Resume playing all voices
     /// </summary>
     /// <param name="fade">The duration of the fade in seconds</param>
-    /// <param name="busID">Specific bus to resume (0 to resume all voices)</param>
+    /// <param name="busID">Specific bus to resume (0 to resume all voices), includes its child buses</param>
     EXPORT void ResumeAll(const FLOAT fade = 0.1f, const INT32 busID = 0);
     /// <summary>
     /// Stop all voices
     /// </summary>
     /// <param name="fade">Fade duration in seconds</param>
-    /// <param name="busID">Specific bus to stop (0 to stop all voices)</param>
+    /// <param name="busID">Specific bus to stop (0 to stop all voices), includes its child buses</param>
     EXPORT void StopAll(const FLOAT fade = 0.1f, const INT32 busID = 0);
     /// <summary>
     /// Protect a voice from PauseAll, ResumeAll and StopAll operations
@@ -89,6 +136,21 @@ namespace SaXAudio
     /// <param name="voiceID">The voice to protect</param>
     EXPORT void Protect(const INT32 voiceID);
 
+    /// <summary>
+    /// Limit the number of voices actually being mixed
+    /// Voices over the limit become virtual, they keep track of their position without being heard
+    /// and are brought back at the correct sample when they are important enough again
+    /// </summary>
+    /// <param name="count">Maximum number of real voices, 0 for no limit</param>
+    EXPORT void SetMaxRealVoices(const UINT32 count);
+    /// <summary>
+    /// Set the priority of a voice, higher priority voices are kept real over lower priority ones
+    /// Between voices of the same priority the most audible ones (volume x bus volume) are kept
+    /// </summary>
+    /// <param name="voiceID">The voice to change</param>
+    /// <param name="priority">The priority, 0 by default</param>
+    EXPORT void SetPriority(const INT32 voiceID, const UINT32 priority);
+
     /// <summary>
     /// Add wav audio data to the sound bank
     /// The data in the buffer will be copied in memory
@@ -133,6 +195,54 @@ namespace SaXAudio
     /// </summary>
     /// <param name="bankID">The bankID of the data to remove</param>
     EXPORT void BankAutoRemove(const INT32 bankID);
+    /// <summary>
+    /// Limit how many voices can play the bank at the same time
+    /// Useful for sounds triggered in rapid succession (footsteps, impacts, clicks)
+    /// </summary>
+    /// <param name="bankID">The bank to limit</param>
+    /// <param name="maxInstances">Maximum number of voices playing the bank, 0 for no limit</param>
+    /// <param name="cooldown">Minimum time in seconds between the creation of two voices, 0 for none</param>
+    /// <param name="policy">What to do when maxInstances is reached: reject the new voice or stop the oldest/quietest one</param>
+    EXPORT void BankSetLimits(const INT32 bankID, const UINT32 maxInstances, const FLOAT cooldown, const StealPolicy policy);
+    /// <summary>
+    /// Get how many voices were not created because of the bank limits
+    /// </summary>
+    /// <param name="bankID">The bank to query, 0 for all banks</param>
+    /// <returns>Number of rejected voices</returns>
+    EXPORT UINT32 BankGetRejectedCount(const INT32 bankID);
+    /// <summary>
+    /// Get how many voices were stopped to make room for a new voice because of the bank limits
+    /// </summary>
+    /// <param name="bankID">The bank to query, 0 for all banks</param>
+    /// <returns>Number of stolen voices</returns>
+    EXPORT UINT32 BankGetStolenCount(const INT32 bankID);
+    /// <summary>
+    /// Measure the integrated loudness (ITU-R BS.1770) and true peak of the banks added from now on
+    /// Ogg banks are measured while decoding, wav banks when added
+    /// </summary>
+    /// <param name="enabled">Enable or disable the analysis</param>
+    EXPORT void SetLoudnessAnalysis(const BOOL enabled);
+    /// <summary>
+    /// Normalize the voices created from analyzed banks to the target loudness
+    /// The gain is limited so the true peak stays under 0dBTP, it doesn't change the voice volume
+    /// </summary>
+    /// <param name="target">Target loudness in LUFS (e.g. -16), 0 to disable</param>
+    EXPORT void SetLoudnessTarget(const FLOAT target);
+    /// <summary>
+    /// Get the loudness measured for a bank, to cache it with the asset
+    /// </summary>
+    /// <param name="bankID">The bank to query</param>
+    /// <param name="loudness">Receives the integrated loudness in LUFS</param>
+    /// <param name="truePeak">Receives the linear true peak</param>
+    /// <returns>true if the bank was analyzed</returns>
+    EXPORT BOOL BankGetLoudness(const INT32 bankID, FLOAT* loudness, FLOAT* truePeak);
+    /// <summary>
+    /// Restore a cached loudness, an Ogg bank still decoding is not analyzed anymore
+    /// </summary>
+    /// <param name="bankID">The bank to modify</param>
+    /// <param name="loudness">Integrated loudness in LUFS</param>
+    /// <param name="truePeak">Linear true peak</param>
+    EXPORT void BankSetLoudness(const INT32 bankID, const FLOAT loudness, const FLOAT truePeak);
 
     /// <summary>
     /// Create a voice for playing the specified audio data
@@ -141,33 +251,44 @@ namespace SaXAudio
     /// <param name="bankID">The bankID of the data to play</param>
     /// <param name="busID">The bus to play the voice on</param>
     /// <param name="paused">when false, the audio will start playing immediately</param>
-    /// <returns>unique voiceID</returns>
+    /// <returns>unique voiceID, 0 if the bank doesn't exist. The voice is created by the next control tick, it is dropped if the bank limits reject it</returns>
     EXPORT INT32 CreateVoice(const INT32 bankID, const INT32 busID, const BOOL paused = true);
     /// <summary>
     /// Check if the specified voice exists
     /// </summary>
     /// <param name="voiceID">The voice to check</param>
-    /// <returns>true if the specified voice exists</returns>
+    /// <returns>true if the specified voice exists or is waiting to be created</returns>
     EXPORT BOOL VoiceExist(const INT32 voiceID);
 
     /// <summary>
     /// Create a bus
+    /// The volume and effects of a bus apply to its child buses
     /// </summary>
+    /// <param name="parentBusID">The bus to output to, 0 for the mastering voice</param>
     /// <returns>unique busID</returns>
-    EXPORT INT32 CreateBus();
+    EXPORT INT32 CreateBus(const INT32 parentBusID = 0);
     /// <summary>
     /// Removes a bus
-    /// All voices on that bus will be stopped
+    /// All voices on that bus and its child buses will be stopped, the child buses are removed
     /// </summary>
     /// <param name="busID">The bus to remove</param>
     EXPORT void RemoveBus(INT32 busID);
+    /// <summary>
+    /// Send the voice to another bus on top of its own, e.g. a bus hosting a reverb shared by many voices
+    /// The send follows the panning of the voice, scaled by the level
+    /// </summary>
+    /// <param name="voiceID">The voice to modify</param>
+    /// <param name="busID">The bus to send to, 0 for the mastering voice</param>
+    /// <param name="level">Send level [0, 1], 0 removes the send</param>
+    EXPORT void SetSend(const INT32 voiceID, const INT32 busID, const FLOAT level);
 
     /// <summary>
     /// Starts playing the specified voice
     /// Resets the pause stack
+    /// The start is queued and applied by the next control tick, like the other commands
     /// </summary>
     /// <param name="voiceID">The voice to start</param>
-    /// <returns>true if successful or already playing</returns>
+    /// <returns>true if the voice exists and the start was queued</returns>
     EXPORT BOOL Start(const INT32 voiceID);
     /// <summary>
     /// Starts playing the specified voice at a specific sample
@@ -175,7 +296,7 @@ namespace SaXAudio
     /// </summary>
     /// <param name="voiceID">The voice to start</param>
     /// <param name="sample">The sample position to start at</param>
-    /// <returns>true if successful</returns>
+    /// <returns>true if the voice exists and the start was queued</returns>
     EXPORT BOOL StartAtSample(const INT32 voiceID, const UINT32 sample);
     /// <summary>
     /// Starts playing the specified voice at a specific time in seconds
@@ -183,15 +304,51 @@ namespace SaXAudio
     /// </summary>
     /// <param name="voiceID">The voice to start</param>
     /// <param name="time">The time position in seconds to start at</param>
-    /// <returns>true if successful</returns>
+    /// <returns>true if the voice exists and the start was queued</returns>
     EXPORT BOOL StartAtTime(const INT32 voiceID, const FLOAT time);
     /// <summary>
+    /// Starts playing the specified voice when the engine reaches a sample time
+    /// Voices scheduled to the same time start on the same sample, use GetEngineTime to get the current time
+    /// Scheduling the voice again replaces the previous time, Stop cancels it
+    /// Rarely, when the engine begins a pass while the start is committed, the voices start one pass (10ms) late
+    /// </summary>
+    /// <param name="voiceID">The voice to start</param>
+    /// <param name="engineTime">The engine sample time to start at, see GetEngineSampleRate</param>
+    /// <returns>true if the voice exists and isn't playing, the start is scheduled by the next control tick</returns>
+    EXPORT BOOL StartAtEngineTime(const INT32 voiceID, const UINT64 engineTime);
+    /// <summary>
+    /// Starts playing several voices at once, they all begin in the same audio pass
+    /// </summary>
+    /// <param name="voiceIDs">The voices to start</param>
+    /// <param name="count">The number of voices</param>
+    /// <returns>The number of voices found, their starts are queued and applied together by the next control tick</returns>
+    EXPORT UINT32 StartGroup(const INT32* voiceIDs, const UINT32 count);
+    /// <summary>
+    /// Starts playing a list of regions of the bank one after the other, like an intro followed by a loop
+    /// The transitions are sample exact, a final infinite loop can be exited with SetLooping(false)
+    /// </summary>
+    /// <param name="voiceID">The voice to start</param>
+    /// <param name="segments">The regions to play, at most 16</param>
+    /// <param name="count">The number of regions</param>
+    /// <returns>true if the voice exists and the regions were queued, the regions are checked by the next control tick</returns>
+    EXPORT BOOL StartSegments(const INT32 voiceID, const PlaybackSegment* segments, const UINT32 count);
+    /// <summary>
+    /// Get the number of samples processed by the engine since Create
+    /// </summary>
+    /// <returns>The engine sample time</returns>
+    EXPORT UINT64 GetEngineTime();
+    /// <summary>
+    /// Get the sample rate of the engine time
+    /// </summary>
+    /// <returns>The sample rate of the mastering voice</returns>
+    EXPORT UINT32 GetEngineSampleRate();
+    /// <summary>
     /// Stops playing the specified voice
     /// This will also delete the voice
     /// </summary>
     /// <param name="voiceID">The voice to stop</param>
     /// <param name="fade">Fade duration in seconds</param>
-    /// <returns>true if successful</returns>
+    /// <returns>true if the voice was playing or scheduled, the stop is queued either way</returns>
     EXPORT BOOL Stop(const INT32 voiceID, const FLOAT fade = 0.1f);
 
     /// <summary>
@@ -201,15 +358,15 @@ namespace SaXAudio
     /// </summary>
     /// <param name="voiceID">The voice to pause</param>
     /// <param name="fade">The duration of the fade in seconds</param>
-    /// <returns>value of the pause stack</returns>
-    EXPORT UINT32 Pause(const INT32 voiceID, const FLOAT fade = 0.1f);
+    /// <returns>true if the voice exists and the pause was queued, see GetPauseStack once it is applied</returns>
+    EXPORT BOOL Pause(const INT32 voiceID, const FLOAT fade = 0.1f);
     /// <summary>
     /// Reduce the pause stack and resume playing the voice if the stack becomes empty
     /// </summary>
     /// <param name="voiceID">The voice to resume</param>
     /// <param name="fade">The duration of the fade in seconds</param>
-    /// <returns>value of the pause stack</returns>
-    EXPORT UINT32 Resume(const INT32 voiceID, const FLOAT fade = 0.1f);
+    /// <returns>true if the voice exists and the resume was queued, see GetPauseStack once it is applied</returns>
+    EXPORT BOOL Resume(const INT32 voiceID, const FLOAT fade = 0.1f);
     /// <summary>
     /// Gets the pause stack value of the specified voice, 0 if empty
     /// </summary>
@@ -217,6 +374,65 @@ namespace SaXAudio
     /// <returns>The current pause stack value</returns>
     EXPORT UINT32 GetPauseStack(const INT32 voiceID);
 
+    /// <summary>
+    /// Create a music playlist, the tracks play back to back without gaps
+    /// </summary>
+    /// <param name="busID">The bus the tracks are played on, 0 for the mastering voice</param>
+    /// <returns>The playlistID</returns>
+    EXPORT INT32 CreatePlaylist(const INT32 busID = 0);
+    /// <summary>
+    /// Stop and remove a playlist
+    /// </summary>
+    /// <param name="playlistID">The playlist to remove</param>
+    EXPORT void RemovePlaylist(const INT32 playlistID);
+    /// <summary>
+    /// Set the tempo used to quantize the transitions
+    /// The beat grid starts when the current track started
+    /// </summary>
+    /// <param name="playlistID">The playlist to modify</param>
+    /// <param name="bpm">Beats per minute</param>
+    /// <param name="beatsPerBar">Beats per bar</param>
+    /// <returns>true if successful</returns>
+    EXPORT BOOL PlaylistSetTempo(const INT32 playlistID, const FLOAT bpm, const UINT32 beatsPerBar = 4);
+    /// <summary>
+    /// Add a track at the end of the playlist
+    /// The next track is scheduled to start the sample the current one ends
+    /// A looping track plays until PlaylistTransition or PlaylistStop
+    /// </summary>
+    /// <param name="playlistID">The playlist to modify</param>
+    /// <param name="bankID">The bank to play</param>
+    /// <param name="looping">Loop the track</param>
+    /// <returns>true if successful</returns>
+    EXPORT BOOL PlaylistQueue(const INT32 playlistID, const INT32 bankID, const BOOL looping = false);
+    /// <summary>
+    /// Start playing the first queued track
+    /// </summary>
+    /// <param name="playlistID">The playlist to play</param>
+    /// <returns>true if a track is playing</returns>
+    EXPORT BOOL PlaylistPlay(const INT32 playlistID);
+    /// <summary>
+    /// Crossfade from the current track to a new one, the queued tracks play after it
+    /// </summary>
+    /// <param name="playlistID">The playlist to modify</param>
+    /// <param name="bankID">The bank to play</param>
+    /// <param name="looping">Loop the track</param>
+    /// <param name="fade">Equal power crossfade duration in seconds</param>
+    /// <param name="quantize">Start on the next beat or bar of the current track</param>
+    /// <returns>true if successful</returns>
+    EXPORT BOOL PlaylistTransition(const INT32 playlistID, const INT32 bankID, const BOOL looping, const FLOAT fade, const Quantize quantize = QUANTIZE_NONE);
+    /// <summary>
+    /// Stop the current track and clear the queue
+    /// </summary>
+    /// <param name="playlistID">The playlist to stop</param>
+    /// <param name="fade">Fade duration in seconds</param>
+    EXPORT void PlaylistStop(const INT32 playlistID, const FLOAT fade = 0.1f);
+    /// <summary>
+    /// Get the voice playing the current track
+    /// </summary>
+    /// <param name="playlistID">The playlist to query</param>
+    /// <returns>The voiceID or 0 if nothing is playing</returns>
+    EXPORT INT32 PlaylistGetCurrentVoice(const INT32 playlistID);
+
     /// <summary>
     /// Set the master volume
     /// </summary>
@@ -260,6 +476,13 @@ namespace SaXAudio
     /// <param name="start">Loop start position in samples</param>
     /// <param name="end">Loop end position in samples</param>
     EXPORT void SetLoopPoints(const INT32 voiceID, const UINT32 start, const UINT32 end);
+    /// <summary>
+    /// Makes loop changes seamless, the voice is never stopped or flushed
+    /// New loop points and disabling the loop take effect when the current loop reaches its end
+    /// </summary>
+    /// <param name="voiceID">The voice to modify</param>
+    /// <param name="seamless">true to wait for the end of the loop, false to apply changes immediately</param>
+    EXPORT void SetSeamlessLoops(const INT32 voiceID, const BOOL seamless);
 
     /// <summary>
     /// Get the master volume
@@ -350,19 +573,96 @@ namespace SaXAudio
     /// <param name="fade">Fade duration in seconds</param>
     /// <param name="isBus">true if voiceID refers to a bus, false for voice</param>
     EXPORT void RemoveEcho(const INT32 voiceID, const FLOAT fade = 0, BOOL isBus = false);
+    /// <summary>
+    /// Set the longest delay the echo of a voice or bus can use, its memory grows with it
+    /// Applied the next time the echo is added, the echo delay is limited to it
+    /// </summary>
+    /// <param name="voiceID">The voice or bus ID to modify</param>
+    /// <param name="maxDelay">[1, 3000] in milliseconds, 0 for 3000</param>
+    /// <param name="isBus">true if voiceID refers to a bus, false for voice</param>
+    EXPORT void SetEchoMaxDelay(const INT32 voiceID, const FLOAT maxDelay, BOOL isBus = false);
+
+    /// <summary>
+    /// Add/Modify the native filter of a voice or bus, much cheaper than the EQ for occlusion
+    /// The cutoff fades when the type doesn't change, band-pass and notch start without fade
+    /// </summary>
+    /// <param name="voiceID">The voice or bus ID to modify</param>
+    /// <param name="type">Type of the filter</param>
+    /// <param name="cutoff">Cutoff frequency in Hz, capped at a sixth of the engine sample rate except for one-pole filters</param>
+    /// <param name="q">[0.67, ...] quality of the filter, one-pole filters ignore it</param>
+    /// <param name="fade">Fade duration in seconds</param>
+    /// <param name="isBus">true if voiceID refers to a bus, false for voice</param>
+    EXPORT void SetFilter(const INT32 voiceID, const XAUDIO2_FILTER_TYPE type, const FLOAT cutoff, const FLOAT q = 1.0f, const FLOAT fade = 0, BOOL isBus = false);
+    /// <summary>
+    /// Remove the native filter of a voice or bus
+    /// </summary>
+    /// <param name="voiceID">The voice or bus ID to modify</param>
+    /// <param name="fade">Fade duration in seconds</param>
+    /// <param name="isBus">true if voiceID refers to a bus, false for voice</param>
+    EXPORT void RemoveFilter(const INT32 voiceID, const FLOAT fade = 0, BOOL isBus = false);
+
+    /// <summary>
+    /// Add/Modify the convolution reverb of a bus, using a bank as impulse response
+    /// The bank must be fully decoded, it can be removed afterward
+    /// The reverb is delayed by 512 samples, the dry sound is not
+    /// A new bank is resampled and prepared on its own thread, the previous one keeps playing until it is ready
+    /// </summary>
+    /// <param name="busID">The bus to modify</param>
+    /// <param name="bankID">The impulse response</param>
+    /// <param name="wetDryMix">[0, 100] percentage of reverb</param>
+    /// <returns>true if the bus and the decoded bank exist, the reverb is enabled once prepared</returns>
+    EXPORT BOOL SetConvolutionReverb(const INT32 busID, const INT32 bankID, const FLOAT wetDryMix = 100.0f);
+    /// <summary>
+    /// Remove the convolution reverb from a bus
+    /// </summary>
+    /// <param name="busID">The bus to modify</param>
+    EXPORT void RemoveConvolutionReverb(const INT32 busID);
+
+    /// <summary>
+    /// Add/Modify the compressor of a bus
+    /// </summary>
+    /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+    /// <param name="params">Compressor parameters</param>
+    /// <param name="sidechainBusID">Bus whose level drives the compression (ducking), 0 for the bus itself</param>
+    /// <returns>true if the buses exist, the compressor is enabled by the next control tick</returns>
+    EXPORT BOOL SetCompressor(const INT32 busID, const CompressorParameters params, const INT32 sidechainBusID = 0);
+    /// <summary>
+    /// Remove the compressor from a bus
+    /// </summary>
+    /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+    EXPORT void RemoveCompressor(const INT32 busID);
+
+    /// <summary>
+    /// Add/Modify the look-ahead limiter of a bus, the bus is delayed by the look-ahead
+    /// </summary>
+    /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+    /// <param name="params">Limiter parameters</param>
+    /// <returns>true if the bus exists, the limiter is enabled by the next control tick</returns>
+    EXPORT BOOL SetLimiter(const INT32 busID, const LimiterParameters params);
+    /// <summary>
+    /// Remove the limiter from a bus
+    /// </summary>
+    /// <param name="busID">The bus to modify, 0 for the mastering voice</param>
+    EXPORT void RemoveLimiter(const INT32 busID);
 
     /// <summary>
     /// Gets the position of the playing voice in samples
     /// </summary>
     /// <param name="voiceID">The voice to query</param>
-    /// <returns>sample position if playing or 0</returns>
+    /// <returns>sample position if playing or 0, as of the last control tick</returns>
     EXPORT UINT32 GetPositionSample(const INT32 voiceID);
     /// <summary>
     /// Gets the position of the playing voice in seconds
     /// </summary>
     /// <param name="voiceID">The voice to query</param>
-    /// <returns>position in seconds if playing or 0</returns>
+    /// <returns>position in seconds if playing or 0, as of the last control tick</returns>
     EXPORT FLOAT GetPositionTime(const INT32 voiceID);
+    /// <summary>
+    /// Get the index of the region playing, see StartSegments
+    /// </summary>
+    /// <param name="voiceID">The voice to query</param>
+    /// <returns>The index of the region, 0 when not playing segments, as of the last control tick</returns>
+    EXPORT UINT32 GetSegmentIndex(const INT32 voiceID);
 
     /// <summary>
     /// Gets the total amount of samples of the voice
@@ -390,12 +690,43 @@ namespace SaXAudio
     /// <param name="voiceID">The voice to query</param>
     /// <returns>number of channels (1=mono, 2=stereo, etc)</returns>
     EXPORT UINT32 GetChannelCount(const INT32 voiceID);
+    /// <summary>
+    /// Get the snapshot of every voice state, refreshed every 10ms by the audio thread
+    /// The memory stays valid for the lifetime of the library, read it without calling into the library
+    /// Read the sequence, the front buffer, then the sequence again: the read is valid if it's even and didn't change
+    /// </summary>
+    /// <returns>Pointer to the snapshot</returns>
+    EXPORT const VoiceSnapshot* GetVoiceSnapshot();
+
+    /// <summary>
+    /// Execute a batch of commands in a single call, in order
+    /// A command can target a voice created earlier in the batch with a negative id: -1 for the first command, -2 for the second...
+    /// </summary>
+    /// <param name="commands">The commands to execute</param>
+    /// <param name="count">The number of commands</param>
+    /// <param name="results">Receives one result per command (voiceID, pause stack, etc.), can be null</param>
+    EXPORT void ExecuteCommands(const Command* commands, const UINT32 count, CommandResult* results);
 
     /// <summary>
     /// Sets a callback for when a voice finishes playing
+    /// The callback is called from a single dispatcher thread, in the order voices finished
     /// </summary>
     /// <param name="callback">The callback function to call when voices finish</param>
     EXPORT void SetOnFinishedCallback(const OnFinishedCallback callback);
+    /// <summary>
+    /// Sets a callback receiving every event (finished, decoded, error) in batches
+    /// The callback is called from a single dispatcher thread
+    /// </summary>
+    /// <param name="callback">The callback function to call with a batch of events</param>
+    EXPORT void SetOnEventsCallback(const OnEventsCallback callback);
+    /// <summary>
+    /// Copy the pending events (finished, decoded, error) into the buffer
+    /// Only use when no callback is set, otherwise the dispatcher thread consumes the events
+    /// </summary>
+    /// <param name="events">The buffer receiving the events</param>
+    /// <param name="maxCount">The maximum number of events the buffer can hold</param>
+    /// <returns>Number of events copied</returns>
+    EXPORT UINT32 PollEvents(AudioEvent* events, const UINT32 maxCount);
 
     /// <summary>
     /// Get the number of voices
@@ -412,10 +743,41 @@ namespace SaXAudio
     EXPORT UINT32 GetBankCount();
 
     /// <summary>
-    /// Get the peak volume level (for VU meters, etc.)
+    /// Get the number of voices being mixed (not virtual)
+    /// </summary>
+    /// <returns>Number of real voices</returns>
+    EXPORT UINT32 GetRealVoiceCount();
+
+    /// <summary>
+    /// Check if a voice is currently virtual
     /// </summary>
     /// <param name="voiceID">The voice to query</param>
+    /// <returns>True if the voice exists and is virtual</returns>
+    EXPORT BOOL IsVirtual(const INT32 voiceID);
+
+    /// <summary>
+    /// Enable the volume meter of a bus, needed by GetPeakLevel and GetRMSLevel on buses
+    /// </summary>
+    /// <param name="busID">The bus to meter, 0 for the mastering voice</param>
+    /// <param name="enabled">Enable or disable the meter</param>
+    EXPORT void SetMetering(const INT32 busID, const BOOL enabled);
+    /// <summary>
+    /// Get the peak volume level (for VU meters, etc.)
+    /// Refreshed every 10ms by the audio thread, reading it doesn't lock
+    /// A voice level is estimated from its audio around the play cursor, times its volume
+    /// A bus level is measured at the end of its effect chain, before the bus volume
+    /// </summary>
+    /// <param name="voiceID">The voice or bus to query</param>
     /// <param name="channelIndex">Channel to get peak for (0=left, 1=right, etc.)</param>
+    /// <param name="isBus">true if voiceID refers to a bus, 0 for the mastering voice</param>
     /// <returns>Peak level [0, 1]</returns>
-    // TODO EXPORT FLOAT GetPeakLevel(const INT32 voiceID, const UINT32 channelIndex = 0);
+    EXPORT FLOAT GetPeakLevel(const INT32 voiceID, const UINT32 channelIndex = 0, const BOOL isBus = false);
+    /// <summary>
+    /// Get the RMS volume level, same as GetPeakLevel
+    /// </summary>
+    /// <param name="voiceID">The voice or bus to query</param>
+    /// <param name="channelIndex">Channel to get RMS for (0=left, 1=right, etc.)</param>
+    /// <param name="isBus">true if voiceID refers to a bus, 0 for the mastering voice</param>
+    /// <returns>RMS level [0, 1]</returns>
+    EXPORT FLOAT GetRMSLevel(const INT32 voiceID, const UINT32 channelIndex = 0, const BOOL isBus = false);
 }
\ No newline at end of file
@@ -26,6 +26,7 @@
 namespace SaXAudio
 {
     Fader& Fader::Instance = Fader::getInstance();
+    const INT32 Fader::INTERVAL;
 
     inline FLOAT MoveToTarget(const FLOAT start, const FLOAT end, const FLOAT rate)
     {
@@ -42,57 +43,43 @@ namespace SaXAudio
         return end;
     }
 
-    void Fader::DoFade()
+    void Fader::Tick()
     {
-        auto start = chrono::steady_clock::now();
-        chrono::milliseconds interval = chrono::milliseconds(INTERVAL);
-        UINT64 count = 0;
-
-        do
+        queue<FaderData> callbackQueue;
         {
-            count++;
-            auto target_time = start + (interval * count);
-            this_thread::sleep_until(target_time);
+            lock_guard<mutex> lock(m_jobsMutex);
 
-            queue<FaderData> callbackQueue;
-            {
-                lock_guard<mutex> lock(Instance.m_jobsMutex);
+            if (m_jobs.empty())
+                return;
 
-                if (!Instance.m_running || Instance.m_jobs.empty())
-                    break;
+            for (auto it = m_jobs.begin(); it != m_jobs.end(); it++)
+            {
+                if (it->second.paused || it->second.hasFinished)
+                    continue;
 
-                for (auto it = Instance.m_jobs.begin(); it != Instance.m_jobs.end(); it++)
+                it->second.hasFinished = true;
+                for (UINT32 i = 0; i < it->second.count; i++)
                 {
-                    if (it->second.paused || it->second.hasFinished)
-                        continue;
-
-                    it->second.hasFinished = true;
-                    for (UINT32 i = 0; i < it->second.count; i++)
-                    {
-                        it->second.current[i] = MoveToTarget(it->second.current[i], it->second.target[i], it->second.rate[i]);
-
-                        if (it->second.current[i] != it->second.target[i])
-                            it->second.hasFinished = false;
-                    }
+                    it->second.current[i] = MoveToTarget(it->second.current[i], it->second.target[i], it->second.rate[i]);
 
-                    callbackQueue.push(it->second);
+                    if (it->second.current[i] != it->second.target[i])
+                        it->second.hasFinished = false;
                 }
+
+                callbackQueue.push(it->second);
             }
+        }
 
-            while (!callbackQueue.empty())
+        while (!callbackQueue.empty())
+        {
+            FaderData data = callbackQueue.front();
+            callbackQueue.pop();
+            data.onFade(data.context, data.count, data.current, data.hasFinished);
+            if (data.hasFinished)
             {
-                FaderData data = callbackQueue.front();
-                callbackQueue.pop();
-                data.onFade(data.context, data.count, data.current, data.hasFinished);
-                if (data.hasFinished)
-                {
-                    Instance.StopFade(data.index);
-                }
+                StopFade(data.index);
             }
         }
-        while (Instance.m_running);
-
-        Instance.m_running = false;
     }
 
     UINT32 Fader::StartFade(FLOAT currentValue, FLOAT target, const FLOAT duration, const OnFadeCallback onFade, INT64 context)
@@ -120,11 +107,6 @@ namespace SaXAudio
             onFade,
             context
         };
-        if (!m_running.exchange(true))
-        {
-            m_thread = make_unique<thread>(DoFade);
-            m_thread->detach();
-        }
         return m_jobsCounter++;
     }
 
@@ -143,6 +125,18 @@ namespace SaXAudio
         m_jobs.erase(fadeID);
     }
 
+    void Fader::Clear()
+    {
+        lock_guard<mutex> lock(m_jobsMutex);
+        for (auto& it : m_jobs)
+        {
+            delete[] it.second.current;
+            delete[] it.second.target;
+            delete[] it.second.rate;
+        }
+        m_jobs.clear();
+    }
+
     void Fader::PauseFade(const UINT32 fadeID)
     {
         if (fadeID == 0) return;
@@ -30,8 +30,11 @@ namespace SaXAudio
 
     class Fader
     {
-    private:
+    public:
+        // Time between two Tick in milliseconds, the fade rates are computed from it
         static const INT32 INTERVAL = 10;
+
+    private:
         Fader() = default;
 
         struct FaderData
@@ -51,9 +54,6 @@ namespace SaXAudio
         UINT32 m_jobsCounter = 1;
         mutex m_jobsMutex;
 
-        atomic<bool> m_running;
-        unique_ptr<thread, default_delete<thread>> m_thread;
-
         static Fader& getInstance()
         {
             static Fader instance;
@@ -62,8 +62,6 @@ namespace SaXAudio
         Fader(const Fader&) = delete;
         Fader& operator=(const Fader&) = delete;
 
-        static void DoFade();
-
     public:
         static Fader& Instance;
 
@@ -72,5 +70,10 @@ namespace SaXAudio
         void StopFade(const UINT32 fadeID);
         void PauseFade(const UINT32 fadeID);
         void ResumeFade(const UINT32 fadeID);
+        // Drop every fade, their contexts are gone once the engine is released
+        void Clear();
+
+        // Advance all the fades by one INTERVAL, called by the control thread
+        void Tick();
     };
 }
\ No newline at end of file
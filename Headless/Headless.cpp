@@ -0,0 +1,297 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "Headless.h"
+#include "xapobase.h"
+#include "xapofx.h"
+#include "xaudio2fx.h"
+
+using namespace std;
+
+namespace Headless
+{
+    atomic<UINT32> ReverbParameterCount(0);
+
+#define XAPO_FLAGS_INPLACE XAPO_FLAG_CHANNELS_MUST_MATCH | XAPO_FLAG_FRAMERATE_MUST_MATCH | XAPO_FLAG_BITSPERSAMPLE_MUST_MATCH \
+    | XAPO_FLAG_BUFFERCOUNT_MUST_MATCH | XAPO_FLAG_INPLACE_SUPPORTED | XAPO_FLAG_INPLACE_REQUIRED
+
+    XAPO_REGISTRATION_PROPERTIES Registration =
+    {
+        {},
+        L"Headless effect",
+        L"",
+        1, 0,
+        XAPO_FLAGS_INPLACE,
+        1, 1, 1, 1
+    };
+
+    // Leaves the audio untouched, only keeps its parameters
+    template<class Parameters, BOOL IsReverb = false>
+    class PassThrough : public CXAPOParametersBase
+    {
+    private:
+        Parameters m_parameters[3] = {};
+
+    protected:
+        void OnSetParameters(const void* pParameters, UINT32 ParameterByteSize) override
+        {
+            if (IsReverb)
+                ReverbParameterCount++;
+        }
+
+    public:
+        PassThrough() : CXAPOParametersBase(&Registration, (BYTE*)m_parameters, sizeof(Parameters), false) {}
+
+        STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+            UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) override
+        {
+            BeginProcess();
+            pOutputProcessParameters[0].BufferFlags = pInputProcessParameters[0].BufferFlags;
+            pOutputProcessParameters[0].ValidFrameCount = pInputProcessParameters[0].ValidFrameCount;
+            EndProcess();
+        }
+    };
+
+    // Peak and RMS of the last pass, per channel
+    class VolumeMeter : public CXAPOParametersBase
+    {
+    private:
+        BYTE m_parameters[3] = {};
+        mutex m_mutex;
+        UINT32 m_channels = 0;
+        vector<FLOAT> m_peak;
+        vector<FLOAT> m_rms;
+
+    public:
+        VolumeMeter() : CXAPOParametersBase(&Registration, m_parameters, 1, false) {}
+
+        STDMETHOD(LockForProcess)(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+            UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters) override
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_channels = pInputLockedParameters[0].pFormat->nChannels;
+            m_peak.assign(m_channels, 0.0f);
+            m_rms.assign(m_channels, 0.0f);
+            return CXAPOParametersBase::LockForProcess(InputLockedParameterCount, pInputLockedParameters, OutputLockedParameterCount, pOutputLockedParameters);
+        }
+
+        STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+            UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) override
+        {
+            const XAPO_PROCESS_BUFFER_PARAMETERS& input = pInputProcessParameters[0];
+            pOutputProcessParameters[0].BufferFlags = input.BufferFlags;
+            pOutputProcessParameters[0].ValidFrameCount = input.ValidFrameCount;
+
+            lock_guard<mutex> lock(m_mutex);
+            const FLOAT* samples = (const FLOAT*)input.pBuffer;
+            for (UINT32 c = 0; c < m_channels; c++)
+            {
+                FLOAT peak = 0;
+                double sum = 0;
+                if (IsEnabled && input.BufferFlags == XAPO_BUFFER_VALID)
+                {
+                    for (UINT32 i = 0; i < input.ValidFrameCount; i++)
+                    {
+                        FLOAT sample = samples[i * m_channels + c];
+                        peak = max(peak, fabsf(sample));
+                        sum += (double)sample * sample;
+                    }
+                }
+                m_peak[c] = peak;
+                m_rms[c] = input.ValidFrameCount > 0 ? (FLOAT)sqrt(sum / input.ValidFrameCount) : 0.0f;
+            }
+        }
+
+        STDMETHOD_(void, GetParameters)(void* pParameters, UINT32 ParameterByteSize) override
+        {
+            if (ParameterByteSize != sizeof(XAUDIO2FX_VOLUMEMETER_LEVELS))
+                return;
+
+            XAUDIO2FX_VOLUMEMETER_LEVELS* levels = (XAUDIO2FX_VOLUMEMETER_LEVELS*)pParameters;
+            lock_guard<mutex> lock(m_mutex);
+            for (UINT32 c = 0; c < levels->ChannelCount && c < m_channels; c++)
+            {
+                if (levels->pPeakLevels)
+                    levels->pPeakLevels[c] = m_peak[c];
+                if (levels->pRMSLevels)
+                    levels->pRMSLevels[c] = m_rms[c];
+            }
+        }
+    };
+}
+
+using namespace Headless;
+
+CXAPOBase::CXAPOBase(const XAPO_REGISTRATION_PROPERTIES* pRegistrationProperties)
+    : m_registration(pRegistrationProperties), m_references(1), m_locked(false)
+{
+}
+
+CXAPOBase::~CXAPOBase()
+{
+}
+
+HRESULT CXAPOBase::QueryInterface(REFIID riid, void** ppInterface)
+{
+    if (!ppInterface)
+        return E_POINTER;
+
+    if (riid == __uuidof(IXAPO) || riid == __uuidof(IUnknown))
+    {
+        *ppInterface = static_cast<IXAPO*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppInterface = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG CXAPOBase::AddRef()
+{
+    return ++m_references;
+}
+
+ULONG CXAPOBase::Release()
+{
+    ULONG references = --m_references;
+    if (references == 0)
+        delete this;
+    return references;
+}
+
+HRESULT CXAPOBase::GetRegistrationProperties(XAPO_REGISTRATION_PROPERTIES** ppRegistrationProperties)
+{
+    if (!ppRegistrationProperties)
+        return E_POINTER;
+
+    *ppRegistrationProperties = (XAPO_REGISTRATION_PROPERTIES*)XAPOAlloc(sizeof(XAPO_REGISTRATION_PROPERTIES));
+    if (!*ppRegistrationProperties)
+        return E_OUTOFMEMORY;
+    memcpy(*ppRegistrationProperties, m_registration, sizeof(XAPO_REGISTRATION_PROPERTIES));
+    return S_OK;
+}
+
+HRESULT CXAPOBase::LockForProcess(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+    UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters)
+{
+    if (m_locked)
+        return XAUDIO2_E_INVALID_CALL;
+    m_locked = true;
+    return S_OK;
+}
+
+void CXAPOBase::UnlockForProcess()
+{
+    m_locked = false;
+}
+
+CXAPOParametersBase::CXAPOParametersBase(const XAPO_REGISTRATION_PROPERTIES* pRegistrationProperties, BYTE* pParameterBlocks, UINT32 uParameterBlockByteSize, BOOL fProducer)
+    : CXAPOBase(pRegistrationProperties), m_blocks(pParameterBlocks), m_size(uParameterBlockByteSize)
+{
+}
+
+CXAPOParametersBase::~CXAPOParametersBase()
+{
+}
+
+HRESULT CXAPOParametersBase::QueryInterface(REFIID riid, void** ppInterface)
+{
+    if (ppInterface && riid == __uuidof(IXAPOParameters))
+    {
+        *ppInterface = static_cast<IXAPOParameters*>(this);
+        AddRef();
+        return S_OK;
+    }
+    return CXAPOBase::QueryInterface(riid, ppInterface);
+}
+
+void CXAPOParametersBase::SetParameters(const void* pParameters, UINT32 ParameterByteSize)
+{
+    if (ParameterByteSize != m_size)
+        return;
+
+    OnSetParameters(pParameters, ParameterByteSize);
+
+    // Any block that is neither being processed nor the latest one is free
+    lock_guard<mutex> lock(m_mutex);
+    UINT32 block = 0;
+    while (block == m_processing || block == m_latest)
+        block++;
+    memcpy(m_blocks + block * m_size, pParameters, m_size);
+    m_latest = block;
+    m_new = true;
+}
+
+void CXAPOParametersBase::GetParameters(void* pParameters, UINT32 ParameterByteSize)
+{
+    if (ParameterByteSize != m_size)
+        return;
+
+    lock_guard<mutex> lock(m_mutex);
+    memcpy(pParameters, m_blocks + m_latest * m_size, m_size);
+}
+
+BYTE* CXAPOParametersBase::BeginProcess()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_changed = m_new;
+    if (m_new)
+    {
+        m_processing = m_latest;
+        m_new = false;
+    }
+    return m_blocks + m_processing * m_size;
+}
+
+HRESULT XAudio2Create(IXAudio2** ppXAudio2, UINT32 Flags, XAUDIO2_PROCESSOR XAudio2Processor)
+{
+    // No device, only the SoftwareMixer is available
+    if (ppXAudio2)
+        *ppXAudio2 = nullptr;
+    return E_NOTIMPL;
+}
+
+HRESULT XAudio2CreateReverb(IUnknown** ppApo, UINT32 Flags)
+{
+    *ppApo = static_cast<IXAPO*>(new PassThrough<XAUDIO2FX_REVERB_PARAMETERS, true>());
+    return S_OK;
+}
+
+HRESULT XAudio2CreateVolumeMeter(IUnknown** ppApo, UINT32 Flags)
+{
+    *ppApo = static_cast<IXAPO*>(new VolumeMeter());
+    return S_OK;
+}
+
+HRESULT CreateFX(REFCLSID clsid, IUnknown** pEffect, const void* pInitDat, UINT32 InitDataByteSize)
+{
+    if (clsid == __uuidof(FXEQ))
+        *pEffect = static_cast<IXAPO*>(new PassThrough<FXEQ_PARAMETERS>());
+    else if (clsid == __uuidof(FXEcho))
+        *pEffect = static_cast<IXAPO*>(new PassThrough<FXECHO_PARAMETERS>());
+    else
+        return E_NOTIMPL;
+    return S_OK;
+}
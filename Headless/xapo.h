@@ -0,0 +1,94 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "minwindef.h"
+#include "winnt.h"
+
+#define STDMETHOD(method) virtual HRESULT STDMETHODCALLTYPE method
+#define STDMETHOD_(type, method) virtual type STDMETHODCALLTYPE method
+#define STDMETHODIMP HRESULT STDMETHODCALLTYPE
+#define STDMETHODIMP_(type) type STDMETHODCALLTYPE
+
+#define XAPO_REGISTRATION_STRING_LENGTH 256
+
+#define XAPO_FLAG_CHANNELS_MUST_MATCH 0x00000001
+#define XAPO_FLAG_FRAMERATE_MUST_MATCH 0x00000002
+#define XAPO_FLAG_BITSPERSAMPLE_MUST_MATCH 0x00000004
+#define XAPO_FLAG_BUFFERCOUNT_MUST_MATCH 0x00000008
+#define XAPO_FLAG_INPLACE_SUPPORTED 0x00000010
+#define XAPO_FLAG_INPLACE_REQUIRED 0x00000020
+
+#define XAPOAlloc(size) malloc(size)
+#define XAPOFree(p) free(p)
+
+typedef struct
+{
+    CLSID clsid;
+    WCHAR FriendlyName[XAPO_REGISTRATION_STRING_LENGTH];
+    WCHAR CopyrightInfo[XAPO_REGISTRATION_STRING_LENGTH];
+    UINT32 MajorVersion;
+    UINT32 MinorVersion;
+    UINT32 Flags;
+    UINT32 MinInputBufferCount;
+    UINT32 MaxInputBufferCount;
+    UINT32 MinOutputBufferCount;
+    UINT32 MaxOutputBufferCount;
+} XAPO_REGISTRATION_PROPERTIES;
+
+typedef struct
+{
+    const WAVEFORMATEX* pFormat;
+    UINT32 MaxFrameCount;
+} XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS;
+
+typedef enum
+{
+    XAPO_BUFFER_SILENT,
+    XAPO_BUFFER_VALID
+} XAPO_BUFFER_FLAGS;
+
+typedef struct
+{
+    void* pBuffer;
+    XAPO_BUFFER_FLAGS BufferFlags;
+    UINT32 ValidFrameCount;
+} XAPO_PROCESS_BUFFER_PARAMETERS;
+
+struct IXAPO : IUnknown
+{
+    STDMETHOD(GetRegistrationProperties)(XAPO_REGISTRATION_PROPERTIES** ppRegistrationProperties) = 0;
+    STDMETHOD(LockForProcess)(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+        UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters) = 0;
+    STDMETHOD_(void, UnlockForProcess)() = 0;
+    STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount, const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+        UINT32 OutputProcessParameterCount, XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) = 0;
+    STDMETHOD_(void, Reset)() = 0;
+};
+
+struct IXAPOParameters : IUnknown
+{
+    STDMETHOD_(void, SetParameters)(const void* pParameters, UINT32 ParameterByteSize) = 0;
+    STDMETHOD_(void, GetParameters)(void* pParameters, UINT32 ParameterByteSize) = 0;
+};
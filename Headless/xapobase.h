@@ -0,0 +1,82 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "xapo.h"
+
+// Same contract as the base classes of the XAPO library: one reference on creation,
+// the parameters are handed to Process through the triple buffer given by the derived class
+class CXAPOBase : public IXAPO
+{
+private:
+    const XAPO_REGISTRATION_PROPERTIES* m_registration;
+    std::atomic<ULONG> m_references;
+    BOOL m_locked;
+
+protected:
+    CXAPOBase(const XAPO_REGISTRATION_PROPERTIES* pRegistrationProperties);
+    virtual ~CXAPOBase();
+
+    BOOL IsLocked() { return m_locked; }
+
+public:
+    STDMETHOD(QueryInterface)(REFIID riid, void** ppInterface) override;
+    STDMETHOD_(ULONG, AddRef)() override;
+    STDMETHOD_(ULONG, Release)() override;
+
+    STDMETHOD(GetRegistrationProperties)(XAPO_REGISTRATION_PROPERTIES** ppRegistrationProperties) override;
+    STDMETHOD(LockForProcess)(UINT32 InputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+        UINT32 OutputLockedParameterCount, const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters) override;
+    STDMETHOD_(void, UnlockForProcess)() override;
+    STDMETHOD_(void, Reset)() override {}
+};
+
+class CXAPOParametersBase : public CXAPOBase, public IXAPOParameters
+{
+private:
+    BYTE* m_blocks;
+    UINT32 m_size;
+    std::mutex m_mutex;
+    UINT32 m_latest = 0;        // Last block written by SetParameters
+    UINT32 m_processing = 0;    // Block used by Process
+    BOOL m_new = false;
+    BOOL m_changed = false;
+
+protected:
+    CXAPOParametersBase(const XAPO_REGISTRATION_PROPERTIES* pRegistrationProperties, BYTE* pParameterBlocks, UINT32 uParameterBlockByteSize, BOOL fProducer);
+    virtual ~CXAPOParametersBase();
+
+    virtual void OnSetParameters(const void* pParameters, UINT32 ParameterByteSize) {}
+    BOOL ParametersChanged() { return m_changed; }
+    BYTE* BeginProcess();
+    void EndProcess() {}
+
+public:
+    STDMETHOD(QueryInterface)(REFIID riid, void** ppInterface) override;
+    STDMETHOD_(ULONG, AddRef)() override { return CXAPOBase::AddRef(); }
+    STDMETHOD_(ULONG, Release)() override { return CXAPOBase::Release(); }
+
+    STDMETHOD_(void, SetParameters)(const void* pParameters, UINT32 ParameterByteSize) override;
+    STDMETHOD_(void, GetParameters)(void* pParameters, UINT32 ParameterByteSize) override;
+};
@@ -0,0 +1,74 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "xaudio2.h"
+
+// The headless effects only pass the audio through, their parameters are kept for GetEffectParameters
+struct FXEQ;
+struct FXEcho;
+struct FXReverb;
+struct FXMasteringLimiter;
+
+#define FXEQ_DEFAULT_FREQUENCY_CENTER_0 100.0f
+#define FXEQ_DEFAULT_FREQUENCY_CENTER_1 800.0f
+#define FXEQ_DEFAULT_FREQUENCY_CENTER_2 2000.0f
+#define FXEQ_DEFAULT_FREQUENCY_CENTER_3 10000.0f
+#define FXEQ_DEFAULT_GAIN 1.0f
+#define FXEQ_DEFAULT_BANDWIDTH 1.0f
+
+#define FXECHO_MIN_DELAY 1.0f
+#define FXECHO_MIN_MAXDELAY 1.0f
+#define FXECHO_MAX_MAXDELAY 20000.0f
+#define FXECHO_DEFAULT_MAXDELAY 1000.0f
+
+typedef struct
+{
+    float FrequencyCenter0;
+    float Gain0;
+    float Bandwidth0;
+    float FrequencyCenter1;
+    float Gain1;
+    float Bandwidth1;
+    float FrequencyCenter2;
+    float Gain2;
+    float Bandwidth2;
+    float FrequencyCenter3;
+    float Gain3;
+    float Bandwidth3;
+} FXEQ_PARAMETERS;
+
+typedef struct
+{
+    float WetDryMix;
+    float Feedback;
+    float Delay;
+} FXECHO_PARAMETERS;
+
+typedef struct
+{
+    float MaxDelay;
+} FXECHO_INITDATA;
+
+HRESULT CreateFX(REFCLSID clsid, IUnknown** pEffect, const void* pInitDat = nullptr, UINT32 InitDataByteSize = 0);
@@ -0,0 +1,273 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "minwindef.h"
+#include "winnt.h"
+
+// Headless stand-in for the XAudio2 interfaces, the engine runs on the SoftwareMixer
+// XAudio2Create always fails, there is no device to play on
+
+#define XAUDIO2_DEFAULT_PROCESSOR 1
+#define XAUDIO2_COMMIT_NOW 0
+#define XAUDIO2_COMMIT_ALL 0
+#define XAUDIO2_LOOP_INFINITE 255
+#define XAUDIO2_MAX_LOOP_COUNT 254
+#define XAUDIO2_MAX_QUEUED_BUFFERS 64
+#define XAUDIO2_END_OF_STREAM 0x40
+#define XAUDIO2_PLAY_TAILS 0x20
+#define XAUDIO2_VOICE_NOPITCH 0x2
+#define XAUDIO2_VOICE_NOSRC 0x4
+#define XAUDIO2_VOICE_USEFILTER 0x8
+#define XAUDIO2_VOICE_NOSAMPLESPLAYED 0x100
+#define XAUDIO2_SEND_USEFILTER 0x80
+#define XAUDIO2_MAX_FREQ_RATIO 1024.0f
+#define XAUDIO2_MIN_FREQ_RATIO (1 / 1024.0f)
+#define XAUDIO2_MAX_SAMPLE_RATE 200000
+#define XAUDIO2_MIN_SAMPLE_RATE 1000
+#define XAUDIO2_DEFAULT_CHANNELS 0
+#define XAUDIO2_DEFAULT_SAMPLERATE 0
+#define XAUDIO2_QUANTUM_NUMERATOR 1
+#define XAUDIO2_QUANTUM_DENOMINATOR 100
+#define XAUDIO2_MAX_FILTER_FREQUENCY 1.0f
+#define XAUDIO2_MAX_FILTER_ONEOVERQ 1.5f
+#define XAUDIO2_DEFAULT_FILTER_FREQUENCY XAUDIO2_MAX_FILTER_FREQUENCY
+#define XAUDIO2_DEFAULT_FILTER_ONEOVERQ 1.0f
+#define XAUDIO2_E_INVALID_CALL ((HRESULT)0x88960001)
+
+typedef UINT32 XAUDIO2_PROCESSOR;
+enum AUDIO_STREAM_CATEGORY { AudioCategory_GameEffects = 6 };
+
+typedef enum
+{
+    LowPassFilter,
+    BandPassFilter,
+    HighPassFilter,
+    NotchFilter,
+    LowPassOnePoleFilter,
+    HighPassOnePoleFilter
+} XAUDIO2_FILTER_TYPE;
+
+typedef struct
+{
+    XAUDIO2_FILTER_TYPE Type;
+    float Frequency;
+    float OneOverQ;
+} XAUDIO2_FILTER_PARAMETERS;
+
+typedef struct
+{
+    UINT32 Flags;
+    UINT32 AudioBytes;
+    const BYTE* pAudioData;
+    UINT32 PlayBegin;
+    UINT32 PlayLength;
+    UINT32 LoopBegin;
+    UINT32 LoopLength;
+    UINT32 LoopCount;
+    void* pContext;
+} XAUDIO2_BUFFER;
+
+typedef struct
+{
+    const UINT32* pDecodedPacketCumulativeBytes;
+    UINT32 PacketCount;
+} XAUDIO2_BUFFER_WMA;
+
+typedef struct
+{
+    void* pCurrentBufferContext;
+    UINT32 BuffersQueued;
+    UINT64 SamplesPlayed;
+} XAUDIO2_VOICE_STATE;
+
+typedef struct
+{
+    UINT32 CreationFlags;
+    UINT32 ActiveFlags;
+    UINT32 InputChannels;
+    UINT32 InputSampleRate;
+} XAUDIO2_VOICE_DETAILS;
+
+struct IXAudio2Voice;
+
+typedef struct
+{
+    UINT32 Flags;
+    IXAudio2Voice* pOutputVoice;
+} XAUDIO2_SEND_DESCRIPTOR;
+
+typedef struct
+{
+    UINT32 SendCount;
+    XAUDIO2_SEND_DESCRIPTOR* pSends;
+} XAUDIO2_VOICE_SENDS;
+
+typedef struct
+{
+    IUnknown* pEffect;
+    BOOL InitialState;
+    UINT32 OutputChannels;
+} XAUDIO2_EFFECT_DESCRIPTOR;
+
+typedef struct
+{
+    UINT32 EffectCount;
+    XAUDIO2_EFFECT_DESCRIPTOR* pEffectDescriptors;
+} XAUDIO2_EFFECT_CHAIN;
+
+typedef struct
+{
+    UINT64 AudioCyclesSinceLastQuery;
+    UINT64 TotalCyclesSinceLastQuery;
+    UINT32 MinimumCyclesPerQuantum;
+    UINT32 MaximumCyclesPerQuantum;
+    UINT32 MemoryUsageInBytes;
+    UINT32 CurrentLatencyInSamples;
+    UINT32 GlitchesSinceEngineStarted;
+    UINT32 ActiveSourceVoiceCount;
+    UINT32 TotalSourceVoiceCount;
+    UINT32 ActiveSubmixVoiceCount;
+    UINT32 ActiveResamplerCount;
+    UINT32 ActiveMatrixMixCount;
+    UINT32 ActiveXmaSourceVoices;
+    UINT32 ActiveXmaStreams;
+} XAUDIO2_PERFORMANCE_DATA;
+
+typedef struct
+{
+    UINT32 TraceMask;
+    UINT32 BreakMask;
+    BOOL LogThreadID;
+    BOOL LogFileline;
+    BOOL LogFunctionName;
+    BOOL LogTiming;
+} XAUDIO2_DEBUG_CONFIGURATION;
+
+struct IXAudio2VoiceCallback
+{
+    virtual void OnVoiceProcessingPassStart(UINT32 BytesRequired) = 0;
+    virtual void OnVoiceProcessingPassEnd() = 0;
+    virtual void OnStreamEnd() = 0;
+    virtual void OnBufferStart(void* pBufferContext) = 0;
+    virtual void OnBufferEnd(void* pBufferContext) = 0;
+    virtual void OnLoopEnd(void* pBufferContext) = 0;
+    virtual void OnVoiceError(void* pBufferContext, HRESULT Error) = 0;
+};
+
+struct IXAudio2EngineCallback
+{
+    virtual void OnProcessingPassStart() = 0;
+    virtual void OnProcessingPassEnd() = 0;
+    virtual void OnCriticalError(HRESULT Error) = 0;
+};
+
+struct IXAudio2Voice
+{
+    virtual void GetVoiceDetails(XAUDIO2_VOICE_DETAILS* pVoiceDetails) = 0;
+    virtual HRESULT SetOutputVoices(const XAUDIO2_VOICE_SENDS* pSendList) = 0;
+    virtual HRESULT SetEffectChain(const XAUDIO2_EFFECT_CHAIN* pEffectChain) = 0;
+    virtual HRESULT EnableEffect(UINT32 EffectIndex, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual HRESULT DisableEffect(UINT32 EffectIndex, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetEffectState(UINT32 EffectIndex, BOOL* pEnabled) = 0;
+    virtual HRESULT SetEffectParameters(UINT32 EffectIndex, const void* pParameters, UINT32 ParametersByteSize, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual HRESULT GetEffectParameters(UINT32 EffectIndex, void* pParameters, UINT32 ParametersByteSize) = 0;
+    virtual HRESULT SetFilterParameters(const XAUDIO2_FILTER_PARAMETERS* pParameters, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetFilterParameters(XAUDIO2_FILTER_PARAMETERS* pParameters) = 0;
+    virtual HRESULT SetOutputFilterParameters(IXAudio2Voice* pDestinationVoice, const XAUDIO2_FILTER_PARAMETERS* pParameters, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetOutputFilterParameters(IXAudio2Voice* pDestinationVoice, XAUDIO2_FILTER_PARAMETERS* pParameters) = 0;
+    virtual HRESULT SetVolume(float Volume, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetVolume(float* pVolume) = 0;
+    virtual HRESULT SetChannelVolumes(UINT32 Channels, const float* pVolumes, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetChannelVolumes(UINT32 Channels, float* pVolumes) = 0;
+    virtual HRESULT SetOutputMatrix(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, const float* pLevelMatrix, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetOutputMatrix(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, float* pLevelMatrix) = 0;
+    virtual void DestroyVoice() = 0;
+};
+
+struct IXAudio2SourceVoice : IXAudio2Voice
+{
+    virtual HRESULT Start(UINT32 Flags = 0, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual HRESULT Stop(UINT32 Flags = 0, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual HRESULT SubmitSourceBuffer(const XAUDIO2_BUFFER* pBuffer, const XAUDIO2_BUFFER_WMA* pBufferWMA = nullptr) = 0;
+    virtual HRESULT FlushSourceBuffers() = 0;
+    virtual HRESULT Discontinuity() = 0;
+    virtual HRESULT ExitLoop(UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetState(XAUDIO2_VOICE_STATE* pVoiceState, UINT32 Flags = 0) = 0;
+    virtual HRESULT SetFrequencyRatio(float Ratio, UINT32 OperationSet = XAUDIO2_COMMIT_NOW) = 0;
+    virtual void GetFrequencyRatio(float* pRatio) = 0;
+    virtual HRESULT SetSourceSampleRate(UINT32 NewSourceSampleRate) = 0;
+};
+
+struct IXAudio2SubmixVoice : IXAudio2Voice
+{
+};
+
+struct IXAudio2MasteringVoice : IXAudio2Voice
+{
+    virtual HRESULT GetChannelMask(DWORD* pChannelmask) = 0;
+};
+
+struct IXAudio2 : IUnknown
+{
+    virtual HRESULT RegisterForCallbacks(IXAudio2EngineCallback* pCallback) = 0;
+    virtual void UnregisterForCallbacks(IXAudio2EngineCallback* pCallback) = 0;
+    virtual HRESULT CreateSourceVoice(IXAudio2SourceVoice** ppSourceVoice, const WAVEFORMATEX* pSourceFormat, UINT32 Flags = 0, float MaxFrequencyRatio = 2.0f,
+        IXAudio2VoiceCallback* pCallback = nullptr, const XAUDIO2_VOICE_SENDS* pSendList = nullptr, const XAUDIO2_EFFECT_CHAIN* pEffectChain = nullptr) = 0;
+    virtual HRESULT CreateSubmixVoice(IXAudio2SubmixVoice** ppSubmixVoice, UINT32 InputChannels, UINT32 InputSampleRate, UINT32 Flags = 0, UINT32 ProcessingStage = 0,
+        const XAUDIO2_VOICE_SENDS* pSendList = nullptr, const XAUDIO2_EFFECT_CHAIN* pEffectChain = nullptr) = 0;
+    virtual HRESULT CreateMasteringVoice(IXAudio2MasteringVoice** ppMasteringVoice, UINT32 InputChannels = XAUDIO2_DEFAULT_CHANNELS, UINT32 InputSampleRate = XAUDIO2_DEFAULT_SAMPLERATE,
+        UINT32 Flags = 0, LPCWSTR szDeviceId = nullptr, const XAUDIO2_EFFECT_CHAIN* pEffectChain = nullptr, AUDIO_STREAM_CATEGORY StreamCategory = AudioCategory_GameEffects) = 0;
+    virtual HRESULT StartEngine() = 0;
+    virtual void StopEngine() = 0;
+    virtual HRESULT CommitChanges(UINT32 OperationSet) = 0;
+    virtual void GetPerformanceData(XAUDIO2_PERFORMANCE_DATA* pPerfData) = 0;
+    virtual void SetDebugConfiguration(const XAUDIO2_DEBUG_CONFIGURATION* pDebugConfiguration, void* pReserved = nullptr) = 0;
+};
+
+HRESULT XAudio2Create(IXAudio2** ppXAudio2, UINT32 Flags = 0, XAUDIO2_PROCESSOR XAudio2Processor = XAUDIO2_DEFAULT_PROCESSOR);
+
+inline float XAudio2DecibelsToAmplitudeRatio(float Decibels)
+{
+    return powf(10.0f, Decibels / 20.0f);
+}
+
+inline float XAudio2AmplitudeRatioToDecibels(float Volume)
+{
+    return Volume == 0 ? -3.402823466e+38f : 20.0f * log10f(Volume);
+}
+
+inline float XAudio2CutoffFrequencyToRadians(float CutoffFrequency, UINT32 SampleRate)
+{
+    if ((UINT32)(CutoffFrequency * 6.0f) >= SampleRate)
+        return XAUDIO2_MAX_FILTER_FREQUENCY;
+    return 2.0f * sinf(3.14159265f * CutoffFrequency / SampleRate);
+}
+
+inline float XAudio2CutoffFrequencyToOnePoleCoefficient(float CutoffFrequency, UINT32 SampleRate)
+{
+    if ((UINT32)CutoffFrequency >= SampleRate)
+        return XAUDIO2_MAX_FILTER_FREQUENCY;
+    return 1.0f - powf(1.0f - 2.0f * CutoffFrequency / SampleRate, 2.0f);
+}
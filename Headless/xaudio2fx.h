@@ -0,0 +1,68 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "xaudio2.h"
+
+#pragma pack(push, 1)
+
+typedef struct
+{
+    float WetDryMix;
+    UINT32 ReflectionsDelay;
+    BYTE ReverbDelay;
+    BYTE RearDelay;
+    BYTE SideDelay;
+    BYTE PositionLeft;
+    BYTE PositionRight;
+    BYTE PositionMatrixLeft;
+    BYTE PositionMatrixRight;
+    BYTE EarlyDiffusion;
+    BYTE LateDiffusion;
+    BYTE LowEQGain;
+    BYTE LowEQCutoff;
+    BYTE HighEQGain;
+    BYTE HighEQCutoff;
+    float RoomFilterFreq;
+    float RoomFilterMain;
+    float RoomFilterHF;
+    float ReflectionsGain;
+    float ReverbGain;
+    float DecayTime;
+    float Density;
+    float RoomSize;
+    BOOL DisableLateField;
+} XAUDIO2FX_REVERB_PARAMETERS;
+
+typedef struct
+{
+    float* pPeakLevels;
+    float* pRMSLevels;
+    UINT32 ChannelCount;
+} XAUDIO2FX_VOLUMEMETER_LEVELS;
+
+#pragma pack(pop)
+
+HRESULT XAudio2CreateReverb(IUnknown** ppApo, UINT32 Flags = 0);
+HRESULT XAudio2CreateVolumeMeter(IUnknown** ppApo, UINT32 Flags = 0);
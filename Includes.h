@@ -41,7 +41,11 @@
 #include <xaudio2fx.h>
 #include <xapofx.h>
 #include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <queue>
+#include <deque>
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -65,8 +69,7 @@ namespace SaXAudio
     void StopLogging();
 }
 #else
-#pragma warning( disable : 4003)
-#define Log(bankID, voiceId, message, hr)
+#define Log(...)
 #define StartLogging()
 #define StopLogging()
 #endif // LOGGING
\ No newline at end of file
@@ -0,0 +1,57 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "OutputMatrix.h"
+
+namespace SaXAudio
+{
+    void SpeakerLayout::Init(const DWORD channelMask, const UINT32 destChannels)
+    {
+        *this = SpeakerLayout();
+        channels = destChannels;
+
+        // Map channel mask to indices (support 5.1/7.1)
+        DWORD currentMask = 1;
+        INT32 channelIndex = 0;
+
+        for (UINT32 i = 0; i < MAX_OUTPUT_CHANNELS && channelIndex < (INT32)destChannels; i++)
+        {
+            if (channelMask & currentMask)
+            {
+                switch (currentMask)
+                {
+                case SPEAKER_FRONT_LEFT: left = channelIndex; break;
+                case SPEAKER_FRONT_RIGHT: right = channelIndex; break;
+                case SPEAKER_FRONT_CENTER: center = channelIndex; break;
+                case SPEAKER_LOW_FREQUENCY: lfe = channelIndex; break;
+                case SPEAKER_BACK_LEFT: backLeft = channelIndex; break;
+                case SPEAKER_BACK_RIGHT: backRight = channelIndex; break;
+                case SPEAKER_SIDE_LEFT: sideLeft = channelIndex; break;
+                case SPEAKER_SIDE_RIGHT: sideRight = channelIndex; break;
+                }
+                channelIndex++;
+            }
+            currentMask <<= 1;
+        }
+    }
+}
@@ -0,0 +1,124 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+#define MAX_OUTPUT_CHANNELS 12
+#define CENTER_GAIN 0.707f  // -3dB
+#define SURROUND_GAIN 0.5f  // -6dB
+
+    // Position of each speaker in the mastering voice channels, -1 when absent
+    // Only depends on the mastering voice so it is computed once
+    struct SpeakerLayout
+    {
+        UINT32 channels = 0;
+
+        INT32 left = -1;
+        INT32 right = -1;
+        INT32 center = -1;
+        INT32 lfe = -1;
+        INT32 backLeft = -1;
+        INT32 backRight = -1;
+        INT32 sideLeft = -1;
+        INT32 sideRight = -1;
+
+        void Init(const DWORD channelMask, const UINT32 destChannels);
+    };
+
+    /// <summary>
+    /// Fill a SourceChannels x layout.channels output matrix for the panning
+    /// The matrix must hold at least SourceChannels * MAX_OUTPUT_CHANNELS values and be initialized to 0
+    /// </summary>
+    template<UINT32 SourceChannels>
+    inline void BuildOutputMatrix(const SpeakerLayout& layout, const FLOAT panning, FLOAT* matrix);
+
+    // Mono: the same source goes to both sides, attenuated on the opposite side of the panning
+    template<>
+    inline void BuildOutputMatrix<1>(const SpeakerLayout& layout, const FLOAT panning, FLOAT* matrix)
+    {
+        FLOAT leftGain = min(1, 1 - panning);
+        FLOAT rightGain = min(1, 1 + panning);
+
+        if (layout.left >= 0) matrix[layout.left] = leftGain;
+        if (layout.right >= 0) matrix[layout.right] = rightGain;
+        if (layout.center >= 0) matrix[layout.center] = CENTER_GAIN;
+
+        if (layout.backLeft >= 0) matrix[layout.backLeft] = SURROUND_GAIN * leftGain;
+        if (layout.backRight >= 0) matrix[layout.backRight] = SURROUND_GAIN * rightGain;
+        if (layout.sideLeft >= 0) matrix[layout.sideLeft] = SURROUND_GAIN * leftGain;
+        if (layout.sideRight >= 0) matrix[layout.sideRight] = SURROUND_GAIN * rightGain;
+
+        // LFE channel gets no direct signal (would need bass management for proper implementation)
+    }
+
+    // Stereo: panning moves part of one channel into the other side
+    template<>
+    inline void BuildOutputMatrix<2>(const SpeakerLayout& layout, const FLOAT panning, FLOAT* matrix)
+    {
+        FLOAT LR = max(0, -panning);
+        FLOAT RL = max(0, panning);
+        FLOAT LL = min(1, 1 - panning);
+        FLOAT RR = min(1, 1 + panning);
+
+        if (layout.left >= 0)
+        {
+            matrix[layout.left * 2 + 0] = LL;
+            matrix[layout.left * 2 + 1] = LR;
+        }
+        if (layout.right >= 0)
+        {
+            matrix[layout.right * 2 + 0] = RL;
+            matrix[layout.right * 2 + 1] = RR;
+        }
+        if (layout.center >= 0)
+        {
+            matrix[layout.center * 2 + 0] = CENTER_GAIN;
+            matrix[layout.center * 2 + 1] = CENTER_GAIN;
+        }
+
+        if (layout.backLeft >= 0)
+        {
+            matrix[layout.backLeft * 2 + 0] = SURROUND_GAIN * LL;
+            matrix[layout.backLeft * 2 + 1] = SURROUND_GAIN * LR;
+        }
+        if (layout.backRight >= 0)
+        {
+            matrix[layout.backRight * 2 + 0] = SURROUND_GAIN * RL;
+            matrix[layout.backRight * 2 + 1] = SURROUND_GAIN * RR;
+        }
+        if (layout.sideLeft >= 0)
+        {
+            matrix[layout.sideLeft * 2 + 0] = SURROUND_GAIN * LL;
+            matrix[layout.sideLeft * 2 + 1] = SURROUND_GAIN * LR;
+        }
+        if (layout.sideRight >= 0)
+        {
+            matrix[layout.sideRight * 2 + 0] = SURROUND_GAIN * RL;
+            matrix[layout.sideRight * 2 + 1] = SURROUND_GAIN * RR;
+        }
+    }
+}
@@ -0,0 +1,339 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "Playlist.h"
+#include "SaXAudio.h"
+#include "Fader.h"
+
+namespace SaXAudio
+{
+#define HALF_PI 1.5707963f
+
+    PlaylistManager& PlaylistManager::Instance = PlaylistManager::getInstance();
+
+    INT32 PlaylistManager::Create(const INT32 busID)
+    {
+        INT32 playlistID = m_playlistCounter++;
+        m_playlists[playlistID].busID = busID;
+
+        Log(0, 0, "[Playlist] Created: " + to_string(playlistID));
+        return playlistID;
+    }
+
+    void PlaylistManager::Remove(const INT32 playlistID)
+    {
+        auto it = m_playlists.find(playlistID);
+        if (it == m_playlists.end())
+            return;
+
+        Stop(playlistID, 0);
+        m_playlists.erase(it);
+        Log(0, 0, "[Playlist] Removed: " + to_string(playlistID));
+    }
+
+    void PlaylistManager::Clear()
+    {
+        // The voices are gone with the engine
+        for (auto& it : m_playlists)
+            Fader::Instance.StopFade(it.second.fadeID);
+        m_playlists.clear();
+    }
+
+    BOOL PlaylistManager::SetTempo(const INT32 playlistID, const FLOAT bpm, const UINT32 beatsPerBar)
+    {
+        auto it = m_playlists.find(playlistID);
+        if (it == m_playlists.end() || bpm <= 0 || beatsPerBar == 0)
+            return false;
+
+        it->second.bpm = bpm;
+        it->second.beatsPerBar = beatsPerBar;
+        return true;
+    }
+
+    BOOL PlaylistManager::Queue(const INT32 playlistID, const INT32 bankID, const BOOL looping)
+    {
+        auto it = m_playlists.find(playlistID);
+        if (it == m_playlists.end())
+            return false;
+
+        PlaylistData& data = it->second;
+        data.tracks.push_back({ bankID, looping });
+
+        // The current track might have been waiting for a next one
+        PrepareNext(data);
+        return true;
+    }
+
+    BOOL PlaylistManager::Play(const INT32 playlistID)
+    {
+        auto it = m_playlists.find(playlistID);
+        if (it == m_playlists.end())
+            return false;
+
+        PlaylistData& data = it->second;
+        if (data.currentVoice && SaXAudio::Instance.GetVoice(data.currentVoice))
+            return true;
+
+        if (data.tracks.empty())
+            return false;
+
+        Track track = data.tracks.front();
+        data.tracks.pop_front();
+
+        // Scheduled slightly ahead so the beat grid starts on a known sample
+        UINT64 now = SaXAudio::Instance.GetEngineTime();
+        UINT64 start = now + (UINT64)SaXAudio::Instance.GetEngineSampleRate() * SCHEDULE_LEAD_MS / 1000;
+        data.currentVoice = StartTrack(data, track, start);
+        data.currentStart = start;
+
+        PrepareNext(data);
+        return data.currentVoice != 0;
+    }
+
+    BOOL PlaylistManager::Transition(const INT32 playlistID, const INT32 bankID, const BOOL looping, const FLOAT fade, const Quantize quantize)
+    {
+        auto it = m_playlists.find(playlistID);
+        if (it == m_playlists.end())
+            return false;
+
+        PlaylistData& data = it->second;
+        UINT32 engineRate = SaXAudio::Instance.GetEngineSampleRate();
+        UINT64 now = SaXAudio::Instance.GetEngineTime();
+        UINT64 start = now + (UINT64)engineRate * SCHEDULE_LEAD_MS / 1000;
+
+        // Only one crossfade at a time, the track fading out of the previous one keeps fading from where it is
+        InterruptFade(data, fade);
+        CancelNext(data);
+
+        AudioVoice* current = SaXAudio::Instance.GetVoice(data.currentVoice);
+        if (!current)
+        {
+            data.currentVoice = 0;
+            data.tracks.push_front({ bankID, looping });
+            return Play(playlistID);
+        }
+
+        if (quantize != QUANTIZE_NONE && start > data.currentStart)
+        {
+            // Round up to the next beat or bar of the current track
+            double unit = engineRate * 60.0 / data.bpm;
+            if (quantize == QUANTIZE_BAR)
+                unit *= data.beatsPerBar;
+
+            double beats = ceil((start - data.currentStart) / unit);
+            start = data.currentStart + (UINT64)(beats * unit);
+        }
+
+        INT32 voiceID = StartTrack(data, { bankID, looping }, start);
+        if (!voiceID)
+            return false;
+
+        Log(0, 0, "[Playlist] Transition at: " + to_string(start) + " now: " + to_string(now));
+
+        data.fadingVoice = data.currentVoice;
+        data.fadingStart = data.currentStart;
+        data.fadingLevel = current->Volume;
+        data.currentVoice = voiceID;
+        data.currentStart = start;
+        data.fadeStart = start;
+        data.fadeLength = (UINT64)(max(fade, 0.0f) * engineRate);
+
+        // The new track starts silent, the fade job lasts until the end of the crossfade
+        SaXAudio::Instance.GetVoice(voiceID)->SetVolume(data.fadeLength > 0 ? 0.0f : 1.0f);
+        FLOAT duration = (FLOAT)(start - now) / engineRate + max(fade, 0.0f);
+        data.fadeID = Fader::Instance.StartFade(0, 1, duration, OnFadeTransition, playlistID);
+
+        PrepareNext(data);
+        return true;
+    }
+
+    void PlaylistManager::Stop(const INT32 playlistID, const FLOAT fade)
+    {
+        auto it = m_playlists.find(playlistID);
+        if (it == m_playlists.end())
+            return;
+
+        PlaylistData& data = it->second;
+        InterruptFade(data, fade);
+        CancelNext(data);
+        data.tracks.clear();
+
+        StopTrack(data.currentVoice, fade);
+        data.currentVoice = 0;
+    }
+
+    INT32 PlaylistManager::GetCurrentVoice(const INT32 playlistID)
+    {
+        auto it = m_playlists.find(playlistID);
+        if (it == m_playlists.end())
+            return 0;
+        return it->second.currentVoice;
+    }
+
+    void PlaylistManager::Update()
+    {
+        if (m_playlists.empty())
+            return;
+
+        UINT64 now = SaXAudio::Instance.GetEngineTime();
+        for (auto& it : m_playlists)
+        {
+            PlaylistData& data = it.second;
+            if (data.currentVoice && !data.nextVoice && !SaXAudio::Instance.GetVoice(data.currentVoice))
+                data.currentVoice = 0;
+
+            if (!data.nextVoice || now < data.nextStart)
+                continue;
+
+            // The next track took over, the beat grid follows it
+            data.currentVoice = data.nextVoice;
+            data.currentStart = data.nextStart;
+            data.nextVoice = 0;
+            PrepareNext(data);
+        }
+    }
+
+    INT32 PlaylistManager::StartTrack(PlaylistData& data, const Track& track, const UINT64 engineTime)
+    {
+        AudioVoice* voice = SaXAudio::Instance.CreateVoice(track.bankID, data.busID);
+        if (!voice)
+            return 0;
+
+        INT32 voiceID = voice->VoiceID;
+        voice->SetLooping(track.looping);
+        if (!SaXAudio::Instance.ScheduleStart(voiceID, engineTime))
+        {
+            SaXAudio::Instance.RemoveVoice(voiceID);
+            return 0;
+        }
+        return voiceID;
+    }
+
+    void PlaylistManager::StopTrack(const INT32 voiceID, const FLOAT fade)
+    {
+        AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
+        if (!voice)
+            return;
+
+        // A track waiting for its scheduled start has nothing to fade
+        if (!voice->IsPlaying || !voice->Stop(fade))
+            SaXAudio::Instance.RemoveVoice(voiceID);
+    }
+
+    void PlaylistManager::PrepareNext(PlaylistData& data)
+    {
+        if (data.nextVoice || data.tracks.empty())
+            return;
+
+        // A looping track only ends with a transition
+        AudioVoice* current = SaXAudio::Instance.GetVoice(data.currentVoice);
+        if (!current || current->Looping || !current->BankData)
+            return;
+
+        // Pre-created and submitted now, it starts the sample the current track ends
+        BankData* bank = current->BankData;
+        UINT64 length = (UINT64)bank->totalSamples * SaXAudio::Instance.GetEngineSampleRate() / bank->sampleRate;
+        UINT64 start = data.currentStart + length;
+
+        Track track = data.tracks.front();
+        data.tracks.pop_front();
+
+        data.nextVoice = StartTrack(data, track, start);
+        data.nextStart = start;
+    }
+
+    void PlaylistManager::CancelNext(PlaylistData& data)
+    {
+        if (!data.nextVoice)
+            return;
+
+        StopTrack(data.nextVoice, 0);
+        data.nextVoice = 0;
+    }
+
+    void PlaylistManager::FinishFade(PlaylistData& data)
+    {
+        // The crossfade reached its end
+        data.fadeID = 0;
+
+        AudioVoice* current = SaXAudio::Instance.GetVoice(data.currentVoice);
+        if (current)
+            current->SetVolume(1.0f);
+
+        StopTrack(data.fadingVoice, 0);
+        data.fadingVoice = 0;
+    }
+
+    void PlaylistManager::InterruptFade(PlaylistData& data, const FLOAT fade)
+    {
+        if (!data.fadeID)
+            return;
+
+        Fader::Instance.StopFade(data.fadeID);
+        data.fadeID = 0;
+
+        if (SaXAudio::Instance.GetEngineTime() < data.fadeStart)
+        {
+            // The incoming track was never heard, the outgoing one is still the current track
+            StopTrack(data.currentVoice, 0);
+            data.currentVoice = data.fadingVoice;
+            data.currentStart = data.fadingStart;
+        }
+        else
+        {
+            // Fades out from its current level instead of cutting
+            StopTrack(data.fadingVoice, fade);
+        }
+        data.fadingVoice = 0;
+    }
+
+    void PlaylistManager::OnFadeTransition(INT64 playlistID, UINT32 count, FLOAT* newValues, BOOL hasFinished)
+    {
+        auto it = Instance.m_playlists.find((INT32)playlistID);
+        if (it == Instance.m_playlists.end())
+            return;
+
+        PlaylistData& data = it->second;
+        if (hasFinished)
+        {
+            Instance.FinishFade(data);
+            return;
+        }
+
+        // The progress comes from the engine clock, the fade job only drives the updates
+        UINT64 now = SaXAudio::Instance.GetEngineTime();
+        FLOAT progress = 0.0f;
+        if (now >= data.fadeStart)
+            progress = data.fadeLength > 0 ? min(1.0f, (FLOAT)(now - data.fadeStart) / data.fadeLength) : 1.0f;
+
+        // Equal power, the loudness stays constant through the crossfade
+        AudioVoice* current = SaXAudio::Instance.GetVoice(data.currentVoice);
+        if (current)
+            current->SetVolume(sinf(progress * HALF_PI));
+
+        AudioVoice* fading = SaXAudio::Instance.GetVoice(data.fadingVoice);
+        if (fading)
+            fading->SetVolume(data.fadingLevel * cosf(progress * HALF_PI));
+    }
+}
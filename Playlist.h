@@ -0,0 +1,114 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+    // Where a transition lands on the beat grid of the current track
+    enum Quantize : UINT32
+    {
+        QUANTIZE_NONE = 0,  // As soon as possible
+        QUANTIZE_BEAT = 1,  // Next beat
+        QUANTIZE_BAR = 2    // Next bar
+    };
+
+    struct Track
+    {
+        INT32 bankID = 0;
+        BOOL looping = false;
+    };
+
+    struct PlaylistData
+    {
+        INT32 busID = 0;
+
+        // The beat grid starts when the current track started
+        FLOAT bpm = 120.0f;
+        UINT32 beatsPerBar = 4;
+
+        deque<Track> tracks;
+
+        INT32 currentVoice = 0;
+        UINT64 currentStart = 0;
+
+        // The next track is created and scheduled to start the sample the current one ends
+        INT32 nextVoice = 0;
+        UINT64 nextStart = 0;
+
+        // Crossfade from fadingVoice to currentVoice, both volumes come from a single fade job
+        INT32 fadingVoice = 0;
+        UINT64 fadingStart = 0;
+        FLOAT fadingLevel = 1.0f;   // Volume of fadingVoice when the crossfade began
+        UINT32 fadeID = 0;
+        UINT64 fadeStart = 0;
+        UINT64 fadeLength = 0;
+    };
+
+    // Playlists own their voices, everything happens with the control lock held
+    class PlaylistManager
+    {
+    private:
+        PlaylistManager() = default;
+
+        unordered_map<INT32, PlaylistData> m_playlists;
+        INT32 m_playlistCounter = 1;
+
+        static PlaylistManager& getInstance()
+        {
+            static PlaylistManager instance;
+            return instance;
+        }
+        PlaylistManager(const PlaylistManager&) = delete;
+        PlaylistManager& operator=(const PlaylistManager&) = delete;
+
+    public:
+        static PlaylistManager& Instance;
+
+        INT32 Create(const INT32 busID);
+        void Remove(const INT32 playlistID);
+        void Clear();
+
+        BOOL SetTempo(const INT32 playlistID, const FLOAT bpm, const UINT32 beatsPerBar);
+        BOOL Queue(const INT32 playlistID, const INT32 bankID, const BOOL looping);
+        BOOL Play(const INT32 playlistID);
+        BOOL Transition(const INT32 playlistID, const INT32 bankID, const BOOL looping, const FLOAT fade, const Quantize quantize);
+        void Stop(const INT32 playlistID, const FLOAT fade);
+        INT32 GetCurrentVoice(const INT32 playlistID);
+
+        // Moves to the next track once it started, called by the control thread
+        void Update();
+
+    private:
+        INT32 StartTrack(PlaylistData& data, const Track& track, const UINT64 engineTime);
+        void StopTrack(const INT32 voiceID, const FLOAT fade);
+        void PrepareNext(PlaylistData& data);
+        void CancelNext(PlaylistData& data);
+        void FinishFade(PlaylistData& data);
+        void InterruptFade(PlaylistData& data, const FLOAT fade);
+
+        static void OnFadeTransition(INT64 playlistID, UINT32 count, FLOAT* newValues, BOOL hasFinished);
+    };
+}
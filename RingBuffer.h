@@ -0,0 +1,126 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+    // Bounded lock-free queue, each cell sequence tells if it is ready to be written or read
+    // Any number of threads can push and pop
+    template<typename T, UINT32 CAPACITY>
+    class RingBuffer
+    {
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of 2");
+
+    private:
+        struct Cell
+        {
+            atomic<UINT32> sequence;
+            T value;
+        };
+        Cell m_cells[CAPACITY];
+        atomic<UINT32> m_enqueuePos;
+        atomic<UINT32> m_dequeuePos;
+
+    public:
+        RingBuffer()
+        {
+            for (UINT32 i = 0; i < CAPACITY; i++)
+                m_cells[i].sequence = i;
+            m_enqueuePos = 0;
+            m_dequeuePos = 0;
+        }
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        /// <summary>
+        /// Add a value at the end of the queue
+        /// </summary>
+        /// <returns>false if the queue is full</returns>
+        BOOL Push(const T& value)
+        {
+            UINT32 pos = m_enqueuePos.load(memory_order_relaxed);
+            Cell* cell;
+            while (true)
+            {
+                cell = &m_cells[pos & (CAPACITY - 1)];
+                UINT32 sequence = cell->sequence.load(memory_order_acquire);
+                INT32 diff = (INT32)(sequence - pos);
+                if (diff == 0)
+                {
+                    // The cell is free, try to claim it
+                    if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false; // Full
+                }
+                else
+                {
+                    pos = m_enqueuePos.load(memory_order_relaxed);
+                }
+            }
+
+            cell->value = value;
+            cell->sequence.store(pos + 1, memory_order_release);
+            return true;
+        }
+
+        /// <summary>
+        /// Take the value at the front of the queue
+        /// </summary>
+        /// <returns>false if the queue is empty</returns>
+        BOOL Pop(T& value)
+        {
+            UINT32 pos = m_dequeuePos.load(memory_order_relaxed);
+            Cell* cell;
+            while (true)
+            {
+                cell = &m_cells[pos & (CAPACITY - 1)];
+                UINT32 sequence = cell->sequence.load(memory_order_acquire);
+                INT32 diff = (INT32)(sequence - (pos + 1));
+                if (diff == 0)
+                {
+                    if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false; // Empty
+                }
+                else
+                {
+                    // Another consumer got it first
+                    pos = m_dequeuePos.load(memory_order_relaxed);
+                }
+            }
+
+            value = cell->value;
+            cell->sequence.store(pos + CAPACITY, memory_order_release);
+            return true;
+        }
+    };
+}
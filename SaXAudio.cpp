@@ -22,6 +22,9 @@
 
 #include "SaXAudio.h"
 #include "Fader.h"
+#include "Playlist.h"
+#include "Dsp.h"
+#include "Effects.h"
 
 namespace SaXAudio
 {
@@ -29,18 +32,74 @@ namespace SaXAudio
 #define CHAIN_REVERB 0
 #define CHAIN_EQ 1
 #define CHAIN_ECHO 2
+#define CHAIN_CONVOLUTION 3
+#define CHAIN_COMPRESSOR 4
+#define CHAIN_LIMITER 5
+#define CHAIN_METER 6
+// Bit of EffectData::dirtyEffects for the voice filter, after the chain indices
+#define DIRTY_FILTER 7
+// Lowest filter cutoff in Hz, a high-pass this low lets everything through
+#define FILTER_MIN_CUTOFF 10.0f
+// Effect parameters committed per voice or bus each pass, each commit resets the state of the XAudio2 reverb
+#define MAX_EFFECT_COMMITS 1
 #define POOL_SIZE_VOICES 50
+#define STEAL_FADE 0.02f
 
     SaXAudio& SaXAudio::Instance = SaXAudio::getInstance();
 
-    BOOL SaXAudio::Init()
+    inline void LinkVoice(VoiceList& list, AudioVoice* voice, VoiceLink AudioVoice::* link)
+    {
+        VoiceLink& node = voice->*link;
+        node.list = &list;
+        node.prev = list.tail;
+        node.next = nullptr;
+
+        if (list.tail)
+            (list.tail->*link).next = voice;
+        else
+            list.head = voice;
+        list.tail = voice;
+        list.count++;
+    }
+
+    inline void UnlinkVoice(AudioVoice* voice, VoiceLink AudioVoice::* link)
+    {
+        VoiceLink& node = voice->*link;
+        if (!node.list) return;
+
+        if (node.prev)
+            (node.prev->*link).next = node.next;
+        else
+            node.list->head = node.next;
+
+        if (node.next)
+            (node.next->*link).prev = node.prev;
+        else
+            node.list->tail = node.prev;
+
+        node.list->count--;
+        node = VoiceLink();
+    }
+
+    BOOL SaXAudio::Init(const BOOL software, const UINT32 channels, const UINT32 sampleRate, const BOOL offline)
     {
         if (m_XAudio)
             return true;
 
         StartLogging();
 
-        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        HRESULT hr = S_OK;
+        if (software)
+        {
+            // No device and no COM, the rest of the engine sees the same interfaces
+            m_mixer = new SoftwareMixer();
+            m_XAudio = m_mixer;
+        }
+        else
+        {
+            hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        }
+
         switch (hr)
         {
         case S_OK:
@@ -58,22 +117,26 @@ namespace SaXAudio
         }
 
         // Create XAudio2 instance
-        hr = XAudio2Create(&m_XAudio, 0, XAUDIO2_DEFAULT_PROCESSOR);
-        if (FAILED(hr))
+        if (!m_mixer)
         {
-            Log(0, 0, "[Init] XAudio2 creation failed", hr);
-            m_XAudio = nullptr;
-            return false;
+            hr = XAudio2Create(&m_XAudio, 0, XAUDIO2_DEFAULT_PROCESSOR);
+            if (FAILED(hr))
+            {
+                Log(0, 0, "[Init] XAudio2 creation failed", hr);
+                m_XAudio = nullptr;
+                return false;
+            }
         }
 
         // Create mastering voice
         IXAudio2MasteringVoice* masteringVoice;
-        hr = m_XAudio->CreateMasteringVoice(&masteringVoice, 0, 48000);
+        hr = m_XAudio->CreateMasteringVoice(&masteringVoice, channels, sampleRate);
         if (FAILED(hr))
         {
             Log(0, 0, "[Init] Mastering voice creation failed", hr);
             m_XAudio->Release();
             m_XAudio = nullptr;
+            m_mixer = nullptr;
             return false;
         }
 
@@ -86,13 +149,18 @@ namespace SaXAudio
             Log(0, 0, "[Init] Couldn't get channel mask", hr);
             m_XAudio->Release();
             m_XAudio = nullptr;
+            m_mixer = nullptr;
             return false;
         }
 
         string version = "Unknown";
         // Check which DLL is loaded
-        HMODULE hXAudio2 = GetModuleHandle(L"XAudio2_9.dll");
-        if (hXAudio2)
+        HMODULE hXAudio2 = m_mixer ? nullptr : GetModuleHandle(L"XAudio2_9.dll");
+        if (m_mixer)
+        {
+            version = "Software mixer";
+        }
+        else if (hXAudio2)
         {
             version = "XAudio2 2.9";
         }
@@ -115,6 +183,35 @@ namespace SaXAudio
 
         // Get details
         masteringVoice->GetVoiceDetails(&m_masterDetails);
+        m_speakerLayout.Init(m_channelMask, m_masterDetails.InputChannels);
+
+        // The mastering voice gets the same effect chain as the buses, created when first needed
+        for (XAUDIO2_EFFECT_DESCRIPTOR& descriptor : m_masteringBus.descriptors)
+            descriptor = { nullptr, false, m_masterDetails.InputChannels };
+
+        // XAudio processes 10ms per pass
+        m_engineClock.Samples = 0;
+        m_engineClock.QuantumSamples = m_masterDetails.InputSampleRate / 100;
+        m_XAudio->RegisterForCallbacks(&m_engineClock);
+        m_silence.assign(SILENCE_LENGTH, 0.0f);
+
+        // Callbacks might have been set before a previous Release
+        EventQueue::Instance.StartDispatcher();
+
+        // Offline time only moves when Render is called
+        m_offline = m_mixer && offline;
+        m_offlineOffset = 0;
+        m_renderStats = { 0 };
+        m_renderTotal = 0;
+        if (!m_offline)
+        {
+            m_controlRunning = true;
+            m_controlThread = thread(DoControl);
+        }
+        else
+        {
+            version += " (offline)";
+        }
         Log(0, 0, "[Init] Initialization complete. Version: " + version + " Channels: " + to_string(m_masterDetails.InputChannels) + " Sample rate: " + to_string(m_masterDetails.InputSampleRate));
 
         return true;
@@ -125,31 +222,243 @@ namespace SaXAudio
         if (!m_XAudio)
             return;
 
+        m_controlRunning = false;
+        m_controlWait.notify_all();
+        if (m_controlThread.joinable())
+            m_controlThread.join();
+        StopCapture();
+
+        // The convolution builds hand their engine to a bus, they must be done before the buses go
+        while (m_convolutionBuilds > 0)
+            this_thread::sleep_for(chrono::milliseconds(1));
+
+        // Nothing is playing anymore
+        m_snapshot.sequence++;
+        m_snapshot.count[0] = 0;
+        m_snapshot.count[1] = 0;
+        m_snapshot.sequence++;
+
+        m_meters.sequence++;
+        m_meters.count[0] = 0;
+        m_meters.count[1] = 0;
+        m_meters.sequence++;
+        static_cast<EffectData&>(m_masteringBus) = EffectData();
+
         m_XAudio->StopEngine();
+        m_XAudio->UnregisterForCallbacks(&m_engineClock);
         m_XAudio->Release();
         m_XAudio = nullptr;
+        m_mixer = nullptr;
+        m_offline = false;
+        m_scheduledStarts.clear();
+        m_pendingLoops.clear();
+        m_decodingWaits.clear();
+        m_groupOperationSet = 0;
+
+        // Commands left in the queues refer to the voices and slots of this engine
+        Command command;
+        while (m_commands.Pop(command)) {}
+        EffectCommand effect;
+        while (m_effectCommands.Pop(effect)) {}
+        {
+            lock_guard<mutex> lock(m_segmentMutex);
+            m_postedSegments.clear();
+        }
+        {
+            lock_guard<mutex> lock(m_responseMutex);
+            m_postedResponses.clear();
+        }
+        INT32 finishedID;
+        while (m_finishedVoices.Pop(finishedID)) {}
+        m_dirtyEffects.clear();
+
+        // The voice IDs start over with the next engine, a fade left running would move a new voice
+        Fader::Instance.Clear();
+        {
+            lock_guard<mutex> lock(m_echoMutex);
+            for (auto& it : m_echoPool)
+            {
+                for (IUnknown* echo : it.second)
+                    echo->Release();
+            }
+            m_echoPool.clear();
+        }
+        PlaylistManager::Instance.Clear();
+
+        EventQueue::Instance.StopDispatcher();
 
         while (!m_bank.empty())
         {
             RemoveBankEntry(m_bank.begin()->first);
         }
 
-        for (auto& it : m_bufferPool)
-            delete[] it.Data;
-        m_bufferPool.clear();
+        {
+            lock_guard<mutex> lock(m_bufferMutex);
+            for (auto& it : m_bufferPool)
+                delete[] it.Data;
+            m_bufferPool.clear();
+        }
 
-        while (!m_voicePool.empty())
         {
-            delete m_voicePool.front();
-            m_voicePool.pop();
+            lock_guard<mutex> lock(m_voiceMutex);
+            for (UINT32 i = 0; i < m_slotCount; i++)
+            {
+                delete m_voiceSlots[i].exchange(nullptr);
+            }
+            m_slotCount = 0;
+            m_voiceCount = 0;
+            m_realVoiceCount = 0;
+            m_freeSlots = queue<UINT32>();
+
+            m_masteringBus.voices.head = nullptr;
+            m_masteringBus.voices.tail = nullptr;
+            m_masteringBus.voices.count = 0;
         }
 
         StopLogging();
 
-        m_voices.clear();
         m_masteringBus.voice = nullptr;
     }
 
+    UINT32 SaXAudio::Render(FLOAT* buffer, const UINT32 frames)
+    {
+        // Not the control lock, the voice callbacks made by the mixer lock what they need
+        if (!m_mixer)
+            return 0;
+        lock_guard<mutex> lock(m_renderMutex);
+
+        const UINT32 channels = m_masterDetails.InputChannels;
+        if (!m_offline)
+        {
+            m_mixer->Render(buffer, frames);
+        }
+        else
+        {
+            // The tick runs right before each pass of the mixer, both advance by 10ms of samples
+            const UINT32 quantum = m_engineClock.QuantumSamples;
+            UINT32 written = 0;
+            while (written < frames)
+            {
+                const UINT32 count = min(frames - written, quantum - m_offlineOffset);
+                if (m_offlineOffset > 0)
+                {
+                    m_mixer->Render(buffer + written * channels, count);
+                }
+                else
+                {
+                    auto start = chrono::steady_clock::now();
+                    ControlTick(Fader::INTERVAL / 1000.0f);
+                    m_mixer->Render(buffer + written * channels, count);
+                    FLOAT cost = chrono::duration<FLOAT, milli>(chrono::steady_clock::now() - start).count();
+
+                    m_renderStats.quanta++;
+                    m_renderStats.lastCost = cost;
+                    m_renderStats.maxCost = max(m_renderStats.maxCost, cost);
+                    m_renderTotal += cost;
+                    m_renderStats.averageCost = (FLOAT)(m_renderTotal / m_renderStats.quanta);
+                }
+                written += count;
+                m_offlineOffset = (m_offlineOffset + count) % quantum;
+            }
+
+            // Voices that ended during the last pass are gone when Render returns and the positions are up to date
+            lock_guard<mutex> control(m_controlMutex);
+            RemoveFinishedVoices();
+            UpdateSnapshot();
+        }
+
+        if (m_capture.is_open())
+        {
+            m_capture.write(reinterpret_cast<const char*>(buffer), (streamsize)frames * channels * sizeof(FLOAT));
+            m_captureFrames += frames;
+        }
+        return frames;
+    }
+
+    UINT32 SaXAudio::Advance(const FLOAT seconds)
+    {
+        if (!m_mixer || seconds <= 0)
+            return 0;
+
+        // Rendered a pass at a time, only kept if captured
+        const UINT32 quantum = m_engineClock.QuantumSamples;
+        vector<FLOAT> buffer(quantum * m_masterDetails.InputChannels);
+        UINT32 frames = (UINT32)(seconds * m_masterDetails.InputSampleRate + 0.5f);
+        UINT32 rendered = 0;
+        while (rendered < frames)
+            rendered += Render(buffer.data(), min(quantum, frames - rendered));
+        return rendered;
+    }
+
+    BOOL SaXAudio::StartCapture(const char* filePath)
+    {
+        if (!m_mixer)
+            return false;
+        lock_guard<mutex> lock(m_renderMutex);
+
+        if (m_capture.is_open())
+            return false;
+
+        m_capture.open(filePath, ios::binary | ios::trunc);
+        if (!m_capture.is_open())
+        {
+            Log(0, 0, " ERROR | [StartCapture] Couldn't open " + string(filePath));
+            return false;
+        }
+
+        // The sizes are written once the capture stops
+        WavHeader header = { 0 };
+        m_capture.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+        m_captureFrames = 0;
+        Log(0, 0, "[StartCapture] " + string(filePath));
+        return true;
+    }
+
+    void SaXAudio::StopCapture()
+    {
+        lock_guard<mutex> lock(m_renderMutex);
+        if (!m_capture.is_open())
+            return;
+
+        const UINT16 channels = (UINT16)m_masterDetails.InputChannels;
+        const UINT32 dataSize = (UINT32)(m_captureFrames * channels * sizeof(FLOAT));
+
+        WavHeader header;
+        memcpy(header.riff, "RIFF", 4);
+        header.fileSize = sizeof(WavHeader) - 8 + dataSize;
+        memcpy(header.wave, "WAVE", 4);
+        memcpy(header.fmt, "fmt ", 4);
+        header.fmtSize = 16;
+        header.audioFormat = WAVE_FORMAT_IEEE_FLOAT;
+        header.channels = channels;
+        header.sampleRate = m_masterDetails.InputSampleRate;
+        header.blockAlign = channels * sizeof(FLOAT);
+        header.byteRate = header.sampleRate * header.blockAlign;
+        header.bitsPerSample = 32;
+        memcpy(header.data, "data", 4);
+        header.dataSize = dataSize;
+
+        m_capture.seekp(0);
+        m_capture.write(reinterpret_cast<const char*>(&header), sizeof(WavHeader));
+        m_capture.close();
+        Log(0, 0, "[StopCapture] frames: " + to_string(m_captureFrames));
+    }
+
+    BOOL SaXAudio::GetRenderStats(RenderStats* stats, const BOOL reset)
+    {
+        lock_guard<mutex> lock(m_renderMutex);
+        if (!m_offline)
+            return false;
+
+        *stats = m_renderStats;
+        if (reset)
+        {
+            m_renderStats = { 0 };
+            m_renderTotal = 0;
+        }
+        return true;
+    }
+
     void SaXAudio::StopEngine()
     {
         if (!m_XAudio)
@@ -174,10 +483,14 @@ namespace SaXAudio
             return;
         Log(0, 0, "[PauseAll]");
 
-        for (auto& it : m_voices)
+        vector<INT32> voiceIDs;
+        CollectVoiceIDs(busID, voiceIDs);
+
+        for (INT32 voiceID : voiceIDs)
         {
-            if (!it.second->IsProtected && (busID == 0 || it.second->BusID == busID))
-                it.second->Pause(fade);
+            AudioVoice* voice = GetVoice(voiceID);
+            if (voice && !voice->IsProtected)
+                voice->Pause(fade);
         }
     }
 
@@ -187,10 +500,14 @@ namespace SaXAudio
             return;
         Log(0, 0, "[ResumeAll]");
 
-        for (auto& it : m_voices)
+        vector<INT32> voiceIDs;
+        CollectVoiceIDs(busID, voiceIDs);
+
+        for (INT32 voiceID : voiceIDs)
         {
-            if (!it.second->IsProtected && (busID == 0 || it.second->BusID == busID))
-                it.second->Resume(fade);
+            AudioVoice* voice = GetVoice(voiceID);
+            if (voice && !voice->IsProtected)
+                voice->Resume(fade);
         }
     }
 
@@ -200,10 +517,14 @@ namespace SaXAudio
             return;
         Log(0, 0, "[StopAll]");
 
-        for (auto& it : m_voices)
+        vector<INT32> voiceIDs;
+        CollectVoiceIDs(busID, voiceIDs);
+
+        for (INT32 voiceID : voiceIDs)
         {
-            if (!it.second->IsProtected && (busID == 0 || it.second->BusID == busID))
-                it.second->Stop(fade);
+            AudioVoice* voice = GetVoice(voiceID);
+            if (voice && !voice->IsProtected)
+                voice->Stop(fade);
         }
     }
 
@@ -231,6 +552,7 @@ namespace SaXAudio
 
         Log(m_bankCounter, 0, "[AddBankEntry] entries: " + to_string(m_bank.size() + 1));
 
+        m_bank[m_bankCounter].bankID = m_bankCounter;
         m_bank[m_bankCounter].onDecodedCallback = callback;
         return m_bankCounter++;
     }
@@ -244,22 +566,16 @@ namespace SaXAudio
         data->autoRemove = true;
         data->disposed = true;
 
-        if (m_XAudio)
+        if (m_XAudio && data->voices.count > 0)
         {
             // Let voices finish before removing
-            for (auto& it : m_voices)
-            {
-                if (it.second->BankID == bankID)
-                {
-                    // We let autoRemove delete the bankID
-                    Log(bankID, 0, "[RemoveBankEntry] Waiting for voices to finish");
-                    return;
-                }
-            }
+            // We let autoRemove delete the bankID
+            Log(bankID, 0, "[RemoveBankEntry] Waiting for voices to finish");
+            return;
         }
 
         // Return buffer to the pool
-        m_bufferPool.push_back(data->buffer);
+        ReturnBuffer(data->buffer);
         Log(bankID, 0, "[RemoveBankEntry] Returned buffer size: " + to_string(data->buffer.Size / 1024) + "KB");
 
         // onDecodedCallback guarantied to be called
@@ -285,16 +601,128 @@ namespace SaXAudio
         data->autoRemove = true;
     }
 
-    INT32 SaXAudio::AddBus()
+    void SaXAudio::SetBankLimits(const INT32 bankID, const UINT32 maxInstances, const FLOAT cooldown, const StealPolicy policy)
+    {
+        if (!m_XAudio)
+            return;
+        lock_guard<mutex> lock(m_bankMutex);
+
+        BankData* data = GetEntry(data, m_bank, bankID);
+        if (!data) return;
+
+        Log(bankID, 0, "[SetBankLimits] max: " + to_string(maxInstances) + " cooldown: " + to_string(cooldown) + " policy: " + to_string(policy));
+
+        data->maxInstances = maxInstances;
+        data->cooldown = cooldown;
+        data->stealPolicy = policy;
+    }
+
+    void SaXAudio::SetLoudnessAnalysis(const BOOL enabled)
+    {
+        Log(0, 0, "[SetLoudnessAnalysis] " + to_string(enabled));
+        m_analyzeLoudness = enabled;
+    }
+
+    void SaXAudio::SetLoudnessTarget(const FLOAT target)
+    {
+        Log(0, 0, "[SetLoudnessTarget] " + to_string(target));
+        m_loudnessTarget = target;
+    }
+
+    BOOL SaXAudio::GetBankLoudness(const INT32 bankID, FLOAT* loudness, FLOAT* truePeak)
+    {
+        lock_guard<mutex> lock(m_bankMutex);
+
+        BankData* data = GetEntry(data, m_bank, bankID);
+        if (!data || !data->analyzed) return false;
+
+        if (loudness)
+            *loudness = data->loudness;
+        if (truePeak)
+            *truePeak = data->truePeak;
+        return true;
+    }
+
+    void SaXAudio::SetBankLoudness(const INT32 bankID, const FLOAT loudness, const FLOAT truePeak)
+    {
+        lock_guard<mutex> lock(m_bankMutex);
+
+        BankData* data = GetEntry(data, m_bank, bankID);
+        if (!data) return;
+
+        Log(bankID, 0, "[SetBankLoudness] loudness: " + to_string(loudness) + " true peak: " + to_string(truePeak));
+
+        // A bank still decoding stops being analyzed
+        data->analyzed = true;
+        data->loudness = loudness;
+        data->truePeak = truePeak;
+    }
+
+    UINT32 SaXAudio::GetRejectedCount(const INT32 bankID)
+    {
+        lock_guard<mutex> lock(m_bankMutex);
+
+        if (bankID == 0)
+        {
+            UINT32 count = 0;
+            for (auto& it : m_bank)
+                count += it.second.rejectedCount;
+            return count;
+        }
+
+        BankData* data = GetEntry(data, m_bank, bankID);
+        return data ? data->rejectedCount.load() : 0;
+    }
+
+    UINT32 SaXAudio::GetStolenCount(const INT32 bankID)
+    {
+        lock_guard<mutex> lock(m_bankMutex);
+
+        if (bankID == 0)
+        {
+            UINT32 count = 0;
+            for (auto& it : m_bank)
+                count += it.second.stolenCount;
+            return count;
+        }
+
+        BankData* data = GetEntry(data, m_bank, bankID);
+        return data ? data->stolenCount.load() : 0;
+    }
+
+    INT32 SaXAudio::AddBus(const INT32 parentID)
     {
         if (!m_XAudio)
             return 0;
         lock_guard<mutex> lock(m_busMutex);
 
-        Log(0, 0, "[AddBus]");
+        Log(0, 0, "[AddBus] parent: " + to_string(parentID));
+
+        UINT32 depth = 0;
+        IXAudio2Voice* output = m_masteringBus.voice;
+        if (parentID != 0)
+        {
+            BusData* parent = GetEntry(parent, m_buses, parentID);
+            if (!parent)
+            {
+                Log(0, 0, "[AddBus] Failed, parent bus not found: " + to_string(parentID));
+                return 0;
+            }
+            if (parent->depth + 1 >= MAX_BUS_DEPTH)
+            {
+                Log(0, 0, "[AddBus] Failed, too many levels of buses");
+                return 0;
+            }
+            depth = parent->depth + 1;
+            output = parent->voice;
+        }
+
+        // A submix voice can only output to a later processing stage, children are processed before their parent
+        XAUDIO2_SEND_DESCRIPTOR sendDesc { 0, output };
+        XAUDIO2_VOICE_SENDS sends { 1, &sendDesc };
 
         IXAudio2SubmixVoice* bus;
-        HRESULT hr = m_XAudio->CreateSubmixVoice(&bus, m_masterDetails.InputChannels, m_masterDetails.InputSampleRate);
+        HRESULT hr = m_XAudio->CreateSubmixVoice(&bus, m_masterDetails.InputChannels, m_masterDetails.InputSampleRate, XAUDIO2_VOICE_USEFILTER, MAX_BUS_DEPTH - depth, &sends);
         if (FAILED(hr))
         {
             Log(-1, -1, "Failed creating bus", hr);
@@ -303,10 +731,11 @@ namespace SaXAudio
 
         BusData* data = &m_buses[m_busCounter];
         data->voice = bus;
+        data->parentID = parentID;
+        data->depth = depth;
         data->effectChain = { 3, nullptr };
-        data->descriptors[0] = { nullptr, false, SaXAudio::m_masterDetails.InputChannels };
-        data->descriptors[1] = { nullptr, false, SaXAudio::m_masterDetails.InputChannels };
-        data->descriptors[2] = { nullptr, false, SaXAudio::m_masterDetails.InputChannels };
+        for (XAUDIO2_EFFECT_DESCRIPTOR& descriptor : data->descriptors)
+            descriptor = { nullptr, false, SaXAudio::m_masterDetails.InputChannels };
 
         return m_busCounter++;
     }
@@ -315,20 +744,79 @@ namespace SaXAudio
     {
         if (!m_XAudio)
             return;
-        lock_guard<mutex> lock(m_busMutex);
 
         Log(0, 0, "[RemoveBus] " + to_string(busID));
 
+        // The child buses output to this one, they go first
+        vector<INT32> children;
+        {
+            lock_guard<mutex> busLock(m_busMutex);
+            for (auto& it : m_buses)
+            {
+                if (it.second.parentID == busID)
+                    children.push_back(it.first);
+            }
+        }
+        for (INT32 childID : children)
+            RemoveBus(childID);
+
+        vector<INT32> voiceIDs;
+        {
+            lock_guard<mutex> busLock(m_busMutex);
+            lock_guard<mutex> voiceLock(m_voiceMutex);
+
+            BusData* bus = GetEntry(bus, m_buses, busID);
+            if (!bus) return;
+
+            // The voices are moved to the master list, they will finish stopping there
+            while (bus->voices.head)
+            {
+                AudioVoice* voice = bus->voices.head;
+                voiceIDs.push_back(voice->VoiceID);
+                UnlinkVoice(voice, &AudioVoice::BusLink);
+                LinkVoice(m_masteringBus.voices, voice, &AudioVoice::BusLink);
+                voice->BusID = 0;
+            }
+        }
+
+        for (INT32 voiceID : voiceIDs)
+        {
+            AudioVoice* voice = GetVoice(voiceID);
+            if (voice)
+                voice->Stop();
+        }
+
+        {
+            // Nothing can output to the bus voice once destroyed
+            lock_guard<mutex> voiceLock(m_voiceMutex);
+            for (UINT32 i = 0; i < m_slotCount; i++)
+            {
+                AudioVoice* voice = m_voiceSlots[i];
+                if (voice->VoiceID != 0 && voice->SendCount > 0)
+                    voice->SetSend(busID, 0);
+            }
+        }
+
+        lock_guard<mutex> lock(m_busMutex);
+
         BusData* bus = GetEntry(bus, m_buses, busID);
         if (!bus) return;
 
-        for (auto& it : m_voices)
+        // The compressors ducked by this bus go back to their own input
+        auto releaseSidechain = [busID](BusData& other)
         {
-            if (it.second->BusID == busID)
-                it.second->Stop();
-        }
+            if (other.sidechainBusID != busID) return;
+            other.compressorEffect->SetSidechain(nullptr);
+            other.sidechainBusID = 0;
+        };
+        releaseSidechain(m_masteringBus);
+        for (auto& it : m_buses)
+            releaseSidechain(it.second);
+        if (bus->compressorEffect)
+            bus->compressorEffect->SetSidechain(nullptr);
 
         bus->voice->DestroyVoice();
+        DetachEcho(nullptr, bus);
         m_buses.erase(busID);
     }
 
@@ -342,6 +830,11 @@ namespace SaXAudio
         return bus;
     }
 
+    BOOL SaXAudio::HasBus(const INT32 busID)
+    {
+        return busID == 0 ? m_XAudio != nullptr : GetBus(busID) != nullptr;
+    }
+
     static void OnFadeVolume(INT64 busID, UINT32 count, FLOAT* newValues, BOOL hasFinished)
     {
         BusData* bus = SaXAudio::Instance.GetBus((INT32)busID);
@@ -362,6 +855,9 @@ namespace SaXAudio
         Fader::Instance.StopFade(bus->fadeID);
         bus->fadeID = 0;
 
+        // Used to estimate how audible the voices on the bus are
+        bus->volume = volume;
+
         if (fade > 0)
         {
             FLOAT current = 1.0f;
@@ -396,6 +892,7 @@ namespace SaXAudio
         while (buffer.Size < length)
             buffer.Size <<= 1;
 
+        lock_guard<mutex> lock(m_bufferMutex);
         auto it = m_bufferPool.begin();
         auto end = m_bufferPool.end();
         auto candidate = end;
@@ -441,7 +938,7 @@ namespace SaXAudio
 
     void SaXAudio::ReturnBuffer(Buffer buffer)
     {
-        lock_guard<mutex> bankLock(SaXAudio::Instance.m_bankMutex);
+        lock_guard<mutex> lock(m_bufferMutex);
         m_bufferPool.push_back(buffer);
     }
 
@@ -450,6 +947,15 @@ namespace SaXAudio
         if (!m_XAudio)
             return 0;
 
+        // Analyzed before the bank is visible, no lock needed
+        LoudnessMeter meter;
+        BOOL analyze = m_analyzeLoudness;
+        if (analyze)
+        {
+            meter.Init(channels, sampleRate);
+            meter.Process(buffer.Data, totalSamples);
+        }
+
         lock_guard<mutex> bankLock(SaXAudio::Instance.m_bankMutex);
         Log(m_bankCounter, 0, "[AddBankData]");
 
@@ -460,6 +966,14 @@ namespace SaXAudio
         data->totalSamples = totalSamples;
         data->decodedSamples = data->totalSamples;
 
+        if (analyze)
+        {
+            data->analyzed = true;
+            data->loudness = meter.GetLoudness();
+            data->truePeak = meter.GetTruePeak();
+            Log(m_bankCounter, 0, "[AddBankData] loudness: " + to_string(data->loudness) + " true peak: " + to_string(data->truePeak));
+        }
+
         return m_bankCounter++;
     }
 
@@ -471,104 +985,251 @@ namespace SaXAudio
         if (!vorbis)
             return FALSE;
 
-        lock_guard<mutex> bankLock(m_bankMutex);
-        BankData* data = GetEntry(data, m_bank, bankID);
-        if (!data) return FALSE;
+        {
+            lock_guard<mutex> bankLock(m_bankMutex);
+            BankData* data = GetEntry(data, m_bank, bankID);
+            if (!data)
+            {
+                stb_vorbis_close(vorbis);
+                return FALSE;
+            }
+
+            data->Oggbuffer = buffer;
 
-        data->Oggbuffer = buffer;
+            // Get file info
+            stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+            data->channels = info.channels;
+            data->sampleRate = info.sample_rate;
 
-        // Get file info
-        stb_vorbis_info info = stb_vorbis_get_info(vorbis);
-        data->channels = info.channels;
-        data->sampleRate = info.sample_rate;
+            // Get total samples count and allocate the buffer
+            data->totalSamples = stb_vorbis_stream_length_in_samples(vorbis);
+            data->buffer = GetBuffer(data->totalSamples * data->channels);
+        }
 
-        // Get total samples count and allocate the buffer
-        data->totalSamples = stb_vorbis_stream_length_in_samples(vorbis);
-        data->buffer = GetBuffer(data->totalSamples * data->channels);
+        // Offline, the renderer can be faster than the decoder, the bank is complete before any voice plays it
+        if (m_offline)
+        {
+            DecodeOgg(bankID, vorbis);
+            return TRUE;
+        }
 
         thread decode(DecodeOgg, bankID, vorbis);
         decode.detach();
         return TRUE;
     }
 
-    AudioVoice* SaXAudio::CreateVoice(const INT32 bankID, const INT32 busID)
+    AudioVoice* SaXAudio::CreateVoice(const INT32 bankID, const INT32 busID, const INT32 reservedID)
     {
         if (!m_XAudio)
             return nullptr;
-        lock_guard<mutex> bankLock(m_bankMutex);
-        lock_guard<mutex> busLock(m_busMutex);
-        lock_guard<mutex> voiceLock(m_voiceMutex);
 
-        BankData* data = GetEntry(data, m_bank, bankID);
-        if (!data || data->disposed) return nullptr;
+        INT32 stealID = 0;
+        AudioVoice* voice = AllocateVoice(bankID, busID, reservedID, stealID);
 
-        // Set up audio format
-        WAVEFORMATEX wfx = { 0 };
-        wfx.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;  // 32-bit float format
-        wfx.nChannels = static_cast<WORD>(data->channels);
-        wfx.nSamplesPerSec = static_cast<DWORD>(data->sampleRate);
-        wfx.wBitsPerSample = 32;  // 32-bit float
-        wfx.nBlockAlign = wfx.nChannels * wfx.wBitsPerSample / 8;
-        wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
-        wfx.cbSize = 0;
+        // Stopped outside of the locks, stopping a virtual voice removes it right away
+        AudioVoice* stolen = voice ? GetVoice(stealID) : nullptr;
+        if (stolen && !stolen->Stop(STEAL_FADE))
+            RemoveVoice(stealID);
 
-        // Populate the pool if empty
-        if (m_voicePool.empty())
+        return voice;
+    }
+
+    BOOL SaXAudio::CheckBankLimits(BankData* data, INT32& stealID)
+    {
+        auto now = Now();
+        if (data->cooldown > 0 && data->hasCreated && chrono::duration<FLOAT>(now - data->lastCreated).count() < data->cooldown)
         {
-            for (UINT32 i = 0; i < POOL_SIZE_VOICES; i++)
-                m_voicePool.push(new AudioVoice);
+            data->rejectedCount++;
+            Log(data->bankID, 0, "[CreateVoice] Rejected, retriggered too soon");
+            return false;
         }
 
-        // Get an unused voice
-        AudioVoice* voice = m_voicePool.front();
-        m_voicePool.pop();
+        if (data->maxInstances > 0 && data->voices.count >= data->maxInstances)
+        {
+            // Voices already stopping don't count, they are on their way out
+            UINT32 count = 0;
+            AudioVoice* victim = nullptr;
+            for (AudioVoice* voice = data->voices.head; voice; voice = voice->BankLink.next)
+            {
+                if (voice->IsStopping) continue;
+                count++;
 
-        BusData* bus = GetEntry(bus, m_buses, busID);
+                if (voice->IsProtected) continue;
+                if (!victim
+                    || (data->stealPolicy == STEAL_QUIETEST && voice->Volume < victim->Volume))
+                {
+                    victim = voice;
+                }
+            }
 
-        voice->EffectData.effectChain = { 3, voice->EffectData.descriptors };
-        voice->EffectData.descriptors[0] = { nullptr, false, data->channels };
-        voice->EffectData.descriptors[1] = { nullptr, false, data->channels };
-        voice->EffectData.descriptors[2] = { nullptr, false, data->channels };
+            if (count >= data->maxInstances)
+            {
+                if (data->stealPolicy == STEAL_REJECT || !victim)
+                {
+                    data->rejectedCount++;
+                    Log(data->bankID, 0, "[CreateVoice] Rejected, " + to_string(count) + " instances playing");
+                    return false;
+                }
 
-        HRESULT hr = XAudio2CreateReverb(&voice->EffectData.descriptors[CHAIN_REVERB].pEffect);
-        if (FAILED(hr))
-        {
-            Log(bankID, m_voiceCounter, "Failed to create reverb effect", hr);
+                stealID = victim->VoiceID;
+            }
         }
+        return true;
+    }
 
-        hr = CreateFX(__uuidof(FXEQ), &voice->EffectData.descriptors[CHAIN_EQ].pEffect);
-        if (FAILED(hr))
-        {
-            Log(bankID, m_voiceCounter, "Failed to create EQ effect", hr);
+    INT32 SaXAudio::ReserveVoice(const INT32 bankID)
+    {
+        if (!m_XAudio)
+            return 0;
+
+        {
+            lock_guard<mutex> bankLock(m_bankMutex);
+            BankData* data = GetEntry(data, m_bank, bankID);
+            if (!data || data->disposed) return 0;
         }
 
-        FXECHO_INITDATA init = { 3000 };
-        hr = CreateFX(__uuidof(FXEcho), &voice->EffectData.descriptors[CHAIN_ECHO].pEffect, &init, sizeof(FXECHO_INITDATA));
-        if (FAILED(hr))
+        lock_guard<mutex> voiceLock(m_voiceMutex);
+        INT32 voiceID = TakeVoiceSlot(bankID);
+        if (voiceID != 0)
+            m_voiceSlots[voiceID & VOICE_INDEX_MASK].load()->ReservedID = voiceID;
+        return voiceID;
+    }
+
+    BOOL SaXAudio::IsReserved(const INT32 voiceID)
+    {
+        if (!m_XAudio || voiceID <= 0)
+            return false;
+
+        // Same as GetVoice, the slot is never emptied
+        UINT32 index = voiceID & VOICE_INDEX_MASK;
+        if (index >= m_slotCount)
+            return false;
+
+        AudioVoice* voice = m_voiceSlots[index];
+        return voice && voice->ReservedID == voiceID;
+    }
+
+    INT32 SaXAudio::TakeVoiceSlot(const INT32 bankID)
+    {
+        // Called with the voice lock held
+        // Get an unused slot, new slots are used until enough voices are waiting to be reused
+        UINT32 index = 0;
+        if (m_freeSlots.size() < POOL_SIZE_VOICES && m_slotCount < MAX_VOICES)
+        {
+            index = m_slotCount;
+            m_voiceSlots[index] = new AudioVoice;
+            m_slotCount++;
+        }
+        else if (!m_freeSlots.empty())
+        {
+            index = m_freeSlots.front();
+            m_freeSlots.pop();
+        }
+        else
         {
-            Log(bankID, m_voiceCounter, "Failed to create echo effect", hr);
+            Log(bankID, 0, "[CreateVoice] Failed, no voice slot available", E_FAIL);
+            return 0;
         }
 
-        if (bus && bus->voice)
+        AudioVoice* voice = m_voiceSlots[index];
+        voice->Generation = (voice->Generation % VOICE_GENERATION_MAX) + 1;
+        return (INT32)((voice->Generation << VOICE_INDEX_BITS) | index);
+    }
+
+    AudioVoice* SaXAudio::AllocateVoice(const INT32 bankID, const INT32 busID, const INT32 reservedID, INT32& stealID)
+    {
+        lock_guard<mutex> bankLock(m_bankMutex);
+        lock_guard<mutex> busLock(m_busMutex);
+        lock_guard<mutex> voiceLock(m_voiceMutex);
+
+        // A reservation from before Release doesn't match the slot anymore
+        AudioVoice* reserved = nullptr;
+        if (reservedID != 0)
         {
-            XAUDIO2_SEND_DESCRIPTOR sendDesc { 0, bus->voice };
-            XAUDIO2_VOICE_SENDS sends { 1, &sendDesc };
+            UINT32 index = reservedID & VOICE_INDEX_MASK;
+            reserved = index < m_slotCount ? m_voiceSlots[index].load() : nullptr;
+            if (!reserved || reserved->ReservedID != reservedID)
+                return nullptr;
+        }
 
-            hr = m_XAudio->CreateSourceVoice(&voice->SourceVoice, &wfx, 0, XAUDIO2_MAX_FREQ_RATIO, voice, &sends, &voice->EffectData.effectChain);
+        BankData* data = GetEntry(data, m_bank, bankID);
+        if (!data || data->disposed || !CheckBankLimits(data, stealID))
+        {
+            // The reserved slot goes back to the pool, the voiceID never becomes valid
+            if (reserved)
+            {
+                reserved->ReservedID = 0;
+                m_freeSlots.push(reservedID & VOICE_INDEX_MASK);
+            }
+            return nullptr;
         }
-        else
+
+        const INT32 voiceID = reserved ? reservedID : TakeVoiceSlot(bankID);
+        if (voiceID == 0)
+            return nullptr;
+
+        const UINT32 index = voiceID & VOICE_INDEX_MASK;
+        AudioVoice* voice = m_voiceSlots[index];
+
+        BusData* bus = GetEntry(bus, m_buses, busID);
+
+        voice->EffectData.effectChain = { 3, voice->EffectData.descriptors };
+        voice->EffectData.dirtyEffects = 0;
+        voice->EffectData.descriptors[0] = { nullptr, false, data->channels };
+        voice->EffectData.descriptors[1] = { nullptr, false, data->channels };
+        voice->EffectData.descriptors[2] = { nullptr, false, data->channels };
+
+        HRESULT hr = XAudio2CreateReverb(&voice->EffectData.descriptors[CHAIN_REVERB].pEffect);
+        if (FAILED(hr))
         {
-            hr = m_XAudio->CreateSourceVoice(&voice->SourceVoice, &wfx, 0, XAUDIO2_MAX_FREQ_RATIO, voice, nullptr, &voice->EffectData.effectChain);
+            Log(bankID, voiceID, "Failed to create reverb effect", hr);
         }
 
+        hr = CreateFX(__uuidof(FXEQ), &voice->EffectData.descriptors[CHAIN_EQ].pEffect);
         if (FAILED(hr))
         {
-            voice->Reset();
-            Log(bankID, m_voiceCounter, "Failed to create voice on bus " + to_string(busID), hr);
-            return nullptr;
+            Log(bankID, voiceID, "Failed to create EQ effect", hr);
         }
+
+        // The echo is only taken from the pool when used, see AttachEcho
+        if (!voice->EffectData.echoPlaceholder)
+            voice->EffectData.echoPlaceholder = static_cast<IXAPO*>(new EmptyEffect());
+        voice->EffectData.descriptors[CHAIN_ECHO].pEffect = voice->EffectData.echoPlaceholder;
+        voice->EffectData.echoEffect = nullptr;
+        voice->EffectData.echoMaxDelay = 0;
+        voice->EffectData.filterCutoff = 0;
+        voice->EffectData.filterFadeID = 0;
+
         voice->BankData = data;
 
+        // Normalized to the loudness target, the gain never pushes the true peak above 0dBTP
+        FLOAT target = m_loudnessTarget;
+        if (target != 0 && data->analyzed && data->loudness > LOUDNESS_SILENCE)
+        {
+            voice->Gain = powf(10.0f, (target - data->loudness) / 20.0f);
+            if (data->truePeak > 0)
+                voice->Gain = min(voice->Gain, 1.0f / data->truePeak);
+        }
+
+        // Over the limit, the voice starts virtual and the scheduler decides if it deserves a source voice
+        if (m_maxRealVoices > 0 && m_realVoiceCount >= m_maxRealVoices)
+        {
+            voice->IsVirtual = true;
+        }
+        else
+        {
+            hr = CreateSourceVoice(voice, bus);
+            if (FAILED(hr))
+            {
+                voice->Reset();
+                voice->ReservedID = 0;
+                m_freeSlots.push(index);
+                Log(bankID, voiceID, "Failed to create voice on bus " + to_string(busID), hr);
+                return nullptr;
+            }
+            m_realVoiceCount++;
+        }
+
         // Submit audio buffer
         voice->Buffer = { 0 };
         voice->Buffer.AudioBytes = static_cast<UINT32>(sizeof(float) * data->totalSamples * data->channels);
@@ -576,32 +1237,65 @@ namespace SaXAudio
         voice->Buffer.Flags = XAUDIO2_END_OF_STREAM;
 
         voice->BankID = bankID;
-        voice->VoiceID = m_voiceCounter++;
         voice->BusID = bus ? busID : 0;
 
         // Set up the output matrix
         voice->SetOutputMatrix(0.0f);
 
-        m_voices[voice->VoiceID] = voice;
+        // Publishing the ID makes the voice visible to GetVoice
+        voice->VoiceID = voiceID;
+        voice->ReservedID = 0;
+        m_voiceCount++;
+
+        LinkVoice(bus ? bus->voices : m_masteringBus.voices, voice, &AudioVoice::BusLink);
+        LinkVoice(data->voices, voice, &AudioVoice::BankLink);
 
-        Log(bankID, voice->VoiceID, "[CreateVoice]" + (bus ? " Created on bus " + to_string(busID) : ""));
+        // Only a voice actually created starts the cooldown and steals
+        data->lastCreated = Now();
+        data->hasCreated = true;
+        if (stealID != 0)
+        {
+            data->stolenCount++;
+            Log(bankID, stealID, "[CreateVoice] Stealing voice");
+        }
+
+        Log(bankID, voice->VoiceID, "[CreateVoice]" + (bus ? " Created on bus " + to_string(busID) : "") + (voice->IsVirtual ? " Virtual" : ""));
 
         return voice;
     }
 
     AudioVoice* SaXAudio::GetVoice(const INT32 voiceID)
     {
-        if (!m_XAudio)
+        if (!m_XAudio || voiceID <= 0)
             return nullptr;
-        lock_guard<mutex> lock(m_voiceMutex);
 
-        AudioVoice* voice = nullptr;
-        auto it_voice = m_voices.find(voiceID);
-        if (it_voice != m_voices.end())
-            voice = it_voice->second;
+        // No lock needed, slots are never emptied and the voiceID only matches while the voice is alive
+        UINT32 index = voiceID & VOICE_INDEX_MASK;
+        if (index >= m_slotCount)
+            return nullptr;
+
+        AudioVoice* voice = m_voiceSlots[index];
+        if (!voice || voice->VoiceID != voiceID)
+            return nullptr;
         return voice;
     }
 
+    VoicePin SaXAudio::PinVoice(const INT32 voiceID)
+    {
+        AudioVoice* voice = GetVoice(voiceID);
+        if (!voice)
+            return VoicePin();
+
+        // RemoveVoice clears the voiceID before waiting for the pins, so check it again once pinned
+        voice->Pins++;
+        if (voice->VoiceID != voiceID)
+        {
+            voice->Pins--;
+            return VoicePin();
+        }
+        return VoicePin(voice);
+    }
+
     inline void GetEffectData(INT32 voiceID, BOOL isBus, IXAudio2Voice** sourceVoice, EffectData** data)
     {
         if (isBus)
@@ -615,8 +1309,9 @@ namespace SaXAudio
         else
         {
             AudioVoice* voice = SaXAudio::Instance.GetVoice(voiceID);
-            if (!voice || !voice->SourceVoice) return;
+            if (!voice || (!voice->SourceVoice && !voice->IsVirtual)) return;
 
+            // A virtual voice only gets its data, there is no source voice to apply it to
             *data = &voice->EffectData;
             *sourceVoice = voice->SourceVoice;
         }
@@ -630,7 +1325,15 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
+
+        if (!voice)
+        {
+            // Virtual voice, restored when it gets a source voice again
+            data->reverb = *params;
+            data->descriptors[CHAIN_REVERB].InitialState = true;
+            return;
+        }
 
         if (!data->effectChain.pEffectDescriptors)
         {
@@ -642,6 +1345,7 @@ namespace SaXAudio
         {
             Log(0, 0, "Failed to enable reverb", hr);
         }
+        data->descriptors[CHAIN_REVERB].InitialState = true;
 
         if (fade <= 0)
         {
@@ -757,11 +1461,13 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
-        if (fade <= 0)
+        if (fade <= 0 || !voice)
         {
-            voice->DisableEffect(CHAIN_REVERB);
+            data->descriptors[CHAIN_REVERB].InitialState = false;
+            if (voice)
+                voice->DisableEffect(CHAIN_REVERB);
             return;
         }
 
@@ -831,7 +1537,15 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
+
+        if (!voice)
+        {
+            // Virtual voice, restored when it gets a source voice again
+            data->eq = *params;
+            data->descriptors[CHAIN_EQ].InitialState = true;
+            return;
+        }
 
         if (!data->effectChain.pEffectDescriptors)
         {
@@ -843,6 +1557,7 @@ namespace SaXAudio
         {
             Log(0, 0, "Failed to enable EQ", hr);
         }
+        data->descriptors[CHAIN_EQ].InitialState = true;
 
         if (fade <= 0)
         {
@@ -899,11 +1614,13 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
-        if (fade <= 0)
+        if (fade <= 0 || !voice)
         {
-            voice->DisableEffect(CHAIN_EQ);
+            data->descriptors[CHAIN_EQ].InitialState = false;
+            if (voice)
+                voice->DisableEffect(CHAIN_EQ);
             return;
         }
 
@@ -952,18 +1669,42 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
+
+        // The echo can't delay more than the max delay it was created with
+        FXECHO_PARAMETERS echo = *params;
+        echo.Delay = min(echo.Delay, data->echoMaxDelay > 0 ? data->echoMaxDelay : (FLOAT)ECHO_MAX_DELAY);
+        params = &echo;
+
+        if (!voice)
+        {
+            // Virtual voice, restored when it gets a source voice again
+            data->echo = *params;
+            data->descriptors[CHAIN_ECHO].InitialState = true;
+            return;
+        }
 
         if (!data->effectChain.pEffectDescriptors)
         {
             CreateEffectChain(voice, data);
         }
 
+        // Fading in from silence, with the target feedback and delay
+        if (data->echo.WetDryMix == 0)
+        {
+            data->echo.Feedback = params->Feedback;
+            data->echo.Delay = params->Delay;
+        }
+
+        if (!AttachEcho(voice, data))
+            return;
+
         HRESULT hr = voice->EnableEffect(CHAIN_ECHO);
         if (FAILED(hr))
         {
             Log(0, 0, "Failed to enable echo", hr);
         }
+        data->descriptors[CHAIN_ECHO].InitialState = true;
 
         if (fade <= 0)
         {
@@ -1004,7 +1745,7 @@ namespace SaXAudio
         };
 
         INT64 context = isBus ? -voiceID : voiceID;
-        Fader::Instance.StartFadeMulti(12, current, targets, fade, OnFadeEcho, context);
+        Fader::Instance.StartFadeMulti(3, current, targets, fade, OnFadeEcho, context);
     }
 
     void SaXAudio::RemoveEcho(const INT32 voiceID, const BOOL isBus, const FLOAT fade)
@@ -1015,224 +1756,1609 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
-        if (fade <= 0)
+        if (fade <= 0 || !voice)
         {
-            voice->DisableEffect(CHAIN_ECHO);
+            data->descriptors[CHAIN_ECHO].InitialState = false;
+            if (voice)
+                voice->DisableEffect(CHAIN_ECHO);
+            DetachEcho(voice, data);
             return;
         }
 
-        FLOAT* current = new FLOAT[12]
+        FLOAT* current = new FLOAT[3]
         {
             data->echo.WetDryMix,
             data->echo.Feedback,
             data->echo.Delay
         };
 
-        FLOAT* targets = new FLOAT[12] { 0 };
+        FLOAT* targets = new FLOAT[3] { 0 };
 
         INT64 context = isBus ? -voiceID : voiceID;
         Fader::Instance.StartFadeMulti(3, current, targets, fade, OnFadeEchoDisable, context);
     }
 
-    UINT32 SaXAudio::GetVoiceCount(const INT32 bankID, const INT32 busID)
+    // Cutoff in Hz where the filter lets everything through, 0 for band-pass and notch which have none
+    inline FLOAT GetOpenCutoff(const XAUDIO2_FILTER_TYPE type, const UINT32 sampleRate)
     {
-        if (!m_XAudio)
+        switch (type)
+        {
+        case LowPassFilter:
+            // XAudio2 caps the frequency of the state variable filter at a sixth of the sample rate
+            return sampleRate / 6.0f;
+        case LowPassOnePoleFilter:
+            return sampleRate / 2.0f;
+        case HighPassFilter:
+        case HighPassOnePoleFilter:
+            return FILTER_MIN_CUTOFF;
+        default:
             return 0;
-        lock_guard<mutex> lock(m_voiceMutex);
+        }
+    }
 
-        UINT32 count = 0;
-        for (auto& it : m_voices)
+    void SaXAudio::SetFilter(const INT32 voiceID, const BOOL isBus, const XAUDIO2_FILTER_TYPE type, const FLOAT cutoff, const FLOAT q, const FLOAT fade)
+    {
+        if (!m_XAudio)
+            return;
+
+        IXAudio2Voice* voice = nullptr;
+        EffectData* data = nullptr;
+        GetEffectData(voiceID, isBus, &voice, &data);
+        if (!data) return;
+
+        Fader::Instance.StopFade(data->filterFadeID);
+        data->filterFadeID = 0;
+
+        const FLOAT targetCutoff = max(cutoff, FILTER_MIN_CUTOFF);
+        const FLOAT targetQ = max(q, 1.0f / XAUDIO2_MAX_FILTER_ONEOVERQ);
+        const FLOAT open = GetOpenCutoff(type, m_masterDetails.InputSampleRate);
+
+        // The type can't fade, a new type is applied at once unless it starts from open
+        BOOL isActive = data->filterCutoff > 0;
+        if (fade <= 0 || !voice || (isActive && data->filterType != type) || (!isActive && open <= 0))
         {
-            if (bankID > 0 && it.second->BankID != bankID)
-                continue;
-            if (busID > 0 && it.second->BusID != busID)
-                continue;
-            if (!it.second->SourceVoice)
-                count++;
+            data->filterType = type;
+            data->filterCutoff = targetCutoff;
+            data->filterQ = targetQ;
+            data->dirtyEffects &= ~(1u << DIRTY_FILTER);
+            if (voice)
+                CommitFilter(voice, data);
+            return;
         }
-        return count;
+
+        if (!isActive)
+        {
+            data->filterType = type;
+            data->filterCutoff = open;
+            data->filterQ = targetQ;
+        }
+
+        // The cutoff fades in octaves, evenly to the ear
+        FLOAT* current = new FLOAT[2] { log2f(data->filterCutoff), data->filterQ };
+        FLOAT* targets = new FLOAT[2] { log2f(targetCutoff), targetQ };
+
+        INT64 context = isBus ? -voiceID : voiceID;
+        data->filterFadeID = Fader::Instance.StartFadeMulti(2, current, targets, fade, OnFadeFilter, context);
     }
 
-    UINT32 SaXAudio::GetBankCount()
+    void SaXAudio::RemoveFilter(const INT32 voiceID, const BOOL isBus, const FLOAT fade)
     {
         if (!m_XAudio)
-            return 0;
-        lock_guard<mutex> lock(m_bankMutex);
+            return;
 
-        UINT32 count = 0;
-        for (auto& it : m_bank)
+        IXAudio2Voice* voice = nullptr;
+        EffectData* data = nullptr;
+        GetEffectData(voiceID, isBus, &voice, &data);
+        if (!data) return;
+
+        Fader::Instance.StopFade(data->filterFadeID);
+        data->filterFadeID = 0;
+        if (data->filterCutoff <= 0) return;
+
+        const FLOAT open = GetOpenCutoff(data->filterType, m_masterDetails.InputSampleRate);
+        if (fade <= 0 || !voice || open <= 0)
         {
-            if (!it.second.disposed)
-                count++;
+            data->filterCutoff = 0;
+            data->dirtyEffects &= ~(1u << DIRTY_FILTER);
+            if (voice)
+                CommitFilter(voice, data);
+            return;
         }
 
-        return count;
+        FLOAT* current = new FLOAT[2] { log2f(data->filterCutoff), data->filterQ };
+        FLOAT* targets = new FLOAT[2] { log2f(open), data->filterQ };
+
+        INT64 context = isBus ? -voiceID : voiceID;
+        data->filterFadeID = Fader::Instance.StartFadeMulti(2, current, targets, fade, OnFadeFilterDisable, context);
     }
 
-    void SaXAudio::DecodeOgg(const INT32 bankID, stb_vorbis* vorbis)
+    void SaXAudio::CommitFilter(IXAudio2Voice* voice, EffectData* data)
     {
-        // Reset file position
-        stb_vorbis_seek_start(vorbis);
+        // Voices are resampled before the filter, it runs at the rate of the buses
+        XAUDIO2_FILTER_PARAMETERS filter = { LowPassFilter, XAUDIO2_DEFAULT_FILTER_FREQUENCY, XAUDIO2_DEFAULT_FILTER_ONEOVERQ };
+        if (data->filterCutoff > 0)
+        {
+            const UINT32 sampleRate = m_masterDetails.InputSampleRate;
+            BOOL isOnePole = data->filterType == LowPassOnePoleFilter || data->filterType == HighPassOnePoleFilter;
+            filter.Type = data->filterType;
+            filter.Frequency = isOnePole
+                ? XAudio2CutoffFrequencyToOnePoleCoefficient(data->filterCutoff, sampleRate)
+                : XAudio2CutoffFrequencyToRadians(data->filterCutoff, sampleRate);
+            filter.OneOverQ = min(1.0f / data->filterQ, XAUDIO2_MAX_FILTER_ONEOVERQ);
+        }
 
-        UINT32 samplesTotal = 0;
-        UINT32 samplesDecoded = 0;
-        UINT32 bufferSize = 4096;
+        HRESULT hr = voice->SetFilterParameters(&filter, XAUDIO2_COMMIT_NOW);
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to set filter parameters", hr);
+        }
+    }
 
-        auto it = SaXAudio::Instance.m_bank.find(bankID);
-        if (it != SaXAudio::Instance.m_bank.end())
+    void SaXAudio::SetEchoMaxDelay(const INT32 voiceID, const BOOL isBus, const FLOAT maxDelay)
+    {
+        if (!m_XAudio)
+            return;
+
+        IXAudio2Voice* voice = nullptr;
+        EffectData* data = nullptr;
+        GetEffectData(voiceID, isBus, &voice, &data);
+        if (!data) return;
+
+        // Used the next time an echo is attached, the current one keeps its delay line
+        data->echoMaxDelay = maxDelay > 0 ? max(FXECHO_MIN_DELAY, min(maxDelay, (FLOAT)ECHO_MAX_DELAY)) : 0;
+    }
+
+    UINT32 SaXAudio::PostImpulseResponse(const INT32 bankID)
+    {
+        if (!m_XAudio)
+            return 0;
+
+        ImpulseResponse response;
         {
-            BankData* data = &it->second;
-            if (data)
+            lock_guard<mutex> lock(m_bankMutex);
+
+            BankData* bank = GetEntry(bank, m_bank, bankID);
+            if (!bank || bank->disposed || bank->totalSamples == 0 || bank->decodedSamples < bank->totalSamples)
             {
-                data->decodedSamples = 0;
-                samplesTotal = data->totalSamples;
+                Log(bankID, 0, "[SetConvolutionReverb] Failed, the bank is missing or not decoded yet");
+                return 0;
             }
+
+            response.channels = bank->channels;
+            response.sampleRate = bank->sampleRate;
+            response.samples.assign(bank->buffer.Data, bank->buffer.Data + (size_t)bank->totalSamples * bank->channels);
         }
 
-        while (samplesTotal - samplesDecoded > 0)
+        lock_guard<mutex> lock(m_responseMutex);
+        UINT32 ticket = ++m_responseTicket;
+        m_postedResponses[ticket] = move(response);
+        return ticket;
+    }
+
+    BOOL SaXAudio::SetConvolutionReverb(const INT32 busID, const INT32 bankID, const UINT32 ticket, const FLOAT wetDryMix)
+    {
+        // Called with the control lock held
+        ImpulseResponse response;
         {
-            if (bufferSize > samplesTotal)
-                bufferSize = samplesTotal;
+            lock_guard<mutex> lock(m_responseMutex);
+            auto it = m_postedResponses.find(ticket);
+            if (it != m_postedResponses.end())
+            {
+                response = move(it->second);
+                m_postedResponses.erase(it);
+            }
+        }
 
-            lock_guard<mutex> lock(SaXAudio::Instance.m_bankMutex);
+        if (!m_XAudio || response.channels == 0)
+            return false;
 
-            BankData* data = nullptr;
-            it = SaXAudio::Instance.m_bank.find(bankID);
-            if (it != SaXAudio::Instance.m_bank.end())
-                data = &it->second;
+        BusData* bus = GetBus(busID);
+        if (!bus || !bus->voice)
+        {
+            Log(bankID, 0, "[SetConvolutionReverb] Bus not found: " + to_string(busID));
+            return false;
+        }
 
-            // BankEntry removed
-            if (!data || data->disposed) break;
+        Log(bankID, 0, "[SetConvolutionReverb] bus: " + to_string(busID) + " wet: " + to_string(wetDryMix));
 
-            {
-                lock_guard<mutex> lock(data->decodingMutex);
+        if (!bus->effectChain.pEffectDescriptors)
+        {
+            CreateEffectChain(bus->voice, bus);
+        }
 
-                // Read samples
-                FLOAT* pBuffer = &data->buffer.Data[data->decodedSamples * data->channels];
-                UINT32 decoded = stb_vorbis_get_samples_float_interleaved(vorbis, data->channels, pBuffer, bufferSize * data->channels);
-                samplesDecoded += decoded;
-                data->decodedSamples = samplesDecoded;
+        // The spectra of the impulse response are only computed when the bank changes
+        bus->convolutionWetDryMix = wetDryMix;
+        if (bus->convolutionBankID == bankID)
+        {
+            // An engine still being built for another bank is dropped when it's done
+            bus->convolutionPendingBankID = 0;
+            bus->convolutionTicket = 0;
+            return EnableConvolution(bus);
+        }
 
-                if (decoded == 0)
-                {
-                    // Less samples decoded than expected
-                    // we update the total samples to match
-                    data->totalSamples = samplesDecoded;
-                }
+        // Enabled with the last mix once built
+        if (bus->convolutionPendingBankID == bankID)
+            return true;
 
-                data->decodingPerform.notify_one();
-            }
-        }
+        // Resampling and the spectra take a while, the engine is built on its own thread and handed over by BuildConvolution
+        // The previous engine keeps playing meanwhile
+        bus->convolutionPendingBankID = bankID;
+        bus->convolutionTicket = ticket;
+        m_convolutionBuilds++;
+        thread build(BuildConvolution, busID, bankID, ticket, move(response), m_masterDetails.InputSampleRate, m_masterDetails.InputChannels);
+        build.detach();
+        return true;
+    }
 
-        // Close the Vorbis file
-        stb_vorbis_close(vorbis);
+    void SaXAudio::BuildConvolution(const INT32 busID, const INT32 bankID, const UINT32 ticket, ImpulseResponse response, const UINT32 sampleRate, const UINT32 channels)
+    {
+        vector<FLOAT> resampled;
+        const UINT32 frames = (UINT32)(response.samples.size() / response.channels);
+        Resample(response.samples.data(), frames, response.channels, response.sampleRate, sampleRate, resampled);
+        ConvolutionEngine* engine = new ConvolutionEngine(resampled.data(), (UINT32)(resampled.size() / response.channels), response.channels, channels);
 
         {
-            // Calling back
-            lock_guard<mutex> lock(SaXAudio::Instance.m_bankMutex);
+            auto lock = Instance.AcquireControl();
 
-            BankData* data = GetEntry(data, SaXAudio::Instance.m_bank, bankID);
-            if (data && data->onDecodedCallback)
+            // Not wanted anymore if the bus was removed, got another bank or the reverb was removed
+            BusData* bus = Instance.GetBus(busID);
+            if (bus && bus->convolutionTicket == ticket)
             {
-                (*data->onDecodedCallback)(bankID, data->Oggbuffer);
-                data->onDecodedCallback = nullptr;
+                bus->convolution->SetEngine(engine);
+                engine = nullptr;
+                bus->convolutionBankID = bankID;
+                bus->convolutionPendingBankID = 0;
+                bus->convolutionTicket = 0;
+                Instance.EnableConvolution(bus);
             }
         }
 
-        Log(bankID, 0, "[DecodeOgg] Decoding complete");
+        delete engine;
+        Instance.m_convolutionBuilds--;
     }
 
-    void SaXAudio::RemoveVoice(const INT32 voiceID)
+    BOOL SaXAudio::EnableConvolution(BusData* bus)
     {
-        BOOL autoRemove = false;
-        INT32 bankID = 0;
+        // Called with the control lock held
+        ConvolutionParameters parameters = { bus->convolutionWetDryMix };
+        HRESULT hr = bus->voice->SetEffectParameters(CHAIN_CONVOLUTION, &parameters, sizeof(ConvolutionParameters), XAUDIO2_COMMIT_NOW);
+        if (SUCCEEDED(hr))
+            hr = bus->voice->EnableEffect(CHAIN_CONVOLUTION);
+        if (FAILED(hr))
+        {
+            Log(bus->convolutionBankID, 0, "Failed to enable convolution reverb", hr);
+            return false;
+        }
+        bus->descriptors[CHAIN_CONVOLUTION].InitialState = true;
+        return true;
+    }
+
+    void SaXAudio::RemoveConvolutionReverb(const INT32 busID)
+    {
+        if (!m_XAudio)
+            return;
+
+        BusData* bus = GetBus(busID);
+        if (!bus || !bus->voice || !bus->effectChain.pEffectDescriptors) return;
+
+        Log(0, 0, "[RemoveConvolutionReverb] bus: " + to_string(busID));
+
+        // An engine still being built is dropped, the engine is kept, setting the same bank again is free
+        bus->convolutionPendingBankID = 0;
+        bus->convolutionTicket = 0;
+        bus->descriptors[CHAIN_CONVOLUTION].InitialState = false;
+        bus->voice->DisableEffect(CHAIN_CONVOLUTION);
+    }
+
+    BOOL SaXAudio::SetCompressor(const INT32 busID, const CompressorParameters* params, const INT32 sidechainBusID)
+    {
+        if (!m_XAudio)
+            return false;
+
+        BusData* bus = busID == 0 ? &m_masteringBus : GetBus(busID);
+        if (!bus || !bus->voice)
+        {
+            Log(0, 0, "[SetCompressor] Bus not found: " + to_string(busID));
+            return false;
+        }
+
+        Log(0, 0, "[SetCompressor] bus: " + to_string(busID) + " threshold: " + to_string(params->Threshold) + " ratio: " + to_string(params->Ratio) + " sidechain: " + to_string(sidechainBusID));
+
+        // The mastering voice includes every bus, it can't duck one of them
+        Compressor* sidechain = nullptr;
+        if (sidechainBusID != 0)
+        {
+            BusData* key = GetBus(sidechainBusID);
+            if (!key || !key->voice || key == bus)
+            {
+                Log(0, 0, "[SetCompressor] Failed, sidechain bus not found: " + to_string(sidechainBusID));
+                return false;
+            }
+
+            // The compressor of the sidechain bus measures it, enabled or not
+            if (!key->effectChain.pEffectDescriptors)
+            {
+                CreateEffectChain(key->voice, key);
+            }
+            sidechain = key->compressorEffect;
+        }
+
+        if (!bus->effectChain.pEffectDescriptors)
+        {
+            CreateEffectChain(bus->voice, bus);
+        }
+        if (!bus->compressorEffect)
+            return false;
+
+        bus->compressorEffect->SetSidechain(sidechain);
+        bus->sidechainBusID = sidechain ? sidechainBusID : 0;
+        bus->compressor = *params;
+
+        HRESULT hr = bus->voice->SetEffectParameters(CHAIN_COMPRESSOR, &bus->compressor, sizeof(CompressorParameters), XAUDIO2_COMMIT_NOW);
+        if (SUCCEEDED(hr))
+            hr = bus->voice->EnableEffect(CHAIN_COMPRESSOR);
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to enable compressor", hr);
+            return false;
+        }
+        bus->descriptors[CHAIN_COMPRESSOR].InitialState = true;
+        return true;
+    }
+
+    void SaXAudio::RemoveCompressor(const INT32 busID)
+    {
+        if (!m_XAudio)
+            return;
+
+        BusData* bus = busID == 0 ? &m_masteringBus : GetBus(busID);
+        if (!bus || !bus->voice || !bus->effectChain.pEffectDescriptors) return;
+
+        Log(0, 0, "[RemoveCompressor] bus: " + to_string(busID));
+
+        bus->descriptors[CHAIN_COMPRESSOR].InitialState = false;
+        bus->voice->DisableEffect(CHAIN_COMPRESSOR);
+
+        bus->compressorEffect->SetSidechain(nullptr);
+        bus->sidechainBusID = 0;
+    }
+
+    BOOL SaXAudio::SetLimiter(const INT32 busID, const LimiterParameters* params)
+    {
+        if (!m_XAudio)
+            return false;
+
+        BusData* bus = busID == 0 ? &m_masteringBus : GetBus(busID);
+        if (!bus || !bus->voice)
+        {
+            Log(0, 0, "[SetLimiter] Bus not found: " + to_string(busID));
+            return false;
+        }
+
+        Log(0, 0, "[SetLimiter] bus: " + to_string(busID) + " ceiling: " + to_string(params->Ceiling) + " look-ahead: " + to_string(params->Lookahead));
+
+        if (!bus->effectChain.pEffectDescriptors)
+        {
+            CreateEffectChain(bus->voice, bus);
+        }
+
+        bus->limiter = *params;
+        HRESULT hr = bus->voice->SetEffectParameters(CHAIN_LIMITER, &bus->limiter, sizeof(LimiterParameters), XAUDIO2_COMMIT_NOW);
+        if (SUCCEEDED(hr))
+            hr = bus->voice->EnableEffect(CHAIN_LIMITER);
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to enable limiter", hr);
+            return false;
+        }
+        bus->descriptors[CHAIN_LIMITER].InitialState = true;
+        return true;
+    }
+
+    void SaXAudio::RemoveLimiter(const INT32 busID)
+    {
+        if (!m_XAudio)
+            return;
+
+        BusData* bus = busID == 0 ? &m_masteringBus : GetBus(busID);
+        if (!bus || !bus->voice || !bus->effectChain.pEffectDescriptors) return;
+
+        Log(0, 0, "[RemoveLimiter] bus: " + to_string(busID));
+
+        bus->descriptors[CHAIN_LIMITER].InitialState = false;
+        bus->voice->DisableEffect(CHAIN_LIMITER);
+    }
+
+    UINT32 SaXAudio::GetVoiceCount(const INT32 bankID, const INT32 busID)
+    {
+        if (!m_XAudio)
+            return 0;
+        lock_guard<mutex> bankLock(m_bankMutex);
+        lock_guard<mutex> busLock(m_busMutex);
+        lock_guard<mutex> voiceLock(m_voiceMutex);
+
+        if (bankID <= 0 && busID <= 0)
+            return m_voiceCount;
+
+        BankData* bank = nullptr;
+        if (bankID > 0)
+        {
+            bank = GetEntry(bank, m_bank, bankID);
+            if (!bank) return 0;
+        }
+
+        BusData* bus = nullptr;
+        if (busID > 0)
+        {
+            bus = GetEntry(bus, m_buses, busID);
+            if (!bus) return 0;
+        }
+
+        if (!bus)
+            return bank->voices.count;
+        if (!bank)
+            return bus->voices.count;
+
+        // Filtering by both, walk the shortest list
+        UINT32 count = 0;
+        if (bank->voices.count < bus->voices.count)
+        {
+            for (AudioVoice* voice = bank->voices.head; voice; voice = voice->BankLink.next)
+            {
+                if (voice->BusID == busID)
+                    count++;
+            }
+        }
+        else
+        {
+            for (AudioVoice* voice = bus->voices.head; voice; voice = voice->BusLink.next)
+            {
+                if (voice->BankID == bankID)
+                    count++;
+            }
+        }
+        return count;
+    }
+
+    UINT32 SaXAudio::GetBankCount()
+    {
+        if (!m_XAudio)
+            return 0;
+        lock_guard<mutex> lock(m_bankMutex);
+
+        UINT32 count = 0;
+        for (auto& it : m_bank)
+        {
+            if (!it.second.disposed)
+                count++;
+        }
+
+        return count;
+    }
+
+    void SaXAudio::SetMaxRealVoices(const UINT32 count)
+    {
+        if (!m_XAudio)
+            return;
+        Log(0, 0, "[SetMaxRealVoices] " + to_string(count));
+
+        m_maxRealVoices = count;
+        Reschedule();
+    }
+
+    UINT32 SaXAudio::GetRealVoiceCount()
+    {
+        return m_realVoiceCount;
+    }
+
+    const VoiceSnapshot* SaXAudio::GetVoiceSnapshot()
+    {
+        return &m_snapshot;
+    }
+
+    void SaXAudio::UpdateSnapshot()
+    {
+        // Fill the back buffer, readers only ever see the front one
+        UINT32 back = 1 - m_snapshot.front;
+        VoiceState* states = m_snapshot.voices[back];
+        UINT32 count = 0;
+
+        UINT32 slotCount = m_slotCount;
+        for (UINT32 i = 0; i < slotCount; i++)
+        {
+            AudioVoice* voice = m_voiceSlots[i];
+            INT32 voiceID = voice ? voice->VoiceID.load() : 0;
+            if (!voiceID)
+                continue;
+
+            // Ended voices are removed by the next tick, without a source voice there is nothing to read
+            if (voice->IsFinishing || (!voice->SourceVoice && !voice->IsVirtual))
+                continue;
+
+            // The source voice state is read once for the position, the segment and the levels
+            UINT32 position = 0;
+            UINT32 segmentIndex = 0;
+            voice->GetPlayback(position, segmentIndex);
+
+            VoiceState& state = states[count++];
+            state.voiceID = voiceID;
+            state.position = position;
+            state.playing = voice->IsPlaying;
+
+            voice->Position = position;
+            voice->SegmentIndex = segmentIndex;
+            state.paused = voice->GetPauseStack() > 0;
+            state.volume = voice->Volume;
+
+            voice->UpdateLevels(position);
+            state.peak = max(voice->PeakLevels[0].load(), voice->PeakLevels[1].load());
+            state.rms = max(voice->RMSLevels[0].load(), voice->RMSLevels[1].load());
+        }
+        m_snapshot.count[back] = count;
+
+        m_snapshot.sequence.fetch_add(1, memory_order_release);
+        m_snapshot.front.store(back, memory_order_release);
+        m_snapshot.sequence.fetch_add(1, memory_order_release);
+    }
+
+    void SaXAudio::UpdateMeters()
+    {
+        UINT32 back = 1 - m_meters.front;
+        BusLevels* levels = m_meters.buses[back];
+        UINT32 count = 0;
+
+        auto readMeter = [&](const INT32 busID, IXAudio2Voice* voice, const UINT32 effectIndex)
+        {
+            if (count >= MAX_METERS) return;
+
+            BusLevels& entry = levels[count];
+            entry.busID = busID;
+            entry.channels = m_masterDetails.InputChannels;
+            XAUDIO2FX_VOLUMEMETER_LEVELS meter = { entry.peak, entry.rms, entry.channels };
+            if (entry.channels <= MAX_OUTPUT_CHANNELS && SUCCEEDED(voice->GetEffectParameters(effectIndex, &meter, sizeof(meter))))
+                count++;
+        };
+
+        if (m_masteringBus.effectChain.pEffectDescriptors && m_masteringBus.descriptors[CHAIN_METER].InitialState)
+            readMeter(0, m_masteringBus.voice, CHAIN_METER);
+        {
+            lock_guard<mutex> lock(m_busMutex);
+            for (auto& it : m_buses)
+            {
+                BusData& bus = it.second;
+                if (bus.voice && bus.effectChain.pEffectDescriptors && bus.descriptors[CHAIN_METER].InitialState)
+                    readMeter(it.first, bus.voice, CHAIN_METER);
+            }
+        }
+
+        // Nothing metered, nothing to publish
+        if (count == 0 && m_meters.count[m_meters.front] == 0)
+            return;
+        m_meters.count[back] = count;
+
+        m_meters.sequence.fetch_add(1, memory_order_release);
+        m_meters.front.store(back, memory_order_release);
+        m_meters.sequence.fetch_add(1, memory_order_release);
+    }
+
+    BOOL SaXAudio::ReadBusLevels(const INT32 busID, BusLevels& levels)
+    {
+        // No lock, retry if the control thread switched the buffers while reading
+        while (true)
+        {
+            UINT32 sequence = m_meters.sequence.load(memory_order_acquire);
+            if (sequence & 1)
+                continue;
+
+            UINT32 front = m_meters.front.load(memory_order_acquire);
+            BOOL found = false;
+            for (UINT32 i = 0; i < m_meters.count[front]; i++)
+            {
+                if (m_meters.buses[front][i].busID == busID)
+                {
+                    levels = m_meters.buses[front][i];
+                    found = true;
+                    break;
+                }
+            }
+
+            atomic_thread_fence(memory_order_acquire);
+            if (m_meters.sequence.load(memory_order_relaxed) == sequence)
+                return found;
+        }
+    }
+
+    void SaXAudio::SetMetering(const INT32 busID, const BOOL enabled)
+    {
+        if (!m_XAudio)
+            return;
+        Log(0, 0, "[SetMetering] bus: " + to_string(busID) + " enabled: " + to_string(enabled));
+
+        BusData* bus = busID == 0 ? &m_masteringBus : GetBus(busID);
+        if (!bus || !bus->voice) return;
+
+        if (!bus->effectChain.pEffectDescriptors)
+        {
+            if (!enabled) return;
+
+            bus->descriptors[CHAIN_METER].InitialState = true;
+            CreateEffectChain(bus->voice, bus);
+            return;
+        }
+
+        HRESULT hr = enabled ? bus->voice->EnableEffect(CHAIN_METER) : bus->voice->DisableEffect(CHAIN_METER);
+        bus->descriptors[CHAIN_METER].InitialState = enabled && SUCCEEDED(hr);
+
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to toggle the volume meter", hr);
+        }
+    }
+
+    FLOAT SaXAudio::GetPeakLevel(const INT32 voiceID, const UINT32 channelIndex, const BOOL isBus)
+    {
+        if (!isBus)
+        {
+            VoicePin voice = PinVoice(voiceID);
+            return voice && channelIndex < 2 ? voice->PeakLevels[channelIndex].load() : 0.0f;
+        }
+
+        BusLevels levels;
+        if (!ReadBusLevels(voiceID, levels) || channelIndex >= levels.channels)
+            return 0.0f;
+        return levels.peak[channelIndex];
+    }
+
+    FLOAT SaXAudio::GetRMSLevel(const INT32 voiceID, const UINT32 channelIndex, const BOOL isBus)
+    {
+        if (!isBus)
+        {
+            VoicePin voice = PinVoice(voiceID);
+            return voice && channelIndex < 2 ? voice->RMSLevels[channelIndex].load() : 0.0f;
+        }
+
+        BusLevels levels;
+        if (!ReadBusLevels(voiceID, levels) || channelIndex >= levels.channels)
+            return 0.0f;
+        return levels.rms[channelIndex];
+    }
+
+    UINT64 SaXAudio::GetEngineTime()
+    {
+        return m_engineClock.Samples;
+    }
+
+    UINT32 SaXAudio::GetEngineSampleRate()
+    {
+        return m_masterDetails.InputSampleRate;
+    }
+
+    BOOL SaXAudio::ScheduleStart(const INT32 voiceID, const UINT64 engineTime)
+    {
+        if (!m_XAudio)
+            return false;
+
+        AudioVoice* voice = GetVoice(voiceID);
+        if (!voice || !voice->BankData || voice->IsPlaying)
+            return false;
+        Log(voice->BankID, voiceID, "[ScheduleStart] at: " + to_string(engineTime) + " now: " + to_string(m_engineClock.Samples.load()));
+
+        // A new time replaces the previous one
+        CancelScheduledStart(voiceID);
+        voice->IsScheduled = true;
+        m_scheduledStarts.push_back({ voiceID, engineTime });
+
+        // It might already be close enough
+        ProcessScheduledStarts();
+        return true;
+    }
+
+    void SaXAudio::CancelScheduledStart(const INT32 voiceID)
+    {
+        // Called with the control lock held
+        m_scheduledStarts.erase(remove_if(m_scheduledStarts.begin(), m_scheduledStarts.end(),
+            [voiceID](const ScheduledStart& start) { return start.voiceID == voiceID; }), m_scheduledStarts.end());
+    }
+
+    UINT32 SaXAudio::GetGroupOperationSet()
+    {
+        // Called with the control lock held
+        // The starts are held back until CommitChanges so every voice begins in the same pass
+        if (m_groupOperationSet == 0)
+            m_groupOperationSet = NewOperationSet();
+        return m_groupOperationSet;
+    }
+
+    void SaXAudio::CommitGroup()
+    {
+        // Called with the control lock held
+        if (!m_XAudio || m_groupOperationSet == 0)
+            return;
+
+        Log(0, 0, "[StartGroup] operation set: " + to_string(m_groupOperationSet));
+        m_XAudio->CommitChanges(m_groupOperationSet);
+        m_groupOperationSet = 0;
+    }
+
+    UINT32 SaXAudio::PostSegments(const PlaybackSegment* segments, const UINT32 count)
+    {
+        lock_guard<mutex> lock(m_segmentMutex);
+        UINT32 ticket = ++m_segmentTicket;
+        m_postedSegments[ticket].assign(segments, segments + count);
+        return ticket;
+    }
+
+    BOOL SaXAudio::StartPostedSegments(const INT32 voiceID, const UINT32 ticket)
+    {
+        // Called with the control lock held
+        vector<PlaybackSegment> segments;
+        {
+            lock_guard<mutex> lock(m_segmentMutex);
+            auto it = m_postedSegments.find(ticket);
+            if (it == m_postedSegments.end())
+                return false;
+            segments.swap(it->second);
+            m_postedSegments.erase(it);
+        }
+
+        AudioVoice* voice = GetVoice(voiceID);
+        return voice && voice->StartSegments(segments.data(), (UINT32)segments.size());
+    }
+
+    void SaXAudio::ProcessScheduledStarts()
+    {
+        // Called with the control lock held
+        if (m_scheduledStarts.empty())
+            return;
+
+        // Lead ins are counted from the pass the commit below applies to, not from the last pass that ended
+        // If a pass begins between this read and CommitChanges, the voices start one quantum (10 ms) late
+        UINT32 engineRate = m_masterDetails.InputSampleRate;
+        UINT64 now = m_engineClock.CommitTime();
+        UINT64 lead = (UINT64)engineRate * SCHEDULE_LEAD_MS / 1000;
+        UINT32 operationSet = 0;
+
+        for (auto it = m_scheduledStarts.begin(); it != m_scheduledStarts.end();)
+        {
+            if (it->engineTime > now + lead)
+            {
+                ++it;
+                continue;
+            }
+
+            AudioVoice* voice = GetVoice(it->voiceID);
+            if (!voice || !voice->IsScheduled || !voice->BankData)
+            {
+                it = m_scheduledStarts.erase(it);
+                continue;
+            }
+
+            // Engine samples to samples of the sound
+            BankData* data = voice->BankData;
+            double ratio = (double)data->sampleRate * voice->Speed / engineRate;
+            UINT32 leadIn = 0;
+            UINT64 sample = 0;
+            if (it->engineTime >= now)
+                leadIn = (UINT32)((it->engineTime - now) * ratio);
+            else
+                sample = (UINT64)((now - it->engineTime) * ratio); // Late, skip what should have been heard already
+
+            if ((UINT64)leadIn * data->channels > m_silence.size())
+            {
+                // Not enough silence for such a lead in, wait for the next tick
+                ++it;
+                continue;
+            }
+
+            if (voice->Looping && voice->LoopEnd > voice->LoopStart && sample >= voice->LoopEnd)
+                sample = voice->LoopStart + (sample - voice->LoopStart) % (voice->LoopEnd - voice->LoopStart);
+
+            if (sample >= data->totalSamples)
+            {
+                // The whole sound should have played by now
+                Log(voice->BankID, voice->VoiceID, "[ProcessScheduledStarts] Too late, finished");
+                voice->IsScheduled = false;
+                voice->IsPlaying = true;
+                RemoveVoice(voice->VoiceID);
+            }
+            else
+            {
+                // Voices due in the same tick share the operation set and start in the same pass
+                if (!operationSet)
+                    operationSet = NewOperationSet();
+                voice->Start((UINT32)sample, true, leadIn, operationSet);
+            }
+            it = m_scheduledStarts.erase(it);
+        }
+
+        if (operationSet)
+            m_XAudio->CommitChanges(operationSet);
+    }
+
+    void SaXAudio::ProcessPendingLoops()
+    {
+        // Called with the control lock held
+        for (auto it = m_pendingLoops.begin(); it != m_pendingLoops.end();)
+        {
+            AudioVoice* voice = GetVoice(*it);
+            if (!voice || voice->ApplyLoopChange())
+                it = m_pendingLoops.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void SaXAudio::WaitForDecoding(const INT32 voiceID)
+    {
+        // Called with the control lock held
+        for (const DecodingWait& wait : m_decodingWaits)
+        {
+            if (wait.voiceID == voiceID)
+                return;
+        }
+
+        Log(0, voiceID, "[Start] Waiting for decoded data");
+        m_decodingWaits.push_back({ voiceID, Now() });
+    }
+
+    void SaXAudio::ProcessDecodingWaits()
+    {
+        // Called with the control lock held
+        for (auto it = m_decodingWaits.begin(); it != m_decodingWaits.end();)
+        {
+            // The voice might have been removed or stopped while waiting
+            AudioVoice* voice = GetVoice(it->voiceID);
+            if (!voice || !voice->BankData || !voice->IsPlaying)
+            {
+                it = m_decodingWaits.erase(it);
+                continue;
+            }
+
+            const UINT32 decoded = voice->BankData->decodedSamples;
+            if (decoded <= voice->Buffer.PlayBegin)
+            {
+                // Only gives up when the decoding didn't start at all
+                if (decoded == 0 && Now() - it->since > chrono::milliseconds(500))
+                {
+                    Log(voice->BankID, voice->VoiceID, " ERROR | [Start] Failed waiting for decoded data, timed out");
+                    EventQueue::Instance.Push(EVENT_VOICE_ERROR, voice->VoiceID, voice->BankID, E_FAIL);
+                    RemoveVoice(voice->VoiceID);
+                    it = m_decodingWaits.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+                continue;
+            }
+            it = m_decodingWaits.erase(it);
+
+            // Sound has been paused or virtualized while we were waiting
+            if (voice->GetPauseStack() > 0 || !voice->SourceVoice)
+                continue;
+
+            HRESULT hr = voice->SourceVoice->Start();
+            if (FAILED(hr))
+            {
+                Log(voice->BankID, voice->VoiceID, "[Start] Failed starting", hr);
+                EventQueue::Instance.Push(EVENT_VOICE_ERROR, voice->VoiceID, voice->BankID, hr);
+                RemoveVoice(voice->VoiceID);
+            }
+            else
+            {
+                Log(voice->BankID, voice->VoiceID, "[Start] Successfully waited for decoded data");
+            }
+        }
+    }
+
+    UINT32 SaXAudio::NewOperationSet()
+    {
+        // 0 is XAUDIO2_COMMIT_NOW
+        if (++m_operationSet == XAUDIO2_COMMIT_NOW)
+            ++m_operationSet;
+        return m_operationSet;
+    }
+
+    void SaXAudio::DecodeOgg(const INT32 bankID, stb_vorbis* vorbis)
+    {
+        // Reset file position
+        stb_vorbis_seek_start(vorbis);
+
+        UINT32 samplesTotal = 0;
+        UINT32 samplesDecoded = 0;
+        UINT32 bufferSize = 4096;
+
+        // Each chunk is measured as it is decoded, no second pass over the buffer
+        LoudnessMeter meter;
+        BOOL analyze = SaXAudio::Instance.m_analyzeLoudness;
+
+        auto it = SaXAudio::Instance.m_bank.find(bankID);
+        if (it != SaXAudio::Instance.m_bank.end())
+        {
+            BankData* data = &it->second;
+            if (data)
+            {
+                data->decodedSamples = 0;
+                samplesTotal = data->totalSamples;
+                if (analyze)
+                    meter.Init(data->channels, data->sampleRate);
+            }
+        }
+
+        while (samplesTotal - samplesDecoded > 0)
+        {
+            if (bufferSize > samplesTotal)
+                bufferSize = samplesTotal;
+
+            lock_guard<mutex> lock(SaXAudio::Instance.m_bankMutex);
+
+            BankData* data = nullptr;
+            it = SaXAudio::Instance.m_bank.find(bankID);
+            if (it != SaXAudio::Instance.m_bank.end())
+                data = &it->second;
+
+            // BankEntry removed
+            if (!data || data->disposed) break;
+
+            {
+                lock_guard<mutex> lock(data->decodingMutex);
+
+                // Read samples
+                FLOAT* pBuffer = &data->buffer.Data[data->decodedSamples * data->channels];
+                UINT32 decoded = stb_vorbis_get_samples_float_interleaved(vorbis, data->channels, pBuffer, bufferSize * data->channels);
+                samplesDecoded += decoded;
+                data->decodedSamples = samplesDecoded;
+
+                // Already known if restored with BankSetLoudness
+                analyze = analyze && !data->analyzed;
+                if (analyze)
+                    meter.Process(pBuffer, decoded);
+
+                if (decoded == 0)
+                {
+                    // Less samples decoded than expected
+                    // we update the total samples to match
+                    data->totalSamples = samplesDecoded;
+                }
+
+                data->decodingPerform.notify_one();
+            }
+        }
+
+        // Close the Vorbis file
+        stb_vorbis_close(vorbis);
+
+        {
+            // Calling back
+            lock_guard<mutex> lock(SaXAudio::Instance.m_bankMutex);
+
+            BankData* data = GetEntry(data, SaXAudio::Instance.m_bank, bankID);
+            if (data && analyze && !data->disposed && !data->analyzed)
+            {
+                data->analyzed = true;
+                data->loudness = meter.GetLoudness();
+                data->truePeak = meter.GetTruePeak();
+                Log(bankID, 0, "[DecodeOgg] loudness: " + to_string(data->loudness) + " true peak: " + to_string(data->truePeak));
+            }
+
+            if (data && data->onDecodedCallback)
+            {
+                (*data->onDecodedCallback)(bankID, data->Oggbuffer);
+                data->onDecodedCallback = nullptr;
+            }
+        }
+
+        EventQueue::Instance.Push(EVENT_BANK_DECODED, 0, bankID);
+        Log(bankID, 0, "[DecodeOgg] Decoding complete");
+    }
+
+    void SaXAudio::RemoveVoice(const INT32 voiceID)
+    {
+        BOOL autoRemove = false;
+        INT32 bankID = 0;
+        {
+            lock_guard<mutex> lock(m_voiceMutex);
+
+            AudioVoice* voice = GetVoice(voiceID);
+            if (!voice) return;
+
+            // Only one caller gets to remove the voice, this also makes GetVoice reject the voiceID from now on
+            INT32 expected = voiceID;
+            if (!voice->VoiceID.compare_exchange_strong(expected, 0)) return;
+
+            // Readers that pinned the voice before the voiceID changed must be done with it before it is reset
+            while (voice->Pins > 0)
+                this_thread::yield();
+
+            bankID = voice->BankID;
+
+            UnlinkVoice(voice, &AudioVoice::BusLink);
+            UnlinkVoice(voice, &AudioVoice::BankLink);
+
+            // Stop the voice
+            if (voice->SourceVoice)
+            {
+                Log(bankID, voiceID, "[RemoveVoice] Stopping voice");
+                voice->SourceVoice->DestroyVoice();
+                voice->SourceVoice = nullptr;
+                m_realVoiceCount--;
+            }
+            DetachEcho(nullptr, &voice->EffectData);
+
+            // Notify, the dispatcher or PollEvents will deliver it
+            if (voice->IsPlaying)
+                EventQueue::Instance.Push(EVENT_VOICE_FINISHED, voiceID, bankID);
+
+            // Auto remove
+            BankData* data = GetEntry(data, m_bank, bankID);
+            if (data && data->autoRemove && data->voices.count == 0)
+            {
+                autoRemove = true;
+            }
+
+            // Voice ready to be reused
+            voice->Reset();
+            m_freeSlots.push(voiceID & VOICE_INDEX_MASK);
+            m_voiceCount--;
+
+            Log(voice->BankID, voiceID, "[RemoveVoice] Deleted voice");
+        }
+
+        if (autoRemove)
+            RemoveBankEntry(bankID);
+    }
+
+    void SaXAudio::FinishVoice(const INT32 voiceID)
+    {
+        // The pin keeps the slot from being reused while the voice is flagged
+        VoicePin voice = PinVoice(voiceID);
+        if (!voice || voice->IsFinishing.exchange(true))
+            return;
+
+        if (!m_finishedVoices.Push(voiceID))
+            Log(voice->BankID, voiceID, "[FinishVoice] Queue full", E_FAIL);
+    }
+
+    void SaXAudio::RemoveFinishedVoices()
+    {
+        // Called with the control lock held
+        INT32 voiceID;
+        while (m_finishedVoices.Pop(voiceID))
+            RemoveVoice(voiceID);
+    }
+
+    void SaXAudio::CollectVoiceIDs(const INT32 busID, vector<INT32>& voiceIDs)
+    {
+        lock_guard<mutex> busLock(m_busMutex);
+        lock_guard<mutex> voiceLock(m_voiceMutex);
+
+        if (busID == 0)
+        {
+            voiceIDs.reserve(m_voiceCount);
+            for (AudioVoice* voice = m_masteringBus.voices.head; voice; voice = voice->BusLink.next)
+                voiceIDs.push_back(voice->VoiceID);
+
+            for (auto& it : m_buses)
+            {
+                for (AudioVoice* voice = it.second.voices.head; voice; voice = voice->BusLink.next)
+                    voiceIDs.push_back(voice->VoiceID);
+            }
+            return;
+        }
+
+        // The voices of the child buses are included
+        for (auto& it : m_buses)
+        {
+            if (it.first != busID && !IsInBus(it.second, busID))
+                continue;
+
+            for (AudioVoice* voice = it.second.voices.head; voice; voice = voice->BusLink.next)
+                voiceIDs.push_back(voice->VoiceID);
+        }
+    }
+
+    BOOL SaXAudio::IsInBus(const BusData& bus, const INT32 ancestorID)
+    {
+        // The bus lock must be held
+        INT32 parentID = bus.parentID;
+        while (parentID != 0)
+        {
+            if (parentID == ancestorID)
+                return true;
+
+            auto it = m_buses.find(parentID);
+            if (it == m_buses.end())
+                return false;
+            parentID = it->second.parentID;
+        }
+        return false;
+    }
+
+    FLOAT SaXAudio::GetOutputVolume(const BusData& bus)
+    {
+        // The bus lock must be held, the volume of every parent applies
+        FLOAT volume = bus.volume;
+        INT32 parentID = bus.parentID;
+        while (parentID != 0)
+        {
+            auto it = m_buses.find(parentID);
+            if (it == m_buses.end())
+                break;
+            volume *= it->second.volume;
+            parentID = it->second.parentID;
+        }
+        return volume;
+    }
+
+    void SaXAudio::CreateEffectChain(IXAudio2Voice* voice, EffectData* data)
+    {
+        HRESULT hr = XAudio2CreateReverb(&data->descriptors[CHAIN_REVERB].pEffect);
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to create reverb effect", hr);
+        }
+
+        hr = CreateFX(__uuidof(FXEQ), &data->descriptors[CHAIN_EQ].pEffect);
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to create EQ effect", hr);
+        }
+
+        // Starts with one reference, like the effects created by XAudio2
+        data->echoPlaceholder = static_cast<IXAPO*>(new EmptyEffect());
+        data->descriptors[CHAIN_ECHO].pEffect = data->echoPlaceholder;
+        data->convolution = new ConvolutionReverb();
+        data->descriptors[CHAIN_CONVOLUTION].pEffect = static_cast<IXAPO*>(data->convolution);
+        data->compressorEffect = new Compressor();
+        data->descriptors[CHAIN_COMPRESSOR].pEffect = static_cast<IXAPO*>(data->compressorEffect);
+        data->limiterEffect = new Limiter();
+        data->descriptors[CHAIN_LIMITER].pEffect = static_cast<IXAPO*>(data->limiterEffect);
+
+        hr = XAudio2CreateVolumeMeter(&data->descriptors[CHAIN_METER].pEffect);
+        if (FAILED(hr))
         {
-            lock_guard<mutex> lock(m_voiceMutex);
+            Log(0, 0, "Failed to create volume meter", hr);
+        }
 
-            AudioVoice* voice = nullptr;
-            auto it_voice = m_voices.find(voiceID);
-            if (it_voice != m_voices.end())
-                voice = it_voice->second;
-            if (!voice) return;
-            bankID = voice->BankID;
-            voice->BankID = 0;
+        data->effectChain.EffectCount = 7;
+        data->effectChain.pEffectDescriptors = data->descriptors;
 
-            // Stop the voice
-            if (voice->SourceVoice)
+        hr = voice->SetEffectChain(&data->effectChain);
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to set effect chain", hr);
+        }
+    }
+
+    BOOL SaXAudio::AttachEcho(IXAudio2Voice* voice, EffectData* data)
+    {
+        if (data->echoEffect)
+            return true;
+
+        XAUDIO2_EFFECT_DESCRIPTOR& descriptor = data->descriptors[CHAIN_ECHO];
+        const UINT32 maxDelay = data->echoMaxDelay > 0 ? (UINT32)ceilf(data->echoMaxDelay) : ECHO_MAX_DELAY;
+        const UINT64 key = ((UINT64)descriptor.OutputChannels << 32) | maxDelay;
+
+        IUnknown* echo = nullptr;
+        {
+            lock_guard<mutex> lock(m_echoMutex);
+            vector<IUnknown*>& pool = m_echoPool[key];
+            for (size_t i = 0; i < pool.size(); i++)
             {
-                Log(bankID, voiceID, "[RemoveVoice] Stopping voice");
-                voice->SourceVoice->DestroyVoice();
-                voice->SourceVoice = nullptr;
+                // The chain that returned it may not have let go yet, only ours is left once it did
+                pool[i]->AddRef();
+                if (pool[i]->Release() == 1)
+                {
+                    echo = pool[i];
+                    pool.erase(pool.begin() + i);
+                    break;
+                }
             }
+        }
 
-            // Callback
-            if (voice->IsPlaying && OnFinishedCallback != nullptr)
+        if (!echo)
+        {
+            FXECHO_INITDATA init = { (FLOAT)maxDelay };
+            HRESULT hr = CreateFX(__uuidof(FXEcho), &echo, &init, sizeof(FXECHO_INITDATA));
+            if (FAILED(hr))
             {
-                thread onFinished(*OnFinishedCallback, voiceID);
-                onFinished.detach();
+                Log(0, 0, "Failed to create echo effect", hr);
+                return false;
             }
+        }
 
-            // Auto remove
-            BankData* data = GetEntry(data, m_bank, bankID);
-            if (data && data->autoRemove)
+        data->echoEffect = echo;
+        data->echoEffectDelay = maxDelay;
+        data->echo.Delay = min(data->echo.Delay, (FLOAT)maxDelay);
+        descriptor.pEffect = echo;
+
+        // Virtual voices get it with their next source voice
+        if (!voice)
+            return true;
+
+        HRESULT hr = voice->SetEffectChain(&data->effectChain);
+        if (FAILED(hr))
+        {
+            Log(0, 0, "Failed to set effect chain", hr);
+            DetachEcho(nullptr, data);
+            return false;
+        }
+
+        // A pooled echo still has the parameters of its last chain
+        if (data->echo.Delay >= FXECHO_MIN_DELAY)
+            voice->SetEffectParameters(CHAIN_ECHO, &data->echo, sizeof(FXECHO_PARAMETERS), XAUDIO2_COMMIT_NOW);
+        return true;
+    }
+
+    void SaXAudio::DetachEcho(IXAudio2Voice* voice, EffectData* data)
+    {
+        IUnknown* echo = data->echoEffect;
+        if (!echo) return;
+
+        data->descriptors[CHAIN_ECHO].pEffect = data->echoPlaceholder;
+        if (voice)
+        {
+            HRESULT hr = voice->SetEffectChain(&data->effectChain);
+            if (FAILED(hr))
             {
-                autoRemove = true;
-                for (auto& it : m_voices)
+                // Still in the chain, it goes back to the pool with the voice
+                Log(0, 0, "Failed to set effect chain", hr);
+                data->descriptors[CHAIN_ECHO].pEffect = echo;
+                return;
+            }
+        }
+        data->echoEffect = nullptr;
+        data->dirtyEffects &= ~(1u << CHAIN_ECHO);
+
+        const UINT64 key = ((UINT64)data->descriptors[CHAIN_ECHO].OutputChannels << 32) | data->echoEffectDelay;
+        lock_guard<mutex> lock(m_echoMutex);
+        vector<IUnknown*>& pool = m_echoPool[key];
+        if (pool.size() < ECHO_POOL_SIZE)
+            pool.push_back(echo);
+        else
+            echo->Release();
+    }
+
+    HRESULT SaXAudio::CreateSourceVoice(AudioVoice* voice, BusData* bus)
+    {
+        BankData* data = voice->BankData;
+
+        // Set up audio format
+        WAVEFORMATEX wfx = { 0 };
+        wfx.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;  // 32-bit float format
+        wfx.nChannels = static_cast<WORD>(data->channels);
+        wfx.nSamplesPerSec = static_cast<DWORD>(data->sampleRate);
+        wfx.wBitsPerSample = 32;  // 32-bit float
+        wfx.nBlockAlign = wfx.nChannels * wfx.wBitsPerSample / 8;
+        wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
+        wfx.cbSize = 0;
+
+        // The voice outputs to its bus and to every bus it sends to
+        voice->OutputVoice = bus && bus->voice ? bus->voice : m_masteringBus.voice;
+        XAUDIO2_SEND_DESCRIPTOR descriptors[MAX_SENDS + 1];
+        XAUDIO2_VOICE_SENDS sends { voice->GetOutputs(descriptors), descriptors };
+
+        // The echo went back to the pool when the voice became virtual
+        if (voice->EffectData.descriptors[CHAIN_ECHO].InitialState && !AttachEcho(nullptr, &voice->EffectData))
+            voice->EffectData.descriptors[CHAIN_ECHO].InitialState = false;
+
+        // The effect chain keeps the enabled state of the effects through InitialState
+        return m_XAudio->CreateSourceVoice(&voice->SourceVoice, &wfx, XAUDIO2_VOICE_USEFILTER, XAUDIO2_MAX_FREQ_RATIO, voice, &sends, &voice->EffectData.effectChain);
+    }
+
+    void SaXAudio::RestoreEffects(AudioVoice* voice)
+    {
+        IXAudio2SourceVoice* sourceVoice = voice->SourceVoice;
+        EffectData* data = &voice->EffectData;
+        if (!sourceVoice) return;
+
+        HRESULT hr = S_OK;
+        if (data->descriptors[CHAIN_REVERB].InitialState)
+            hr = sourceVoice->SetEffectParameters(CHAIN_REVERB, &data->reverb, sizeof(XAUDIO2FX_REVERB_PARAMETERS), XAUDIO2_COMMIT_NOW);
+        if (SUCCEEDED(hr) && data->descriptors[CHAIN_EQ].InitialState)
+            hr = sourceVoice->SetEffectParameters(CHAIN_EQ, &data->eq, sizeof(FXEQ_PARAMETERS), XAUDIO2_COMMIT_NOW);
+        if (SUCCEEDED(hr) && data->descriptors[CHAIN_ECHO].InitialState && data->echoEffect)
+            hr = sourceVoice->SetEffectParameters(CHAIN_ECHO, &data->echo, sizeof(FXECHO_PARAMETERS), XAUDIO2_COMMIT_NOW);
+        if (data->filterCutoff > 0)
+            CommitFilter(sourceVoice, data);
+
+        if (FAILED(hr))
+        {
+            Log(voice->BankID, voice->VoiceID, "[RestoreEffects] Failed to set effect parameters", hr);
+        }
+    }
+
+    void SaXAudio::Reschedule()
+    {
+        if (!m_XAudio)
+            return;
+
+        // The control lock is held, only one thread moves voices between real and virtual at a time
+        const UINT32 maxReal = m_maxRealVoices;
+        vector<VoiceCandidate> candidates;
+        {
+            lock_guard<mutex> busLock(m_busMutex);
+            lock_guard<mutex> voiceLock(m_voiceMutex);
+
+            // Everything is real and within the limit
+            if (m_realVoiceCount == m_voiceCount && (maxReal == 0 || m_realVoiceCount <= maxReal))
+                return;
+
+            auto addCandidates = [this, &candidates](BusData& bus)
+            {
+                FLOAT busVolume = GetOutputVolume(bus);
+                for (AudioVoice* voice = bus.voices.head; voice; voice = voice->BusLink.next)
                 {
-                    // Look if any other voice is still playing the bank entry
-                    if (it.second->BankID == bankID)
-                    {
-                        autoRemove = false;
-                        break;
-                    }
+                    // Stopping and finished voices are going away on their own
+                    if (voice->IsStopping || voice->IsFinishing) continue;
+                    candidates.push_back({ voice->VoiceID, voice->Priority, voice->Volume * voice->Gain * busVolume, !voice->IsVirtual });
                 }
+            };
+
+            candidates.reserve(m_voiceCount);
+            addCandidates(m_masteringBus);
+            for (auto& it : m_buses)
+                addCandidates(it.second);
+        }
+
+        vector<INT32> toVirtualize;
+        vector<INT32> toPromote;
+        VoiceScheduler::Schedule(candidates, maxReal, toVirtualize, toPromote);
+
+        // Source voices are destroyed without holding the voice mutex, XAudio callbacks might be waiting on it
+        // Virtualize first so the limit isn't exceeded while promoting
+        for (INT32 voiceID : toVirtualize)
+        {
+            AudioVoice* voice = GetVoice(voiceID);
+            if (voice)
+                voice->Virtualize();
+        }
+
+        for (INT32 voiceID : toPromote)
+        {
+            AudioVoice* voice = GetVoice(voiceID);
+            if (voice)
+                voice->Devirtualize();
+        }
+    }
+
+    void SaXAudio::UpdateVirtualVoices(const FLOAT elapsed)
+    {
+        vector<INT32> finished;
+        {
+            lock_guard<mutex> lock(m_voiceMutex);
+            if (m_realVoiceCount == m_voiceCount)
+                return;
+
+            for (UINT32 i = 0; i < m_slotCount; i++)
+            {
+                AudioVoice* voice = m_voiceSlots[i];
+                if (voice->VoiceID != 0 && voice->AdvanceVirtual(elapsed))
+                    finished.push_back(voice->VoiceID);
             }
+        }
 
-            // Voice ready to be reused
-            voice->Reset();
-            m_voicePool.push(voice);
-            m_voices.erase(voiceID);
+        // Same as OnBufferEnd for a real voice
+        for (INT32 voiceID : finished)
+        {
+            Log(0, voiceID, "[UpdateVirtualVoices] Voice finished playing");
+            RemoveVoice(voiceID);
+        }
+    }
 
-            Log(voice->BankID, voiceID, "[RemoveVoice] Deleted voice");
+    inline BOOL IsMergeable(const CommandType type)
+    {
+        switch (type)
+        {
+        case COMMAND_SET_VOLUME:
+        case COMMAND_SET_SPEED:
+        case COMMAND_SET_PANNING:
+        case COMMAND_SET_PRIORITY:
+        case COMMAND_SET_BUS_VOLUME:
+            return true;
+        default:
+            return false;
         }
+    }
 
-        if (autoRemove)
-            RemoveBankEntry(bankID);
+    inline INT64 GetCommandKey(const Command& command)
+    {
+        return ((INT64)command.type << 32) | (UINT32)command.id;
     }
 
-    void SaXAudio::CreateEffectChain(IXAudio2Voice* voice, EffectData* data)
+    void SaXAudio::PostCommand(const Command& command)
     {
-        HRESULT hr = XAudio2CreateReverb(&data->descriptors[CHAIN_REVERB].pEffect);
-        if (FAILED(hr))
+        if (!m_XAudio)
+            return;
+
+        if (!m_commands.Push(command))
         {
-            Log(0, 0, "Failed to create reverb effect", hr);
+            // Queue is full, apply it right away rather than losing it
+            Log(0, command.id, "[PostCommand] Queue full");
+            auto lock = AcquireControl();
+            ExecuteCommand(command, command.id);
         }
+    }
 
-        hr = CreateFX(__uuidof(FXEQ), &data->descriptors[CHAIN_EQ].pEffect);
-        if (FAILED(hr))
+    void SaXAudio::PostEffectCommand(const EffectCommand& command)
+    {
+        if (!m_XAudio)
+            return;
+
+        if (!m_effectCommands.Push(command))
         {
-            Log(0, 0, "Failed to create EQ effect", hr);
+            Log(0, command.id, "[PostEffectCommand] Queue full");
+            auto lock = AcquireControl();
+            ExecuteEffectCommand(command);
         }
+    }
 
-        FXECHO_INITDATA init = { 3000 };
-        hr = CreateFX(__uuidof(FXEcho), &data->descriptors[CHAIN_ECHO].pEffect, &init, sizeof(FXECHO_INITDATA));
-        if (FAILED(hr))
+    unique_lock<mutex> SaXAudio::AcquireControl()
+    {
+        unique_lock<mutex> lock(m_controlMutex);
+
+        // Commands posted before must be applied first to keep the order of the calls
+        ApplyCommands();
+        return lock;
+    }
+
+    void SaXAudio::ApplyCommands()
+    {
+        m_pendingCommands.clear();
+        Command command;
+        while (m_commands.Pop(command))
+            m_pendingCommands.push_back(command);
+
+        if (!m_pendingCommands.empty())
         {
-            Log(0, 0, "Failed to create echo effect", hr);
+            // Only the last change of a value is applied, five SetVolume on a voice become one
+            m_lastCommands.clear();
+            for (UINT32 i = 0; i < m_pendingCommands.size(); i++)
+            {
+                if (IsMergeable(m_pendingCommands[i].type))
+                    m_lastCommands[GetCommandKey(m_pendingCommands[i])] = i;
+            }
+
+            for (UINT32 i = 0; i < m_pendingCommands.size(); i++)
+            {
+                const Command& pending = m_pendingCommands[i];
+                if (IsMergeable(pending.type) && m_lastCommands[GetCommandKey(pending)] != i)
+                    continue;
+
+                ExecuteCommand(pending, pending.id);
+            }
         }
 
-        data->effectChain.EffectCount = 3;
-        data->effectChain.pEffectDescriptors = data->descriptors;
+        // Effects are set on the voices started by the commands above
+        EffectCommand effect;
+        while (m_effectCommands.Pop(effect))
+            ExecuteEffectCommand(effect);
+    }
 
-        hr = voice->SetEffectChain(&data->effectChain);
-        if (FAILED(hr))
+    chrono::steady_clock::time_point SaXAudio::Now()
+    {
+        if (!m_offline)
+            return chrono::steady_clock::now();
+
+        // Offline time is the engine time, a session renders the same however fast it runs
+        double seconds = (double)m_engineClock.Samples / m_masterDetails.InputSampleRate;
+        return chrono::steady_clock::time_point(chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds)));
+    }
+
+    void SaXAudio::ControlTick(const FLOAT elapsed)
+    {
+        // Everything touching the voices happens here or with the control lock held
+        lock_guard<mutex> lock(m_controlMutex);
+        ApplyCommands();
+        RemoveFinishedVoices();
+        PlaylistManager::Instance.Update();
+        ProcessScheduledStarts();
+        ProcessDecodingWaits();
+        ProcessPendingLoops();
+        Fader::Instance.Tick();
+        CommitEffects();
+        UpdateVirtualVoices(elapsed);
+        Reschedule();
+        UpdateSnapshot();
+        UpdateMeters();
+    }
+
+    void SaXAudio::DoControl()
+    {
+        auto start = chrono::steady_clock::now();
+        auto last = start;
+        chrono::milliseconds interval = chrono::milliseconds(Fader::INTERVAL);
+        UINT64 count = 0;
+
+        while (Instance.m_controlRunning)
         {
-            Log(0, 0, "Failed to set effect chain", hr);
+            count++;
+            {
+                unique_lock<mutex> lock(Instance.m_controlWaitMutex);
+                Instance.m_controlWait.wait_until(lock, start + (interval * count), [] { return !Instance.m_controlRunning; });
+            }
+            if (!Instance.m_controlRunning)
+                break;
+
+            auto now = chrono::steady_clock::now();
+            FLOAT elapsed = chrono::duration<FLOAT>(now - last).count();
+            last = now;
+
+            Instance.ControlTick(elapsed);
         }
     }
 
+    void SaXAudio::MarkEffectDirty(const INT64 context, EffectData* data, const UINT32 effect)
+    {
+        data->dirtyEffects |= 1u << effect;
+        if (find(m_dirtyEffects.begin(), m_dirtyEffects.end(), context) == m_dirtyEffects.end())
+            m_dirtyEffects.push_back(context);
+    }
+
+    void SaXAudio::CommitEffects()
+    {
+        size_t kept = 0;
+        for (size_t n = 0; n < m_dirtyEffects.size(); n++)
+        {
+            INT64 context = m_dirtyEffects[n];
+            BOOL isBus = context < 0;
+            INT32 voiceID = isBus ? -(INT32)context : (INT32)context;
+
+            IXAudio2Voice* voice = nullptr;
+            EffectData* data = nullptr;
+            GetEffectData(voiceID, isBus, &voice, &data);
+            if (!data) continue;
+
+            // Became virtual, RestoreEffects commits everything when it gets a source voice again
+            if (!voice)
+            {
+                data->dirtyEffects = 0;
+                continue;
+            }
+
+            // The filter is cheap to update, it doesn't take a turn
+            if (data->dirtyEffects & (1u << DIRTY_FILTER))
+            {
+                data->dirtyEffects &= ~(1u << DIRTY_FILTER);
+                CommitFilter(voice, data);
+            }
+
+            // Only reverb, EQ and echo fade, they take turns and the others wait for the next pass
+            for (UINT32 commits = 0; commits < MAX_EFFECT_COMMITS && data->dirtyEffects; commits++)
+            {
+                UINT32 effect = data->nextCommit;
+                while (!(data->dirtyEffects & (1u << effect)))
+                    effect = (effect + 1) % (CHAIN_ECHO + 1);
+                data->dirtyEffects &= ~(1u << effect);
+                data->nextCommit = (effect + 1) % (CHAIN_ECHO + 1);
+
+                HRESULT hr = S_OK;
+                switch (effect)
+                {
+                case CHAIN_REVERB:
+                    hr = voice->SetEffectParameters(CHAIN_REVERB, &data->reverb, sizeof(XAUDIO2FX_REVERB_PARAMETERS), XAUDIO2_COMMIT_NOW);
+                    break;
+                case CHAIN_EQ:
+                    hr = voice->SetEffectParameters(CHAIN_EQ, &data->eq, sizeof(FXEQ_PARAMETERS), XAUDIO2_COMMIT_NOW);
+                    break;
+                case CHAIN_ECHO:
+                    if (data->echoEffect)
+                        hr = voice->SetEffectParameters(CHAIN_ECHO, &data->echo, sizeof(FXECHO_PARAMETERS), XAUDIO2_COMMIT_NOW);
+                    break;
+                }
+                if (FAILED(hr))
+                {
+                    Log(0, 0, "Failed to set effect parameters", hr);
+                }
+            }
+
+            if (data->dirtyEffects)
+                m_dirtyEffects[kept++] = context;
+        }
+        m_dirtyEffects.resize(kept);
+    }
 
     void SaXAudio::OnFadeReverb(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
     {
@@ -1242,38 +3368,43 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
         INT32 i = 0;
-        data->reverb.WetDryMix = newValues[i++];
-        data->reverb.ReflectionsDelay = static_cast<UINT32>(newValues[i++]);
-        data->reverb.ReverbDelay = static_cast<BYTE>(newValues[i++]);
-        data->reverb.RearDelay = static_cast<BYTE>(newValues[i++]);
-        data->reverb.SideDelay = static_cast<BYTE>(newValues[i++]);
-        data->reverb.PositionLeft = static_cast<BYTE>(newValues[i++]);
-        data->reverb.PositionRight = static_cast<BYTE>(newValues[i++]);
-        data->reverb.PositionMatrixLeft = static_cast<BYTE>(newValues[i++]);
-        data->reverb.PositionMatrixRight = static_cast<BYTE>(newValues[i++]);
-        data->reverb.EarlyDiffusion = static_cast<BYTE>(newValues[i++]);
-        data->reverb.LateDiffusion = static_cast<BYTE>(newValues[i++]);
-        data->reverb.LowEQGain = static_cast<BYTE>(newValues[i++]);
-        data->reverb.LowEQCutoff = static_cast<BYTE>(newValues[i++]);
-        data->reverb.HighEQGain = static_cast<BYTE>(newValues[i++]);
-        data->reverb.HighEQCutoff = static_cast<BYTE>(newValues[i++]);
-        data->reverb.RoomFilterFreq = newValues[i++];
-        data->reverb.RoomFilterMain = newValues[i++];
-        data->reverb.RoomFilterHF = newValues[i++];
-        data->reverb.ReflectionsGain = newValues[i++];
-        data->reverb.ReverbGain = newValues[i++];
-        data->reverb.DecayTime = newValues[i++];
-        data->reverb.Density = newValues[i++];
-        data->reverb.RoomSize = newValues[i++];
-
-        HRESULT hr = voice->SetEffectParameters(CHAIN_REVERB, &data->reverb, sizeof(XAUDIO2FX_REVERB_PARAMETERS), XAUDIO2_COMMIT_NOW);
-        if (FAILED(hr))
-        {
-            Log(0, 0, "Failed to set reverb parameters", hr);
-        }
+        XAUDIO2FX_REVERB_PARAMETERS reverb = data->reverb;
+        reverb.WetDryMix = newValues[i++];
+        reverb.ReflectionsDelay = static_cast<UINT32>(newValues[i++]);
+        reverb.ReverbDelay = static_cast<BYTE>(newValues[i++]);
+        reverb.RearDelay = static_cast<BYTE>(newValues[i++]);
+        reverb.SideDelay = static_cast<BYTE>(newValues[i++]);
+        reverb.PositionLeft = static_cast<BYTE>(newValues[i++]);
+        reverb.PositionRight = static_cast<BYTE>(newValues[i++]);
+        reverb.PositionMatrixLeft = static_cast<BYTE>(newValues[i++]);
+        reverb.PositionMatrixRight = static_cast<BYTE>(newValues[i++]);
+        reverb.EarlyDiffusion = static_cast<BYTE>(newValues[i++]);
+        reverb.LateDiffusion = static_cast<BYTE>(newValues[i++]);
+        reverb.LowEQGain = static_cast<BYTE>(newValues[i++]);
+        reverb.LowEQCutoff = static_cast<BYTE>(newValues[i++]);
+        reverb.HighEQGain = static_cast<BYTE>(newValues[i++]);
+        reverb.HighEQCutoff = static_cast<BYTE>(newValues[i++]);
+        reverb.RoomFilterFreq = newValues[i++];
+        reverb.RoomFilterMain = newValues[i++];
+        reverb.RoomFilterHF = newValues[i++];
+        reverb.ReflectionsGain = newValues[i++];
+        reverb.ReverbGain = newValues[i++];
+        reverb.DecayTime = newValues[i++];
+        reverb.Density = newValues[i++];
+        reverb.RoomSize = newValues[i++];
+
+        // The integer fields often don't move from one tick to the next
+        if (memcmp(&reverb, &data->reverb, sizeof(XAUDIO2FX_REVERB_PARAMETERS)) == 0)
+            return;
+        data->reverb = reverb;
+
+        // Virtual voice, the parameters are applied when it gets a source voice again
+        if (!voice) return;
+
+        Instance.MarkEffectDirty(context, data, CHAIN_REVERB);
     }
 
     void SaXAudio::OnFadeReverbDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
@@ -1284,11 +3415,14 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
         if (hasFinished)
         {
-            voice->DisableEffect(CHAIN_REVERB);
+            data->descriptors[CHAIN_REVERB].InitialState = false;
+            data->dirtyEffects &= ~(1u << CHAIN_REVERB);
+            if (voice)
+                voice->DisableEffect(CHAIN_REVERB);
             return;
         }
 
@@ -1303,27 +3437,31 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
         INT32 i = 0;
-        data->eq.FrequencyCenter0 = newValues[i++];
-        data->eq.Gain0 = newValues[i++];
-        data->eq.Bandwidth0 = newValues[i++];
-        data->eq.FrequencyCenter1 = newValues[i++];
-        data->eq.Gain1 = newValues[i++];
-        data->eq.Bandwidth1 = newValues[i++];
-        data->eq.FrequencyCenter2 = newValues[i++];
-        data->eq.Gain2 = newValues[i++];
-        data->eq.Bandwidth2 = newValues[i++];
-        data->eq.FrequencyCenter3 = newValues[i++];
-        data->eq.Gain3 = newValues[i++];
-        data->eq.Bandwidth3 = newValues[i++];
-
-        HRESULT hr = voice->SetEffectParameters(CHAIN_EQ, &data->eq, sizeof(FXEQ_PARAMETERS), XAUDIO2_COMMIT_NOW);
-        if (FAILED(hr))
-        {
-            Log(0, 0, "Failed to set EQ parameters", hr);
-        }
+        FXEQ_PARAMETERS eq = data->eq;
+        eq.FrequencyCenter0 = newValues[i++];
+        eq.Gain0 = newValues[i++];
+        eq.Bandwidth0 = newValues[i++];
+        eq.FrequencyCenter1 = newValues[i++];
+        eq.Gain1 = newValues[i++];
+        eq.Bandwidth1 = newValues[i++];
+        eq.FrequencyCenter2 = newValues[i++];
+        eq.Gain2 = newValues[i++];
+        eq.Bandwidth2 = newValues[i++];
+        eq.FrequencyCenter3 = newValues[i++];
+        eq.Gain3 = newValues[i++];
+        eq.Bandwidth3 = newValues[i++];
+
+        if (memcmp(&eq, &data->eq, sizeof(FXEQ_PARAMETERS)) == 0)
+            return;
+        data->eq = eq;
+
+        // Virtual voice, the parameters are applied when it gets a source voice again
+        if (!voice) return;
+
+        Instance.MarkEffectDirty(context, data, CHAIN_EQ);
     }
 
     void SaXAudio::OnFadeEqDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
@@ -1334,11 +3472,14 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
         if (hasFinished)
         {
-            voice->DisableEffect(CHAIN_EQ);
+            data->descriptors[CHAIN_EQ].InitialState = false;
+            data->dirtyEffects &= ~(1u << CHAIN_EQ);
+            if (voice)
+                voice->DisableEffect(CHAIN_EQ);
             return;
         }
 
@@ -1353,21 +3494,48 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
-        if (!voice) return;
+        if (!data) return;
 
         INT32 i = 0;
-        data->echo.WetDryMix = newValues[i++];
-        data->echo.Feedback = newValues[i++];
-        data->echo.Delay = newValues[i++];
+        FXECHO_PARAMETERS echo = data->echo;
+        echo.WetDryMix = newValues[i++];
+        echo.Feedback = newValues[i++];
+        echo.Delay = newValues[i++];
 
-        HRESULT hr = voice->SetEffectParameters(CHAIN_ECHO, &data->echo, sizeof(FXECHO_PARAMETERS), XAUDIO2_COMMIT_NOW);
-        if (FAILED(hr))
+        if (memcmp(&echo, &data->echo, sizeof(FXECHO_PARAMETERS)) == 0)
+            return;
+        data->echo = echo;
+
+        // Virtual voice, the parameters are applied when it gets a source voice again
+        if (!voice) return;
+
+        Instance.MarkEffectDirty(context, data, CHAIN_ECHO);
+    }
+
+    void SaXAudio::OnFadeEchoDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
+    {
+        BOOL isBus = context < 0;
+        INT32 voiceID = isBus ? -(INT32)context : (INT32)context;
+
+        IXAudio2Voice* voice = nullptr;
+        EffectData* data = nullptr;
+        GetEffectData(voiceID, isBus, &voice, &data);
+        if (!data) return;
+
+        if (hasFinished)
         {
-            Log(0, 0, "Failed to set EQ parameters", hr);
+            data->descriptors[CHAIN_ECHO].InitialState = false;
+            data->dirtyEffects &= ~(1u << CHAIN_ECHO);
+            if (voice)
+                voice->DisableEffect(CHAIN_ECHO);
+            Instance.DetachEcho(voice, data);
+            return;
         }
+
+        OnFadeEcho(context, count, newValues, hasFinished);
     }
 
-    void SaXAudio::OnFadeEchoDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
+    void SaXAudio::OnFadeFilter(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
     {
         BOOL isBus = context < 0;
         INT32 voiceID = isBus ? -(INT32)context : (INT32)context;
@@ -1375,14 +3543,43 @@ namespace SaXAudio
         IXAudio2Voice* voice = nullptr;
         EffectData* data = nullptr;
         GetEffectData(voiceID, isBus, &voice, &data);
+        if (!data) return;
+
+        if (hasFinished)
+            data->filterFadeID = 0;
+
+        FLOAT cutoff = exp2f(newValues[0]);
+        if (cutoff == data->filterCutoff && newValues[1] == data->filterQ)
+            return;
+        data->filterCutoff = cutoff;
+        data->filterQ = newValues[1];
+
+        // Virtual voice, the filter is applied when it gets a source voice again
         if (!voice) return;
 
+        Instance.MarkEffectDirty(context, data, DIRTY_FILTER);
+    }
+
+    void SaXAudio::OnFadeFilterDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished)
+    {
+        BOOL isBus = context < 0;
+        INT32 voiceID = isBus ? -(INT32)context : (INT32)context;
+
+        IXAudio2Voice* voice = nullptr;
+        EffectData* data = nullptr;
+        GetEffectData(voiceID, isBus, &voice, &data);
+        if (!data) return;
+
         if (hasFinished)
         {
-            voice->DisableEffect(CHAIN_ECHO);
+            data->filterFadeID = 0;
+            data->filterCutoff = 0;
+            data->dirtyEffects &= ~(1u << DIRTY_FILTER);
+            if (voice)
+                Instance.CommitFilter(voice, data);
             return;
         }
 
-        OnFadeEcho(context, count, newValues, hasFinished);
+        OnFadeFilter(context, count, newValues, hasFinished);
     }
 }
@@ -25,39 +25,256 @@
 #include "Includes.h"
 #include "Structs.h"
 #include "AudioVoice.h"
+#include "EventQueue.h"
+#include "VoiceScheduler.h"
+#include "OutputMatrix.h"
+#include "SoftwareMixer.h"
+#include "Commands.h"
+#include "RingBuffer.h"
 
 namespace SaXAudio
 {
+    // A voiceID is made of a slot index (low bits) and a generation (high bits)
+    // The generation changes every time a slot is reused so a stale voiceID never resolves to another voice
+#define VOICE_INDEX_BITS 12
+#define MAX_VOICES (1 << VOICE_INDEX_BITS)
+#define VOICE_INDEX_MASK (MAX_VOICES - 1)
+#define VOICE_GENERATION_MAX (0x7FFFFFFF >> VOICE_INDEX_BITS)
+#define COMMAND_CAPACITY 4096
+    // Effect changes waiting for the control thread
+#define EFFECT_COMMAND_CAPACITY 256
+    // Scheduled voices are started this long before their time, the gap is filled with silence
+#define SCHEDULE_LEAD_MS 30
+    // Enough silence for the lead in of 8 channels at 192kHz
+#define SILENCE_LENGTH 48000
+    // Levels of nested buses, each level is one XAudio2 processing stage
+#define MAX_BUS_DEPTH 8
+    // Buses with metering enabled, the mastering voice included
+#define MAX_METERS 64
+    // Longest echo delay in ms, used when no max delay is set on the voice or bus
+#define ECHO_MAX_DELAY 3000
+    // Unused echoes kept for each channel count and max delay
+#define ECHO_POOL_SIZE 16
+
+    struct VoiceState
+    {
+        INT32 voiceID;
+        UINT32 position;    // In samples
+        BOOL playing;
+        BOOL paused;
+        FLOAT volume;
+        FLOAT peak;         // Loudest channel, estimated from the bank buffer around the play cursor
+        FLOAT rms;
+    };
+
+    // State of every voice, refreshed by the control thread every tick and read without locking
+    // The sequence is odd while the front buffer is switched, a read is valid if the sequence didn't change
+    struct VoiceSnapshot
+    {
+        atomic<UINT32> sequence = 0;
+        atomic<UINT32> front = 0;
+        UINT32 capacity = MAX_VOICES;
+        UINT32 count[2] = { 0, 0 };
+        VoiceState voices[2][MAX_VOICES];
+    };
+
+    // Read from the volume meter of a bus
+    struct BusLevels
+    {
+        INT32 busID;
+        UINT32 channels;
+        FLOAT peak[MAX_OUTPUT_CHANNELS];
+        FLOAT rms[MAX_OUTPUT_CHANNELS];
+    };
+
+    // Time taken by the offline passes, in milliseconds
+    struct RenderStats
+    {
+        UINT64 quanta;
+        FLOAT lastCost;
+        FLOAT averageCost;
+        FLOAT maxCost;
+    };
+
+    // Same double buffer as VoiceSnapshot for the metered buses
+    struct MeterSnapshot
+    {
+        atomic<UINT32> sequence = 0;
+        atomic<UINT32> front = 0;
+        UINT32 count[2] = { 0, 0 };
+        BusLevels buses[2][MAX_METERS];
+    };
+
+    // A voice found by PinVoice, it can't be removed or reused until the pin is released
+    class VoicePin
+    {
+    private:
+        AudioVoice* m_voice = nullptr;
+    public:
+        VoicePin() = default;
+        explicit VoicePin(AudioVoice* voice) : m_voice(voice) {}
+        VoicePin(VoicePin&& other) noexcept : m_voice(other.m_voice) { other.m_voice = nullptr; }
+        VoicePin(const VoicePin&) = delete;
+        VoicePin& operator=(const VoicePin&) = delete;
+        ~VoicePin() { if (m_voice) m_voice->Pins--; }
+
+        AudioVoice* operator->() const { return m_voice; }
+        explicit operator bool() const { return m_voice != nullptr; }
+    };
+
+    // Counts the samples processed by the engine, called by XAudio on its processing thread
+    class EngineClock : public IXAudio2EngineCallback
+    {
+    public:
+        atomic<UINT64> Samples = 0;
+        UINT32 QuantumSamples = 0;
+
+        void __stdcall OnProcessingPassStart() override
+        {
+            m_sequence++;
+            m_inPass = true;
+            m_sequence++;
+        }
+        void __stdcall OnProcessingPassEnd() override
+        {
+            m_sequence++;
+            Samples += QuantumSamples;
+            m_inPass = false;
+            m_sequence++;
+        }
+        void __stdcall OnCriticalError(HRESULT) override {}
+
+        /// <summary>
+        /// Engine time of the first sample of the next pass, where changes committed now are heard
+        /// During a pass it is the end of that pass, not Samples
+        /// </summary>
+        UINT64 CommitTime() const
+        {
+            UINT64 sequence, samples;
+            BOOL inPass;
+            do
+            {
+                // Odd while the processing thread is updating, retry until both values are from the same pass
+                sequence = m_sequence;
+                samples = Samples;
+                inPass = m_inPass;
+            } while ((sequence & 1) || sequence != m_sequence);
+            return samples + (inPass ? QuantumSamples : 0);
+        }
+
+    private:
+        atomic<UINT64> m_sequence = 0;
+        atomic<BOOL> m_inPass = false;
+    };
+
     class SaXAudio
     {
         friend class AudioVoice;
+        friend class PlaylistManager;
     private:
         SaXAudio() = default;
 
         IXAudio2* m_XAudio = nullptr;
+        // Set when m_XAudio is the software mixer, the audio is then rendered by the caller
+        SoftwareMixer* m_mixer = nullptr;
+
+        // Offline, the control tick is run by Render before each pass instead of the control thread
+        BOOL m_offline = false;
+        UINT32 m_offlineOffset = 0;
+        mutex m_renderMutex;
+        RenderStats m_renderStats = { 0 };
+        double m_renderTotal = 0;
+        ofstream m_capture;
+        UINT64 m_captureFrames = 0;
         BusData m_masteringBus;
 
         unordered_map<INT32, BankData> m_bank;
         INT32 m_bankCounter = 1;
         mutex m_bankMutex;
 
+        // Buffers of removed banks, reused by GetBuffer
         list<Buffer> m_bufferPool;
+        mutex m_bufferMutex;
 
-        unordered_map<INT32, AudioVoice*> m_voices;
-        INT32 m_voiceCounter = 1;
+        // Slots are only ever filled, the voices are never deleted before Release
+        // This allows GetVoice to read them without locking, the generation in the voiceID rejects stale IDs
+        atomic<AudioVoice*> m_voiceSlots[MAX_VOICES] = {};
+        atomic<UINT32> m_slotCount = 0;
+        UINT32 m_voiceCount = 0;
         mutex m_voiceMutex;
 
         // XAudio will continue to send callbacks for a little while even after we destroyed the source voice
-        // This is why we use a pool and don't delete the voices, it is not possible to know when it's safe to do so
-        // So we put them back at the end the pool and hope XAudio is done with it by the time it gets reused
-        queue<AudioVoice*> m_voicePool;
+        // This is why we don't delete the voices, it is not possible to know when it's safe to do so
+        // So we put the slots back at the end of the queue and hope XAudio is done with it by the time it gets reused
+        queue<UINT32> m_freeSlots;
 
         unordered_map<INT32, BusData> m_buses;
         INT32 m_busCounter = 1;
         mutex m_busMutex;
 
+        // Source voices above the limit are made virtual, 0 for no limit
+        atomic<UINT32> m_maxRealVoices = 0;
+        atomic<UINT32> m_realVoiceCount = 0;
+
+        // Voices and buses are only changed with this lock held, see AcquireControl
+        // The control thread holds it while applying commands, fades and virtual voices
+        mutex m_controlMutex;
+        thread m_controlThread;
+        atomic<BOOL> m_controlRunning = false;
+        mutex m_controlWaitMutex;
+        condition_variable m_controlWait;
+
+        // Commands posted from any thread, applied by the control thread
+        RingBuffer<Command, COMMAND_CAPACITY> m_commands;
+        RingBuffer<EffectCommand, EFFECT_COMMAND_CAPACITY> m_effectCommands;
+        vector<Command> m_pendingCommands;
+        unordered_map<INT64, UINT32> m_lastCommands;
+
+        // Sample clock of the mastering voice and the starts waiting on it
+        EngineClock m_engineClock;
+        vector<ScheduledStart> m_scheduledStarts;
+        vector<FLOAT> m_silence;
+        UINT32 m_operationSet = 0;
+        UINT32 m_groupOperationSet = 0;
+
+        // Segments posted by StartSegments, taken by the control thread
+        unordered_map<UINT32, vector<PlaybackSegment>> m_postedSegments;
+        UINT32 m_segmentTicket = 0;
+        mutex m_segmentMutex;
+
+        // Impulse responses posted by SetConvolutionReverb, the engines are built by their own thread
+        unordered_map<UINT32, ImpulseResponse> m_postedResponses;
+        UINT32 m_responseTicket = 0;
+        mutex m_responseMutex;
+        atomic<UINT32> m_convolutionBuilds = 0;
+
+        // Banks are analyzed when added, voices get a gain reaching the target, 0 to disable
+        atomic<BOOL> m_analyzeLoudness = false;
+        atomic<FLOAT> m_loudnessTarget = 0;
+
+        // Voices waiting for a previous loop change to play before applying the next one
+        vector<INT32> m_pendingLoops;
+
+        // Voices that ended on the XAudio thread or failed to start, removed by the control thread
+        // A voice is only queued once so every voice fits
+        RingBuffer<INT32, MAX_VOICES> m_finishedVoices;
+        // Voices waiting for their bank to be decoded far enough to start
+        vector<DecodingWait> m_decodingWaits;
+
+        // Voices (positive) and buses (negative) with effect parameters to commit
+        vector<INT64> m_dirtyEffects;
+
+        // Echoes not used by any chain, by channel count (high bits) and max delay in ms (low bits)
+        // Each echo holds a delay line of its max delay, only the voices and buses using echo keep one
+        unordered_map<UINT64, vector<IUnknown*>> m_echoPool;
+        mutex m_echoMutex;
+
+        VoiceSnapshot m_snapshot;
+        MeterSnapshot m_meters;
+
         DWORD m_channelMask = 0;
         XAUDIO2_VOICE_DETAILS m_masterDetails = { 0 };
+        SpeakerLayout m_speakerLayout;
 
         static SaXAudio& getInstance()
         {
@@ -70,9 +287,12 @@ namespace SaXAudio
     public:
         static SaXAudio& Instance;
 
-        OnFinishedCallback OnFinishedCallback = nullptr;
-
-        BOOL Init();
+        BOOL Init(const BOOL software = false, const UINT32 channels = 0, const UINT32 sampleRate = 48000, const BOOL offline = false);
+        UINT32 Render(FLOAT* buffer, const UINT32 frames);
+        UINT32 Advance(const FLOAT seconds);
+        BOOL StartCapture(const char* filePath);
+        void StopCapture();
+        BOOL GetRenderStats(RenderStats* stats, const BOOL reset);
 
         void Release();
 
@@ -87,10 +307,20 @@ namespace SaXAudio
         INT32 AddBankEntry(const OnDecodedCallback callback);
         void RemoveBankEntry(const INT32 bankID);
         void AutoRemoveBank(const INT32 bankID);
+        void SetBankLimits(const INT32 bankID, const UINT32 maxInstances, const FLOAT cooldown, const StealPolicy policy);
+        UINT32 GetRejectedCount(const INT32 bankID = 0);
+        UINT32 GetStolenCount(const INT32 bankID = 0);
+
+        void SetLoudnessAnalysis(const BOOL enabled);
+        void SetLoudnessTarget(const FLOAT target);
+        BOOL GetBankLoudness(const INT32 bankID, FLOAT* loudness, FLOAT* truePeak);
+        void SetBankLoudness(const INT32 bankID, const FLOAT loudness, const FLOAT truePeak);
 
-        INT32 AddBus();
+        INT32 AddBus(const INT32 parentID = 0);
         void RemoveBus(const INT32 busID);
         BusData* GetBus(const INT32 busID);
+        // Bus 0 is the mastering voice
+        BOOL HasBus(const INT32 busID);
 
         void SetBusVolume(const INT32 busID, const FLOAT volume, const FLOAT fade);
         FLOAT GetBusVolume(const INT32 busID);
@@ -100,8 +330,25 @@ namespace SaXAudio
         UINT32 AddBankData(Buffer buffer, UINT32 channels, UINT32 sampleRate, UINT32 totalSamples);
         BOOL StartDecodeOgg(const INT32 bankID, const BYTE* buffer, const UINT32 length);
 
-        AudioVoice* CreateVoice(const INT32 bankID, const INT32 busID = 0);
+        AudioVoice* CreateVoice(const INT32 bankID, const INT32 busID = 0, const INT32 reservedID = 0);
+        /// <summary>
+        /// Take a slot and its voiceID without the control lock, COMMAND_CREATE_RESERVED creates the voice in it
+        /// </summary>
+        /// <returns>The voiceID, 0 if the bank doesn't exist or no slot is left</returns>
+        INT32 ReserveVoice(const INT32 bankID);
+        /// <summary>
+        /// Check if the voiceID is reserved and still waiting for its creation
+        /// </summary>
+        BOOL IsReserved(const INT32 voiceID);
+        /// <summary>
+        /// Find a voice without pinning it, the voice can only be used on the control thread or while holding the control lock
+        /// </summary>
         AudioVoice* GetVoice(const INT32 voiceID);
+        /// <summary>
+        /// Find a voice and keep it alive until the pin is released, for reads from any thread
+        /// Don't take the control or voice locks while holding a pin, RemoveVoice waits for it under them
+        /// </summary>
+        VoicePin PinVoice(const INT32 voiceID);
 
         void SetReverb(const INT32 voiceID, const BOOL isBus, const XAUDIO2FX_REVERB_PARAMETERS* params, const FLOAT fade);
         void RemoveReverb(const INT32 voiceID, const BOOL isBus, const FLOAT fade);
@@ -111,14 +358,101 @@ namespace SaXAudio
 
         void SetEcho(const INT32 voiceID, const BOOL isBus, const FXECHO_PARAMETERS* params, const FLOAT fade);
         void RemoveEcho(const INT32 voiceID, const BOOL isBus, const FLOAT fade);
+        void SetEchoMaxDelay(const INT32 voiceID, const BOOL isBus, const FLOAT maxDelay);
+
+        void SetFilter(const INT32 voiceID, const BOOL isBus, const XAUDIO2_FILTER_TYPE type, const FLOAT cutoff, const FLOAT q, const FLOAT fade);
+        void RemoveFilter(const INT32 voiceID, const BOOL isBus, const FLOAT fade);
+
+        /// <summary>
+        /// Copy a decoded bank for EFFECT_SET_CONVOLUTION
+        /// </summary>
+        /// <returns>The ticket of the copy, 0 if the bank is missing or not decoded yet</returns>
+        UINT32 PostImpulseResponse(const INT32 bankID);
+        BOOL SetConvolutionReverb(const INT32 busID, const INT32 bankID, const UINT32 ticket, const FLOAT wetDryMix);
+        void RemoveConvolutionReverb(const INT32 busID);
+
+        BOOL SetCompressor(const INT32 busID, const CompressorParameters* params, const INT32 sidechainBusID);
+        void RemoveCompressor(const INT32 busID);
+
+        BOOL SetLimiter(const INT32 busID, const LimiterParameters* params);
+        void RemoveLimiter(const INT32 busID);
 
         UINT32 GetVoiceCount(const INT32 bankID = 0, const INT32 busID = 0);
         UINT32 GetBankCount();
 
+        void SetMaxRealVoices(const UINT32 count);
+        UINT32 GetRealVoiceCount();
+
+        const VoiceSnapshot* GetVoiceSnapshot();
+
+        void SetMetering(const INT32 busID, const BOOL enabled);
+        FLOAT GetPeakLevel(const INT32 voiceID, const UINT32 channelIndex, const BOOL isBus);
+        FLOAT GetRMSLevel(const INT32 voiceID, const UINT32 channelIndex, const BOOL isBus);
+
+        UINT64 GetEngineTime();
+        UINT32 GetEngineSampleRate();
+        BOOL ScheduleStart(const INT32 voiceID, const UINT64 engineTime);
+        // The starts held by COMMAND_START, CommitGroup begins them in the same pass
+        UINT32 GetGroupOperationSet();
+        void CommitGroup();
+        /// <summary>
+        /// Keep the segments for COMMAND_START_SEGMENTS, they don't fit in a Command
+        /// </summary>
+        /// <returns>The ticket of the segments</returns>
+        UINT32 PostSegments(const PlaybackSegment* segments, const UINT32 count);
+        BOOL StartPostedSegments(const INT32 voiceID, const UINT32 ticket);
+
+        /// <summary>
+        /// Queue a command for the control thread, changes of the same value are merged within a tick
+        /// </summary>
+        void PostCommand(const Command& command);
+        /// <summary>
+        /// Queue an effect change for the control thread, applied after the commands posted before it
+        /// </summary>
+        void PostEffectCommand(const EffectCommand& command);
+        /// <summary>
+        /// Lock the voices and buses, the commands posted so far are applied first
+        /// </summary>
+        unique_lock<mutex> AcquireControl();
+
     private:
         static void DecodeOgg(const INT32 bankID, stb_vorbis* vorbis);
+        static void BuildConvolution(const INT32 busID, const INT32 bankID, const UINT32 ticket, ImpulseResponse response, const UINT32 sampleRate, const UINT32 channels);
+        BOOL EnableConvolution(BusData* bus);
+        AudioVoice* AllocateVoice(const INT32 bankID, const INT32 busID, const INT32 reservedID, INT32& stealID);
+        INT32 TakeVoiceSlot(const INT32 bankID);
+        // Only decides, AllocateVoice records the creation once the voice exists
+        BOOL CheckBankLimits(BankData* data, INT32& stealID);
         void RemoveVoice(const INT32 voiceID);
+        void FinishVoice(const INT32 voiceID);
+        void RemoveFinishedVoices();
+        void WaitForDecoding(const INT32 voiceID);
+        void ProcessDecodingWaits();
+        void CollectVoiceIDs(const INT32 busID, vector<INT32>& voiceIDs);
+        BOOL IsInBus(const BusData& bus, const INT32 ancestorID);
+        FLOAT GetOutputVolume(const BusData& bus);
         void CreateEffectChain(IXAudio2Voice* voice, EffectData* data);
+        BOOL AttachEcho(IXAudio2Voice* voice, EffectData* data);
+        void DetachEcho(IXAudio2Voice* voice, EffectData* data);
+        void CommitFilter(IXAudio2Voice* voice, EffectData* data);
+
+        HRESULT CreateSourceVoice(AudioVoice* voice, BusData* bus);
+        void RestoreEffects(AudioVoice* voice);
+        void Reschedule();
+        void UpdateVirtualVoices(const FLOAT elapsed);
+        void ApplyCommands();
+        void ProcessScheduledStarts();
+        void CancelScheduledStart(const INT32 voiceID);
+        void ProcessPendingLoops();
+        void MarkEffectDirty(const INT64 context, EffectData* data, const UINT32 effect);
+        void CommitEffects();
+        void UpdateSnapshot();
+        void UpdateMeters();
+        BOOL ReadBusLevels(const INT32 busID, BusLevels& levels);
+        UINT32 NewOperationSet();
+        chrono::steady_clock::time_point Now();
+        void ControlTick(const FLOAT elapsed);
+        static void DoControl();
 
         static void OnFadeReverb(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished);
         static void OnFadeReverbDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished);
@@ -128,5 +462,8 @@ namespace SaXAudio
 
         static void OnFadeEcho(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished);
         static void OnFadeEchoDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished);
+
+        static void OnFadeFilter(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished);
+        static void OnFadeFilterDisable(INT64 context, UINT32 count, FLOAT* newValues, BOOL hasFinished);
     };
 }
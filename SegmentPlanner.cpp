@@ -0,0 +1,259 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "SegmentPlanner.h"
+
+namespace SaXAudio
+{
+    SegmentPlan PlanStart(const UINT32 position, const BOOL looping, const UINT32 loopStart, const UINT32 loopEnd, const UINT32 totalSamples)
+    {
+        SegmentPlan plan;
+
+        if (looping && loopStart < loopEnd && position < loopEnd)
+        {
+            if (position < loopStart)
+            {
+                // Play up to the loop first, the cursor must be in the loop region for ExitLoop to work
+                Segment& intro = plan.segments[plan.count++];
+                intro.playBegin = position;
+                intro.playEnd = loopStart;
+            }
+
+            Segment& loop = plan.segments[plan.count++];
+            loop.playBegin = max(position, loopStart);
+            loop.playEnd = loopEnd;
+            loop.loopBegin = loopStart;
+            loop.loopEnd = loopEnd;
+            loop.loopCount = XAUDIO2_LOOP_INFINITE;
+        }
+        else if (position < totalSamples)
+        {
+            // XAudio will refuse the buffer if PlayBegin is past the end of the loop,
+            // we will just play the sound from the position without a loop
+            Segment& tail = plan.segments[plan.count++];
+            tail.playBegin = position;
+        }
+        return plan;
+    }
+
+    SegmentPlan PlanLoopChange(const UINT32 boundary, const BOOL looping, const UINT32 loopStart, const UINT32 loopEnd, const UINT32 totalSamples)
+    {
+        if (looping && loopStart < loopEnd && boundary >= loopEnd)
+            return PlanStart(loopStart, true, loopStart, loopEnd, totalSamples);
+
+        return PlanStart(boundary, looping, loopStart, loopEnd, totalSamples);
+    }
+
+    SegmentPlan PlanSegments(const PlaybackSegment* segments, const UINT32 count, const UINT32 totalSamples)
+    {
+        SegmentPlan plan;
+
+        for (UINT32 i = 0; i < count && plan.count < MAX_PLAN_SEGMENTS; i++)
+        {
+            UINT32 start = segments[i].start;
+            UINT32 end = segments[i].end ? min(segments[i].end, totalSamples) : totalSamples;
+            if (start >= end)
+                continue;
+
+            Segment& segment = plan.segments[plan.count++];
+            segment.playBegin = start;
+            segment.playEnd = end;
+
+            if (segments[i].loopCount > 0)
+            {
+                segment.loopBegin = start;
+                segment.loopEnd = end;
+                segment.loopCount = segments[i].loopCount > XAUDIO2_MAX_LOOP_COUNT ? XAUDIO2_LOOP_INFINITE : segments[i].loopCount;
+
+                // Nothing after would ever play
+                if (segment.loopCount == XAUDIO2_LOOP_INFINITE)
+                    break;
+            }
+        }
+        return plan;
+    }
+
+    inline UINT64 GetSegmentLength(const Segment& segment, const UINT32 totalSamples)
+    {
+        UINT32 end = segment.playEnd ? segment.playEnd : totalSamples;
+        return end > segment.playBegin ? end - segment.playBegin : 0;
+    }
+
+    // Number of samples played by the segment including its loops
+    inline UINT64 GetSegmentDuration(const Segment& segment, const UINT32 totalSamples)
+    {
+        UINT64 length = GetSegmentLength(segment, totalSamples);
+        if (!segment.loopEnd)
+            return length;
+        if (segment.loopCount == XAUDIO2_LOOP_INFINITE)
+            return UINT64_MAX;
+        return length + (UINT64)segment.loopCount * (segment.loopEnd - segment.loopBegin);
+    }
+
+    // XAudio plays up to the loop end, repeats the loop region, then plays up to the play end
+    inline UINT64 GetSegmentPosition(const Segment& segment, UINT64 elapsed)
+    {
+        if (!segment.loopEnd)
+            return segment.playBegin + elapsed;
+
+        UINT64 first = segment.loopEnd - segment.playBegin;
+        if (elapsed < first)
+            return segment.playBegin + elapsed;
+        elapsed -= first;
+
+        UINT64 loopLength = segment.loopEnd - segment.loopBegin;
+        if (segment.loopCount == XAUDIO2_LOOP_INFINITE || elapsed < segment.loopCount * loopLength)
+            return segment.loopBegin + elapsed % loopLength;
+
+        return segment.loopEnd + elapsed - segment.loopCount * loopLength;
+    }
+
+    UINT64 GetPlanPosition(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples)
+    {
+        if (plan.count == 0 || samplesPlayed < plan.origin)
+            return 0;
+
+        UINT64 elapsed = samplesPlayed - plan.origin;
+        for (UINT32 i = 0; i < plan.count; i++)
+        {
+            UINT64 duration = GetSegmentDuration(plan.segments[i], totalSamples);
+            if (elapsed < duration || i == plan.count - 1)
+                return GetSegmentPosition(plan.segments[i], elapsed);
+            elapsed -= duration;
+        }
+        return 0;
+    }
+
+    UINT32 GetPlanSegment(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples)
+    {
+        if (plan.count == 0 || samplesPlayed < plan.origin)
+            return 0;
+
+        UINT64 elapsed = samplesPlayed - plan.origin;
+        for (UINT32 i = 0; i < plan.count; i++)
+        {
+            UINT64 duration = GetSegmentDuration(plan.segments[i], totalSamples);
+            if (elapsed < duration)
+                return i;
+            elapsed -= duration;
+        }
+        return plan.count - 1;
+    }
+
+    UINT64 GetPlanLoopExit(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples)
+    {
+        UINT64 start = plan.origin;
+        for (UINT32 i = 0; i < plan.count; i++)
+        {
+            const Segment& segment = plan.segments[i];
+            if (segment.loopEnd && segment.loopCount == XAUDIO2_LOOP_INFINITE)
+            {
+                UINT64 firstEnd = start + (segment.loopEnd - segment.playBegin);
+                if (samplesPlayed < firstEnd)
+                    return firstEnd;
+
+                UINT64 loopLength = segment.loopEnd - segment.loopBegin;
+                return firstEnd + ((samplesPlayed - firstEnd) / loopLength + 1) * loopLength;
+            }
+            start += GetSegmentDuration(segment, totalSamples);
+        }
+        return 0;
+    }
+
+    UINT64 GetPlanDuration(const SegmentPlan& plan, const UINT32 totalSamples)
+    {
+        UINT64 duration = 0;
+        for (UINT32 i = 0; i < plan.count; i++)
+        {
+            UINT64 segment = GetSegmentDuration(plan.segments[i], totalSamples);
+            if (segment == UINT64_MAX)
+                return UINT64_MAX;
+            duration += segment;
+        }
+        return duration;
+    }
+
+    SegmentPlan PlanRemainder(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples)
+    {
+        SegmentPlan remainder;
+        if (samplesPlayed < plan.origin)
+        {
+            remainder = plan;
+            remainder.origin = 0;
+            return remainder;
+        }
+
+        UINT64 elapsed = samplesPlayed - plan.origin;
+        UINT32 i = 0;
+        for (; i < plan.count; i++)
+        {
+            UINT64 duration = GetSegmentDuration(plan.segments[i], totalSamples);
+            if (elapsed < duration)
+                break;
+            elapsed -= duration;
+        }
+        if (i == plan.count)
+            return remainder;
+
+        // The segment playing continues from where it is with the loops it has left
+        Segment current = plan.segments[i];
+        UINT64 first = current.loopEnd ? current.loopEnd - current.playBegin : 0;
+        if (!current.loopEnd || elapsed < first)
+        {
+            current.playBegin += (UINT32)elapsed;
+        }
+        else
+        {
+            elapsed -= first;
+            UINT64 loopLength = current.loopEnd - current.loopBegin;
+            UINT64 loop = elapsed / loopLength;
+            if (current.loopCount == XAUDIO2_LOOP_INFINITE || loop < current.loopCount)
+            {
+                current.playBegin = current.loopBegin + (UINT32)(elapsed % loopLength);
+                if (current.loopCount != XAUDIO2_LOOP_INFINITE)
+                    current.loopCount -= (UINT32)loop + 1;
+
+                // The last time through, XAudio wants no loop region without a loop count
+                if (current.loopCount == 0)
+                {
+                    current.loopBegin = 0;
+                    current.loopEnd = 0;
+                }
+            }
+            else
+            {
+                // Past the loops, what is left after the loop end
+                current.playBegin = current.loopEnd + (UINT32)(elapsed - current.loopCount * loopLength);
+                current.loopBegin = 0;
+                current.loopEnd = 0;
+                current.loopCount = 0;
+            }
+        }
+
+        remainder.segments[remainder.count++] = current;
+        for (i++; i < plan.count; i++)
+            remainder.segments[remainder.count++] = plan.segments[i];
+        return remainder;
+    }
+}
@@ -0,0 +1,114 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+#define MAX_PLAN_SEGMENTS 16
+
+    // A region of the bank given to StartSegments
+    struct PlaybackSegment
+    {
+        UINT32 start;
+        UINT32 end;         // 0 for the end of the sound
+        UINT32 loopCount;   // Number of times the region is repeated, XAUDIO2_LOOP_INFINITE (255) to loop forever
+    };
+
+    // A part of the sound submitted as one buffer
+    struct Segment
+    {
+        UINT32 playBegin = 0;
+        UINT32 playEnd = 0;     // 0 plays until the end of the sound
+        UINT32 loopBegin = 0;
+        UINT32 loopEnd = 0;     // 0 when the segment doesn't loop
+        UINT32 loopCount = 0;   // An infinite loop is always the last segment
+    };
+
+    // The segments queued on a voice, origin is the SamplesPlayed of the voice when the first segment starts
+    struct SegmentPlan
+    {
+        Segment segments[MAX_PLAN_SEGMENTS];
+        UINT32 count = 0;
+        UINT64 origin = 0;
+    };
+
+    /// <summary>
+    /// Plan the segments to play a sound from a position
+    /// The loop segment ends at its loop end so ExitLoop continues with what is queued after it
+    /// </summary>
+    /// <param name="position">The sample to start at</param>
+    /// <param name="looping">Whether the loop is enabled, ignored past the loop end</param>
+    /// <param name="loopStart">Start of the loop</param>
+    /// <param name="loopEnd">End of the loop</param>
+    /// <param name="totalSamples">Length of the sound</param>
+    SegmentPlan PlanStart(const UINT32 position, const BOOL looping, const UINT32 loopStart, const UINT32 loopEnd, const UINT32 totalSamples);
+
+    /// <summary>
+    /// Plan the segments queued behind a loop segment exiting at boundary
+    /// Playback past the new loop end goes back to the new loop start
+    /// </summary>
+    /// <param name="boundary">The loop end of the exiting segment</param>
+    /// <param name="looping">Whether the loop is enabled</param>
+    /// <param name="loopStart">New start of the loop</param>
+    /// <param name="loopEnd">New end of the loop</param>
+    /// <param name="totalSamples">Length of the sound</param>
+    SegmentPlan PlanLoopChange(const UINT32 boundary, const BOOL looping, const UINT32 loopStart, const UINT32 loopEnd, const UINT32 totalSamples);
+
+    /// <summary>
+    /// Plan a list of regions played one after the other
+    /// Empty regions are skipped, nothing after an infinite loop is kept
+    /// </summary>
+    /// <param name="segments">The regions to play</param>
+    /// <param name="count">The number of regions, at most MAX_PLAN_SEGMENTS are used</param>
+    /// <param name="totalSamples">Length of the sound</param>
+    SegmentPlan PlanSegments(const PlaybackSegment* segments, const UINT32 count, const UINT32 totalSamples);
+
+    /// <summary>
+    /// Position in the sound after the voice played samplesPlayed samples
+    /// </summary>
+    UINT64 GetPlanPosition(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples);
+
+    /// <summary>
+    /// Index of the segment playing after the voice played samplesPlayed samples
+    /// </summary>
+    UINT32 GetPlanSegment(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples);
+
+    /// <summary>
+    /// SamplesPlayed of the voice when the infinite loop next reaches its loop end, 0 if the plan doesn't loop forever
+    /// </summary>
+    UINT64 GetPlanLoopExit(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples);
+
+    /// <summary>
+    /// Number of samples played by the whole plan, UINT64_MAX if it loops forever
+    /// </summary>
+    UINT64 GetPlanDuration(const SegmentPlan& plan, const UINT32 totalSamples);
+
+    /// <summary>
+    /// Plan the part left to play after the voice played samplesPlayed samples, with the loops left
+    /// Used to resume a plan on a new source voice, the origin is 0
+    /// </summary>
+    SegmentPlan PlanRemainder(const SegmentPlan& plan, const UINT64 samplesPlayed, const UINT32 totalSamples);
+}
@@ -0,0 +1,1009 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "SoftwareMixer.h"
+
+namespace SaXAudio
+{
+    inline void DefaultMatrix(vector<FLOAT>& matrix, const UINT32 sourceChannels, const UINT32 destinationChannels)
+    {
+        // Mono goes to every channel, otherwise each channel goes to the same channel
+        matrix.assign(sourceChannels * destinationChannels, 0.0f);
+        for (UINT32 d = 0; d < destinationChannels; d++)
+        {
+            for (UINT32 s = 0; s < sourceChannels; s++)
+            {
+                if (sourceChannels == 1 || s == d)
+                    matrix[d * sourceChannels + s] = 1.0f;
+            }
+        }
+    }
+
+    inline WAVEFORMATEX FloatFormat(const UINT32 channels, const UINT32 sampleRate)
+    {
+        WAVEFORMATEX format = { 0 };
+        format.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+        format.nChannels = (WORD)channels;
+        format.nSamplesPerSec = sampleRate;
+        format.wBitsPerSample = 32;
+        format.nBlockAlign = (WORD)(channels * sizeof(FLOAT));
+        format.nAvgBytesPerSec = sampleRate * format.nBlockAlign;
+        return format;
+    }
+
+    MixNode::MixNode(SoftwareMixer* mixer, IXAudio2Voice* voice, const UINT32 channels, const UINT32 sampleRate, const UINT32 flags, const UINT32 stage)
+        : m_mixer(mixer), m_voice(voice), m_channels(channels), m_sampleRate(sampleRate), m_flags(flags), m_stage(stage)
+    {
+        m_channelVolumes.assign(channels, 1.0f);
+        m_filterState.assign(channels * 4, 0.0f);
+        m_buffer.assign(mixer->m_quantum * channels, 0.0f);
+        m_scratch.assign(mixer->m_quantum * channels, 0.0f);
+        m_data = m_buffer.data();
+    }
+
+    MixNode::~MixNode()
+    {
+        ReleaseEffects();
+    }
+
+    void MixNode::Process(const UINT32 frames)
+    {
+        const UINT32 samples = frames * m_channels;
+        m_data = m_buffer.data();
+
+        // The default parameters let everything through, skipped
+        const XAUDIO2_FILTER_TYPE type = m_filter.Type;
+        const FLOAT frequency = m_filter.Frequency;
+        const FLOAT oneOverQ = m_filter.OneOverQ;
+        BOOL isDefault = type == LowPassFilter && frequency >= XAUDIO2_MAX_FILTER_FREQUENCY && oneOverQ == XAUDIO2_DEFAULT_FILTER_ONEOVERQ;
+        if ((m_flags & XAUDIO2_VOICE_USEFILTER) && !isDefault && !m_silent)
+        {
+            for (UINT32 c = 0; c < m_channels; c++)
+            {
+                // The state of a channel is indexed by filter type, the one-pole filters use the low-pass
+                FLOAT* state = &m_filterState[c * 4];
+                if (type <= NotchFilter)
+                {
+                    for (UINT32 i = c; i < samples; i += m_channels)
+                    {
+                        state[LowPassFilter] += frequency * state[BandPassFilter];
+                        state[HighPassFilter] = m_data[i] - state[LowPassFilter] - oneOverQ * state[BandPassFilter];
+                        state[BandPassFilter] += frequency * state[HighPassFilter];
+                        state[NotchFilter] = state[HighPassFilter] + state[LowPassFilter];
+                        m_data[i] = state[type];
+                    }
+                }
+                else
+                {
+                    for (UINT32 i = c; i < samples; i += m_channels)
+                    {
+                        state[LowPassFilter] += frequency * (m_data[i] - state[LowPassFilter]);
+                        m_data[i] = type == LowPassOnePoleFilter ? state[LowPassFilter] : m_data[i] - state[LowPassFilter];
+                    }
+                }
+            }
+        }
+
+        XAPO_BUFFER_FLAGS flags = m_silent ? XAPO_BUFFER_SILENT : XAPO_BUFFER_VALID;
+        for (Effect& effect : m_effects)
+        {
+            FLOAT* output = m_data;
+            if (!effect.inPlace)
+                output = m_data == m_buffer.data() ? m_scratch.data() : m_buffer.data();
+
+            XAPO_PROCESS_BUFFER_PARAMETERS input = { m_data, flags, frames };
+            XAPO_PROCESS_BUFFER_PARAMETERS result = { output, flags, frames };
+            effect.xapo->Process(1, &input, 1, &result, effect.enabled);
+
+            m_data = output;
+            flags = result.BufferFlags;
+        }
+        m_silent = flags == XAPO_BUFFER_SILENT;
+    }
+
+    void MixNode::Mix(const UINT32 frames)
+    {
+        if (m_silent) return;
+
+        for (Output& output : m_outputs)
+        {
+            MixNode* node = output.node;
+            if (node->m_destroyed) continue;
+
+            const UINT32 channels = node->m_channels;
+            FLOAT* target = node->m_buffer.data();
+            for (UINT32 d = 0; d < channels; d++)
+            {
+                for (UINT32 s = 0; s < m_channels; s++)
+                {
+                    const FLOAT level = output.matrix[d * m_channels + s] * m_volume * m_channelVolumes[s];
+                    if (level == 0) continue;
+
+                    const FLOAT* source = m_data + s;
+                    FLOAT* destination = target + d;
+                    for (UINT32 f = 0; f < frames; f++)
+                        destination[f * channels] += source[f * m_channels] * level;
+                    node->m_silent = false;
+                }
+            }
+        }
+    }
+
+    void MixNode::ReleaseEffects()
+    {
+        for (Effect& effect : m_effects)
+        {
+            effect.xapo->UnlockForProcess();
+            effect.xapo->Release();
+            if (effect.parameters)
+                effect.parameters->Release();
+        }
+        m_effects.clear();
+    }
+
+    MixNode::Output* MixNode::FindOutput(IXAudio2Voice* voice)
+    {
+        // No destination means the only output
+        if (!voice)
+            return m_outputs.size() == 1 ? &m_outputs[0] : nullptr;
+
+        for (Output& output : m_outputs)
+        {
+            if (output.node->m_voice == voice)
+                return &output;
+        }
+        return nullptr;
+    }
+
+    void MixNode::GetVoiceDetails(XAUDIO2_VOICE_DETAILS* pVoiceDetails)
+    {
+        pVoiceDetails->CreationFlags = m_flags;
+        pVoiceDetails->ActiveFlags = m_flags;
+        pVoiceDetails->InputChannels = m_channels;
+        pVoiceDetails->InputSampleRate = m_sampleRate;
+    }
+
+    HRESULT MixNode::SetOutputVoices(const XAUDIO2_VOICE_SENDS* pSendList)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        return m_mixer->SetOutputs(this, pSendList);
+    }
+
+    HRESULT MixNode::SetEffectChain(const XAUDIO2_EFFECT_CHAIN* pEffectChain)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        return m_mixer->LockEffects(this, pEffectChain);
+    }
+
+    HRESULT MixNode::EnableEffect(UINT32 EffectIndex, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (EffectIndex >= m_effects.size())
+            return XAUDIO2_E_INVALID_CALL;
+        m_effects[EffectIndex].enabled = true;
+        return S_OK;
+    }
+
+    HRESULT MixNode::DisableEffect(UINT32 EffectIndex, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (EffectIndex >= m_effects.size())
+            return XAUDIO2_E_INVALID_CALL;
+        m_effects[EffectIndex].enabled = false;
+        return S_OK;
+    }
+
+    void MixNode::GetEffectState(UINT32 EffectIndex, BOOL* pEnabled)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        *pEnabled = EffectIndex < m_effects.size() && m_effects[EffectIndex].enabled;
+    }
+
+    HRESULT MixNode::SetEffectParameters(UINT32 EffectIndex, const void* pParameters, UINT32 ParametersByteSize, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (EffectIndex >= m_effects.size() || !m_effects[EffectIndex].parameters)
+            return XAUDIO2_E_INVALID_CALL;
+        m_effects[EffectIndex].parameters->SetParameters(pParameters, ParametersByteSize);
+        return S_OK;
+    }
+
+    HRESULT MixNode::GetEffectParameters(UINT32 EffectIndex, void* pParameters, UINT32 ParametersByteSize)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (EffectIndex >= m_effects.size() || !m_effects[EffectIndex].parameters)
+            return XAUDIO2_E_INVALID_CALL;
+        m_effects[EffectIndex].parameters->GetParameters(pParameters, ParametersByteSize);
+        return S_OK;
+    }
+
+    HRESULT MixNode::SetFilterParameters(const XAUDIO2_FILTER_PARAMETERS* pParameters, UINT32 OperationSet)
+    {
+        if (!(m_flags & XAUDIO2_VOICE_USEFILTER))
+            return XAUDIO2_E_INVALID_CALL;
+
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        m_filter = *pParameters;
+        m_filter.Frequency = min(m_filter.Frequency, XAUDIO2_MAX_FILTER_FREQUENCY);
+        m_filter.OneOverQ = min(m_filter.OneOverQ, XAUDIO2_MAX_FILTER_ONEOVERQ);
+        return S_OK;
+    }
+
+    void MixNode::GetFilterParameters(XAUDIO2_FILTER_PARAMETERS* pParameters)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        *pParameters = m_filter;
+    }
+
+    HRESULT MixNode::SetVolume(float Volume, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        m_volume = Volume;
+        return S_OK;
+    }
+
+    void MixNode::GetVolume(float* pVolume)
+    {
+        *pVolume = m_volume;
+    }
+
+    HRESULT MixNode::SetChannelVolumes(UINT32 Channels, const float* pVolumes, UINT32 OperationSet)
+    {
+        if (Channels != m_channels)
+            return E_INVALIDARG;
+
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        m_channelVolumes.assign(pVolumes, pVolumes + Channels);
+        return S_OK;
+    }
+
+    void MixNode::GetChannelVolumes(UINT32 Channels, float* pVolumes)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        for (UINT32 i = 0; i < Channels && i < m_channels; i++)
+            pVolumes[i] = m_channelVolumes[i];
+    }
+
+    HRESULT MixNode::SetOutputMatrix(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, const float* pLevelMatrix, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        Output* output = FindOutput(pDestinationVoice);
+        if (!output || SourceChannels != m_channels || DestinationChannels != output->node->m_channels)
+            return E_INVALIDARG;
+
+        output->matrix.assign(pLevelMatrix, pLevelMatrix + SourceChannels * DestinationChannels);
+        return S_OK;
+    }
+
+    void MixNode::GetOutputMatrix(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, float* pLevelMatrix)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        Output* output = FindOutput(pDestinationVoice);
+        if (!output || SourceChannels * DestinationChannels != output->matrix.size())
+            return;
+
+        copy(output->matrix.begin(), output->matrix.end(), pLevelMatrix);
+    }
+
+    void MixNode::DestroyVoice()
+    {
+        SoftwareMixer* mixer = m_mixer;
+        lock_guard<mutex> lock(mixer->m_mutex);
+        mixer->DestroyNode(this);
+    }
+
+    MixSourceVoice::MixSourceVoice(SoftwareMixer* mixer, const WAVEFORMATEX* format, const UINT32 flags, const FLOAT maxRatio, IXAudio2VoiceCallback* callback)
+        : MixVoice(mixer, format->nChannels, format->nSamplesPerSec, flags, 0),
+        m_callback(callback), m_blockAlign(format->nBlockAlign), m_maxRatio(maxRatio)
+    {
+        m_previous.assign(m_channels, 0.0f);
+        m_current.assign(m_channels, 0.0f);
+    }
+
+    BOOL MixSourceVoice::ReadFrame()
+    {
+        while (!m_queue.empty())
+        {
+            QueuedBuffer& queued = m_queue.front();
+            XAUDIO2_BUFFER& buffer = queued.buffer;
+            if (!queued.started)
+            {
+                queued.started = true;
+                m_events.push_back({ EVENT_BUFFER_START, buffer.pContext });
+            }
+
+            if (buffer.LoopCount > 0 && queued.position == queued.loopEnd)
+            {
+                queued.position = buffer.LoopBegin;
+                if (buffer.LoopCount != XAUDIO2_LOOP_INFINITE)
+                    buffer.LoopCount--;
+                m_events.push_back({ EVENT_LOOP_END, buffer.pContext });
+            }
+
+            if (queued.position < queued.end)
+            {
+                const FLOAT* frame = (const FLOAT*)buffer.pAudioData + (size_t)queued.position * m_channels;
+                copy(frame, frame + m_channels, m_current.begin());
+                queued.position++;
+                m_samplesPlayed++;
+                return true;
+            }
+
+            // Like XAudio2, the samples are counted from the start of the stream
+            m_events.push_back({ EVENT_BUFFER_END, buffer.pContext });
+            if (buffer.Flags & XAUDIO2_END_OF_STREAM)
+            {
+                m_events.push_back({ EVENT_STREAM_END, nullptr });
+                m_samplesPlayed = 0;
+            }
+            m_queue.pop_front();
+        }
+        return false;
+    }
+
+    void MixSourceVoice::Render(const UINT32 frames)
+    {
+        FLOAT* output = m_buffer.data();
+        if (!m_running)
+        {
+            if (!m_silent)
+                fill(m_buffer.begin(), m_buffer.end(), 0.0f);
+            m_silent = true;
+            return;
+        }
+
+        // Resampled to the rate of the mixer, the filter and the effects run after
+        const double step = (double)m_ratio * m_sampleRate / m_mixer->m_sampleRate;
+        BOOL hasRead = false;
+        for (UINT32 f = 0; f < frames; f++)
+        {
+            while (m_fraction >= 1.0)
+            {
+                m_previous.swap(m_current);
+                if (ReadFrame())
+                    hasRead = true;
+                else
+                    fill(m_current.begin(), m_current.end(), 0.0f);
+                m_fraction -= 1.0;
+            }
+
+            const FLOAT t = (FLOAT)m_fraction;
+            for (UINT32 c = 0; c < m_channels; c++)
+                output[f * m_channels + c] = m_previous[c] + (m_current[c] - m_previous[c]) * t;
+            m_fraction += step;
+        }
+        m_silent = !hasRead;
+    }
+
+    void MixSourceVoice::DispatchEvents(vector<Event>& events)
+    {
+        for (const Event& event : events)
+        {
+            switch (event.type)
+            {
+            case EVENT_BUFFER_START:
+                m_callback->OnBufferStart(event.context);
+                break;
+            case EVENT_BUFFER_END:
+                m_callback->OnBufferEnd(event.context);
+                break;
+            case EVENT_LOOP_END:
+                m_callback->OnLoopEnd(event.context);
+                break;
+            case EVENT_STREAM_END:
+                m_callback->OnStreamEnd();
+                break;
+            }
+        }
+    }
+
+    HRESULT MixSourceVoice::Start(UINT32 Flags, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (OperationSet != XAUDIO2_COMMIT_NOW)
+        {
+            m_mixer->m_operations.push_back({ OperationSet, this, true });
+            return S_OK;
+        }
+        m_running = true;
+        return S_OK;
+    }
+
+    HRESULT MixSourceVoice::Stop(UINT32 Flags, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (OperationSet != XAUDIO2_COMMIT_NOW)
+        {
+            m_mixer->m_operations.push_back({ OperationSet, this, false });
+            return S_OK;
+        }
+        m_running = false;
+        return S_OK;
+    }
+
+    HRESULT MixSourceVoice::SubmitSourceBuffer(const XAUDIO2_BUFFER* pBuffer, const XAUDIO2_BUFFER_WMA* pBufferWMA)
+    {
+        // The audio data isn't copied, it must stay valid until OnBufferEnd like with XAudio2
+        const UINT32 frames = pBuffer->AudioBytes / m_blockAlign;
+        QueuedBuffer queued = { *pBuffer, pBuffer->PlayBegin, 0, 0, false };
+        queued.end = pBuffer->PlayLength ? pBuffer->PlayBegin + pBuffer->PlayLength : frames;
+        queued.loopEnd = pBuffer->LoopLength ? pBuffer->LoopBegin + pBuffer->LoopLength : queued.end;
+        if (queued.end > frames || pBuffer->PlayBegin >= queued.end)
+            return XAUDIO2_E_INVALID_CALL;
+        if (pBuffer->LoopCount > 0 && (pBuffer->LoopBegin >= queued.loopEnd || queued.loopEnd > queued.end))
+            return XAUDIO2_E_INVALID_CALL;
+
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (m_queue.size() >= XAUDIO2_MAX_QUEUED_BUFFERS)
+            return XAUDIO2_E_INVALID_CALL;
+        m_queue.push_back(queued);
+        return S_OK;
+    }
+
+    HRESULT MixSourceVoice::FlushSourceBuffers()
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+
+        // A running voice keeps the buffer it is playing, each flushed buffer still gets OnBufferEnd on the next pass
+        size_t kept = m_running && !m_queue.empty() && m_queue.front().started ? 1 : 0;
+        for (size_t i = kept; i < m_queue.size(); i++)
+            m_events.push_back({ EVENT_BUFFER_END, m_queue[i].buffer.pContext });
+        m_queue.resize(kept);
+        return S_OK;
+    }
+
+    HRESULT MixSourceVoice::Discontinuity()
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (!m_queue.empty())
+            m_queue.back().buffer.Flags |= XAUDIO2_END_OF_STREAM;
+        return S_OK;
+    }
+
+    HRESULT MixSourceVoice::ExitLoop(UINT32 OperationSet)
+    {
+        // The current iteration finishes, then the buffer plays to its end
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (!m_queue.empty())
+            m_queue.front().buffer.LoopCount = 0;
+        return S_OK;
+    }
+
+    void MixSourceVoice::GetState(XAUDIO2_VOICE_STATE* pVoiceState, UINT32 Flags)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        pVoiceState->pCurrentBufferContext = m_queue.empty() ? nullptr : m_queue.front().buffer.pContext;
+        pVoiceState->BuffersQueued = (UINT32)m_queue.size();
+        pVoiceState->SamplesPlayed = (Flags & XAUDIO2_VOICE_NOSAMPLESPLAYED) ? 0 : m_samplesPlayed;
+    }
+
+    HRESULT MixSourceVoice::SetFrequencyRatio(float Ratio, UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        m_ratio = max(XAUDIO2_MIN_FREQ_RATIO, min(Ratio, m_maxRatio));
+        return S_OK;
+    }
+
+    void MixSourceVoice::GetFrequencyRatio(float* pRatio)
+    {
+        *pRatio = m_ratio;
+    }
+
+    HRESULT MixSourceVoice::SetSourceSampleRate(UINT32 NewSourceSampleRate)
+    {
+        lock_guard<mutex> lock(m_mixer->m_mutex);
+        if (!m_queue.empty())
+            return XAUDIO2_E_INVALID_CALL;
+        m_sampleRate = NewSourceSampleRate;
+        return S_OK;
+    }
+
+    HRESULT MixMasteringVoice::GetChannelMask(DWORD* pChannelmask)
+    {
+        switch (m_channels)
+        {
+        case 1:
+            *pChannelmask = SPEAKER_FRONT_CENTER;
+            break;
+        case 2:
+            *pChannelmask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+            break;
+        case 4:
+            *pChannelmask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+            break;
+        case 6:
+            *pChannelmask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | SPEAKER_LOW_FREQUENCY | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+            break;
+        case 8:
+            *pChannelmask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | SPEAKER_LOW_FREQUENCY | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT
+                | SPEAKER_SIDE_LEFT | SPEAKER_SIDE_RIGHT;
+            break;
+        default:
+            *pChannelmask = 0;
+            break;
+        }
+        return S_OK;
+    }
+
+    SoftwareMixer::~SoftwareMixer()
+    {
+        for (MixSourceVoice* voice : m_sources)
+            delete voice;
+        for (MixNode* node : m_submixes)
+            delete node;
+        delete m_master;
+    }
+
+    MixNode* SoftwareMixer::FindNode(IXAudio2Voice* voice)
+    {
+        if (m_master && m_master->m_voice == voice)
+            return m_master;
+        for (MixNode* node : m_submixes)
+        {
+            if (node->m_voice == voice)
+                return node;
+        }
+        return nullptr;
+    }
+
+    HRESULT SoftwareMixer::SetOutputs(MixNode* node, const XAUDIO2_VOICE_SENDS* sends)
+    {
+        vector<MixNode::Output> outputs;
+        if (!sends)
+        {
+            // Like XAudio2, the voice outputs to the mastering voice by default
+            if (node != m_master)
+                outputs.push_back({ m_master, {} });
+        }
+        else
+        {
+            const BOOL isSubmix = find(m_submixes.begin(), m_submixes.end(), node) != m_submixes.end();
+            for (UINT32 i = 0; i < sends->SendCount; i++)
+            {
+                // A submix only outputs to the submixes processed after it
+                MixNode* target = FindNode(sends->pSends[i].pOutputVoice);
+                if (!target || target == node || node == m_master || (isSubmix && target != m_master && target->m_stage <= node->m_stage))
+                    return XAUDIO2_E_INVALID_CALL;
+                outputs.push_back({ target, {} });
+            }
+        }
+
+        // The levels set for a destination it already had are kept
+        for (MixNode::Output& output : outputs)
+        {
+            MixNode::Output* previous = node->FindOutput(output.node->m_voice);
+            if (previous)
+                output.matrix = previous->matrix;
+            else
+                DefaultMatrix(output.matrix, node->m_channels, output.node->m_channels);
+        }
+        node->m_outputs = outputs;
+        return S_OK;
+    }
+
+    HRESULT SoftwareMixer::LockEffects(MixNode* node, const XAUDIO2_EFFECT_CHAIN* chain)
+    {
+        // The effects run after the resampling, at the rate of the mixer
+        const WAVEFORMATEX format = FloatFormat(node->m_channels, m_sampleRate);
+        const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS parameters = { &format, m_quantum };
+
+        vector<MixNode::Effect> effects;
+        vector<BOOL> locked;
+        HRESULT hr = S_OK;
+        for (UINT32 i = 0; chain && i < chain->EffectCount; i++)
+        {
+            const XAUDIO2_EFFECT_DESCRIPTOR& descriptor = chain->pEffectDescriptors[i];
+            if (!descriptor.pEffect || descriptor.OutputChannels != node->m_channels)
+            {
+                hr = XAUDIO2_E_INVALID_CALL;
+                break;
+            }
+
+            MixNode::Effect effect = { nullptr, nullptr, descriptor.InitialState, false };
+            hr = descriptor.pEffect->QueryInterface(__uuidof(IXAPO), (void**)&effect.xapo);
+            if (FAILED(hr))
+                break;
+            if (FAILED(descriptor.pEffect->QueryInterface(__uuidof(IXAPOParameters), (void**)&effect.parameters)))
+                effect.parameters = nullptr;
+
+            XAPO_REGISTRATION_PROPERTIES* properties = nullptr;
+            if (SUCCEEDED(effect.xapo->GetRegistrationProperties(&properties)))
+            {
+                effect.inPlace = (properties->Flags & XAPO_FLAG_INPLACE_SUPPORTED) != 0;
+                XAPOFree(properties);
+            }
+
+            // An effect kept from the current chain is already locked with the same format
+            BOOL kept = find_if(node->m_effects.begin(), node->m_effects.end(),
+                [&](const MixNode::Effect& current) { return current.xapo == effect.xapo; }) != node->m_effects.end();
+            if (!kept)
+            {
+                hr = effect.xapo->LockForProcess(1, &parameters, 1, &parameters);
+                if (FAILED(hr))
+                {
+                    effect.xapo->Release();
+                    if (effect.parameters)
+                        effect.parameters->Release();
+                    break;
+                }
+            }
+            effects.push_back(effect);
+            locked.push_back(!kept);
+        }
+
+        if (FAILED(hr))
+        {
+            for (size_t i = 0; i < effects.size(); i++)
+            {
+                if (locked[i])
+                    effects[i].xapo->UnlockForProcess();
+                effects[i].xapo->Release();
+                if (effects[i].parameters)
+                    effects[i].parameters->Release();
+            }
+            return hr;
+        }
+
+        // Only the effects leaving the chain are unlocked
+        for (MixNode::Effect& current : node->m_effects)
+        {
+            BOOL kept = find_if(effects.begin(), effects.end(),
+                [&](const MixNode::Effect& effect) { return effect.xapo == current.xapo; }) != effects.end();
+            if (!kept)
+                current.xapo->UnlockForProcess();
+            current.xapo->Release();
+            if (current.parameters)
+                current.parameters->Release();
+        }
+        node->m_effects = effects;
+        return S_OK;
+    }
+
+    void SoftwareMixer::DestroyNode(MixNode* node)
+    {
+        node->m_destroyed = true;
+        m_operations.erase(remove_if(m_operations.begin(), m_operations.end(),
+            [node](const Operation& operation) { return static_cast<MixNode*>(operation.voice) == node; }), m_operations.end());
+
+        // The pass may still have the node in its lists
+        if (m_rendering)
+            m_destroyed.push_back(node);
+        else
+            DeleteNode(node);
+    }
+
+    void SoftwareMixer::DeleteNode(MixNode* node)
+    {
+        m_sources.erase(remove_if(m_sources.begin(), m_sources.end(),
+            [node](MixSourceVoice* voice) { return static_cast<MixNode*>(voice) == node; }), m_sources.end());
+        m_submixes.erase(remove(m_submixes.begin(), m_submixes.end(), node), m_submixes.end());
+        if (node == m_master)
+            m_master = nullptr;
+
+        // Nothing outputs to it anymore
+        auto removeOutputs = [node](MixNode* other)
+        {
+            other->m_outputs.erase(remove_if(other->m_outputs.begin(), other->m_outputs.end(),
+                [node](const MixNode::Output& output) { return output.node == node; }), other->m_outputs.end());
+        };
+        for (MixSourceVoice* voice : m_sources)
+            removeOutputs(voice);
+        for (MixNode* submix : m_submixes)
+            removeOutputs(submix);
+
+        delete node;
+    }
+
+    void SoftwareMixer::ProcessPass(unique_lock<mutex>& lock)
+    {
+        if (!m_running || !m_master)
+        {
+            fill(m_output.begin(), m_output.end(), 0.0f);
+            return;
+        }
+
+        m_rendering = true;
+        vector<IXAudio2EngineCallback*> engineCallbacks = m_engineCallbacks;
+        lock.unlock();
+        for (IXAudio2EngineCallback* callback : engineCallbacks)
+            callback->OnProcessingPassStart();
+        lock.lock();
+
+        for (MixNode* node : m_submixes)
+        {
+            fill(node->m_buffer.begin(), node->m_buffer.end(), 0.0f);
+            node->m_silent = true;
+        }
+        fill(m_master->m_buffer.begin(), m_master->m_buffer.end(), 0.0f);
+        m_master->m_silent = true;
+
+        // Voices created by a callback are in the list, voices destroyed by a callback are skipped
+        vector<MixSourceVoice::Event> events;
+        for (size_t i = 0; i < m_sources.size(); i++)
+        {
+            MixSourceVoice* voice = m_sources[i];
+            if (voice->m_destroyed) continue;
+
+            IXAudio2VoiceCallback* callback = voice->m_callback;
+            if (callback)
+            {
+                UINT32 bytesRequired = 0;
+                if (voice->m_running && voice->m_queue.empty())
+                    bytesRequired = (UINT32)(m_quantum * voice->m_ratio * voice->m_sampleRate / m_sampleRate + 1) * voice->m_blockAlign;
+
+                // Buffers flushed since the last pass
+                events.swap(voice->m_events);
+                lock.unlock();
+                callback->OnVoiceProcessingPassStart(bytesRequired);
+                voice->DispatchEvents(events);
+                lock.lock();
+                events.clear();
+                if (voice->m_destroyed) continue;
+            }
+
+            voice->Render(m_quantum);
+            voice->Process(m_quantum);
+            voice->Mix(m_quantum);
+
+            if (callback)
+            {
+                events.swap(voice->m_events);
+                lock.unlock();
+                voice->DispatchEvents(events);
+                callback->OnVoiceProcessingPassEnd();
+                lock.lock();
+                events.clear();
+            }
+        }
+
+        for (MixNode* node : m_submixes)
+        {
+            if (node->m_destroyed) continue;
+            node->Process(m_quantum);
+            node->Mix(m_quantum);
+        }
+
+        MixNode* master = m_master;
+        if (master->m_destroyed)
+        {
+            fill(m_output.begin(), m_output.end(), 0.0f);
+        }
+        else
+        {
+            master->Process(m_quantum);
+            const UINT32 channels = master->m_channels;
+            for (UINT32 c = 0; c < channels; c++)
+            {
+                const FLOAT level = master->m_silent ? 0 : master->m_volume * master->m_channelVolumes[c];
+                for (UINT32 f = 0; f < m_quantum; f++)
+                    m_output[f * channels + c] = master->m_data[f * channels + c] * level;
+            }
+        }
+
+        m_rendering = false;
+        for (MixNode* node : m_destroyed)
+            DeleteNode(node);
+        m_destroyed.clear();
+
+        engineCallbacks = m_engineCallbacks;
+        lock.unlock();
+        for (IXAudio2EngineCallback* callback : engineCallbacks)
+            callback->OnProcessingPassEnd();
+        lock.lock();
+    }
+
+    void SoftwareMixer::Render(FLOAT* buffer, const UINT32 frames)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        if (!m_master)
+            return;
+
+        const UINT32 channels = m_master->m_channels;
+        UINT32 written = 0;
+        while (written < frames)
+        {
+            // The mixer processes 10ms per pass like XAudio2, what the buffer can't take is kept for the next call
+            if (m_outputOffset >= m_quantum)
+            {
+                ProcessPass(lock);
+                m_outputOffset = 0;
+                if (!m_master)
+                    return;
+            }
+
+            const UINT32 count = min(frames - written, m_quantum - m_outputOffset);
+            memcpy(buffer + written * channels, m_output.data() + m_outputOffset * channels, count * channels * sizeof(FLOAT));
+            written += count;
+            m_outputOffset += count;
+        }
+    }
+
+    HRESULT SoftwareMixer::QueryInterface(REFIID riid, void** ppvInterface)
+    {
+        if (riid == __uuidof(IXAudio2) || riid == __uuidof(IUnknown))
+        {
+            *ppvInterface = static_cast<IXAudio2*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvInterface = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG SoftwareMixer::AddRef()
+    {
+        return ++m_references;
+    }
+
+    ULONG SoftwareMixer::Release()
+    {
+        ULONG references = --m_references;
+        if (references == 0)
+            delete this;
+        return references;
+    }
+
+    HRESULT SoftwareMixer::RegisterForCallbacks(IXAudio2EngineCallback* pCallback)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (find(m_engineCallbacks.begin(), m_engineCallbacks.end(), pCallback) == m_engineCallbacks.end())
+            m_engineCallbacks.push_back(pCallback);
+        return S_OK;
+    }
+
+    void SoftwareMixer::UnregisterForCallbacks(IXAudio2EngineCallback* pCallback)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_engineCallbacks.erase(remove(m_engineCallbacks.begin(), m_engineCallbacks.end(), pCallback), m_engineCallbacks.end());
+    }
+
+    HRESULT SoftwareMixer::CreateSourceVoice(IXAudio2SourceVoice** ppSourceVoice, const WAVEFORMATEX* pSourceFormat, UINT32 Flags, float MaxFrequencyRatio,
+        IXAudio2VoiceCallback* pCallback, const XAUDIO2_VOICE_SENDS* pSendList, const XAUDIO2_EFFECT_CHAIN* pEffectChain)
+    {
+        // Only the format of the banks is mixed
+        if (pSourceFormat->wFormatTag != WAVE_FORMAT_IEEE_FLOAT || pSourceFormat->wBitsPerSample != 32 || pSourceFormat->nChannels == 0)
+            return E_INVALIDARG;
+
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_master)
+            return XAUDIO2_E_INVALID_CALL;
+
+        MixSourceVoice* voice = new MixSourceVoice(this, pSourceFormat, Flags, MaxFrequencyRatio, pCallback);
+        HRESULT hr = SetOutputs(voice, pSendList);
+        if (SUCCEEDED(hr))
+            hr = LockEffects(voice, pEffectChain);
+        if (FAILED(hr))
+        {
+            delete voice;
+            return hr;
+        }
+
+        m_sources.push_back(voice);
+        *ppSourceVoice = voice;
+        return S_OK;
+    }
+
+    HRESULT SoftwareMixer::CreateSubmixVoice(IXAudio2SubmixVoice** ppSubmixVoice, UINT32 InputChannels, UINT32 InputSampleRate, UINT32 Flags, UINT32 ProcessingStage,
+        const XAUDIO2_VOICE_SENDS* pSendList, const XAUDIO2_EFFECT_CHAIN* pEffectChain)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        // Submix voices are not resampled
+        if (!m_master || InputChannels == 0 || (InputSampleRate != XAUDIO2_DEFAULT_SAMPLERATE && InputSampleRate != m_sampleRate))
+            return XAUDIO2_E_INVALID_CALL;
+
+        MixSubmixVoice* voice = new MixSubmixVoice(this, InputChannels, m_sampleRate, Flags, ProcessingStage);
+        auto position = upper_bound(m_submixes.begin(), m_submixes.end(), ProcessingStage,
+            [](const UINT32 stage, const MixNode* node) { return stage < node->m_stage; });
+        m_submixes.insert(position, voice);
+
+        HRESULT hr = SetOutputs(voice, pSendList);
+        if (SUCCEEDED(hr))
+            hr = LockEffects(voice, pEffectChain);
+        if (FAILED(hr))
+        {
+            DeleteNode(voice);
+            return hr;
+        }
+
+        *ppSubmixVoice = voice;
+        return S_OK;
+    }
+
+    HRESULT SoftwareMixer::CreateMasteringVoice(IXAudio2MasteringVoice** ppMasteringVoice, UINT32 InputChannels, UINT32 InputSampleRate, UINT32 Flags,
+        LPCWSTR szDeviceId, const XAUDIO2_EFFECT_CHAIN* pEffectChain, AUDIO_STREAM_CATEGORY StreamCategory)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_master)
+            return XAUDIO2_E_INVALID_CALL;
+
+        // There is no device to ask, stereo at 48kHz by default
+        const UINT32 channels = InputChannels != XAUDIO2_DEFAULT_CHANNELS ? InputChannels : 2;
+        m_sampleRate = InputSampleRate != XAUDIO2_DEFAULT_SAMPLERATE ? InputSampleRate : 48000;
+        m_quantum = m_sampleRate / 100;
+        m_output.assign(m_quantum * channels, 0.0f);
+        m_outputOffset = m_quantum;
+
+        MixMasteringVoice* voice = new MixMasteringVoice(this, channels, m_sampleRate);
+        HRESULT hr = LockEffects(voice, pEffectChain);
+        if (FAILED(hr))
+        {
+            delete voice;
+            return hr;
+        }
+
+        m_master = voice;
+        *ppMasteringVoice = voice;
+        return S_OK;
+    }
+
+    HRESULT SoftwareMixer::StartEngine()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = true;
+        return S_OK;
+    }
+
+    void SoftwareMixer::StopEngine()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    HRESULT SoftwareMixer::CommitChanges(UINT32 OperationSet)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        // XAUDIO2_COMMIT_ALL applies every pending operation
+        size_t kept = 0;
+        for (size_t i = 0; i < m_operations.size(); i++)
+        {
+            Operation& operation = m_operations[i];
+            if (OperationSet == XAUDIO2_COMMIT_ALL || operation.set == OperationSet)
+                operation.voice->m_running = operation.start;
+            else
+                m_operations[kept++] = operation;
+        }
+        m_operations.resize(kept);
+        return S_OK;
+    }
+
+    void SoftwareMixer::GetPerformanceData(XAUDIO2_PERFORMANCE_DATA* pPerfData)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        *pPerfData = { 0 };
+        for (MixSourceVoice* voice : m_sources)
+        {
+            if (voice->m_running)
+                pPerfData->ActiveSourceVoiceCount++;
+        }
+        pPerfData->TotalSourceVoiceCount = (UINT32)m_sources.size();
+        pPerfData->ActiveSubmixVoiceCount = (UINT32)m_submixes.size();
+        pPerfData->CurrentLatencyInSamples = m_quantum;
+    }
+
+    void SoftwareMixer::SetDebugConfiguration(const XAUDIO2_DEBUG_CONFIGURATION* pDebugConfiguration, void* pReserved)
+    {
+    }
+}
@@ -0,0 +1,298 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+#include <xapo.h>
+
+namespace SaXAudio
+{
+    class SoftwareMixer;
+
+    // State and processing shared by the source, submix and mastering voices of the software mixer
+    class MixNode
+    {
+        friend class SoftwareMixer;
+    protected:
+        struct Output
+        {
+            MixNode* node;
+            vector<FLOAT> matrix;   // Level of source channel s in destination channel d at [d * channels + s]
+        };
+
+        struct Effect
+        {
+            IXAPO* xapo;
+            IXAPOParameters* parameters;
+            BOOL enabled;
+            BOOL inPlace;
+        };
+
+        SoftwareMixer* m_mixer;
+        IXAudio2Voice* m_voice;
+        UINT32 m_channels;
+        UINT32 m_sampleRate;
+        UINT32 m_flags;
+        UINT32 m_stage;
+        BOOL m_destroyed = false;
+
+        FLOAT m_volume = 1.0f;
+        vector<FLOAT> m_channelVolumes;
+        XAUDIO2_FILTER_PARAMETERS m_filter = { LowPassFilter, XAUDIO2_DEFAULT_FILTER_FREQUENCY, XAUDIO2_DEFAULT_FILTER_ONEOVERQ };
+        vector<FLOAT> m_filterState;
+        vector<Effect> m_effects;
+        vector<Output> m_outputs;
+
+        // Input of the pass, the audio ends in m_data after the effects which may swap it with m_scratch
+        vector<FLOAT> m_buffer;
+        vector<FLOAT> m_scratch;
+        FLOAT* m_data = nullptr;
+        BOOL m_silent = true;
+
+        MixNode(SoftwareMixer* mixer, IXAudio2Voice* voice, const UINT32 channels, const UINT32 sampleRate, const UINT32 flags, const UINT32 stage);
+        virtual ~MixNode();
+
+        /// <summary>
+        /// Filter, effects and volume on the input of the pass, the result is in m_data
+        /// </summary>
+        void Process(const UINT32 frames);
+        /// <summary>
+        /// Add the result of Process to the inputs of the outputs
+        /// </summary>
+        void Mix(const UINT32 frames);
+
+        void ReleaseEffects();
+        Output* FindOutput(IXAudio2Voice* voice);
+
+    public:
+        void GetVoiceDetails(XAUDIO2_VOICE_DETAILS* pVoiceDetails);
+        HRESULT SetOutputVoices(const XAUDIO2_VOICE_SENDS* pSendList);
+        HRESULT SetEffectChain(const XAUDIO2_EFFECT_CHAIN* pEffectChain);
+        HRESULT EnableEffect(UINT32 EffectIndex, UINT32 OperationSet);
+        HRESULT DisableEffect(UINT32 EffectIndex, UINT32 OperationSet);
+        void GetEffectState(UINT32 EffectIndex, BOOL* pEnabled);
+        HRESULT SetEffectParameters(UINT32 EffectIndex, const void* pParameters, UINT32 ParametersByteSize, UINT32 OperationSet);
+        HRESULT GetEffectParameters(UINT32 EffectIndex, void* pParameters, UINT32 ParametersByteSize);
+        HRESULT SetFilterParameters(const XAUDIO2_FILTER_PARAMETERS* pParameters, UINT32 OperationSet);
+        void GetFilterParameters(XAUDIO2_FILTER_PARAMETERS* pParameters);
+        HRESULT SetVolume(float Volume, UINT32 OperationSet);
+        void GetVolume(float* pVolume);
+        HRESULT SetChannelVolumes(UINT32 Channels, const float* pVolumes, UINT32 OperationSet);
+        void GetChannelVolumes(UINT32 Channels, float* pVolumes);
+        HRESULT SetOutputMatrix(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, const float* pLevelMatrix, UINT32 OperationSet);
+        void GetOutputMatrix(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, float* pLevelMatrix);
+        void DestroyVoice();
+    };
+
+    // Implements the voice interface of XAudio2 on a MixNode, the filters on sends are not supported
+    template<class Interface>
+    class MixVoice : public Interface, public MixNode
+    {
+    public:
+        MixVoice(SoftwareMixer* mixer, const UINT32 channels, const UINT32 sampleRate, const UINT32 flags, const UINT32 stage)
+            : MixNode(mixer, this, channels, sampleRate, flags, stage) {}
+
+        STDMETHOD_(void, GetVoiceDetails)(XAUDIO2_VOICE_DETAILS* pVoiceDetails) override { MixNode::GetVoiceDetails(pVoiceDetails); }
+        STDMETHOD(SetOutputVoices)(const XAUDIO2_VOICE_SENDS* pSendList) override { return MixNode::SetOutputVoices(pSendList); }
+        STDMETHOD(SetEffectChain)(const XAUDIO2_EFFECT_CHAIN* pEffectChain) override { return MixNode::SetEffectChain(pEffectChain); }
+        STDMETHOD(EnableEffect)(UINT32 EffectIndex, UINT32 OperationSet) override { return MixNode::EnableEffect(EffectIndex, OperationSet); }
+        STDMETHOD(DisableEffect)(UINT32 EffectIndex, UINT32 OperationSet) override { return MixNode::DisableEffect(EffectIndex, OperationSet); }
+        STDMETHOD_(void, GetEffectState)(UINT32 EffectIndex, BOOL* pEnabled) override { MixNode::GetEffectState(EffectIndex, pEnabled); }
+        STDMETHOD(SetEffectParameters)(UINT32 EffectIndex, const void* pParameters, UINT32 ParametersByteSize, UINT32 OperationSet) override
+        {
+            return MixNode::SetEffectParameters(EffectIndex, pParameters, ParametersByteSize, OperationSet);
+        }
+        STDMETHOD(GetEffectParameters)(UINT32 EffectIndex, void* pParameters, UINT32 ParametersByteSize) override
+        {
+            return MixNode::GetEffectParameters(EffectIndex, pParameters, ParametersByteSize);
+        }
+        STDMETHOD(SetFilterParameters)(const XAUDIO2_FILTER_PARAMETERS* pParameters, UINT32 OperationSet) override { return MixNode::SetFilterParameters(pParameters, OperationSet); }
+        STDMETHOD_(void, GetFilterParameters)(XAUDIO2_FILTER_PARAMETERS* pParameters) override { MixNode::GetFilterParameters(pParameters); }
+        STDMETHOD(SetOutputFilterParameters)(IXAudio2Voice*, const XAUDIO2_FILTER_PARAMETERS*, UINT32) override { return XAUDIO2_E_INVALID_CALL; }
+        STDMETHOD_(void, GetOutputFilterParameters)(IXAudio2Voice*, XAUDIO2_FILTER_PARAMETERS* pParameters) override { MixNode::GetFilterParameters(pParameters); }
+        STDMETHOD(SetVolume)(float Volume, UINT32 OperationSet) override { return MixNode::SetVolume(Volume, OperationSet); }
+        STDMETHOD_(void, GetVolume)(float* pVolume) override { MixNode::GetVolume(pVolume); }
+        STDMETHOD(SetChannelVolumes)(UINT32 Channels, const float* pVolumes, UINT32 OperationSet) override { return MixNode::SetChannelVolumes(Channels, pVolumes, OperationSet); }
+        STDMETHOD_(void, GetChannelVolumes)(UINT32 Channels, float* pVolumes) override { MixNode::GetChannelVolumes(Channels, pVolumes); }
+        STDMETHOD(SetOutputMatrix)(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, const float* pLevelMatrix, UINT32 OperationSet) override
+        {
+            return MixNode::SetOutputMatrix(pDestinationVoice, SourceChannels, DestinationChannels, pLevelMatrix, OperationSet);
+        }
+        STDMETHOD_(void, GetOutputMatrix)(IXAudio2Voice* pDestinationVoice, UINT32 SourceChannels, UINT32 DestinationChannels, float* pLevelMatrix) override
+        {
+            MixNode::GetOutputMatrix(pDestinationVoice, SourceChannels, DestinationChannels, pLevelMatrix);
+        }
+        STDMETHOD_(void, DestroyVoice)() override { MixNode::DestroyVoice(); }
+    };
+
+    class MixSourceVoice : public MixVoice<IXAudio2SourceVoice>
+    {
+        friend class SoftwareMixer;
+    private:
+        struct QueuedBuffer
+        {
+            XAUDIO2_BUFFER buffer;
+            UINT32 position;
+            UINT32 end;
+            UINT32 loopEnd;
+            BOOL started;
+        };
+
+        enum EventType
+        {
+            EVENT_BUFFER_START,
+            EVENT_BUFFER_END,
+            EVENT_LOOP_END,
+            EVENT_STREAM_END
+        };
+
+        struct Event
+        {
+            EventType type;
+            void* context;
+        };
+
+        IXAudio2VoiceCallback* m_callback;
+        UINT32 m_blockAlign;
+        FLOAT m_maxRatio;
+        FLOAT m_ratio = 1.0f;
+        BOOL m_running = false;
+        UINT64 m_samplesPlayed = 0;
+        deque<QueuedBuffer> m_queue;
+
+        // Linear interpolation between the last two frames read, m_fraction is the position between them
+        vector<FLOAT> m_previous;
+        vector<FLOAT> m_current;
+        double m_fraction = 1.0;
+
+        // Callbacks are made by the mixer once it unlocked, never while a voice is processed
+        vector<Event> m_events;
+
+        BOOL ReadFrame();
+        void Render(const UINT32 frames);
+        void DispatchEvents(vector<Event>& events);
+
+    public:
+        MixSourceVoice(SoftwareMixer* mixer, const WAVEFORMATEX* format, const UINT32 flags, const FLOAT maxRatio, IXAudio2VoiceCallback* callback);
+
+        STDMETHOD(Start)(UINT32 Flags, UINT32 OperationSet) override;
+        STDMETHOD(Stop)(UINT32 Flags, UINT32 OperationSet) override;
+        STDMETHOD(SubmitSourceBuffer)(const XAUDIO2_BUFFER* pBuffer, const XAUDIO2_BUFFER_WMA* pBufferWMA) override;
+        STDMETHOD(FlushSourceBuffers)() override;
+        STDMETHOD(Discontinuity)() override;
+        STDMETHOD(ExitLoop)(UINT32 OperationSet) override;
+        STDMETHOD_(void, GetState)(XAUDIO2_VOICE_STATE* pVoiceState, UINT32 Flags) override;
+        STDMETHOD(SetFrequencyRatio)(float Ratio, UINT32 OperationSet) override;
+        STDMETHOD_(void, GetFrequencyRatio)(float* pRatio) override;
+        STDMETHOD(SetSourceSampleRate)(UINT32 NewSourceSampleRate) override;
+    };
+
+    class MixSubmixVoice : public MixVoice<IXAudio2SubmixVoice>
+    {
+    public:
+        MixSubmixVoice(SoftwareMixer* mixer, const UINT32 channels, const UINT32 sampleRate, const UINT32 flags, const UINT32 stage)
+            : MixVoice(mixer, channels, sampleRate, flags, stage) {}
+    };
+
+    class MixMasteringVoice : public MixVoice<IXAudio2MasteringVoice>
+    {
+    public:
+        MixMasteringVoice(SoftwareMixer* mixer, const UINT32 channels, const UINT32 sampleRate)
+            : MixVoice(mixer, channels, sampleRate, 0, 0) {}
+
+        STDMETHOD(GetChannelMask)(DWORD* pChannelmask) override;
+    };
+
+    /// <summary>
+    /// Engine mixing in software what XAudio2 would send to the audio device
+    /// It runs the same voices, buffers, effects and callbacks and renders into a buffer given by the caller
+    /// Source voices must be 32-bit float, submix voices must use the sample rate of the mastering voice
+    /// </summary>
+    class SoftwareMixer : public IXAudio2
+    {
+        friend class MixNode;
+        friend class MixSourceVoice;
+    private:
+        struct Operation
+        {
+            UINT32 set;
+            MixSourceVoice* voice;
+            BOOL start;
+        };
+
+        atomic<ULONG> m_references = 1;
+
+        // Held while the voices change or a pass is processed, released for the callbacks
+        mutex m_mutex;
+        BOOL m_rendering = false;
+        BOOL m_running = true;
+
+        MixMasteringVoice* m_master = nullptr;
+        vector<MixSourceVoice*> m_sources;
+        vector<MixNode*> m_submixes;    // Ordered by processing stage
+        vector<MixNode*> m_destroyed;   // Destroyed during a pass, deleted once it ends
+        vector<IXAudio2EngineCallback*> m_engineCallbacks;
+        vector<Operation> m_operations;
+
+        UINT32 m_sampleRate = 0;
+        UINT32 m_quantum = 0;
+        vector<FLOAT> m_output;
+        UINT32 m_outputOffset = 0;
+
+        MixNode* FindNode(IXAudio2Voice* voice);
+        HRESULT SetOutputs(MixNode* node, const XAUDIO2_VOICE_SENDS* sends);
+        HRESULT LockEffects(MixNode* node, const XAUDIO2_EFFECT_CHAIN* chain);
+        void DestroyNode(MixNode* node);
+        void DeleteNode(MixNode* node);
+        void ProcessPass(unique_lock<mutex>& lock);
+
+    public:
+        ~SoftwareMixer();
+
+        /// <summary>
+        /// Process as many passes as needed to fill the buffer, from one thread at a time
+        /// </summary>
+        /// <param name="buffer">Receives frames of interleaved samples, one per channel of the mastering voice</param>
+        /// <param name="frames">The number of frames to render</param>
+        void Render(FLOAT* buffer, const UINT32 frames);
+
+        STDMETHOD(QueryInterface)(REFIID riid, void** ppvInterface) override;
+        STDMETHOD_(ULONG, AddRef)() override;
+        STDMETHOD_(ULONG, Release)() override;
+
+        STDMETHOD(RegisterForCallbacks)(IXAudio2EngineCallback* pCallback) override;
+        STDMETHOD_(void, UnregisterForCallbacks)(IXAudio2EngineCallback* pCallback) override;
+        STDMETHOD(CreateSourceVoice)(IXAudio2SourceVoice** ppSourceVoice, const WAVEFORMATEX* pSourceFormat, UINT32 Flags, float MaxFrequencyRatio,
+            IXAudio2VoiceCallback* pCallback, const XAUDIO2_VOICE_SENDS* pSendList, const XAUDIO2_EFFECT_CHAIN* pEffectChain) override;
+        STDMETHOD(CreateSubmixVoice)(IXAudio2SubmixVoice** ppSubmixVoice, UINT32 InputChannels, UINT32 InputSampleRate, UINT32 Flags, UINT32 ProcessingStage,
+            const XAUDIO2_VOICE_SENDS* pSendList, const XAUDIO2_EFFECT_CHAIN* pEffectChain) override;
+        STDMETHOD(CreateMasteringVoice)(IXAudio2MasteringVoice** ppMasteringVoice, UINT32 InputChannels, UINT32 InputSampleRate, UINT32 Flags,
+            LPCWSTR szDeviceId, const XAUDIO2_EFFECT_CHAIN* pEffectChain, AUDIO_STREAM_CATEGORY StreamCategory) override;
+        STDMETHOD(StartEngine)() override;
+        STDMETHOD_(void, StopEngine)() override;
+        STDMETHOD(CommitChanges)(UINT32 OperationSet) override;
+        STDMETHOD_(void, GetPerformanceData)(XAUDIO2_PERFORMANCE_DATA* pPerfData) override;
+        STDMETHOD_(void, SetDebugConfiguration)(const XAUDIO2_DEBUG_CONFIGURATION* pDebugConfiguration, void* pReserved) override;
+    };
+}
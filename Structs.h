@@ -23,15 +23,38 @@
 #pragma once
 
 #include "Includes.h"
+#include "Dsp.h"
 
 namespace SaXAudio
 {
     typedef void (*OnDecodedCallback)(INT32 bankID, const BYTE* buffer);
 
+    class AudioVoice;
+    class ConvolutionReverb;
+    class Compressor;
+    class Limiter;
+    struct VoiceList;
+
+    // Intrusive link stored in the voice, protected by the voice mutex
+    struct VoiceLink
+    {
+        AudioVoice* prev = nullptr;
+        AudioVoice* next = nullptr;
+        VoiceList* list = nullptr;
+    };
+
+    // List of voices ordered from oldest to newest
+    struct VoiceList
+    {
+        AudioVoice* head = nullptr;
+        AudioVoice* tail = nullptr;
+        atomic<UINT32> count = 0;
+    };
+
     struct EffectData
     {
         XAUDIO2_EFFECT_CHAIN effectChain = { 0 };
-        XAUDIO2_EFFECT_DESCRIPTOR descriptors[3] = { 0 };
+        XAUDIO2_EFFECT_DESCRIPTOR descriptors[7] = { 0 };    // Buses also get a convolution reverb, dynamics and a volume meter
         XAUDIO2FX_REVERB_PARAMETERS reverb = { 0 };
         FXEQ_PARAMETERS eq = {
             FXEQ_DEFAULT_FREQUENCY_CENTER_0,
@@ -48,12 +71,88 @@ namespace SaXAudio
             FXEQ_DEFAULT_BANDWIDTH
         };
         FXECHO_PARAMETERS echo = { 0 };
+
+        // The echo comes from a pool while it is used, an EmptyEffect holds its place otherwise
+        IUnknown* echoEffect = nullptr;
+        IUnknown* echoPlaceholder = nullptr;
+        FLOAT echoMaxDelay = 0;         // In ms, 0 for ECHO_MAX_DELAY, used the next time an echo is attached
+        UINT32 echoEffectDelay = 0;     // Max delay of the attached echo
+
+        // Native filter of the voice, cutoff in Hz and 0 while the filter is off
+        XAUDIO2_FILTER_TYPE filterType = LowPassFilter;
+        FLOAT filterCutoff = 0;
+        FLOAT filterQ = 1.0f;
+        UINT32 filterFadeID = 0;
+
+        // Effects changed by a fade and not committed yet, one bit per chain index
+        UINT32 dirtyEffects = 0;
+        UINT32 nextCommit = 0;
+
+        // Buses only, the effect of the chain and the bank of its impulse response
+        ConvolutionReverb* convolution = nullptr;
+        INT32 convolutionBankID = 0;
+        // The engine of another bank being built off the control thread, see BuildConvolution
+        INT32 convolutionPendingBankID = 0;
+        UINT32 convolutionTicket = 0;
+        FLOAT convolutionWetDryMix = 0;
+
+        // Buses only, the compressor follows the level of the sidechain bus if not 0
+        Compressor* compressorEffect = nullptr;
+        Limiter* limiterEffect = nullptr;
+        CompressorParameters compressor;
+        LimiterParameters limiter;
+        INT32 sidechainBusID = 0;
     };
 
     struct BusData : EffectData
     {
         IXAudio2Voice* voice = nullptr;
         UINT32 fadeID = 0;
+        FLOAT volume = 1.0f;
+
+        // The bus this one outputs to, 0 for the mastering voice
+        INT32 parentID = 0;
+        UINT32 depth = 0;
+
+        VoiceList voices;
+    };
+
+    // What CreateVoice does when a bank reached its maximum number of instances
+    enum StealPolicy : UINT32
+    {
+        STEAL_REJECT = 0,   // The new voice is not created
+        STEAL_OLDEST = 1,   // The oldest voice is stopped
+        STEAL_QUIETEST = 2  // The voice with the lowest volume is stopped
+    };
+
+    // Extra output of a voice, many voices can feed the effects of a single bus
+    struct VoiceSend
+    {
+        INT32 busID = 0;    // 0 for the mastering voice
+        IXAudio2Voice* voice = nullptr;
+        FLOAT level = 0;    // Scales the output matrix to that bus
+    };
+
+    // A voice waiting for the engine to reach a sample time
+    struct ScheduledStart
+    {
+        INT32 voiceID = 0;
+        UINT64 engineTime = 0;
+    };
+
+    // The samples of a bank copied by SetConvolutionReverb, the bank can be removed right after
+    struct ImpulseResponse
+    {
+        vector<FLOAT> samples;
+        UINT32 channels = 0;
+        UINT32 sampleRate = 0;
+    };
+
+    // A voice started before its bank decoded the first samples it plays
+    struct DecodingWait
+    {
+        INT32 voiceID = 0;
+        chrono::steady_clock::time_point since;
     };
 
     struct Buffer
@@ -77,8 +176,45 @@ namespace SaXAudio
         UINT32 sampleRate = 0;
         UINT32 totalSamples = 0;
 
+        VoiceList voices;
+
+        // Polyphony limits, protected by the bank mutex
+        UINT32 maxInstances = 0;    // 0 for no limit
+        FLOAT cooldown = 0;         // Minimum time in seconds between two voices
+        StealPolicy stealPolicy = STEAL_REJECT;
+        chrono::steady_clock::time_point lastCreated;
+        BOOL hasCreated = false;    // Offline the clock starts at 0, lastCreated means nothing before the first voice
+
+        atomic<UINT32> rejectedCount = 0;
+        atomic<UINT32> stolenCount = 0;
+
+        // Measured when the bank is added if the analysis is enabled, or restored with BankSetLoudness
+        BOOL analyzed = false;
+        FLOAT loudness = 0;     // Integrated loudness in LUFS
+        FLOAT truePeak = 0;     // Linear
+
         atomic<UINT32> decodedSamples = 0;
         mutex decodingMutex;
         condition_variable decodingPerform;
     };
+
+    // WAV file header structures
+#pragma pack(push, 1)
+    struct WavHeader
+    {
+        char riff[4];           // "RIFF"
+        UINT32 fileSize;        // File size - 8
+        char wave[4];           // "WAVE"
+        char fmt[4];            // "fmt "
+        UINT32 fmtSize;         // Format chunk size
+        UINT16 audioFormat;     // Audio format (WAVE_FORMAT_IEEE_FLOAT)
+        UINT16 channels;        // Number of channels
+        UINT32 sampleRate;      // Sample rate
+        UINT32 byteRate;        // Byte rate (nSamplesPerSec * nBlockAlign)
+        UINT16 blockAlign;      // Block alignment (nChannels * wBitsPerSample / 8)
+        UINT16 bitsPerSample;   // Bits per sample (32 for IEEE float)
+        char data[4];           // "data"
+        UINT32 dataSize;        // Data chunk size
+    };
+#pragma pack(pop)
 }
\ No newline at end of file
@@ -0,0 +1,237 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+#include "Headless.h"
+
+namespace SaXAudio
+{
+    // The commands are applied in order by the next control tick, the getters then see their result
+    static void TestQueuedCommands()
+    {
+        INT32 bankID = Test::AddSineBank(2, 48000, 48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+
+        SetVolume(voiceID, 0.5f);
+        SetSpeed(voiceID, 1.5f);
+        SetPanning(voiceID, -0.25f);
+        SetLoopPoints(voiceID, 100, 20000);
+        SetLooping(voiceID, true);
+        CHECK(StartAtSample(voiceID, 1000));
+        Advance(0.01f);
+
+        CHECK(GetVolume(voiceID) == 0.5f);
+        CHECK(GetSpeed(voiceID) == 1.5f);
+        CHECK(GetPanning(voiceID) == -0.25f);
+        CHECK(GetLoopStart(voiceID) == 100 && GetLoopEnd(voiceID) == 20000);
+        CHECK(GetLooping(voiceID));
+        CHECK(GetPositionSample(voiceID) >= 1000);
+
+        // The positions are those of the end of the last pass
+        UINT32 position = GetPositionSample(voiceID);
+        Advance(0.1f);
+        CHECK(GetPositionSample(voiceID) > position + 4800);
+
+        CHECK(Pause(voiceID, 0));
+        CHECK(Pause(voiceID, 0));
+        Advance(0.01f);
+        CHECK(GetPauseStack(voiceID) == 2);
+        CHECK(Resume(voiceID, 0));
+        Advance(0.01f);
+        CHECK(GetPauseStack(voiceID) == 1);
+
+        CHECK(Stop(voiceID, 0));
+        Advance(0.05f);
+        CHECK(!VoiceExist(voiceID));
+        CHECK(!Start(voiceID));
+        CHECK(!Pause(voiceID, 0));
+        CHECK(GetVolume(voiceID) == 1.0f);
+    }
+
+    // CreateVoice only reserves the voiceID, the commands posted before the voice exists follow its creation
+    static void TestReservedVoices()
+    {
+        CHECK(CreateVoice(-1, 0, true) == 0);
+
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceID = CreateVoice(bankID, 0, false);
+        CHECK(VoiceExist(voiceID));
+        CHECK(GetPositionSample(voiceID) == 0);
+        SetVolume(voiceID, 0.5f);
+        CHECK(Pause(voiceID, 0));
+        Advance(0.01f);
+        CHECK(GetVolume(voiceID) == 0.5f);
+        CHECK(GetPauseStack(voiceID) == 1);
+        Stop(voiceID, 0);
+
+        PlaybackSegment segments[] = { { 24000, 0, 0 } };
+        voiceID = CreateVoice(bankID, 0, true);
+        CHECK(StartSegments(voiceID, segments, 1));
+        Advance(0.01f);
+        CHECK(GetPositionSample(voiceID) >= 24000);
+        Stop(voiceID, 0);
+        Advance(0.02f);
+
+        // Rejected by the limits, the slot goes back to the pool
+        BankSetLimits(bankID, 1, 0, STEAL_REJECT);
+        INT32 firstID = CreateVoice(bankID, 0, true);
+        INT32 rejectedID = CreateVoice(bankID, 0, true);
+        CHECK(rejectedID > 0);
+        Advance(0.01f);
+        CHECK(VoiceExist(firstID));
+        CHECK(!VoiceExist(rejectedID));
+        CHECK(!Start(rejectedID));
+        Stop(firstID, 0);
+        BankSetLimits(bankID, 0, 0, STEAL_REJECT);
+        Advance(0.02f);
+    }
+
+    // The starts of a group are held in one operation set, the voices begin on the same sample
+    static void TestQueuedGroup()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceIDs[3] = { CreateVoice(bankID, 0, true), CreateVoice(bankID, 0, true), 0 };
+        Advance(0.01f);
+        voiceIDs[2] = CreateVoice(bankID, 0, true);
+
+        CHECK(StartGroup(voiceIDs, 3) == 3);
+        CHECK(GetPositionSample(voiceIDs[0]) == 0);
+        Advance(0.05f);
+        UINT32 position = GetPositionSample(voiceIDs[0]);
+        CHECK(position > 0);
+        CHECK(GetPositionSample(voiceIDs[1]) == position);
+        CHECK(GetPositionSample(voiceIDs[2]) == position);
+
+        INT32 missing[2] = { voiceIDs[0] + MAX_VOICES, 0 };
+        CHECK(StartGroup(missing, 2) == 0);
+        for (INT32 voiceID : voiceIDs)
+            Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    // Scheduled through the queue as well, also usable in a batch
+    static void TestQueuedSchedule()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        CHECK(StartAtEngineTime(voiceID, GetEngineTime() + 4800));
+        Advance(0.05f);
+        CHECK(GetPositionSample(voiceID) == 0);
+        Advance(0.1f);
+        CHECK(GetPositionSample(voiceID) > 0);
+        Stop(voiceID, 0);
+
+        UINT64 engineTime = GetEngineTime() + 0x100000000ull;
+        Command commands[2] = {
+            { COMMAND_CREATE_VOICE, bankID, 0, 1, 0, 0 },
+            { COMMAND_START_AT_ENGINE_TIME, -1, (INT32)(UINT32)engineTime, (INT32)(UINT32)(engineTime >> 32), 0, 0 },
+        };
+        CommandResult results[2];
+        ExecuteCommands(commands, 2, results);
+        CHECK(results[0].success && results[1].success);
+        Advance(0.05f);
+        CHECK(GetPositionSample(results[0].value) == 0);
+        Stop(results[0].value, 0);
+        Advance(0.02f);
+    }
+
+    // The getters and the queued commands don't wait on the control lock
+    static void TestNoBlocking()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        INT32 busID = CreateBus(0);
+        INT32 createdID = 0;
+        INT32 groupID = 0;
+        BOOL compressorSet = false;
+        BOOL limiterSet = false;
+
+        XAUDIO2FX_REVERB_PARAMETERS reverb = {};
+        reverb.WetDryMix = 50.0f;
+        const UINT32 reverbSets = Headless::ReverbParameterCount;
+
+        atomic<BOOL> done = false;
+        auto control = SaXAudio::Instance.AcquireControl();
+        thread caller([&]
+            {
+                SetVolume(voiceID, 0.25f);
+                Start(voiceID);
+                GetVolume(voiceID);
+                GetPositionTime(voiceID);
+                GetMasterVolume();
+                Pause(voiceID, 0);
+                SetReverb(voiceID, reverb, 0.0f);
+                SetFilter(voiceID, LowPassFilter, 1000.0f);
+
+                createdID = CreateVoice(bankID, busID, false);
+                groupID = CreateVoice(bankID, 0, true);
+                StartGroup(&groupID, 1);
+                PlaybackSegment segment = { 0, 0, 0 };
+                StartSegments(createdID, &segment, 1);
+                compressorSet = SetCompressor(busID, CompressorParameters());
+                limiterSet = SetLimiter(busID, LimiterParameters());
+                done = true;
+            });
+
+        auto start = chrono::steady_clock::now();
+        while (!done && chrono::steady_clock::now() - start < chrono::seconds(2))
+            this_thread::sleep_for(chrono::milliseconds(1));
+        CHECK(done);
+        control.unlock();
+        caller.join();
+
+        Advance(0.01f);
+        CHECK(GetVolume(voiceID) == 0.25f);
+        CHECK(GetPauseStack(voiceID) == 1);
+        CHECK(Headless::ReverbParameterCount > reverbSets);
+        CHECK(GetPositionSample(createdID) > 0);
+        CHECK(GetPositionSample(groupID) > 0);
+        CHECK(compressorSet && limiterSet);
+        // The compressor and the limiter are the effects 4 and 5 of a bus chain
+        BusData* bus = SaXAudio::Instance.GetBus(busID);
+        CHECK(bus && bus->descriptors[4].InitialState && bus->descriptors[5].InitialState);
+        CHECK(!SetCompressor(busID, CompressorParameters(), busID));
+        CHECK(!SetLimiter(busID + 100, LimiterParameters()));
+        Stop(voiceID, 0);
+        Stop(createdID, 0);
+        Stop(groupID, 0);
+        RemoveBus(busID);
+        Advance(0.02f);
+    }
+
+    void RunCommandTests()
+    {
+        CreateOffline(2, 48000);
+        TestQueuedCommands();
+        TestReservedVoices();
+        TestQueuedGroup();
+        TestQueuedSchedule();
+        TestNoBlocking();
+        Release();
+    }
+}
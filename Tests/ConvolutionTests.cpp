@@ -0,0 +1,275 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+#include "Dsp.h"
+
+namespace SaXAudio
+{
+    static vector<FLOAT> MakeNoise(const UINT32 count, const UINT32 seed)
+    {
+        mt19937 random(seed);
+        uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+        vector<FLOAT> samples(count);
+        for (FLOAT& sample : samples)
+            sample = distribution(random);
+        return samples;
+    }
+
+    static void TestFFT()
+    {
+        // Inverse(Forward(x)) is x times the size
+        FFT fft;
+        fft.Init(1024);
+        vector<FLOAT> re = MakeNoise(1024, 1);
+        vector<FLOAT> im(1024, 0.0f);
+        vector<FLOAT> original = re;
+        fft.Forward(re.data(), im.data());
+
+        // The first bin is the sum
+        double sum = 0;
+        for (FLOAT sample : original)
+            sum += sample;
+        CHECK_NEAR(re[0], sum, 1e-3);
+        CHECK_NEAR(im[0], 0.0f, 1e-3);
+
+        fft.Inverse(re.data(), im.data());
+        FLOAT error = 0;
+        for (UINT32 i = 0; i < 1024; i++)
+            error = max(error, fabsf(re[i] / 1024 - original[i]));
+        CHECK(error < 1e-5f);
+    }
+
+    // The partitioned convolution gives the direct convolution with the response at unit energy, CONVOLUTION_BLOCK frames later
+    static void TestConvolution(const UINT32 responseFrames, const UINT32 responseChannels, const UINT32 channels)
+    {
+        vector<FLOAT> response = MakeNoise(responseFrames * responseChannels, 2);
+        for (UINT32 i = 0; i < responseFrames; i++)
+        {
+            // Decaying like a reverb
+            for (UINT32 c = 0; c < responseChannels; c++)
+                response[i * responseChannels + c] *= expf(-4.0f * i / responseFrames);
+        }
+
+        double energy = 0;
+        for (FLOAT sample : response)
+            energy += (double)sample * sample;
+        double scale = 1.0 / sqrt(energy / responseChannels);
+
+        const UINT32 frames = 4000;
+        vector<FLOAT> input = MakeNoise(frames * channels, 3);
+        vector<FLOAT> samples = input;
+
+        ConvolutionEngine engine(response.data(), responseFrames, responseChannels, channels);
+        // Fed in passes of 480 frames, not aligned on the blocks
+        for (UINT32 i = 0; i < frames; i += 480)
+            engine.Process(samples.data() + i * channels, min(480u, frames - i), 1.0f, 0.0f);
+
+        double error = 0;
+        double peak = 0;
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            for (UINT32 c = 0; c < channels; c++)
+            {
+                double expected = 0;
+                for (UINT32 k = 0; k < responseFrames && k + CONVOLUTION_BLOCK <= i; k++)
+                    expected += response[k * responseChannels + c % responseChannels] * scale * input[(i - CONVOLUTION_BLOCK - k) * channels + c];
+                error = max(error, fabs(samples[i * channels + c] - expected));
+                peak = max(peak, fabs(expected));
+            }
+        }
+        CHECK(peak > 0.1);
+        CHECK(error < peak * 1e-4);
+    }
+
+    static void TestMix()
+    {
+        vector<FLOAT> response = { 1.0f };
+        ConvolutionEngine engine(response.data(), 1, 1, 2);
+        CHECK(engine.GetChannels() == 2);
+        CHECK(engine.GetTail() == 2 * CONVOLUTION_BLOCK);
+
+        // A unit impulse gives the input back, delayed
+        vector<FLOAT> input = MakeNoise(2000 * 2, 4);
+        vector<FLOAT> samples = input;
+        engine.Process(samples.data(), 2000, 0.25f, 0.75f);
+        FLOAT error = 0;
+        for (UINT32 i = 0; i < 2000 * 2; i++)
+        {
+            FLOAT wet = i >= CONVOLUTION_BLOCK * 2 ? input[i - CONVOLUTION_BLOCK * 2] : 0.0f;
+            error = max(error, fabsf(samples[i] - (0.75f * input[i] + 0.25f * wet)));
+        }
+        CHECK(error < 1e-5f);
+
+        // Nothing carried over after a reset
+        engine.Reset();
+        vector<FLOAT> silence(2000 * 2, 0.0f);
+        engine.Process(silence.data(), 2000, 1.0f, 0.0f);
+        CHECK(*max_element(silence.begin(), silence.end()) == 0.0f && *min_element(silence.begin(), silence.end()) == 0.0f);
+    }
+
+    // Amplitude of a sine resampled from one rate to another, measured away from the edges
+    static FLOAT ResampledAmplitude(const FLOAT frequency, const UINT32 inputRate, const UINT32 outputRate)
+    {
+        vector<FLOAT> input(inputRate / 10);
+        for (UINT32 i = 0; i < input.size(); i++)
+            input[i] = sinf(2.0f * (FLOAT)M_PI * frequency * i / inputRate);
+
+        vector<FLOAT> output;
+        Resample(input.data(), (UINT32)input.size(), 1, inputRate, outputRate, output);
+        CHECK(output.size() == outputRate / 10);
+
+        FLOAT peak = 0;
+        for (size_t i = output.size() / 4; i < output.size() * 3 / 4; i++)
+            peak = max(peak, fabsf(output[i]));
+        return peak;
+    }
+
+    static void TestResample()
+    {
+        CHECK_NEAR(ResampledAmplitude(1000.0f, 96000, 48000), 1.0f, 0.01f);
+        CHECK_NEAR(ResampledAmplitude(1000.0f, 44100, 48000), 1.0f, 0.01f);
+
+        // Above the Nyquist frequency of the output, linear interpolation would fold it back to 18kHz at full level
+        CHECK(ResampledAmplitude(30000.0f, 96000, 48000) < 0.01f);
+
+        // Same rate, a copy
+        vector<FLOAT> input = MakeNoise(100 * 2, 5);
+        vector<FLOAT> output;
+        Resample(input.data(), 100, 2, 48000, 48000, output);
+        CHECK(output == input);
+    }
+
+    // The engine is prepared on its own thread and handed to the bus by a later control tick
+    static BOOL WaitForConvolution(const INT32 busID, const INT32 bankID)
+    {
+        auto start = chrono::steady_clock::now();
+        while (chrono::steady_clock::now() - start < chrono::seconds(10))
+        {
+            Advance(0.01f);
+            BusData* bus = SaXAudio::Instance.GetBus(busID);
+            if (bus && bus->convolutionBankID == bankID && bus->convolutionPendingBankID == 0)
+                return true;
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    // A long response at another rate takes a while, the control ticks go on and the bank can be removed right away
+    static void TestPreparedOffControl()
+    {
+        vector<FLOAT> noise = MakeNoise(96000 * 2 * 2, 6);
+        Buffer buffer = SaXAudio::Instance.GetBuffer((UINT32)noise.size());
+        copy(noise.begin(), noise.end(), buffer.Data);
+        INT32 responseID = SaXAudio::Instance.AddBankData(buffer, 2, 96000, 96000 * 2);
+
+        INT32 busID = CreateBus();
+        CHECK(SetConvolutionReverb(busID, responseID, 100.0f));
+        BankRemove(responseID);
+        CHECK(!SetConvolutionReverb(busID, responseID, 100.0f));
+
+        auto start = chrono::steady_clock::now();
+        Advance(0.01f);
+        CHECK(chrono::steady_clock::now() - start < chrono::milliseconds(100));
+        BusData* bus = SaXAudio::Instance.GetBus(busID);
+        CHECK(bus && bus->convolutionBankID == 0 && bus->convolutionPendingBankID == responseID);
+
+        CHECK(WaitForConvolution(busID, responseID));
+        CHECK(bus->descriptors[3].InitialState);
+
+        // Removed while another bank is prepared, the engine is dropped once built
+        Buffer click = SaXAudio::Instance.GetBuffer(96000);
+        fill(click.Data, click.Data + 96000, 0.0f);
+        INT32 otherID = SaXAudio::Instance.AddBankData(click, 1, 96000, 96000);
+        CHECK(SetConvolutionReverb(busID, otherID, 100.0f));
+        RemoveConvolutionReverb(busID);
+        Advance(0.01f);
+        CHECK(!bus->descriptors[3].InitialState);
+        CHECK(bus->convolutionPendingBankID == 0);
+
+        RemoveBus(busID);
+        Advance(0.02f);
+    }
+
+    // On a bus, the reverb comes out CONVOLUTION_BLOCK frames after the dry sound
+    static void TestBusReverb()
+    {
+        // A single click as impulse response gives a delayed copy
+        Buffer click = SaXAudio::Instance.GetBuffer(480);
+        fill(click.Data, click.Data + 480, 0.0f);
+        click.Data[0] = 1.0f;
+        INT32 responseID = SaXAudio::Instance.AddBankData(click, 1, 48000, 480);
+
+        Buffer pulse = SaXAudio::Instance.GetBuffer(4800);
+        fill(pulse.Data, pulse.Data + 4800, 0.0f);
+        pulse.Data[0] = 0.5f;
+        INT32 bankID = SaXAudio::Instance.AddBankData(pulse, 1, 48000, 4800);
+
+        INT32 busID = CreateBus();
+        CHECK(SetConvolutionReverb(busID, responseID, 50.0f));
+        CHECK(WaitForConvolution(busID, responseID));
+
+        INT32 voiceID = CreateVoice(bankID, busID, true);
+        Start(voiceID);
+        vector<FLOAT> buffer(2400 * 2);
+        Render(buffer.data(), 2400);
+
+        vector<UINT32> heard;
+        for (UINT32 i = 0; i < 2400; i++)
+        {
+            if (fabsf(buffer[i * 2]) > 1e-3f)
+                heard.push_back(i);
+        }
+        CHECK(heard.size() == 2);
+        if (heard.size() == 2)
+        {
+            CHECK(heard[1] - heard[0] == CONVOLUTION_BLOCK);
+            CHECK_NEAR(buffer[heard[0] * 2], 0.25f, 1e-4);
+            CHECK_NEAR(buffer[heard[1] * 2], 0.25f, 1e-4);
+        }
+
+        RemoveConvolutionReverb(busID);
+        RemoveBus(busID);
+        Advance(0.02f);
+    }
+
+    void RunConvolutionTests()
+    {
+        TestFFT();
+        TestConvolution(100, 1, 1);
+        TestConvolution(1300, 2, 2);
+        TestConvolution(2 * CONVOLUTION_BLOCK, 1, 2);
+        TestMix();
+        TestResample();
+
+        CreateOffline(2, 48000);
+        TestBusReverb();
+        TestPreparedOffControl();
+        Release();
+    }
+}
@@ -0,0 +1,246 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+#include "Dsp.h"
+
+namespace SaXAudio
+{
+    static FLOAT ToDb(const FLOAT level)
+    {
+        return 20.0f * log10f(level);
+    }
+
+    static void TestCompressor()
+    {
+        CompressorEngine compressor;
+        compressor.Init(2, 48000);
+        CompressorParameters parameters;
+        parameters.Threshold = -20.0f;
+        parameters.Ratio = 4.0f;
+        parameters.Attack = 10.0f;
+        parameters.Release = 100.0f;
+        compressor.SetParameters(parameters);
+
+        // Under the threshold nothing changes
+        vector<FLOAT> samples(4800 * 2, 0.05f);
+        compressor.Process(samples.data(), 4800, -1.0f);
+        CHECK(samples.back() == 0.05f);
+        CHECK(compressor.GetReduction() == 0.0f);
+
+        // 14dB over the threshold comes out 3.5dB over it once settled
+        const FLOAT level = powf(10.0f, -6.0f / 20.0f);
+        samples.assign(48000 * 2, level);
+        compressor.Process(samples.data(), 48000, -1.0f);
+        CHECK_NEAR(compressor.GetReduction(), -10.5f, 0.01f);
+        CHECK_NEAR(ToDb(samples.back()), -16.5f, 0.01f);
+
+        // The attack covers 63% of the way in its time
+        compressor.Reset();
+        samples.assign(480 * 2, level);
+        compressor.Process(samples.data(), 480, -1.0f);
+        CHECK_NEAR(compressor.GetReduction(), -10.5f * 0.632f, 0.05f);
+
+        // So does the release
+        samples.assign(4800 * 2, 0.0f);
+        FLOAT before = compressor.GetReduction();
+        compressor.Process(samples.data(), 4800, -1.0f);
+        CHECK_NEAR(compressor.GetReduction(), before * 0.368f, 0.05f);
+
+        // The makeup gain is added after the reduction
+        parameters.MakeupGain = 6.0f;
+        compressor.SetParameters(parameters);
+        compressor.Reset();
+        samples.assign(48000 * 2, level);
+        compressor.Process(samples.data(), 48000, -1.0f);
+        CHECK_NEAR(ToDb(samples.back()), -10.5f, 0.01f);
+
+        // A key drives the reduction instead of the samples
+        parameters.MakeupGain = 0;
+        compressor.SetParameters(parameters);
+        compressor.Reset();
+        samples.assign(48000 * 2, 0.01f);
+        compressor.Process(samples.data(), 48000, level);
+        CHECK_NEAR(compressor.GetReduction(), -10.5f, 0.01f);
+
+        // RMS follows the mean square, a sine is 3dB under its peak
+        parameters.RMS = true;
+        compressor.SetParameters(parameters);
+        compressor.Reset();
+        samples.resize(48000 * 2);
+        for (UINT32 i = 0; i < 48000; i++)
+            samples[i * 2] = samples[i * 2 + 1] = sinf(2.0f * 3.14159265f * 1000.0f * i / 48000);
+        compressor.Process(samples.data(), 48000, -1.0f);
+        CHECK_NEAR(compressor.GetReduction(), (-20.0f + 3.01f) * 0.75f, 0.3f);
+    }
+
+    static void TestLimiter()
+    {
+        LimiterEngine limiter;
+        limiter.Init(2, 48000);
+        LimiterParameters parameters;
+        parameters.Ceiling = -1.0f;
+        parameters.Lookahead = 5.0f;
+        parameters.Release = 50.0f;
+        limiter.SetParameters(parameters);
+        CHECK(limiter.GetLatency() == 240);
+
+        // Under the ceiling the samples only get delayed
+        vector<FLOAT> samples(4800 * 2, 0.0f);
+        samples[0] = 0.5f;
+        samples[1] = -0.25f;
+        limiter.Process(samples.data(), 4800);
+        for (UINT32 i = 0; i < 4800; i++)
+        {
+            CHECK(samples[i * 2] == (i == 240 ? 0.5f : 0.0f));
+            CHECK(samples[i * 2 + 1] == (i == 240 ? -0.25f : 0.0f));
+        }
+        CHECK(limiter.GetReduction() == 0.0f);
+
+        // Noise with peaks up to +12dB never goes over the ceiling
+        const FLOAT ceiling = powf(10.0f, -1.0f / 20.0f);
+        mt19937 random(1);
+        uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+        samples.resize(48000 * 2);
+        for (UINT32 i = 0; i < 48000 * 2; i++)
+            samples[i] = distribution(random) * (i % 9600 < 960 ? 4.0f : 0.5f);
+        vector<FLOAT> input = samples;
+        limiter.Process(samples.data(), 48000);
+        FLOAT peak = 0;
+        for (FLOAT sample : samples)
+            peak = max(peak, fabsf(sample));
+        CHECK(peak <= ceiling * 1.0001f);
+        CHECK(peak > ceiling * 0.9f);
+
+        // The channels are linked, a peak on the left lowers the right as much
+        limiter.Reset();
+        samples.assign(48000 * 2, 0.0f);
+        for (UINT32 i = 0; i < 48000; i++)
+        {
+            samples[i * 2] = i == 1000 ? 2.0f : 0.1f;
+            samples[i * 2 + 1] = 0.1f;
+        }
+        limiter.Process(samples.data(), 48000);
+        CHECK_NEAR(samples[1240 * 2], ceiling, 1e-4);
+        CHECK_NEAR(samples[1240 * 2 + 1], 0.1f * ceiling / 2.0f, 1e-5);
+
+        // The gain starts going down one lookahead before the peak comes out
+        CHECK_NEAR(samples[999 * 2 + 1], 0.1f, 1e-6);
+        CHECK(samples[1000 * 2 + 1] < 0.1f);
+        CHECK(samples[1239 * 2 + 1] < samples[1000 * 2 + 1]);
+
+        // And back up after the release
+        CHECK_NEAR(samples[47999 * 2 + 1], 0.1f, 1e-4);
+    }
+
+    static INT32 AddConstantBank(const FLOAT value)
+    {
+        const UINT32 frames = 48000;
+        Buffer buffer = SaXAudio::Instance.GetBuffer(frames);
+        fill(buffer.Data, buffer.Data + frames, value);
+        return SaXAudio::Instance.AddBankData(buffer, 1, 48000, frames);
+    }
+
+    // Level of the left channel over the last pass rendered
+    static FLOAT RenderPeak(const FLOAT seconds)
+    {
+        Advance(seconds);
+        vector<FLOAT> buffer(480 * 2);
+        Render(buffer.data(), 480);
+        FLOAT peak = 0;
+        for (UINT32 i = 0; i < 480; i++)
+            peak = max(peak, fabsf(buffer[i * 2]));
+        return peak;
+    }
+
+    // The master limiter protects the mix, the compressor of a bus can follow another bus
+    static void TestBusDynamics()
+    {
+        INT32 loudID = AddConstantBank(0.5f);
+        INT32 musicBusID = CreateBus();
+        INT32 voiceBusID = CreateBus();
+
+        INT32 musicID = CreateVoice(loudID, musicBusID, true);
+        SetLooping(musicID, true);
+        Start(musicID);
+        CHECK_NEAR(RenderPeak(0.02f), 0.5f, 1e-4);
+
+        // Ducked by the voice bus, silent for now
+        CompressorParameters ducking;
+        ducking.Threshold = -30.0f;
+        ducking.Ratio = 10.0f;
+        ducking.Attack = 5.0f;
+        ducking.Release = 200.0f;
+        CHECK(SetCompressor(musicBusID, ducking, voiceBusID));
+        CHECK_NEAR(RenderPeak(0.1f), 0.5f, 1e-4);
+
+        // The key is measured before the volume of its bus, only the music is heard
+        SetVolume(voiceBusID, 0.0f, 0, true);
+        INT32 voiceID = CreateVoice(loudID, voiceBusID, true);
+        SetVolume(voiceID, 0.0f);
+        SetLooping(voiceID, true);
+        Start(voiceID);
+        CHECK_NEAR(RenderPeak(0.1f), 0.5f, 1e-4);
+
+        // -6dB on the voice bus is 24dB over the threshold, the music goes 21.6dB down
+        SetVolume(voiceID, 1.0f);
+        FLOAT ducked = RenderPeak(0.3f);
+        CHECK_NEAR(ToDb(ducked), ToDb(0.5f) - 21.6f, 0.2f);
+
+        SetVolume(voiceID, 0.0f);
+        CHECK_NEAR(RenderPeak(2.0f), 0.5f, 0.01f);
+
+        // Two buses at 0.5 sum to 1.0, the limiter holds the master at -6dB
+        SetVolume(voiceID, 1.0f);
+        SetVolume(voiceBusID, 1.0f, 0, true);
+        RemoveCompressor(musicBusID);
+        CHECK_NEAR(RenderPeak(0.1f), 1.0f, 1e-4);
+
+        LimiterParameters limiter;
+        limiter.Ceiling = -6.0f;
+        CHECK(SetLimiter(0, limiter));
+        CHECK_NEAR(RenderPeak(0.1f), powf(10.0f, -6.0f / 20.0f), 1e-3);
+
+        RemoveLimiter(0);
+        CHECK_NEAR(RenderPeak(0.1f), 1.0f, 1e-4);
+
+        RemoveBus(voiceBusID);
+        RemoveBus(musicBusID);
+        Advance(0.02f);
+    }
+
+    void RunDynamicsTests()
+    {
+        TestCompressor();
+        TestLimiter();
+
+        CreateOffline(2, 48000);
+        TestBusDynamics();
+        Release();
+    }
+}
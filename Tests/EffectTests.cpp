@@ -0,0 +1,342 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+#include "Headless.h"
+
+namespace SaXAudio
+{
+    static const UINT32 VOICE_COUNT = 50;
+
+    static XAUDIO2FX_REVERB_PARAMETERS GetCommittedReverb(const INT32 voiceID)
+    {
+        XAUDIO2FX_REVERB_PARAMETERS reverb = {};
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (voice && voice->SourceVoice)
+            voice->SourceVoice->GetEffectParameters(0, &reverb, sizeof(XAUDIO2FX_REVERB_PARAMETERS));
+        return reverb;
+    }
+
+    static IUnknown* GetEcho(const INT32 voiceID)
+    {
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        return voice ? voice->EffectData.echoEffect : nullptr;
+    }
+
+    static FXECHO_PARAMETERS GetCommittedEcho(const INT32 voiceID)
+    {
+        FXECHO_PARAMETERS echo = {};
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (voice && voice->SourceVoice)
+            voice->SourceVoice->GetEffectParameters(2, &echo, sizeof(FXECHO_PARAMETERS));
+        return echo;
+    }
+
+    static INT32 CreateLoopingVoice(const INT32 bankID)
+    {
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        SetLooping(voiceID, true);
+        Start(voiceID);
+        return voiceID;
+    }
+
+    // Reverb commits of each pass while the fades run, the highest is returned
+    static UINT32 AdvanceFades(const UINT32 passes, UINT32* total)
+    {
+        UINT32 highest = 0;
+        *total = 0;
+        for (UINT32 i = 0; i < passes; i++)
+        {
+            UINT32 before = Headless::ReverbParameterCount;
+            Advance(0.01f);
+            UINT32 commits = Headless::ReverbParameterCount - before;
+            highest = max(highest, commits);
+            *total += commits;
+        }
+        return highest;
+    }
+
+    // 50 voices fading their reverb at once, only the values that moved get committed, one effect per voice and pass
+    static void TestReverbFades()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        vector<INT32> voices;
+        for (UINT32 i = 0; i < VOICE_COUNT; i++)
+        {
+            INT32 voiceID = CreateVoice(bankID, 0, true);
+            SetLooping(voiceID, true);
+            Start(voiceID);
+            voices.push_back(voiceID);
+        }
+
+        XAUDIO2FX_REVERB_PARAMETERS reverb = {};
+        reverb.WetDryMix = 20.0f;
+        FXEQ_PARAMETERS eq = {};
+        eq.Gain0 = 1.0f;
+        for (INT32 voiceID : voices)
+        {
+            SetReverb(voiceID, reverb, 0);
+            SetEq(voiceID, eq, 0);
+        }
+        Advance(0.02f);
+        CHECK(GetCommittedReverb(voices[0]).WetDryMix == 20.0f);
+
+        // Over 50 ticks the delay only takes 5 new values, the steps in between commit nothing
+        XAUDIO2FX_REVERB_PARAMETERS delayed = reverb;
+        delayed.ReverbDelay = 5;
+        for (INT32 voiceID : voices)
+            SetReverb(voiceID, delayed, 0.5f);
+
+        UINT32 total = 0;
+        UINT32 highest = AdvanceFades(60, &total);
+        CHECK(highest <= VOICE_COUNT);
+        CHECK(total == VOICE_COUNT * 5);
+        for (INT32 voiceID : voices)
+            CHECK(GetCommittedReverb(voiceID).ReverbDelay == 5);
+
+        // With the EQ fading too they take turns, the reverb gets about every other pass
+        XAUDIO2FX_REVERB_PARAMETERS wet = delayed;
+        wet.WetDryMix = 80.0f;
+        eq.Gain0 = 4.0f;
+        for (INT32 voiceID : voices)
+        {
+            SetReverb(voiceID, wet, 0.5f);
+            SetEq(voiceID, eq, 0.5f);
+        }
+
+        highest = AdvanceFades(60, &total);
+        CHECK(highest <= VOICE_COUNT);
+        CHECK(total < VOICE_COUNT * 30);
+        CHECK(total > VOICE_COUNT * 20);
+
+        // The last value of the fades always gets committed
+        for (INT32 voiceID : voices)
+        {
+            CHECK(GetCommittedReverb(voiceID).WetDryMix == 80.0f);
+            CHECK(GetCommittedReverb(voiceID).ReverbDelay == 5);
+        }
+
+        // Nothing left to commit once the fades are over
+        AdvanceFades(10, &total);
+        CHECK(total == 0);
+
+        for (INT32 voiceID : voices)
+            Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    // An echo goes back to the pool when it isn't used anymore, the next voice wanting one gets it
+    static void TestEchoPool()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 firstID = CreateLoopingVoice(bankID);
+        INT32 secondID = CreateLoopingVoice(bankID);
+
+        FXECHO_PARAMETERS echo = { 50.0f, 0.3f, 100.0f };
+        SetEcho(firstID, echo);
+        Advance(0.01f);
+        IUnknown* pooled = GetEcho(firstID);
+        CHECK(pooled != nullptr);
+
+        // Removed right away
+        RemoveEcho(firstID);
+        Advance(0.01f);
+        CHECK(GetEcho(firstID) == nullptr);
+        SetEcho(secondID, echo);
+        Advance(0.01f);
+        CHECK(GetEcho(secondID) == pooled);
+
+        // Removed once the fade out is over
+        RemoveEcho(secondID, 0.1f);
+        Advance(0.05f);
+        CHECK(GetEcho(secondID) == pooled);
+        Advance(0.1f);
+        CHECK(GetEcho(secondID) == nullptr);
+
+        // A faded echo gets to its target
+        SetEcho(firstID, echo);
+        Advance(0.01f);
+        CHECK(GetEcho(firstID) == pooled);
+        FXECHO_PARAMETERS target = { 80.0f, 0.5f, 200.0f };
+        SetEcho(firstID, target, 0.1f);
+        Advance(0.05f);
+        FXECHO_PARAMETERS halfway = GetCommittedEcho(firstID);
+        CHECK(halfway.WetDryMix > 50.0f && halfway.WetDryMix < 80.0f);
+        Advance(0.1f);
+        FXECHO_PARAMETERS committed = GetCommittedEcho(firstID);
+        CHECK(committed.WetDryMix == 80.0f);
+        CHECK(committed.Feedback == 0.5f);
+        CHECK(committed.Delay == 200.0f);
+
+        // Released when the voice becomes virtual, attached again when it is real
+        SetPriority(firstID, 0);
+        SetPriority(secondID, 1);
+        SetMaxRealVoices(1);
+        Advance(0.02f);
+        CHECK(IsVirtual(firstID));
+        CHECK(GetEcho(firstID) == nullptr);
+        SetEcho(secondID, echo);
+        Advance(0.01f);
+        CHECK(GetEcho(secondID) == pooled);
+
+        SetMaxRealVoices(0);
+        Advance(0.02f);
+        CHECK(!IsVirtual(firstID));
+        CHECK(GetEcho(firstID) != nullptr);
+        CHECK(GetEcho(firstID) != pooled);
+        CHECK(GetCommittedEcho(firstID).WetDryMix == 80.0f);
+
+        // Released when the voice is removed
+        IUnknown* restored = GetEcho(firstID);
+        Stop(firstID, 0);
+        Advance(0.02f);
+        INT32 thirdID = CreateLoopingVoice(bankID);
+        SetEcho(thirdID, echo);
+        Advance(0.01f);
+        CHECK(GetEcho(thirdID) == restored);
+
+        // The max delay is for the next echo attached, it comes from another pool
+        SetEchoMaxDelay(thirdID, 500.0f);
+        SetEcho(thirdID, target);
+        Advance(0.01f);
+        CHECK(GetEcho(thirdID) == restored);
+        RemoveEcho(thirdID);
+        FXECHO_PARAMETERS longer = { 50.0f, 0.3f, 800.0f };
+        SetEcho(thirdID, longer);
+        Advance(0.01f);
+        CHECK(GetEcho(thirdID) != nullptr);
+        CHECK(GetEcho(thirdID) != restored);
+        CHECK(GetCommittedEcho(thirdID).Delay == 500.0f);
+        {
+            VoicePin voice = SaXAudio::Instance.PinVoice(thirdID);
+            CHECK(voice && voice->EffectData.echoEffectDelay == 500);
+        }
+
+        // Buses give theirs back when removed
+        INT32 busID = CreateBus();
+        SetEcho(busID, echo, 0, true);
+        Advance(0.01f);
+        IUnknown* busEcho = SaXAudio::Instance.GetBus(busID)->echoEffect;
+        CHECK(busEcho != nullptr);
+        RemoveBus(busID);
+        Advance(0.01f);
+        INT32 otherBusID = CreateBus();
+        SetEcho(otherBusID, echo, 0, true);
+        Advance(0.01f);
+        CHECK(SaXAudio::Instance.GetBus(otherBusID)->echoEffect == busEcho);
+
+        RemoveBus(otherBusID);
+        Stop(secondID, 0);
+        Stop(thirdID, 0);
+        Advance(0.02f);
+    }
+
+    static FLOAT GetFilterCutoff(const INT32 voiceID)
+    {
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        return voice ? voice->EffectData.filterCutoff : -1.0f;
+    }
+
+    static XAUDIO2_FILTER_PARAMETERS GetCommittedFilter(const INT32 voiceID)
+    {
+        XAUDIO2_FILTER_PARAMETERS filter = {};
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (voice && voice->SourceVoice)
+            voice->SourceVoice->GetFilterParameters(&filter);
+        return filter;
+    }
+
+    // The cutoff fades in octaves, the type switches at once and RemoveFilter fades back to open
+    static void TestFilter()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceID = CreateLoopingVoice(bankID);
+
+        SetFilter(voiceID, LowPassFilter, 4000.0f);
+        Advance(0.01f);
+        XAUDIO2_FILTER_PARAMETERS filter = GetCommittedFilter(voiceID);
+        CHECK(filter.Type == LowPassFilter);
+        CHECK_NEAR(filter.Frequency, XAudio2CutoffFrequencyToRadians(4000.0f, 48000), 1e-6);
+        CHECK_NEAR(filter.OneOverQ, 1.0f, 1e-6);
+
+        // 4 octaves down, halfway is 2 octaves down and not halfway in Hz
+        SetFilter(voiceID, LowPassFilter, 250.0f, 1.0f, 0.4f);
+        Advance(0.2f);
+        CHECK_NEAR(GetFilterCutoff(voiceID), 1000.0f, 100.0f);
+        CHECK_NEAR(GetCommittedFilter(voiceID).Frequency, XAudio2CutoffFrequencyToRadians(GetFilterCutoff(voiceID), 48000), 1e-6);
+        Advance(0.25f);
+        CHECK_NEAR(GetFilterCutoff(voiceID), 250.0f, 0.01f);
+        CHECK_NEAR(GetCommittedFilter(voiceID).Frequency, XAudio2CutoffFrequencyToRadians(250.0f, 48000), 1e-5);
+
+        // Another type can't fade, it replaces the low-pass at once
+        SetFilter(voiceID, HighPassFilter, 2000.0f, 2.0f, 0.4f);
+        Advance(0.01f);
+        filter = GetCommittedFilter(voiceID);
+        CHECK(filter.Type == HighPassFilter);
+        CHECK_NEAR(filter.Frequency, XAudio2CutoffFrequencyToRadians(2000.0f, 48000), 1e-6);
+        CHECK_NEAR(filter.OneOverQ, 0.5f, 1e-6);
+
+        // Back to open, for a high-pass the lowest cutoff, then removed
+        RemoveFilter(voiceID, 0.4f);
+        Advance(0.2f);
+        CHECK_NEAR(GetFilterCutoff(voiceID), sqrtf(2000.0f * 10.0f), 15.0f);
+        CHECK(GetCommittedFilter(voiceID).Type == HighPassFilter);
+        Advance(0.25f);
+        CHECK(GetFilterCutoff(voiceID) == 0);
+        filter = GetCommittedFilter(voiceID);
+        CHECK(filter.Type == LowPassFilter);
+        CHECK(filter.Frequency == XAUDIO2_DEFAULT_FILTER_FREQUENCY);
+        CHECK(filter.OneOverQ == XAUDIO2_DEFAULT_FILTER_ONEOVERQ);
+
+        // From open, a fade starts at the open cutoff of the new type
+        SetFilter(voiceID, LowPassOnePoleFilter, 240.0f, 1.0f, 0.4f);
+        Advance(0.2f);
+        filter = GetCommittedFilter(voiceID);
+        CHECK(filter.Type == LowPassOnePoleFilter);
+        CHECK_NEAR(GetFilterCutoff(voiceID), sqrtf(24000.0f * 240.0f), 150.0f);
+        CHECK_NEAR(filter.Frequency, XAudio2CutoffFrequencyToOnePoleCoefficient(GetFilterCutoff(voiceID), 48000), 1e-6);
+
+        // Removed at once
+        RemoveFilter(voiceID);
+        Advance(0.01f);
+        CHECK(GetFilterCutoff(voiceID) == 0);
+        CHECK(GetCommittedFilter(voiceID).Frequency == XAUDIO2_DEFAULT_FILTER_FREQUENCY);
+
+        Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    void RunEffectTests()
+    {
+        CreateOffline(2, 48000);
+        TestReverbFades();
+        TestEchoPool();
+        TestFilter();
+        Release();
+    }
+}
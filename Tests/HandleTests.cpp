@@ -0,0 +1,182 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    static void TestLookup()
+    {
+        INT32 bankID = Test::AddSineBank(2, 48000, 4800);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        CHECK(voiceID > 0);
+        CHECK(VoiceExist(voiceID));
+
+        // Only reserved until the control tick creates it
+        CHECK(GetSampleRate(voiceID) == 0);
+        Advance(0.01f);
+        CHECK(VoiceExist(voiceID));
+        CHECK(GetSampleRate(voiceID) == 48000);
+        CHECK(GetChannelCount(voiceID) == 2);
+        CHECK(GetTotalSample(voiceID) == 4800);
+
+        // Invalid IDs and other generations of the same slot
+        CHECK(!VoiceExist(0));
+        CHECK(!VoiceExist(-1));
+        CHECK(!VoiceExist(voiceID + MAX_VOICES));
+
+        // Removed once it finished playing
+        CHECK(Start(voiceID));
+        Advance(0.2f);
+        CHECK(!VoiceExist(voiceID));
+        CHECK(GetSampleRate(voiceID) == 0);
+        CHECK(GetTotalSample(voiceID) == 0);
+    }
+
+    // Removed voices go back to the pool, their slots are reused with a new generation
+    static void TestSlotReuse()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 480);
+        vector<INT32> voiceIDs;
+        for (UINT32 round = 0; round < 4; round++)
+        {
+            for (UINT32 i = 0; i < 40; i++)
+            {
+                INT32 voiceID = CreateVoice(bankID, 0, false);
+                CHECK(voiceID > 0);
+                voiceIDs.push_back(voiceID);
+            }
+            Advance(0.05f);
+        }
+
+        unordered_map<INT32, UINT32> slots;
+        for (INT32 voiceID : voiceIDs)
+        {
+            slots[voiceID & VOICE_INDEX_MASK]++;
+            CHECK(!VoiceExist(voiceID));
+        }
+        CHECK(slots.size() < voiceIDs.size());
+
+        sort(voiceIDs.begin(), voiceIDs.end());
+        CHECK(unique(voiceIDs.begin(), voiceIDs.end()) == voiceIDs.end());
+    }
+
+    // A pinned voice stays valid, RemoveVoice waits for the pin to be released
+    static void TestPin()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 480);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        Advance(0.01f);
+        Start(voiceID);
+
+        atomic<BOOL> removed = false;
+        thread control;
+        {
+            VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+            CHECK(!!voice);
+
+            control = thread([&]
+                {
+                    Advance(0.05f);
+                    removed = true;
+                });
+            this_thread::sleep_for(chrono::milliseconds(50));
+
+            CHECK(!removed);
+            CHECK(voice->BankID == bankID);
+            CHECK(voice->BankData && voice->BankData->sampleRate == 48000);
+        }
+        control.join();
+        CHECK(removed);
+        CHECK(!VoiceExist(voiceID));
+    }
+
+    // Lookups from other threads while the voices are created and removed
+    // A stale voiceID must never resolve to the voice that reused its slot
+    static void TestConcurrentLookup()
+    {
+        const UINT32 rates[2] = { 48000, 44100 };
+        const INT32 banks[2] = { Test::AddSineBank(1, rates[0], 480), Test::AddSineBank(1, rates[1], 441) };
+
+        const UINT32 count = 64;
+        atomic<INT32> voiceIDs[count] = {};
+        atomic<BOOL> running = true;
+        atomic<UINT64> lookups = 0;
+        atomic<UINT64> found = 0;
+        atomic<UINT64> mismatches = 0;
+
+        vector<thread> readers;
+        for (UINT32 t = 0; t < 2; t++)
+        {
+            readers.emplace_back([&]
+                {
+                    UINT64 localLookups = 0;
+                    UINT64 localFound = 0;
+                    UINT64 localMismatches = 0;
+                    while (running)
+                    {
+                        for (UINT32 i = 0; i < count; i++)
+                        {
+                            UINT32 rate = GetSampleRate(voiceIDs[i]);
+                            localFound += rate != 0;
+                            localMismatches += rate != 0 && rate != rates[i % 2];
+                        }
+                        localLookups += count;
+                    }
+                    lookups += localLookups;
+                    found += localFound;
+                    mismatches += localMismatches;
+                });
+        }
+
+        for (UINT32 round = 0; round < 100; round++)
+        {
+            for (UINT32 i = 0; i < count; i++)
+                voiceIDs[i] = CreateVoice(banks[i % 2], 0, false);
+            Advance(0.02f);
+        }
+
+        running = false;
+        for (thread& reader : readers)
+            reader.join();
+
+        CHECK(lookups > 0);
+        CHECK(mismatches == 0);
+        CHECK(GetVoiceCount() == 0);
+    }
+
+    void RunHandleTests()
+    {
+        CreateOffline(2, 48000);
+        TestLookup();
+        TestSlotReuse();
+        TestPin();
+        TestConcurrentLookup();
+        Release();
+    }
+}
@@ -0,0 +1,196 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "VorbisWriter.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    static UINT32 CountEvents(const EventType type, const INT32 voiceID)
+    {
+        AudioEvent events[64];
+        UINT32 found = 0;
+        UINT32 count;
+        while ((count = PollEvents(events, 64)) > 0)
+        {
+            for (UINT32 i = 0; i < count; i++)
+                found += events[i].type == type && events[i].voiceID == voiceID;
+        }
+        return found;
+    }
+
+    // Renders from this thread like an audio callback would, the control thread runs on its own
+    static BOOL RenderUntil(const function<BOOL()>& condition, const FLOAT timeout)
+    {
+        vector<FLOAT> buffer(480 * 2);
+        auto start = chrono::steady_clock::now();
+        while (!condition())
+        {
+            if (chrono::duration<FLOAT>(chrono::steady_clock::now() - start).count() > timeout)
+                return false;
+            Render(buffer.data(), 480);
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+        return true;
+    }
+
+    // Offline the voices that ended during a pass are removed before Render returns
+    static void TestOfflineRemoval()
+    {
+        CreateOffline(2, 48000);
+        INT32 bankID = Test::AddSineBank(1, 48000, 960);
+        INT32 voiceID = CreateVoice(bankID, 0, false);
+
+        Advance(0.01f);
+        CHECK(VoiceExist(voiceID));
+        Advance(0.02f);
+        CHECK(!VoiceExist(voiceID));
+        CHECK(CountEvents(EVENT_VOICE_FINISHED, voiceID) == 1);
+        Release();
+    }
+
+    // Offline the time starts at 0, the first voice of a bank isn't taken for a retrigger
+    static void TestOfflineCooldown()
+    {
+        CreateOffline(2, 48000);
+        INT32 bankID = Test::AddSineBank(1, 48000, 960);
+        BankSetLimits(bankID, 0, 0.1f, STEAL_REJECT);
+
+        // The limits are checked when the control tick creates the voices
+        INT32 firstID = CreateVoice(bankID, 0, true);
+        INT32 retriggerID = CreateVoice(bankID, 0, true);
+        CHECK(firstID > 0 && retriggerID > 0);
+        Advance(0.01f);
+        CHECK(VoiceExist(firstID));
+        CHECK(!VoiceExist(retriggerID));
+        CHECK(BankGetRejectedCount(bankID) == 1);
+
+        Advance(0.1f);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        Advance(0.01f);
+        CHECK(VoiceExist(voiceID));
+        Release();
+    }
+
+    // A voice that couldn't be created doesn't start the cooldown or steal
+    static void TestFailedCreation()
+    {
+        CreateOffline(2, 48000);
+
+        // The mixer has no source voice for a bank without channels
+        INT32 bankID = SaXAudio::Instance.AddBankData(SaXAudio::Instance.GetBuffer(480), 0, 48000, 480);
+        BankSetLimits(bankID, 1, 1.0f, STEAL_OLDEST);
+        INT32 firstID = CreateVoice(bankID, 0, true);
+        INT32 secondID = CreateVoice(bankID, 0, true);
+        Advance(0.01f);
+        CHECK(!VoiceExist(firstID));
+        CHECK(!VoiceExist(secondID));
+        CHECK(BankGetRejectedCount(bankID) == 0);
+
+        // A virtual voice needs no source voice, the next one would steal it but fails too
+        INT32 otherID = CreateVoice(Test::AddSineBank(1, 48000, 48000), 0, true);
+        SetMaxRealVoices(1);
+        BankSetLimits(bankID, 1, 0, STEAL_OLDEST);
+        INT32 virtualID = CreateVoice(bankID, 0, true);
+        Advance(0.01f);
+        CHECK(IsVirtual(virtualID));
+        SetMaxRealVoices(0);
+        Stop(otherID, 0);
+        Advance(0.02f);
+        INT32 failedID = CreateVoice(bankID, 0, true);
+        Advance(0.01f);
+        CHECK(!VoiceExist(failedID));
+        CHECK(BankGetStolenCount(bankID) == 0);
+        CHECK(VoiceExist(virtualID));
+        Release();
+    }
+
+    // The voice IDs start over with a new engine, a fade left running by the last one doesn't reach them
+    static void TestReleaseFades()
+    {
+        CreateOffline(2, 48000);
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceID = CreateVoice(bankID, 0, false);
+        Stop(voiceID, 0.2f);
+        Advance(0.02f);
+        Release();
+
+        CreateOffline(2, 48000);
+        bankID = Test::AddSineBank(1, 48000, 48000);
+        CHECK(CreateVoice(bankID, 0, false) == voiceID);
+        Advance(0.1f);
+        FLOAT volume = 0;
+        {
+            VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+            if (voice && voice->SourceVoice)
+                voice->SourceVoice->GetVolume(&volume);
+        }
+        CHECK(volume == 1.0f);
+        Release();
+    }
+
+    // The mixer thread only flags the voice, the control thread removes it
+    static void TestControlRemoval()
+    {
+        CreateSoftware(2, 48000);
+        INT32 bankID = Test::AddSineBank(1, 48000, 960);
+        INT32 voiceID = CreateVoice(bankID, 0, false);
+
+        CHECK(RenderUntil([&] { return !VoiceExist(voiceID); }, 2.0f));
+        CHECK(CountEvents(EVENT_VOICE_FINISHED, voiceID) == 1);
+        CHECK(GetVoiceCount() == 0);
+        Release();
+    }
+
+    // A voice started before its bank is decoded is started by the control thread once the samples are there
+    static void TestDecodingWait()
+    {
+        CreateSoftware(2, 48000);
+        SetLoudnessAnalysis(false);
+
+        vector<BYTE> ogg = VorbisWriter::Write(2, 48000, 4.0f);
+        INT32 bankID = BankAddOgg(ogg.data(), (UINT32)ogg.size());
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        const UINT32 sample = 48000 * 3;
+        CHECK(StartAtSample(voiceID, sample));
+
+        CHECK(RenderUntil([&] { return GetPositionSample(voiceID) > sample; }, 5.0f));
+        CHECK(CountEvents(EVENT_VOICE_ERROR, voiceID) == 0);
+        Release();
+    }
+
+    void RunLifecycleTests()
+    {
+        TestOfflineRemoval();
+        TestOfflineCooldown();
+        TestReleaseFades();
+        TestFailedCreation();
+        TestControlRemoval();
+        TestDecodingWait();
+    }
+}
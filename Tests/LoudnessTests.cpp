@@ -0,0 +1,185 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+#include "Dsp.h"
+
+namespace SaXAudio
+{
+    static const double PI = 3.14159265358979323846;
+
+    // Interleaved sine on every channel
+    static vector<FLOAT> MakeSine(const UINT32 channels, const UINT32 sampleRate, const FLOAT seconds, const FLOAT frequency, const FLOAT amplitude, const FLOAT phase = 0)
+    {
+        UINT32 frames = (UINT32)(seconds * sampleRate);
+        vector<FLOAT> samples(frames * channels);
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            for (UINT32 c = 0; c < channels; c++)
+                samples[i * channels + c] = amplitude * (FLOAT)sin(2.0 * PI * frequency * i / sampleRate + phase);
+        }
+        return samples;
+    }
+
+    static FLOAT Measure(const vector<FLOAT>& samples, const UINT32 channels, const UINT32 sampleRate, FLOAT* truePeak = nullptr)
+    {
+        LoudnessMeter meter;
+        meter.Init(channels, sampleRate);
+
+        // Fed in uneven chunks like a decoder would
+        UINT32 frames = (UINT32)samples.size() / channels;
+        for (UINT32 i = 0; i < frames; i += 1237)
+            meter.Process(samples.data() + i * channels, min(1237u, frames - i));
+
+        if (truePeak)
+            *truePeak = meter.GetTruePeak();
+        return meter.GetLoudness();
+    }
+
+    // BS.1770: a 1kHz sine at full scale on one channel measures -3.01 LUFS
+    static void TestLoudness()
+    {
+        CHECK_NEAR(Measure(MakeSine(1, 48000, 3.0f, 1000.0f, 0.1f), 1, 48000), -23.01f, 0.05f);
+        CHECK_NEAR(Measure(MakeSine(1, 44100, 3.0f, 1000.0f, 0.1f), 1, 44100), -23.01f, 0.05f);
+
+        // The channels add up
+        CHECK_NEAR(Measure(MakeSine(2, 48000, 3.0f, 1000.0f, 0.1f), 2, 48000), -20.0f, 0.05f);
+
+        // The K-weighting lowers the bass
+        CHECK(Measure(MakeSine(1, 48000, 3.0f, 40.0f, 0.1f), 1, 48000) < -24.0f);
+
+        // Shorter than a gating block, the whole sound is measured
+        CHECK_NEAR(Measure(MakeSine(1, 48000, 0.2f, 1000.0f, 0.1f), 1, 48000), -23.01f, 0.1f);
+
+        CHECK(Measure(vector<FLOAT>(48000), 1, 48000) == LOUDNESS_SILENCE);
+    }
+
+    static void TestGating()
+    {
+        // Silence is under the absolute gate
+        // The 3 blocks over the edge are partly silent, 30 blocks hold 28.5 blocks of sine: -0.22dB
+        vector<FLOAT> samples = MakeSine(1, 48000, 3.0f, 1000.0f, 0.1f);
+        samples.resize(samples.size() * 2, 0.0f);
+        CHECK_NEAR(Measure(samples, 1, 48000), -23.23f, 0.05f);
+
+        // 40dB quieter is under the relative gate
+        vector<FLOAT> quiet = MakeSine(1, 48000, 3.0f, 1000.0f, 0.001f);
+        samples.resize(samples.size() / 2);
+        samples.insert(samples.end(), quiet.begin(), quiet.end());
+        CHECK_NEAR(Measure(samples, 1, 48000), -23.23f, 0.05f);
+
+        // 6dB quieter isn't, the loudness is in between
+        vector<FLOAT> mixed = MakeSine(1, 48000, 3.0f, 1000.0f, 0.1f);
+        vector<FLOAT> half = MakeSine(1, 48000, 3.0f, 1000.0f, 0.05f);
+        mixed.insert(mixed.end(), half.begin(), half.end());
+        FLOAT loudness = Measure(mixed, 1, 48000);
+        CHECK(loudness < -23.5f && loudness > -29.0f);
+    }
+
+    // A sine at a quarter of the sample rate shifted by 45 degrees never has a sample on its peaks
+    static void TestTruePeak()
+    {
+        vector<FLOAT> samples = MakeSine(2, 48000, 0.5f, 12000.0f, 0.5f, (FLOAT)(PI / 4));
+        FLOAT samplePeak = 0;
+        for (FLOAT sample : samples)
+            samplePeak = max(samplePeak, fabsf(sample));
+
+        FLOAT truePeak = 0;
+        Measure(samples, 2, 48000, &truePeak);
+        CHECK_NEAR(samplePeak, 0.3536f, 1e-3);
+        CHECK_NEAR(truePeak, 0.5f, 0.025f);
+
+        // On a low frequency the true peak is the sample peak
+        Measure(MakeSine(1, 48000, 0.5f, 100.0f, 0.5f), 1, 48000, &truePeak);
+        CHECK_NEAR(truePeak, 0.5f, 0.01f);
+    }
+
+    // Analyzed banks give new voices a gain reaching the target, limited by the true peak
+    static void TestNormalization()
+    {
+        SetLoudnessAnalysis(true);
+
+        // 1kHz, amplitude 0.1 then 0.5 is -23 then -9 LUFS
+        INT32 quietID = Test::AddSineBank(1, 48000, 48000 * 2, 0.1f);
+        INT32 loudID = Test::AddSineBank(1, 48000, 48000 * 2, 0.5f);
+        FLOAT loudness = 0;
+        FLOAT truePeak = 0;
+        CHECK(BankGetLoudness(loudID, &loudness, &truePeak));
+        CHECK(loudness > -10.5f && loudness < -8.0f);
+        CHECK_NEAR(truePeak, 0.5f, 0.02f);
+
+        SetLoudnessAnalysis(false);
+        INT32 plainID = Test::AddSineBank(1, 48000, 48000, 0.5f);
+        CHECK(!BankGetLoudness(plainID, &loudness, &truePeak));
+
+        // Both banks end up at the target, the same sine gets the same level
+        SetLoudnessTarget(-23.0f);
+        FLOAT quietLoudness = 0;
+        BankGetLoudness(quietID, &quietLoudness, &truePeak);
+        INT32 quietVoiceID = CreateVoice(quietID, 0, false);
+        INT32 loudVoiceID = CreateVoice(loudID, 0, false);
+        Advance(0.05f);
+        FLOAT quietPeak = GetPeakLevel(quietVoiceID);
+        CHECK_NEAR(20.0f * log10f(quietPeak / 0.1f), -23.0f - quietLoudness, 0.05f);
+        CHECK_NEAR(GetPeakLevel(loudVoiceID), quietPeak, quietPeak * 0.01f);
+
+        // Not analyzed, no gain
+        INT32 plainVoiceID = CreateVoice(plainID, 0, false);
+        Advance(0.05f);
+        CHECK_NEAR(GetPeakLevel(plainVoiceID), 0.5f, 0.01f);
+
+        // A gain of +22dB would clip, the true peak stops at 0dBTP
+        SetLoudnessTarget(-1.0f);
+        INT32 limitedID = CreateVoice(quietID, 0, false);
+        Advance(0.05f);
+        CHECK_NEAR(GetPeakLevel(limitedID), 1.0f, 0.02f);
+        CHECK(GetPeakLevel(limitedID) <= 1.0f + 1e-4f);
+
+        // A cached loudness replaces the measure
+        BankSetLoudness(plainID, -13.0f, 0.5f);
+        SetLoudnessTarget(-23.0f);
+        INT32 cachedID = CreateVoice(plainID, 0, false);
+        Advance(0.05f);
+        CHECK_NEAR(GetPeakLevel(cachedID), 0.5f * powf(10.0f, -10.0f / 20.0f), 0.01f);
+
+        SetLoudnessTarget(0);
+        StopAll();
+        Advance(0.02f);
+    }
+
+    void RunLoudnessTests()
+    {
+        TestLoudness();
+        TestGating();
+        TestTruePeak();
+
+        CreateOffline(2, 48000);
+        TestNormalization();
+        Release();
+    }
+}
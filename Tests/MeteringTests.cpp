@@ -0,0 +1,158 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+#include "Dsp.h"
+
+namespace SaXAudio
+{
+    // The SSE2 kernel gives the same levels as a plain loop, whatever is left after the groups of 4
+    static void TestMeasureLevels()
+    {
+        mt19937 random(1);
+        uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+        vector<FLOAT> samples(64 * 6);
+        for (FLOAT& sample : samples)
+            sample = distribution(random);
+
+        const UINT32 channelCounts[] = { 1, 2, 3, 6 };
+        for (UINT32 channels : channelCounts)
+        {
+            for (UINT32 frames = 0; frames <= 37; frames++)
+            {
+                FLOAT peak[6];
+                FLOAT rms[6];
+                MeasureLevels(samples.data(), frames, channels, peak, rms);
+
+                for (UINT32 c = 0; c < channels; c++)
+                {
+                    FLOAT expectedPeak = 0;
+                    double sum = 0;
+                    for (UINT32 i = 0; i < frames; i++)
+                    {
+                        FLOAT sample = samples[i * channels + c];
+                        expectedPeak = max(expectedPeak, fabsf(sample));
+                        sum += sample * sample;
+                    }
+                    FLOAT expectedRMS = frames ? (FLOAT)sqrt(sum / frames) : 0.0f;
+                    CHECK(peak[c] == expectedPeak);
+                    CHECK_NEAR(rms[c], expectedRMS, 1e-5);
+                }
+            }
+        }
+
+        // A full scale sine has an RMS 3dB under its peak
+        vector<FLOAT> sine(4800);
+        for (UINT32 i = 0; i < 4800; i++)
+            sine[i] = sinf(2.0f * 3.14159265f * 100.0f * i / 48000);
+        FLOAT peak, rms;
+        MeasureLevels(sine.data(), 4800, 1, &peak, &rms);
+        CHECK_NEAR(peak, 1.0f, 1e-4);
+        CHECK_NEAR(rms, 0.70711f, 1e-4);
+    }
+
+    static INT32 AddConstantBank(const UINT32 channels, const FLOAT left, const FLOAT right)
+    {
+        const UINT32 frames = 48000;
+        Buffer buffer = SaXAudio::Instance.GetBuffer(frames * channels);
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            buffer.Data[i * channels] = left;
+            if (channels == 2)
+                buffer.Data[i * channels + 1] = right;
+        }
+        return SaXAudio::Instance.AddBankData(buffer, channels, 48000, frames);
+    }
+
+    // Voice levels come from the bank around the play cursor, times the volume
+    static void TestVoiceLevels()
+    {
+        INT32 bankID = AddConstantBank(2, 0.5f, -0.25f);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        SetVolume(voiceID, 0.5f);
+        SetLooping(voiceID, true);
+        CHECK(GetPeakLevel(voiceID, 0) == 0.0f);
+
+        Start(voiceID);
+        Advance(0.05f);
+        CHECK_NEAR(GetPeakLevel(voiceID, 0), 0.25f, 1e-5);
+        CHECK_NEAR(GetRMSLevel(voiceID, 0), 0.25f, 1e-5);
+        CHECK_NEAR(GetPeakLevel(voiceID, 1), 0.125f, 1e-5);
+        CHECK(GetPeakLevel(voiceID, 2) == 0.0f);
+
+        // Paused voices are silent
+        Pause(voiceID);
+        Advance(0.05f);
+        CHECK(GetPeakLevel(voiceID, 0) == 0.0f);
+
+        Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    // Bus levels come from the volume meter ending the effect chain, the bus volume applies after it
+    static void TestBusLevels()
+    {
+        INT32 bankID = AddConstantBank(1, 0.5f, 0);
+        INT32 busID = CreateBus();
+        SetVolume(busID, 0.5f, 0, true);
+
+        INT32 voiceID = CreateVoice(bankID, busID, true);
+        SetLooping(voiceID, true);
+        Start(voiceID);
+        Advance(0.05f);
+
+        // Without a meter there is nothing to read
+        CHECK(GetPeakLevel(busID, 0, true) == 0.0f);
+
+        SetMetering(busID, true);
+        SetMetering(0, true);
+        Advance(0.05f);
+        CHECK_NEAR(GetPeakLevel(busID, 0, true), 0.5f, 1e-5);
+        CHECK_NEAR(GetRMSLevel(busID, 1, true), 0.5f, 1e-5);
+        CHECK_NEAR(GetPeakLevel(0, 0, true), 0.25f, 1e-5);
+
+        SetMetering(busID, false);
+        Advance(0.05f);
+        CHECK(GetPeakLevel(busID, 0, true) == 0.0f);
+        CHECK_NEAR(GetPeakLevel(0, 0, true), 0.25f, 1e-5);
+
+        SetMetering(0, false);
+        RemoveBus(busID);
+        Advance(0.02f);
+    }
+
+    void RunMeteringTests()
+    {
+        TestMeasureLevels();
+
+        CreateOffline(2, 48000);
+        TestVoiceLevels();
+        TestBusLevels();
+        Release();
+    }
+}
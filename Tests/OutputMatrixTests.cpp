@@ -0,0 +1,134 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    static const DWORD STEREO = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+    static const DWORD SURROUND_5_1 = STEREO | SPEAKER_FRONT_CENTER | SPEAKER_LOW_FREQUENCY | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+    static const DWORD SURROUND_7_1 = SURROUND_5_1 | SPEAKER_SIDE_LEFT | SPEAKER_SIDE_RIGHT;
+
+    static void TestLayout()
+    {
+        SpeakerLayout layout;
+        layout.Init(STEREO, 2);
+        CHECK(layout.channels == 2 && layout.left == 0 && layout.right == 1);
+        CHECK(layout.center == -1 && layout.lfe == -1 && layout.backLeft == -1 && layout.sideLeft == -1);
+
+        layout.Init(SURROUND_7_1, 8);
+        CHECK(layout.left == 0 && layout.right == 1 && layout.center == 2 && layout.lfe == 3);
+        CHECK(layout.backLeft == 4 && layout.backRight == 5 && layout.sideLeft == 6 && layout.sideRight == 7);
+
+        // Speakers beyond the channels of the voice are ignored
+        layout.Init(SURROUND_7_1, 6);
+        CHECK(layout.backRight == 5 && layout.sideLeft == -1 && layout.sideRight == -1);
+    }
+
+    static void TestMono()
+    {
+        SpeakerLayout layout;
+        layout.Init(STEREO, 2);
+
+        FLOAT matrix[MAX_OUTPUT_CHANNELS] = {};
+        BuildOutputMatrix<1>(layout, 0.0f, matrix);
+        CHECK(matrix[0] == 1.0f && matrix[1] == 1.0f);
+
+        BuildOutputMatrix<1>(layout, -1.0f, matrix);
+        CHECK(matrix[0] == 1.0f && matrix[1] == 0.0f);
+
+        BuildOutputMatrix<1>(layout, 0.5f, matrix);
+        CHECK(matrix[0] == 0.5f && matrix[1] == 1.0f);
+
+        // The center gets the source at -3dB and the surrounds follow the panning at -6dB, the LFE gets nothing
+        layout.Init(SURROUND_5_1, 6);
+        FLOAT surround[MAX_OUTPUT_CHANNELS] = {};
+        BuildOutputMatrix<1>(layout, 1.0f, surround);
+        CHECK(surround[layout.left] == 0.0f && surround[layout.right] == 1.0f);
+        CHECK(surround[layout.center] == CENTER_GAIN && surround[layout.lfe] == 0.0f);
+        CHECK(surround[layout.backLeft] == 0.0f && surround[layout.backRight] == SURROUND_GAIN);
+    }
+
+    static void TestStereo()
+    {
+        SpeakerLayout layout;
+        layout.Init(STEREO, 2);
+
+        // Destination major: matrix[destination * 2 + source]
+        FLOAT matrix[2 * MAX_OUTPUT_CHANNELS] = {};
+        BuildOutputMatrix<2>(layout, 0.0f, matrix);
+        CHECK(matrix[0] == 1.0f && matrix[1] == 0.0f && matrix[2] == 0.0f && matrix[3] == 1.0f);
+
+        // Fully left, the right channel moves into the left speaker
+        BuildOutputMatrix<2>(layout, -1.0f, matrix);
+        CHECK(matrix[0] == 1.0f && matrix[1] == 1.0f && matrix[2] == 0.0f && matrix[3] == 0.0f);
+
+        BuildOutputMatrix<2>(layout, 0.5f, matrix);
+        CHECK(matrix[0] == 0.5f && matrix[1] == 0.0f && matrix[2] == 0.5f && matrix[3] == 1.0f);
+
+        layout.Init(SURROUND_7_1, 8);
+        FLOAT surround[2 * MAX_OUTPUT_CHANNELS] = {};
+        BuildOutputMatrix<2>(layout, 0.0f, surround);
+        CHECK(surround[layout.center * 2 + 0] == CENTER_GAIN && surround[layout.center * 2 + 1] == CENTER_GAIN);
+        CHECK(surround[layout.lfe * 2 + 0] == 0.0f && surround[layout.lfe * 2 + 1] == 0.0f);
+        CHECK(surround[layout.sideLeft * 2 + 0] == SURROUND_GAIN && surround[layout.sideLeft * 2 + 1] == 0.0f);
+        CHECK(surround[layout.sideRight * 2 + 0] == 0.0f && surround[layout.sideRight * 2 + 1] == SURROUND_GAIN);
+    }
+
+    // The panning reaches the mix through the output matrix of the source voice
+    static void TestRenderPanning()
+    {
+        CreateOffline(2, 48000);
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        SetPanning(voiceID, -1.0f);
+        Start(voiceID);
+
+        vector<FLOAT> buffer(4800 * 2);
+        Render(buffer.data(), 4800);
+
+        double left = 0;
+        double right = 0;
+        for (UINT32 i = 0; i < 4800; i++)
+        {
+            left += fabs(buffer[i * 2 + 0]);
+            right += fabs(buffer[i * 2 + 1]);
+        }
+        CHECK(left > 100.0);
+        CHECK(right < 1e-3);
+        Release();
+    }
+
+    void RunOutputMatrixTests()
+    {
+        TestLayout();
+        TestMono();
+        TestStereo();
+        TestRenderPanning();
+    }
+}
@@ -0,0 +1,137 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    // The volume of the source voice, fades from Stop don't change GetVolume
+    static FLOAT GetHeardVolume(const INT32 voiceID)
+    {
+        FLOAT volume = 0;
+        VoicePin voice = SaXAudio::Instance.PinVoice(voiceID);
+        if (voice && voice->SourceVoice)
+            voice->SourceVoice->GetVolume(&volume);
+        return volume;
+    }
+
+    // A new transition during a crossfade fades both tracks out from where they are
+    static void TestInterruptedTransition()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 playlistID = CreatePlaylist();
+        PlaylistQueue(playlistID, bankID, true);
+        PlaylistPlay(playlistID);
+        Advance(0.2f);
+        INT32 firstID = PlaylistGetCurrentVoice(playlistID);
+
+        CHECK(PlaylistTransition(playlistID, bankID, true, 1.0f));
+        Advance(0.5f);
+        INT32 secondID = PlaylistGetCurrentVoice(playlistID);
+        FLOAT first = GetHeardVolume(firstID);
+        FLOAT second = GetHeardVolume(secondID);
+        CHECK(first > 0.1f && first < 0.9f);
+        CHECK(second > 0.1f && second < 0.9f);
+
+        CHECK(PlaylistTransition(playlistID, bankID, true, 1.0f));
+        Advance(0.1f);
+        INT32 thirdID = PlaylistGetCurrentVoice(playlistID);
+        CHECK(thirdID != secondID);
+        CHECK(VoiceExist(firstID) && GetHeardVolume(firstID) < first);
+        CHECK(VoiceExist(secondID) && GetHeardVolume(secondID) < second);
+
+        Advance(1.5f);
+        CHECK(!VoiceExist(firstID) && !VoiceExist(secondID));
+        CHECK(GetHeardVolume(thirdID) == 1.0f);
+
+        RemovePlaylist(playlistID);
+        Advance(0.02f);
+    }
+
+    // Stopping during a crossfade fades both tracks out
+    static void TestInterruptedStop()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 playlistID = CreatePlaylist();
+        PlaylistQueue(playlistID, bankID, true);
+        PlaylistPlay(playlistID);
+        Advance(0.2f);
+        INT32 firstID = PlaylistGetCurrentVoice(playlistID);
+
+        CHECK(PlaylistTransition(playlistID, bankID, true, 1.0f));
+        Advance(0.5f);
+        INT32 secondID = PlaylistGetCurrentVoice(playlistID);
+        FLOAT first = GetHeardVolume(firstID);
+        FLOAT second = GetHeardVolume(secondID);
+
+        PlaylistStop(playlistID, 0.5f);
+        Advance(0.1f);
+        CHECK(VoiceExist(firstID) && GetHeardVolume(firstID) < first);
+        CHECK(VoiceExist(secondID) && GetHeardVolume(secondID) < second);
+
+        Advance(0.5f);
+        CHECK(!VoiceExist(firstID) && !VoiceExist(secondID));
+
+        RemovePlaylist(playlistID);
+        Advance(0.02f);
+    }
+
+    // Interrupted before the incoming track is heard, the playing track stays the current one
+    static void TestTransitionBeforeStart()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 playlistID = CreatePlaylist();
+        PlaylistQueue(playlistID, bankID, true);
+        PlaylistPlay(playlistID);
+        Advance(0.2f);
+        INT32 firstID = PlaylistGetCurrentVoice(playlistID);
+
+        CHECK(PlaylistTransition(playlistID, bankID, true, 1.0f));
+        INT32 secondID = PlaylistGetCurrentVoice(playlistID);
+        CHECK(PlaylistTransition(playlistID, bankID, true, 1.0f));
+        Advance(0.02f);
+        CHECK(!VoiceExist(secondID));
+        CHECK(VoiceExist(firstID));
+
+        Advance(1.5f);
+        CHECK(!VoiceExist(firstID));
+        CHECK(GetHeardVolume(PlaylistGetCurrentVoice(playlistID)) == 1.0f);
+
+        RemovePlaylist(playlistID);
+        Advance(0.02f);
+    }
+
+    void RunPlaylistTests()
+    {
+        CreateOffline(2, 48000);
+        TestInterruptedTransition();
+        TestInterruptedStop();
+        TestTransitionBeforeStart();
+        Release();
+    }
+}
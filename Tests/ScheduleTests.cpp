@@ -0,0 +1,129 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    // A constant signal, the first rendered sample that isn't 0 is where the voice started
+    static INT32 AddConstantBank(const UINT32 frames)
+    {
+        Buffer buffer = SaXAudio::Instance.GetBuffer(frames);
+        for (UINT32 i = 0; i < frames; i++)
+            buffer.Data[i] = 0.5f;
+        return SaXAudio::Instance.AddBankData(buffer, 1, 48000, frames);
+    }
+
+    // Renders until the voice is heard, returns the engine time of its first sample
+    // Called between passes, the engine time is counted when a pass ends
+    static UINT64 RenderUntilHeard(const UINT64 limit)
+    {
+        const UINT32 quantum = GetEngineSampleRate() / 100;
+        vector<FLOAT> buffer(quantum * 2);
+        for (UINT64 time = GetEngineTime(); time < limit; time += quantum)
+        {
+            Render(buffer.data(), quantum);
+            for (UINT32 i = 0; i < quantum; i++)
+            {
+                if (buffer[i * 2] != 0.0f)
+                    return time + i;
+            }
+        }
+        return 0;
+    }
+
+    // Samples between the start of a voice and its first sample in the mix, the resampler holds one frame
+    static UINT64 s_latency = 0;
+
+    static void TestLatency()
+    {
+        INT32 bankID = AddConstantBank(48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+
+        UINT64 now = GetEngineTime();
+        Start(voiceID);
+        s_latency = RenderUntilHeard(now + 4800) - now;
+        CHECK(s_latency <= 1);
+        Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    static void TestScheduledTime()
+    {
+        INT32 bankID = AddConstantBank(48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+
+        UINT64 engineTime = GetEngineTime() + 4800 + 123;
+        CHECK(StartAtEngineTime(voiceID, engineTime));
+        CHECK(RenderUntilHeard(engineTime + 48000) == engineTime + s_latency);
+        Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    // Scheduling again replaces the previous time
+    static void TestReschedule()
+    {
+        INT32 bankID = AddConstantBank(48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+
+        UINT64 now = GetEngineTime();
+        CHECK(StartAtEngineTime(voiceID, now + 2400));
+        CHECK(StartAtEngineTime(voiceID, now + 9600));
+        CHECK(RenderUntilHeard(now + 48000) == now + 9600 + s_latency);
+        Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    // A canceled start doesn't come back when the voice is scheduled again
+    static void TestCancel()
+    {
+        INT32 bankID = AddConstantBank(48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+
+        UINT64 now = GetEngineTime();
+        CHECK(StartAtEngineTime(voiceID, now + 4800));
+        Advance(0.01f);
+        CHECK(Stop(voiceID, 0));
+        Advance(0.01f);
+        CHECK(VoiceExist(voiceID));
+        CHECK(StartAtEngineTime(voiceID, now + 14400));
+        CHECK(RenderUntilHeard(now + 48000) == now + 14400 + s_latency);
+        Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    void RunScheduleTests()
+    {
+        CreateOffline(2, 48000);
+        TestLatency();
+        TestScheduledTime();
+        TestReschedule();
+        TestCancel();
+        Release();
+    }
+}
@@ -0,0 +1,137 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    static BOOL Contains(const vector<INT32>& voiceIDs, const INT32 voiceID)
+    {
+        return find(voiceIDs.begin(), voiceIDs.end(), voiceID) != voiceIDs.end();
+    }
+
+    static void TestSchedule()
+    {
+        vector<INT32> toVirtualize;
+        vector<INT32> toPromote;
+
+        // No limit, every virtual voice is promoted
+        vector<VoiceCandidate> candidates = { { 1, 0, 0.5f, true }, { 2, 0, 0.1f, false } };
+        VoiceScheduler::Schedule(candidates, 0, toVirtualize, toPromote);
+        CHECK(toVirtualize.empty());
+        CHECK(toPromote.size() == 1 && toPromote[0] == 2);
+
+        // The quietest real voices give their place
+        toPromote.clear();
+        candidates = { { 1, 0, 1.0f, true }, { 2, 0, 0.2f, true }, { 3, 0, 0.8f, true }, { 4, 0, 0.1f, true } };
+        VoiceScheduler::Schedule(candidates, 2, toVirtualize, toPromote);
+        CHECK(toVirtualize.size() == 2 && Contains(toVirtualize, 2) && Contains(toVirtualize, 4));
+        CHECK(toPromote.empty());
+
+        // Priority comes before audibility
+        toVirtualize.clear();
+        candidates = { { 1, 0, 1.0f, true }, { 2, 1, 0.01f, false } };
+        VoiceScheduler::Schedule(candidates, 1, toVirtualize, toPromote);
+        CHECK(toVirtualize.size() == 1 && toVirtualize[0] == 1);
+        CHECK(toPromote.size() == 1 && toPromote[0] == 2);
+    }
+
+    static void TestHysteresis()
+    {
+        vector<INT32> toVirtualize;
+        vector<INT32> toPromote;
+
+        // Slightly louder isn't enough to swap
+        vector<VoiceCandidate> candidates = { { 1, 0, 1.0f, true }, { 2, 0, 1.2f, false } };
+        VoiceScheduler::Schedule(candidates, 1, toVirtualize, toPromote);
+        CHECK(toVirtualize.empty() && toPromote.empty());
+
+        // Equal after the hysteresis keeps the current state
+        candidates = { { 1, 0, 1.0f, true }, { 2, 0, VoiceScheduler::HYSTERESIS, false } };
+        VoiceScheduler::Schedule(candidates, 1, toVirtualize, toPromote);
+        CHECK(toVirtualize.empty() && toPromote.empty());
+
+        candidates = { { 1, 0, 1.0f, true }, { 2, 0, 1.3f, false } };
+        VoiceScheduler::Schedule(candidates, 1, toVirtualize, toPromote);
+        CHECK(toVirtualize.size() == 1 && toVirtualize[0] == 1);
+        CHECK(toPromote.size() == 1 && toPromote[0] == 2);
+    }
+
+    // The engine keeps the loudest voices real and tracks the others
+    static void TestRealVoiceLimit()
+    {
+        CreateOffline(2, 48000);
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+
+        const FLOAT volumes[4] = { 1.0f, 0.8f, 0.2f, 0.1f };
+        INT32 voiceIDs[4];
+        for (UINT32 i = 0; i < 4; i++)
+        {
+            voiceIDs[i] = CreateVoice(bankID, 0, true);
+            SetVolume(voiceIDs[i], volumes[i]);
+            SetLooping(voiceIDs[i], true);
+            Start(voiceIDs[i]);
+        }
+
+        SetMaxRealVoices(2);
+        Advance(0.05f);
+        CHECK(GetVoiceCount() == 4);
+        CHECK(GetRealVoiceCount() == 2);
+        CHECK(!IsVirtual(voiceIDs[0]) && !IsVirtual(voiceIDs[1]));
+        CHECK(IsVirtual(voiceIDs[2]) && IsVirtual(voiceIDs[3]));
+
+        // Virtual voices keep advancing
+        UINT32 position = GetPositionSample(voiceIDs[3]);
+        Advance(0.1f);
+        CHECK(GetPositionSample(voiceIDs[3]) != position);
+
+        // Louder than the quietest real voice with its hysteresis
+        SetVolume(voiceIDs[3], 1.5f);
+        Advance(0.05f);
+        CHECK(!IsVirtual(voiceIDs[3]));
+        CHECK(IsVirtual(voiceIDs[1]));
+
+        // Priority wins over volume
+        SetPriority(voiceIDs[2], 1);
+        Advance(0.05f);
+        CHECK(!IsVirtual(voiceIDs[2]));
+        CHECK(GetRealVoiceCount() == 2);
+
+        SetMaxRealVoices(0);
+        Advance(0.05f);
+        CHECK(GetRealVoiceCount() == 4);
+        Release();
+    }
+
+    void RunSchedulerTests()
+    {
+        TestSchedule();
+        TestHysteresis();
+        TestRealVoiceLimit();
+    }
+}
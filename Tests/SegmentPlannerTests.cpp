@@ -0,0 +1,305 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    static void TestPlanStart()
+    {
+        // Before the loop, an intro plays up to the loop start
+        SegmentPlan plan = PlanStart(100, true, 1000, 2000, 5000);
+        CHECK(plan.count == 2);
+        CHECK(plan.segments[0].playBegin == 100 && plan.segments[0].playEnd == 1000 && plan.segments[0].loopEnd == 0);
+        CHECK(plan.segments[1].playBegin == 1000 && plan.segments[1].playEnd == 2000);
+        CHECK(plan.segments[1].loopBegin == 1000 && plan.segments[1].loopEnd == 2000 && plan.segments[1].loopCount == XAUDIO2_LOOP_INFINITE);
+
+        // Inside the loop, the loop segment begins at the position
+        plan = PlanStart(1500, true, 1000, 2000, 5000);
+        CHECK(plan.count == 1 && plan.segments[0].playBegin == 1500 && plan.segments[0].loopBegin == 1000);
+
+        // Past the loop end or not looping, the sound plays to its end
+        plan = PlanStart(2500, true, 1000, 2000, 5000);
+        CHECK(plan.count == 1 && plan.segments[0].playBegin == 2500 && plan.segments[0].playEnd == 0 && plan.segments[0].loopEnd == 0);
+        plan = PlanStart(100, false, 1000, 2000, 5000);
+        CHECK(plan.count == 1 && plan.segments[0].playBegin == 100 && plan.segments[0].loopEnd == 0);
+
+        // Nothing left to play
+        plan = PlanStart(5000, false, 0, 0, 5000);
+        CHECK(plan.count == 0);
+    }
+
+    static void TestPlanLoopChange()
+    {
+        // The new loop is ahead, the sound continues from the boundary up to it
+        SegmentPlan plan = PlanLoopChange(2000, true, 3000, 4000, 5000);
+        CHECK(plan.count == 2 && plan.segments[0].playBegin == 2000 && plan.segments[0].playEnd == 3000);
+        CHECK(plan.segments[1].loopBegin == 3000 && plan.segments[1].loopEnd == 4000);
+
+        // The new loop is behind, playback goes back to its start
+        plan = PlanLoopChange(2000, true, 500, 1500, 5000);
+        CHECK(plan.count == 1 && plan.segments[0].playBegin == 500 && plan.segments[0].loopBegin == 500 && plan.segments[0].loopEnd == 1500);
+
+        // Loop disabled, the sound plays from the boundary to its end
+        plan = PlanLoopChange(2000, false, 1000, 2000, 5000);
+        CHECK(plan.count == 1 && plan.segments[0].playBegin == 2000 && plan.segments[0].loopEnd == 0);
+    }
+
+    static void TestPlanSegments()
+    {
+        // Empty regions are skipped, end 0 is the end of the sound, nothing follows an infinite loop
+        PlaybackSegment segments[] =
+        {
+            { 0, 1000, 0 },
+            { 3000, 2000, 0 },
+            { 1000, 2000, 2 },
+            { 4000, 0, 0 },
+            { 2000, 3000, XAUDIO2_LOOP_INFINITE },
+            { 0, 1000, 0 },
+        };
+        SegmentPlan plan = PlanSegments(segments, 6, 5000);
+        CHECK(plan.count == 4);
+        CHECK(plan.segments[1].playBegin == 1000 && plan.segments[1].loopEnd == 2000 && plan.segments[1].loopCount == 2);
+        CHECK(plan.segments[2].playBegin == 4000 && plan.segments[2].playEnd == 5000 && plan.segments[2].loopEnd == 0);
+        CHECK(plan.segments[3].loopCount == XAUDIO2_LOOP_INFINITE);
+
+        // Past the end of the sound, the region is clamped
+        PlaybackSegment clamped = { 4000, 9000, 0 };
+        plan = PlanSegments(&clamped, 1, 5000);
+        CHECK(plan.count == 1 && plan.segments[0].playEnd == 5000);
+
+        // At most MAX_PLAN_SEGMENTS are kept
+        vector<PlaybackSegment> many(MAX_PLAN_SEGMENTS + 4, { 0, 100, 0 });
+        plan = PlanSegments(many.data(), (UINT32)many.size(), 5000);
+        CHECK(plan.count == MAX_PLAN_SEGMENTS);
+    }
+
+    static void TestPlanPosition()
+    {
+        // 0-1000 once, 1000-2000 three times in total, then 2000-3000 forever
+        PlaybackSegment segments[] =
+        {
+            { 0, 1000, 0 },
+            { 1000, 2000, 2 },
+            { 2000, 3000, XAUDIO2_LOOP_INFINITE },
+        };
+        SegmentPlan plan = PlanSegments(segments, 3, 5000);
+        plan.origin = 10000;
+
+        CHECK(GetPlanPosition(plan, 5000, 5000) == 0);
+        CHECK(GetPlanPosition(plan, 10500, 5000) == 500);
+        CHECK(GetPlanPosition(plan, 11500, 5000) == 1500);
+        CHECK(GetPlanPosition(plan, 12500, 5000) == 1500);
+        CHECK(GetPlanPosition(plan, 13999, 5000) == 1999);
+        CHECK(GetPlanPosition(plan, 14000, 5000) == 2000);
+        CHECK(GetPlanPosition(plan, 16250, 5000) == 2250);
+
+        CHECK(GetPlanSegment(plan, 10999, 5000) == 0);
+        CHECK(GetPlanSegment(plan, 11000, 5000) == 1);
+        CHECK(GetPlanSegment(plan, 13999, 5000) == 1);
+        CHECK(GetPlanSegment(plan, 100000, 5000) == 2);
+
+        // The infinite loop first ends 1000 samples after it starts, then every 1000 samples
+        CHECK(GetPlanLoopExit(plan, 10000, 5000) == 15000);
+        CHECK(GetPlanLoopExit(plan, 15000, 5000) == 16000);
+        CHECK(GetPlanLoopExit(plan, 16250, 5000) == 17000);
+
+        // Playing to the end doesn't loop
+        SegmentPlan tail = PlanStart(0, false, 0, 0, 5000);
+        CHECK(GetPlanLoopExit(tail, 0, 5000) == 0);
+
+        CHECK(GetPlanDuration(plan, 5000) == UINT64_MAX);
+        CHECK(GetPlanDuration(tail, 5000) == 5000);
+    }
+
+    static void TestPlanRemainder()
+    {
+        PlaybackSegment segments[] =
+        {
+            { 0, 1000, 0 },
+            { 1000, 2000, 2 },
+            { 3000, 0, 0 },
+        };
+        SegmentPlan plan = PlanSegments(segments, 3, 5000);
+        plan.origin = 100;
+        CHECK(GetPlanDuration(plan, 5000) == 6000);
+
+        // Not started yet, everything is left
+        SegmentPlan remainder = PlanRemainder(plan, 50, 5000);
+        CHECK(remainder.count == 3 && remainder.origin == 0 && remainder.segments[0].playBegin == 0);
+
+        // Inside the first region
+        remainder = PlanRemainder(plan, 600, 5000);
+        CHECK(remainder.count == 3 && remainder.segments[0].playBegin == 500 && remainder.segments[0].playEnd == 1000);
+
+        // On the first repeat of the loop, one repeat is left
+        remainder = PlanRemainder(plan, 2350, 5000);
+        CHECK(remainder.count == 2 && remainder.segments[0].playBegin == 1250);
+        CHECK(remainder.segments[0].loopBegin == 1000 && remainder.segments[0].loopEnd == 2000 && remainder.segments[0].loopCount == 1);
+
+        // On the last repeat there is no loop left
+        remainder = PlanRemainder(plan, 3350, 5000);
+        CHECK(remainder.count == 2 && remainder.segments[0].playBegin == 1250 && remainder.segments[0].loopEnd == 0);
+
+        // The durations add up to what was left
+        for (UINT64 played = 100; played < 6100; played += 250)
+            CHECK(GetPlanDuration(PlanRemainder(plan, played, 5000), 5000) == 6100 - played);
+
+        CHECK(PlanRemainder(plan, 6100, 5000).count == 0);
+
+        // An infinite loop stays infinite
+        SegmentPlan loop = PlanStart(0, true, 1000, 2000, 5000);
+        remainder = PlanRemainder(loop, 10500, 5000);
+        CHECK(remainder.count == 1 && remainder.segments[0].playBegin == 1500 && remainder.segments[0].loopCount == XAUDIO2_LOOP_INFINITE);
+    }
+
+    static void TestSeamlessLoopChange()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        SetSeamlessLoops(voiceID, true);
+        SetLooping(voiceID, true);
+        SetLoopPoints(voiceID, 0, 4800);
+        Start(voiceID);
+        Advance(0.05f);
+
+        // The playing loop finishes before the new one starts, restarting would already have looped back from 3600
+        SetLoopPoints(voiceID, 1200, 3600);
+        Advance(0.07f);
+        CHECK(GetPositionSample(voiceID) == 2160);
+        Advance(0.05f);
+        CHECK(GetPositionSample(voiceID) == 2160);
+        CHECK(GetLoopStart(voiceID) == 1200 && GetLoopEnd(voiceID) == 3600);
+
+        Stop(voiceID, 0);
+        Advance(0.02f);
+    }
+
+    // Only StartSegments counts regions, an intro before the loop is region 0 whether the voice is real or virtual
+    static void TestSegmentIndex()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 loudID = CreateVoice(bankID, 0, true);
+        SetLooping(loudID, true);
+        Start(loudID);
+
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        SetVolume(voiceID, 0.1f);
+        SetLooping(voiceID, true);
+        SetLoopPoints(voiceID, 2400, 4800);
+        Start(voiceID);
+        Advance(0.1f);
+        CHECK(GetSegmentIndex(voiceID) == 0);
+        SetMaxRealVoices(1);
+        Advance(0.02f);
+        CHECK(IsVirtual(voiceID));
+        CHECK(GetSegmentIndex(voiceID) == 0);
+        SetMaxRealVoices(0);
+        Advance(0.02f);
+        CHECK(!IsVirtual(voiceID));
+
+        // The loop of the regions is left, the voice plays on as a plain start
+        PlaybackSegment segments[] =
+        {
+            { 0, 4800, 0 },
+            { 9600, 14400, XAUDIO2_LOOP_INFINITE },
+        };
+        CHECK(StartSegments(voiceID, segments, 2));
+        Advance(0.15f);
+        CHECK(GetSegmentIndex(voiceID) == 1);
+        SetLooping(voiceID, false);
+        Advance(0.02f);
+        CHECK(GetSegmentIndex(voiceID) == 0);
+        SetMaxRealVoices(1);
+        Advance(0.02f);
+        CHECK(IsVirtual(voiceID));
+        CHECK(GetSegmentIndex(voiceID) == 0);
+        SetMaxRealVoices(0);
+
+        Stop(voiceID, 0);
+        Stop(loudID, 0);
+        Advance(0.02f);
+    }
+
+    // A virtual voice keeps following its regions and resumes them once real again
+    static void TestVirtualSegments()
+    {
+        INT32 bankID = Test::AddSineBank(1, 48000, 48000);
+        INT32 loudID = CreateVoice(bankID, 0, true);
+        SetLooping(loudID, true);
+        Start(loudID);
+
+        PlaybackSegment segments[] =
+        {
+            { 0, 4800, 0 },
+            { 24000, 28800, 1 },
+            { 9600, 14400, 0 },
+        };
+        INT32 voiceID = CreateVoice(bankID, 0, true);
+        SetVolume(voiceID, 0.1f);
+        CHECK(StartSegments(voiceID, segments, 3));
+        SetMaxRealVoices(1);
+
+        Advance(0.15f);
+        CHECK(IsVirtual(voiceID));
+        CHECK_NEAR(GetPositionSample(voiceID), 26400, 2);
+        CHECK(GetSegmentIndex(voiceID) == 1);
+        Advance(0.10f);
+        CHECK_NEAR(GetPositionSample(voiceID), 26400, 2);
+
+        SetMaxRealVoices(0);
+        Advance(0.10f);
+        CHECK(!IsVirtual(voiceID));
+        CHECK_NEAR(GetPositionSample(voiceID), 12000, 2);
+        CHECK(GetSegmentIndex(voiceID) == 2);
+
+        // The plan ends where it would have without being virtual
+        Advance(0.03f);
+        CHECK(VoiceExist(voiceID));
+        Advance(0.07f);
+        CHECK(!VoiceExist(voiceID));
+
+        Stop(loudID, 0);
+        Advance(0.02f);
+    }
+
+    void RunSegmentPlannerTests()
+    {
+        TestPlanStart();
+        TestPlanLoopChange();
+        TestPlanSegments();
+        TestPlanPosition();
+        TestPlanRemainder();
+
+        CreateOffline(2, 48000);
+        TestSeamlessLoopChange();
+        TestSegmentIndex();
+        TestVirtualSegments();
+        Release();
+    }
+}
@@ -0,0 +1,137 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+#include "Playlist.h"
+#include "Exports.h"
+
+namespace SaXAudio
+{
+    // A constant mono signal, the mix is the sum of the gains on its way
+    static INT32 AddConstantBank(const FLOAT value)
+    {
+        const UINT32 frames = 48000;
+        Buffer buffer = SaXAudio::Instance.GetBuffer(frames);
+        for (UINT32 i = 0; i < frames; i++)
+            buffer.Data[i] = value;
+        return SaXAudio::Instance.AddBankData(buffer, 1, 48000, frames);
+    }
+
+    // The left channel at the end of a pass, once the changes are applied
+    static FLOAT RenderLevel()
+    {
+        vector<FLOAT> buffer(480 * 2);
+        Advance(0.02f);
+        Render(buffer.data(), 480);
+        return buffer[479 * 2];
+    }
+
+    static void TestSendLevel()
+    {
+        INT32 bankID = AddConstantBank(0.5f);
+        INT32 busID = CreateBus();
+        INT32 sendBusID = CreateBus();
+
+        // Only the send is heard
+        SetVolume(busID, 0.0f, 0, true);
+        INT32 voiceID = CreateVoice(bankID, busID, true);
+        SetLooping(voiceID, true);
+        Start(voiceID);
+        CHECK_NEAR(RenderLevel(), 0.0f, 1e-6);
+
+        SetSend(voiceID, sendBusID, 0.5f);
+        CHECK_NEAR(RenderLevel(), 0.25f, 1e-5);
+
+        SetSend(voiceID, sendBusID, 1.0f);
+        CHECK_NEAR(RenderLevel(), 0.5f, 1e-5);
+
+        // The bus is shared, the sends add up
+        INT32 otherID = CreateVoice(bankID, busID, true);
+        SetLooping(otherID, true);
+        Start(otherID);
+        SetSend(otherID, sendBusID, 0.5f);
+        CHECK_NEAR(RenderLevel(), 0.75f, 1e-5);
+
+        // The bus volume applies to every send
+        SetVolume(sendBusID, 0.5f, 0, true);
+        CHECK_NEAR(RenderLevel(), 0.375f, 1e-5);
+
+        // Level 0 removes the send
+        SetSend(otherID, sendBusID, 0.0f);
+        CHECK_NEAR(RenderLevel(), 0.25f, 1e-5);
+
+        // Removing the bus drops the sends to it, the voices keep playing
+        RemoveBus(sendBusID);
+        CHECK_NEAR(RenderLevel(), 0.0f, 1e-6);
+        CHECK(VoiceExist(voiceID) && VoiceExist(otherID));
+
+        SetVolume(busID, 1.0f, 0, true);
+        CHECK_NEAR(RenderLevel(), 1.0f, 1e-5);
+
+        RemoveBus(busID);
+        Advance(0.02f);
+    }
+
+    // A virtual voice gets its sends back with its source voice
+    static void TestVirtualSend()
+    {
+        INT32 bankID = AddConstantBank(0.5f);
+        INT32 busID = CreateBus();
+        INT32 sendBusID = CreateBus();
+        SetVolume(busID, 0.0f, 0, true);
+
+        INT32 loudID = CreateVoice(bankID, busID, true);
+        SetLooping(loudID, true);
+        Start(loudID);
+
+        INT32 voiceID = CreateVoice(bankID, busID, true);
+        SetVolume(voiceID, 0.5f);
+        SetLooping(voiceID, true);
+        SetSend(voiceID, sendBusID, 1.0f);
+        Start(voiceID);
+        CHECK_NEAR(RenderLevel(), 0.25f, 1e-5);
+
+        SetMaxRealVoices(1);
+        CHECK_NEAR(RenderLevel(), 0.0f, 1e-6);
+        CHECK(IsVirtual(voiceID));
+
+        SetMaxRealVoices(0);
+        CHECK_NEAR(RenderLevel(), 0.25f, 1e-5);
+        CHECK(!IsVirtual(voiceID));
+
+        RemoveBus(sendBusID);
+        RemoveBus(busID);
+        Advance(0.02f);
+    }
+
+    void RunSendTests()
+    {
+        CreateOffline(2, 48000);
+        TestSendLevel();
+        TestVirtualSend();
+        Release();
+    }
+}
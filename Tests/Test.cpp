@@ -0,0 +1,102 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+
+#include "Test.h"
+#include "SaXAudio.h"
+
+namespace SaXAudio
+{
+    UINT32 Test::Failures = 0;
+
+    void Test::Check(const BOOL condition, const char* expression, const char* file, const INT32 line)
+    {
+        if (condition)
+            return;
+
+        Failures++;
+        printf("%s(%d): check failed: %s\n", file, line, expression);
+    }
+
+    INT32 Test::AddSineBank(const UINT32 channels, const UINT32 sampleRate, const UINT32 frames, const FLOAT amplitude)
+    {
+        Buffer buffer = SaXAudio::Instance.GetBuffer(frames * channels);
+        for (UINT32 i = 0; i < frames; i++)
+        {
+            for (UINT32 c = 0; c < channels; c++)
+                buffer.Data[i * channels + c] = amplitude * sinf(2.0f * 3.14159265f * 440.0f * i / sampleRate);
+        }
+        return SaXAudio::Instance.AddBankData(buffer, channels, sampleRate, frames);
+    }
+}
+
+using namespace SaXAudio;
+
+struct TestGroup
+{
+    const char* name;
+    void (*run)();
+};
+
+int main(int argc, char** argv)
+{
+    const TestGroup groups[] =
+    {
+        { "handles", RunHandleTests },
+        { "scheduler", RunSchedulerTests },
+        { "output_matrix", RunOutputMatrixTests },
+        { "lifecycle", RunLifecycleTests },
+        { "commands", RunCommandTests },
+        { "schedule", RunScheduleTests },
+        { "segment_planner", RunSegmentPlannerTests },
+        { "playlist", RunPlaylistTests },
+        { "send", RunSendTests },
+        { "metering", RunMeteringTests },
+        { "loudness", RunLoudnessTests },
+        { "convolution", RunConvolutionTests },
+        { "dynamics", RunDynamicsTests },
+        { "effects", RunEffectTests },
+    };
+
+    // Without argument every group runs, ctest runs them one by one
+    string filter = argc > 1 ? argv[1] : "";
+    UINT32 count = 0;
+    for (const TestGroup& group : groups)
+    {
+        if (!filter.empty() && filter != group.name)
+            continue;
+
+        UINT32 failures = Test::Failures;
+        group.run();
+        printf("%-16s %s\n", group.name, Test::Failures == failures ? "passed" : "FAILED");
+        count++;
+    }
+
+    if (count == 0)
+    {
+        printf("Unknown test group: %s\n", filter.c_str());
+        return 1;
+    }
+    return Test::Failures > 0 ? 1 : 0;
+}
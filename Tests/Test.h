@@ -0,0 +1,59 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+    // Checks of the headless build, a failed check is printed and the test keeps going
+    class Test
+    {
+    public:
+        static UINT32 Failures;
+
+        static void Check(const BOOL condition, const char* expression, const char* file, const INT32 line);
+        // A bank of a sine, without going through a file
+        static INT32 AddSineBank(const UINT32 channels, const UINT32 sampleRate, const UINT32 frames, const FLOAT amplitude = 0.5f);
+    };
+
+#define CHECK(condition) Test::Check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(value, expected, tolerance) Test::Check(fabs((double)(value) - (double)(expected)) <= (tolerance), #value " ~ " #expected, __FILE__, __LINE__)
+
+    void RunHandleTests();
+    void RunSchedulerTests();
+    void RunOutputMatrixTests();
+    void RunLifecycleTests();
+    void RunCommandTests();
+    void RunScheduleTests();
+    void RunSegmentPlannerTests();
+    void RunPlaylistTests();
+    void RunSendTests();
+    void RunMeteringTests();
+    void RunLoudnessTests();
+    void RunConvolutionTests();
+    void RunDynamicsTests();
+    void RunEffectTests();
+}
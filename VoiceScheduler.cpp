@@ -0,0 +1,59 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "VoiceScheduler.h"
+
+namespace SaXAudio
+{
+    inline BOOL IsMoreImportant(const VoiceCandidate& a, const VoiceCandidate& b)
+    {
+        if (a.priority != b.priority)
+            return a.priority > b.priority;
+
+        FLOAT audibilityA = a.isReal ? a.audibility * VoiceScheduler::HYSTERESIS : a.audibility;
+        FLOAT audibilityB = b.isReal ? b.audibility * VoiceScheduler::HYSTERESIS : b.audibility;
+        if (audibilityA != audibilityB)
+            return audibilityA > audibilityB;
+
+        // Keep the current state when equal
+        return a.isReal && !b.isReal;
+    }
+
+    void VoiceScheduler::Schedule(vector<VoiceCandidate>& candidates, const UINT32 maxReal, vector<INT32>& toVirtualize, vector<INT32>& toPromote)
+    {
+        UINT32 realCount = (maxReal == 0 || maxReal > candidates.size()) ? (UINT32)candidates.size() : maxReal;
+
+        // Only the split between the most important voices and the others matters
+        if (realCount < candidates.size())
+            nth_element(candidates.begin(), candidates.begin() + realCount, candidates.end(), IsMoreImportant);
+
+        for (UINT32 i = 0; i < candidates.size(); i++)
+        {
+            const VoiceCandidate& candidate = candidates[i];
+            if (i < realCount && !candidate.isReal)
+                toPromote.push_back(candidate.voiceID);
+            else if (i >= realCount && candidate.isReal)
+                toVirtualize.push_back(candidate.voiceID);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+// MIT License
+// 
+// Copyright(c) 2025 SamsamTS
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Includes.h"
+
+namespace SaXAudio
+{
+    struct VoiceCandidate
+    {
+        INT32 voiceID = 0;
+        UINT32 priority = 0;
+        FLOAT audibility = 0;
+        BOOL isReal = false;
+    };
+
+    class VoiceScheduler
+    {
+    public:
+        // A virtual voice needs to be this much louder than a real voice of the same priority to take its place
+        // Avoids voices of similar volume swapping back and forth
+        static constexpr FLOAT HYSTERESIS = 1.25f;
+
+        /// <summary>
+        /// Decide which voices should have a real source voice
+        /// Voices are ranked by priority, then by audibility
+        /// </summary>
+        /// <param name="candidates">All the voices, the order will be changed</param>
+        /// <param name="maxReal">Maximum number of real voices (0 for no limit)</param>
+        /// <param name="toVirtualize">Receives the real voices that must become virtual</param>
+        /// <param name="toPromote">Receives the virtual voices that must become real</param>
+        static void Schedule(vector<VoiceCandidate>& candidates, const UINT32 maxReal, vector<INT32>& toVirtualize, vector<INT32>& toPromote);
+    };
+}